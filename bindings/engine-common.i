@@ -44,8 +44,10 @@ AccountList * gnc_account_get_descendants_sorted (const Account *account);
 %ignore gnc_account_get_children_sorted;
 %ignore gnc_account_get_descendants;
 %ignore gnc_account_get_descendants_sorted;
+%ignore xaccAccountsGetBalancesAtDates;
 %include <Account.h>
 
+%newobject xaccTransCommitBulk;
 %include <Transaction.h>
 
 %include <gnc-lot.h>
@@ -26,6 +26,7 @@
 
 #include "swig-runtime.h"
 #include <libguile.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "Account.h"
@@ -1852,6 +1853,70 @@ SCM gnc_account_value_ptr_to_scm (GncAccountValue *av)
                      gnc_numeric_to_scm (val));
 }
 
+static int
+compare_time64 (const void *a, const void *b)
+{
+    time64 time_a = *(const time64*)a, time_b = *(const time64*)b;
+    return time_a < time_b ? -1 : time_a > time_b ? 1 : 0;
+}
+
+SCM
+gnc_accounts_get_balances_at_dates (SCM accounts, SCM dates,
+                                    gboolean ignore_closing, gboolean changes)
+{
+    static const char *func_name = "gnc-accounts-get-balances-at-dates";
+    swig_type_info * account_type = get_acct_type();
+    guint n_accounts, n_dates, i, j;
+    Account **account_array;
+    time64 *date_array;
+    gnc_numeric *balances;
+    SCM node, result = SCM_EOL;
+
+    /* Check the arguments before allocating anything, the errors don't
+     * return. */
+    SCM_ASSERT (scm_is_true (scm_list_p (accounts)), accounts, SCM_ARG1, func_name);
+    SCM_ASSERT (scm_is_true (scm_list_p (dates)), dates, SCM_ARG2, func_name);
+    for (node = accounts; !scm_is_null (node); node = SCM_CDR (node))
+        SCM_ASSERT (SWIG_IsPointerOfType (SCM_CAR (node), account_type),
+                    SCM_CAR (node), SCM_ARG1, func_name);
+    for (node = dates; !scm_is_null (node); node = SCM_CDR (node))
+        SCM_ASSERT (scm_is_signed_integer (SCM_CAR (node), INT64_MIN, INT64_MAX),
+                    SCM_CAR (node), SCM_ARG2, func_name);
+
+    n_accounts = scm_to_uint (scm_length (accounts));
+    n_dates = scm_to_uint (scm_length (dates));
+    if (!n_accounts)
+        return SCM_EOL;
+
+    account_array = g_new (Account*, n_accounts);
+    date_array = g_new (time64, n_dates);
+    balances = g_new (gnc_numeric, (gsize)n_accounts * n_dates);
+
+    for (i = 0, node = accounts; i < n_accounts; i++, node = SCM_CDR (node))
+        account_array[i] = SWIG_MustGetPtr (SCM_CAR (node), account_type, 1, 0);
+    for (i = 0, node = dates; i < n_dates; i++, node = SCM_CDR (node))
+        date_array[i] = scm_to_int64 (SCM_CAR (node));
+    qsort (date_array, n_dates, sizeof (time64), compare_time64);
+
+    xaccAccountsGetBalancesAtDates (account_array, n_accounts,
+                                    date_array, n_dates,
+                                    ignore_closing, changes, balances);
+
+    for (i = n_accounts; i-- > 0;)
+    {
+        SCM account_balances = SCM_EOL;
+        for (j = n_dates; j-- > 0;)
+            account_balances = scm_cons (gnc_numeric_to_scm (balances[i * n_dates + j]),
+                                         account_balances);
+        result = scm_cons (account_balances, result);
+    }
+
+    g_free (account_array);
+    g_free (date_array);
+    g_free (balances);
+    return result;
+}
+
 typedef struct
 {
     SCM proc;
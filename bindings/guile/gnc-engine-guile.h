@@ -59,6 +59,15 @@ SCM gnc_book_to_scm (const QofBook *book);
 GncAccountValue * gnc_scm_to_account_value_ptr (SCM valuearg);
 SCM gnc_account_value_ptr_to_scm (GncAccountValue *);
 
+/** Get the balances of a list of accounts at a list of dates, see
+ *  xaccAccountsGetBalancesAtDates(). The dates are sorted first.
+ *
+ *  @return A list holding a list of balances for each account, in the
+ *  order of the accounts and the sorted dates. */
+SCM gnc_accounts_get_balances_at_dates (SCM accounts, SCM dates,
+                                        gboolean ignore_closing,
+                                        gboolean changes);
+
 /**
  * add Scheme-style danglers from a hook
  */
@@ -88,6 +88,38 @@
 
 %include <base-typemaps.i>
 
+/* A list of Transaction objects or their instances, for xaccTransCommitBulk */
+%typemap(in) TransList * {
+    $1 = NULL;
+    if (!PyList_Check($input)) {
+        PyErr_SetString(PyExc_TypeError, "not a list");
+        return NULL;
+    }
+    for (Py_ssize_t i = PyList_Size($input) - 1; i >= 0; i--) {
+        PyObject *item = PyList_GetItem($input, i);
+        PyObject *instance = PyObject_GetAttrString(item, "instance");
+        void *trans = NULL;
+        int res;
+        if (!instance) {
+            PyErr_Clear();
+            Py_INCREF(item);
+            instance = item;
+        }
+        res = SWIG_ConvertPtr(instance, &trans, $descriptor(Transaction *), 0);
+        Py_DECREF(instance);
+        if (!SWIG_IsOK(res)) {
+            PyErr_SetString(PyExc_TypeError, "list must contain transactions");
+            g_list_free($1);
+            return NULL;
+        }
+        $1 = g_list_prepend($1, trans);
+    }
+}
+
+%typemap(freearg) TransList * {
+    g_list_free($1);
+}
+
 %include <engine-common.i>
 
 %include <qofbackend.h>
@@ -107,6 +139,8 @@
 
 /* SWIG doesn't like this macro, so redefine it to simply mean const */
 #define G_CONST_RETURN const
+//Ignored because it takes a C array
+%ignore guid_replace_batch;
 %include <guid.h>
 
 /* %include <Transaction.h>
@@ -115,6 +149,8 @@
 
 //Ignored because it is unimplemented
 %ignore gnc_numeric_convert_with_error;
+//Ignored because it takes a C array
+%ignore gnc_numeric_sum;
 %include <gnc-numeric.h>
 
 %include <gnc-commodity.h>
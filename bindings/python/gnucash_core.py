@@ -782,6 +782,16 @@ methods_return_instance(Transaction, trans_dict)
 methods_return_instance_lists(
     Transaction, { 'GetSplitList': Split,
                        })
+
+def _trans_commit_bulk(transactions, mode=gnucash_core_c.TRANS_BULK_SCRUB):
+    """Commit a list of open transactions at once, see xaccTransCommitBulk.
+
+    Returns the transactions left open."""
+    return [Transaction(instance=trans) for trans in
+            gnucash_core_c.xaccTransCommitBulk(transactions, mode)]
+
+# xaccTransCommitBulk takes a list of transactions, not a single one
+Transaction.CommitBulk = staticmethod(_trans_commit_bulk)
 Transaction.decorate_functions(
     decorate_monetary_list_returning_function, 'GetImbalance')
 
@@ -77,6 +77,16 @@ class TestTransaction(TransactionSession):
         self.trans.CommitEdit()
         self.assertFalse( self.trans.IsOpen() )
 
+    def test_commit_bulk(self):
+        OTHER = Transaction(self.book)
+        Split(self.book).SetParent(OTHER)
+        OTHER.SetCurrency(self.currency)
+        self.trans.BeginEdit()
+        OTHER.BeginEdit()
+        self.assertEqual( Transaction.CommitBulk([self.trans, OTHER]), [] )
+        self.assertFalse( self.trans.IsOpen() )
+        self.assertFalse( OTHER.IsOpen() )
+
     def test_rollback(self):
         self.assertEqual( '', self.trans.GetDescription() )
         self.trans.BeginEdit()
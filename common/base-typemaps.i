@@ -267,7 +267,7 @@ typedef char gchar;
 }
 
 %typemap(out) GList *, CommodityList *, SplitList *, AccountList *, LotList *,
-    MonetaryList *, PriceList *, EntryList * {
+    MonetaryList *, PriceList *, EntryList *, TransList * {
     gpointer data;
     GList *l;
     PyObject *list = PyList_New(0);
@@ -116,6 +116,8 @@ gnc_style_sheet_options_apply_cb (GNCOptionWin * propertybox,
         g_hash_table_foreach (reports, dirty_same_stylesheet, ssi->stylesheet);
 
     results = gnc_option_db_commit (ssi->odb);
+    /* The render cache doesn't know which style sheet a report uses */
+    gnc_report_render_cache_invalidate ();
     for (iter = results; iter; iter = iter->next)
     {
         GtkWidget *dialog = gtk_message_dialog_new (NULL,
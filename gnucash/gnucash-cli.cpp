@@ -63,6 +63,13 @@ namespace Gnucash {
         boost::optional <std::string> m_report_name;
         boost::optional <std::string> m_export_type;
         boost::optional <std::string> m_output_file;
+        boost::optional <std::string> m_batch_file;
+        boost::optional <std::string> m_output_dir;
+        int m_jobs = 1;
+
+        boost::optional <std::string> m_import_cmd;
+        boost::optional <std::string> m_import_file;
+        boost::optional <std::string> m_import_preset;
     };
 
 }
@@ -105,16 +112,37 @@ Gnucash::GnucashCli::configure_program_options (void)
      "  list: \tLists available reports.\n"
      "  show: \tDescribe the options modified in the named report. A datafile \
 may be specified to describe some saved options.\n"
-     "  run: \tRun the named report in the given GnuCash datafile.\n"))
+     "  run: \tRun the named report in the given GnuCash datafile.\n"
+     "  run-batch: \tRun the saved reports named in the batch file, or all saved \
+reports, in the given GnuCash datafile, writing them to the output directory.\n"))
     ("name", bpo::value (&m_report_name),
      _("Name of the report to run\n"))
     ("export-type", bpo::value (&m_export_type),
      _("Specify export type\n"))
     ("output-file", bpo::value (&m_output_file),
-     _("Output file for report\n"));
+     _("Output file for report\n"))
+    ("batch-file", bpo::value (&m_batch_file),
+     _("File listing the names of the saved reports to run, one per line\n"))
+    ("output-dir", bpo::value (&m_output_dir),
+     _("Output directory for the reports run in a batch\n"))
+    ("jobs,j", bpo::value (&m_jobs),
+     _("Number of processes to run a batch of reports in\n"));
     m_opt_desc_display->add (report_options);
     m_opt_desc_all.add (report_options);
 
+    bpo::options_description import_options(_("Import Options"));
+    import_options.add_options()
+    ("import,I", bpo::value (&m_import_cmd),
+     _("Execute import related commands. The following commands are supported.\n\n"
+     "  transactions: \tImport transactions from a csv file into the given GnuCash datafile.\n"
+     "  prices: \tImport prices from a csv file into the given GnuCash datafile.\n"))
+    ("import-file", bpo::value (&m_import_file),
+     _("File to import\n"))
+    ("preset", bpo::value (&m_import_preset),
+     _("Name of the saved csv import settings to use for the import\n"));
+    m_opt_desc_display->add (import_options);
+    m_opt_desc_all.add (import_options);
+
 }
 
 int
@@ -156,6 +184,25 @@ Gnucash::GnucashCli::start ([[maybe_unused]] int argc, [[maybe_unused]] char **a
                                            m_export_type, m_output_file);
         }
 
+        else if (*m_report_cmd == "run-batch")
+        {
+            if (!m_file_to_load || m_file_to_load->empty())
+            {
+                std::cerr << bl::translate("Missing data file parameter") << "\n\n"
+                          << *m_opt_desc_display.get();
+                return 1;
+            }
+            else if (!m_output_dir || m_output_dir->empty())
+            {
+                std::cerr << bl::translate("Missing --output-dir parameter") << "\n\n"
+                          << *m_opt_desc_display.get();
+                return 1;
+            }
+            else
+                return Gnucash::run_report_batch(m_file_to_load, m_batch_file,
+                                                 m_output_dir, m_jobs);
+        }
+
         // The command "list" does *not* test&pass the m_file_to_load
         // argument because the reports are global rather than
         // per-file objects. In the future, saved reports may be saved
@@ -185,6 +232,38 @@ Gnucash::GnucashCli::start ([[maybe_unused]] int argc, [[maybe_unused]] char **a
         }
     }
 
+    if (m_import_cmd)
+    {
+        if (*m_import_cmd != "transactions" && *m_import_cmd != "prices")
+        {
+            std::cerr << bl::format (bl::translate("Unknown import command '{1}'")) % *m_import_cmd << "\n\n"
+                      << *m_opt_desc_display.get();
+            return 1;
+        }
+
+        if (!m_file_to_load || m_file_to_load->empty())
+        {
+            std::cerr << bl::translate("Missing data file parameter") << "\n\n"
+                      << *m_opt_desc_display.get();
+            return 1;
+        }
+        else if (!m_import_file || m_import_file->empty())
+        {
+            std::cerr << bl::translate("Missing --import-file parameter") << "\n\n"
+                      << *m_opt_desc_display.get();
+            return 1;
+        }
+        else if (!m_import_preset || m_import_preset->empty())
+        {
+            std::cerr << bl::translate("Missing --preset parameter") << "\n\n"
+                      << *m_opt_desc_display.get();
+            return 1;
+        }
+        else
+            return Gnucash::run_import (m_file_to_load, m_import_cmd,
+                                        m_import_file, m_import_preset);
+    }
+
     std::cerr << bl::translate("Missing command or option") << "\n\n"
               << *m_opt_desc_display.get();
 
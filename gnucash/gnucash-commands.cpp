@@ -33,17 +33,28 @@
 
 extern "C" {
 #include <gnc-engine-guile.h>
+#include <gnc-guile-utils.h>
 #include <gnc-prefs.h>
 #include <gnc-prefs-utils.h>
 #include <gnc-gnome-utils.h>
 #include <gnc-report.h>
 #include <gnc-session.h>
+#include <gnc-state.h>
 #include <qoflog.h>
 }
 
+#include <gnc-import-batch.hpp>
+
 #include <boost/locale.hpp>
+#include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <iostream>
+#include <vector>
+#ifndef __MINGW32__
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 namespace bl = boost::locale;
 
@@ -147,18 +158,19 @@ struct run_report_args {
     const std::string& output_file;
 };
 
-static inline void
+static inline bool
 write_report_file (const char *html, const char* file)
 {
-    if (!file || !html || !*html) return;
+    if (!file || !html || !*html) return false;
     std::ofstream ofs{file};
     if (!ofs)
     {
         std::cerr << "Failed to open file " << file << " for writing\n";
-        return;
+        return false;
     }
     ofs << html << std::endl;
     // ofs destructor will close the file
+    return true;
 }
 
 static void
@@ -287,6 +299,227 @@ return a document object with export-string or export-error.") << std::endl;
 }
 
 
+struct run_report_batch_args {
+    const std::string& file_to_load;
+    const std::string& batch_file;
+    const std::string& output_dir;
+    int jobs;
+};
+
+/* Reads the names of the reports to run from batch_file, one per line.
+ * Empty lines and lines starting with '#' are skipped. Without a batch
+ * file all saved reports are run. */
+static std::vector<std::string>
+report_batch_names (const std::string& batch_file)
+{
+    std::vector<std::string> names;
+
+    if (batch_file.empty())
+    {
+        auto guids = scm_c_eval_string ("(gnc:custom-report-template-guids)");
+        for (; scm_is_pair (guids); guids = scm_cdr (guids))
+        {
+            auto guid = gnc_scm_to_utf8_string (scm_car (guids));
+            names.emplace_back (guid);
+            g_free (guid);
+        }
+        return names;
+    }
+
+    std::ifstream ifs{batch_file};
+    if (!ifs)
+    {
+        std::cerr << bl::format (bl::translate ("Failed to open file {1}")) % batch_file << "\n";
+        scm_cleanup_and_exit_with_failure (nullptr);
+    }
+    std::string line;
+    while (std::getline (ifs, line))
+    {
+        auto start = line.find_first_not_of (" \t");
+        if (start == std::string::npos || line[start] == '#')
+            continue;
+        auto end = line.find_last_not_of (" \t\r");
+        names.emplace_back (line.substr (start, end - start + 1));
+    }
+    return names;
+}
+
+/* Looks up the template guid of each report in names. Reports that
+ * don't match a single template are counted in failures. A template
+ * that's listed more than once, by name or by guid, is only returned
+ * once so no two reports are written to the same file. */
+static std::vector<std::string>
+report_batch_guids (const std::vector<std::string>& names, int& failures)
+{
+    auto get_guid_cmd = scm_c_eval_string ("gnc:cmdline-get-report-guid");
+    std::vector<std::string> guids;
+
+    for (const auto& name : names)
+    {
+        auto scm_guid = scm_call_1 (get_guid_cmd, scm_from_locale_string (name.c_str()));
+        if (!scm_is_string (scm_guid))
+        {
+            failures++;
+            continue;
+        }
+        auto guid = gnc_scm_to_utf8_string (scm_guid);
+        if (std::find (guids.begin(), guids.end(), guid) == guids.end())
+            guids.emplace_back (guid);
+        g_free (guid);
+    }
+    return guids;
+}
+
+/* Renders every stride'th report in guids starting at first into
+ * output_dir, naming the files after the reports and their template
+ * guids. Returns the number of reports that failed. */
+static int
+run_report_batch_part (const std::vector<std::string>& guids,
+                       const std::string& output_dir, size_t first, size_t stride)
+{
+    auto get_report_cmd = scm_c_eval_string ("gnc:cmdline-get-report-id");
+    auto get_report_name = scm_c_eval_string ("gnc:report-name");
+    int failures = 0;
+
+    for (auto i = first; i < guids.size(); i += stride)
+    {
+        auto id = scm_call_1 (get_report_cmd, scm_from_locale_string (guids[i].c_str()));
+        if (scm_is_false (id))
+        {
+            failures++;
+            continue;
+        }
+
+        auto report_id = scm_to_int (id);
+        auto name = gnc_scm_call_1_to_string (get_report_name, gnc_report_find (report_id));
+        char *html, *errmsg;
+        if (gnc_run_report_with_error_handling (report_id, &html, &errmsg))
+        {
+            auto basename = g_strconcat (name ? name : "report", "-",
+                                         guids[i].c_str(), ".html", nullptr);
+            g_strdelimit (basename, "/\\:*?\"<>|", '_');
+            auto file = g_build_filename (output_dir.c_str(), basename, nullptr);
+            if (write_report_file (html, file))
+                std::cout << bl::format (bl::translate ("Wrote {1}")) % file << "\n";
+            else
+                failures++;
+            g_free (file);
+            g_free (basename);
+            g_free (html);
+        }
+        else
+        {
+            std::cerr << bl::format (bl::translate ("Failed to run report {1}:\n{2}"))
+                         % guids[i] % errmsg << "\n";
+            g_free (errmsg);
+            failures++;
+        }
+        g_free (name);
+        gnc_report_remove_by_id (report_id);
+    }
+    return failures;
+}
+
+static void
+scm_run_report_batch (void *data,
+                      [[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    auto args = static_cast<run_report_batch_args*>(data);
+
+    scm_c_eval_string("(debug-set! stack 200000)");
+    scm_c_use_module ("gnucash utilities");
+    scm_c_use_module ("gnucash app-utils");
+    scm_c_use_module ("gnucash reports");
+
+    gnc_report_init ();
+    gnc_prefs_init ();
+    qof_event_suspend ();
+
+    int failures = 0;
+    auto guids = report_batch_guids (report_batch_names (args->batch_file), failures);
+    if (guids.empty())
+    {
+        std::cerr << bl::translate ("No reports to run") << "\n";
+        scm_cleanup_and_exit_with_failure (nullptr);
+    }
+
+    auto output_dir = args->output_dir.empty() ? std::string{"."} : args->output_dir;
+    if (g_mkdir_with_parents (output_dir.c_str(), 0755) != 0)
+    {
+        std::cerr << bl::format (bl::translate ("Failed to create directory {1}"))
+                     % output_dir << "\n";
+        scm_cleanup_and_exit_with_failure (nullptr);
+    }
+
+    auto datafile = args->file_to_load.c_str();
+    PINFO ("Loading datafile %s...\n", datafile);
+
+    auto session = gnc_get_current_session ();
+    if (!session)
+        scm_cleanup_and_exit_with_failure (session);
+
+    qof_session_begin (session, datafile, SESSION_READ_ONLY);
+    if (qof_session_get_error (session) != ERR_BACKEND_NO_ERR)
+        scm_cleanup_and_exit_with_failure (session);
+
+    qof_session_load (session, report_session_percentage);
+    if (qof_session_get_error (session) != ERR_BACKEND_NO_ERR)
+        scm_cleanup_and_exit_with_failure (session);
+
+    auto start = std::chrono::steady_clock::now();
+    auto jobs = std::min<size_t> (args->jobs, guids.size());
+
+#ifndef __MINGW32__
+    if (jobs > 1)
+    {
+        /* The workers are forked now that the book is loaded, so they all
+         * share it copy-on-write. Guile's primitive-fork takes care of
+         * guile's own threads. */
+        auto fork_cmd = scm_c_eval_string ("primitive-fork");
+        std::vector<pid_t> workers;
+        for (size_t worker = 0; worker < jobs; worker++)
+        {
+            std::cout.flush();
+            auto pid = scm_to_int (scm_call_0 (fork_cmd));
+            if (pid == 0)
+            {
+                auto failed = run_report_batch_part (guids, output_dir, worker, jobs);
+                std::cout.flush();
+                std::cerr.flush();
+                _exit (failed ? 1 : 0);
+            }
+            workers.push_back (pid);
+        }
+        for (auto pid : workers)
+        {
+            int status;
+            if (waitpid (pid, &status, 0) < 0 || !WIFEXITED (status) ||
+                WEXITSTATUS (status) != 0)
+                failures++;
+        }
+    }
+    else
+#endif
+        failures += run_report_batch_part (guids, output_dir, 0, 1);
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << bl::format (bl::translate ("Ran {1} reports in {2} seconds using {3} processes."))
+                 % guids.size() % elapsed.count() % jobs << "\n";
+
+    if (failures)
+    {
+        std::cerr << bl::translate ("Some reports failed to run.") << "\n";
+        scm_cleanup_and_exit_with_failure (session);
+    }
+
+    qof_session_destroy (session);
+
+    qof_event_resume ();
+    gnc_shutdown (0);
+    return;
+}
+
+
 struct show_report_args {
     const std::string& file_to_load;
     const std::string& show_report;
@@ -341,6 +574,84 @@ scm_report_list ([[maybe_unused]] void *data,
     return;
 }
 
+struct run_import_args {
+    const std::string& file_to_load;
+    const std::string& import_type;
+    const std::string& import_file;
+    const std::string& preset;
+};
+
+static void
+scm_run_import (void *data,
+                [[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    auto args = static_cast<run_import_args*>(data);
+
+    scm_c_eval_string("(debug-set! stack 200000)");
+    scm_c_use_module ("gnucash app-utils");
+
+    gnc_prefs_init ();
+    qof_event_suspend ();
+
+    auto datafile = args->file_to_load.c_str();
+    PINFO ("Loading datafile %s...\n", datafile);
+
+    auto session = gnc_get_current_session ();
+    if (!session)
+        scm_cleanup_and_exit_with_failure (session);
+
+    qof_session_begin (session, datafile, SESSION_NORMAL_OPEN);
+    if (qof_session_get_error (session) != ERR_BACKEND_NO_ERR)
+        scm_cleanup_and_exit_with_failure (session);
+
+    qof_session_load (session, report_session_percentage);
+    if (qof_session_get_error (session) != ERR_BACKEND_NO_ERR)
+        scm_cleanup_and_exit_with_failure (session);
+
+    /* The import presets are stored in the datafile's state file */
+    gnc_state_load (session);
+
+    auto counts = GncImportBatchCounts();
+    auto start = std::chrono::steady_clock::now();
+    try
+    {
+        if (args->import_type == "transactions")
+            gnc_import_batch_transactions (args->import_file, args->preset, counts);
+        else
+            gnc_import_batch_prices (args->import_file, args->preset, counts);
+    }
+    catch (const std::exception& err)
+    {
+        std::cerr << bl::format (bl::translate ("Failed to import {1}:\n{2}"))
+                     % args->import_file % err.what() << "\n";
+        scm_cleanup_and_exit_with_failure (session);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    qof_session_save (session, nullptr);
+    if (qof_session_get_error (session) != ERR_BACKEND_NO_ERR)
+        scm_cleanup_and_exit_with_failure (session);
+
+    if (args->import_type == "transactions")
+        std::cout << bl::format (bl::translate ("Imported {1} transactions in {2} seconds. "
+                                                "{3} were balanced from the import map, "
+                                                "{4} were left unbalanced."))
+                     % counts.imported % elapsed.count() % counts.matched % counts.unbalanced
+                  << "\n";
+    else
+        std::cout << bl::format (bl::translate ("Imported {1} prices in {2} seconds. "
+                                                "{3} replaced an existing price, "
+                                                "{4} duplicates were skipped."))
+                     % counts.imported % elapsed.count() % counts.replaced % counts.duplicated
+                  << "\n";
+
+    qof_session_destroy (session);
+
+    qof_event_resume ();
+    gnc_shutdown (0);
+    return;
+}
+
 int
 Gnucash::add_quotes (const bo_str& uri)
 {
@@ -366,6 +677,27 @@ Gnucash::run_report (const bo_str& file_to_load,
     return 0;
 }
 
+int
+Gnucash::run_report_batch (const bo_str& file_to_load,
+                           const bo_str& batch_file,
+                           const bo_str& output_dir,
+                           int jobs)
+{
+    if (jobs < 1)
+    {
+        std::cerr << bl::translate ("The number of jobs must be at least 1") << "\n";
+        return 1;
+    }
+
+    auto args = run_report_batch_args { file_to_load ? *file_to_load : empty_string,
+                                        batch_file ? *batch_file : empty_string,
+                                        output_dir ? *output_dir : empty_string,
+                                        jobs };
+    scm_boot_guile (0, nullptr, scm_run_report_batch, &args);
+
+    return 0;
+}
+
 int
 Gnucash::report_show (const bo_str& file_to_load,
                       const bo_str& show_report)
@@ -384,3 +716,19 @@ Gnucash::report_list (void)
     scm_boot_guile (0, nullptr, scm_report_list, NULL);
     return 0;
 }
+
+int
+Gnucash::run_import (const bo_str& file_to_load,
+                     const bo_str& import_type,
+                     const bo_str& import_file,
+                     const bo_str& preset)
+{
+    auto args = run_import_args { file_to_load ? *file_to_load : empty_string,
+                                  import_type ? *import_type : empty_string,
+                                  import_file ? *import_file : empty_string,
+                                  preset ? *preset : empty_string };
+    if (import_file && !import_file->empty())
+        scm_boot_guile (0, nullptr, scm_run_import, &args);
+
+    return 0;
+}
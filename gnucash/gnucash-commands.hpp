@@ -37,8 +37,16 @@ namespace Gnucash {
                     const bo_str& run_report,
                     const bo_str& export_type,
                     const bo_str& output_file);
+    int run_report_batch (const bo_str& file_to_load,
+                          const bo_str& batch_file,
+                          const bo_str& output_dir,
+                          int jobs);
     int report_list (void);
     int report_show (const bo_str& file_to_load,
                      const bo_str& run_report);
+    int run_import (const bo_str& file_to_load,
+                    const bo_str& import_type,
+                    const bo_str& import_file,
+                    const bo_str& preset);
 }
 #endif
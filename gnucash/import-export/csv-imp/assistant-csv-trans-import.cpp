@@ -77,6 +77,7 @@ extern "C"
 namespace bl = boost::locale;
 
 #define MIN_COL_WIDTH 70
+#define PREVIEW_MAX_ROWS 1000
 #define GNC_PREFS_GROUP "dialogs.import.csv"
 #define ASSISTANT_CSV_IMPORT_TRANS_CM_CLASS "assistant-csv-trans-import"
 
@@ -1545,9 +1546,16 @@ void CsvImpTransAssist::preview_refresh_table ()
     auto store = gtk_list_store_newv (ncols, model_col_types);
     g_free (model_col_types);
 
-    /* Fill the data liststore with data from importer object. */
-    for (auto parse_line : tx_imp->m_parsed_lines)
+    /* Fill the data liststore with data from importer object. To keep large
+     * files manageable only the first PREVIEW_MAX_ROWS lines are shown,
+     * followed by any later line that still has errors to correct. */
+    uint32_t row = 0;
+    for (auto& parse_line : tx_imp->m_parsed_lines)
     {
+        if ((row++ >= PREVIEW_MAX_ROWS) &&
+            (std::get<PL_SKIP>(parse_line) || std::get<PL_ERROR>(parse_line).empty()))
+            continue;
+
         /* Fill the state cells */
         GtkTreeIter iter;
         gtk_list_store_append (store, &iter);
@@ -1753,6 +1761,44 @@ void CsvImpTransAssist::acct_match_set_accounts ()
 }
 
 
+/* Matches the account strings in the account match view to the
+ * accounts they were mapped to in earlier imports.
+ *
+ * @param mappings_store The model of the account match view
+ */
+static void
+csv_tximp_acct_match_load_mappings (GtkTreeModel *mappings_store)
+{
+    // Set iter to first entry of store
+    GtkTreeIter iter;
+    auto valid = gtk_tree_model_get_iter_first (mappings_store, &iter);
+
+    // Walk through the store trying to match to a map
+    while (valid)
+    {
+        Account *account = nullptr;
+        gchar   *map_string;
+
+        // Walk through the list, reading each row
+        gtk_tree_model_get (mappings_store, &iter, MAPPING_STRING, &map_string, MAPPING_ACCOUNT, &account, -1);
+
+        if (!account) // if account is NULL, store has not been updated
+            account = gnc_csv_account_map_search (map_string); //search the account list for the map_string
+
+        if (account)
+        {
+            auto fullpath = gnc_account_get_full_name (account);
+            gtk_list_store_set (GTK_LIST_STORE(mappings_store), &iter, MAPPING_FULLPATH, fullpath,
+                                MAPPING_ACCOUNT, account, -1);
+            g_free (fullpath);
+        }
+
+        g_free (map_string);
+        valid = gtk_tree_model_iter_next (mappings_store, &iter);
+    }
+}
+
+
 static bool
 csv_tximp_acct_match_check_all (GtkTreeModel *model)
 {
@@ -1967,7 +2013,7 @@ CsvImpTransAssist::assist_account_match_page_prepare ()
 
     // Match the account strings to the mappings
     auto store = gtk_tree_view_get_model (GTK_TREE_VIEW(account_match_view));
-    gnc_csv_account_map_load_mappings (store);
+    csv_tximp_acct_match_load_mappings (store);
 
     auto text = std::string ("<span size=\"medium\" color=\"red\"><b>");
     text += _("To change mapping, double click on a row or select a row and press the button...");
@@ -26,7 +26,7 @@
 */
 #include <config.h>
 
-#include <gtk/gtk.h>
+#include <glib.h>
 #include <glib/gi18n.h>
 
 #include "qof.h"
@@ -94,52 +94,6 @@ Account * gnc_csv_account_map_search (const gchar *map_string)
 }
 
 
-/**************************************************
- * gnc_csv_account_map_load_mappings
- *
- * load the existing mappings
- **************************************************/
-void
-gnc_csv_account_map_load_mappings (GtkTreeModel *mappings_store)
-{
-    GtkTreeIter iter;
-    gboolean    valid;
-
-    // Set iter to first entry of store
-    valid = gtk_tree_model_get_iter_first (mappings_store, &iter);
-
-    // Walk through the store trying to match to a map
-    while (valid)
-    {
-        Account *account = NULL;
-        gchar   *map_string;
-        gchar   *fullpath;
-
-        // Walk through the list, reading each row
-        gtk_tree_model_get (GTK_TREE_MODEL(mappings_store), &iter, MAPPING_STRING, &map_string, MAPPING_ACCOUNT, &account, -1);
-
-        if (account == NULL) // if account is NULL, store has not been updated
-        {
-            account = gnc_csv_account_map_search (map_string); //search the account list for the map_string
-
-            if (account == NULL) // account still NULL, we have no map
-            {
-                g_free (map_string);
-                valid = gtk_tree_model_iter_next (mappings_store, &iter);
-                continue;
-            }
-        }
-        fullpath = gnc_account_get_full_name (account);
-        gtk_list_store_set (GTK_LIST_STORE(mappings_store), &iter, MAPPING_FULLPATH, fullpath, -1);
-        gtk_list_store_set (GTK_LIST_STORE(mappings_store), &iter, MAPPING_ACCOUNT, account, -1);
-        g_free (fullpath);
-
-        g_free (map_string);
-        valid = gtk_tree_model_iter_next (mappings_store, &iter);
-    }
-}
-
-
 /**************************************************
  * gnc_csv_account_map_change_mappings
  *
@@ -27,17 +27,12 @@
 #ifndef GNC_CSV_ACCOUNT_MAP_H
 #define GNC_CSV_ACCOUNT_MAP_H
 
-#include <gtk/gtk.h>
+#include <glib.h>
 #include "Account.h"
 
 /** Enumeration for the mappings liststore */
 enum GncImportColumn {MAPPING_STRING, MAPPING_FULLPATH, MAPPING_ACCOUNT};
 
-/** Load the import mappings.
- *
- */
-void gnc_csv_account_map_load_mappings (GtkTreeModel *mappings_store);
-
 /** Update the import mappings.
  *
  */
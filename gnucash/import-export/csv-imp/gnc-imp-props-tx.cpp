@@ -316,6 +316,50 @@ void GncPreTrans::reset (GncTransPropType prop_type)
     }
 }
 
+void GncPreTrans::copy_prop (GncTransPropType prop_type, const GncPreTrans& other)
+{
+    m_errors.erase(prop_type);
+    auto error = other.m_errors.find (prop_type);
+    if (error != other.m_errors.end())
+        m_errors.emplace(prop_type, error->second);
+
+    switch (prop_type)
+    {
+        case GncTransPropType::UNIQUE_ID:
+            m_differ = other.m_differ;
+            break;
+
+        case GncTransPropType::DATE:
+            m_date = other.m_date;
+            break;
+
+        case GncTransPropType::NUM:
+            m_num = other.m_num;
+            break;
+
+        case GncTransPropType::DESCRIPTION:
+            m_desc = other.m_desc;
+            break;
+
+        case GncTransPropType::NOTES:
+            m_notes = other.m_notes;
+            break;
+
+        case GncTransPropType::COMMODITY:
+            m_commodity = other.m_commodity;
+            break;
+
+        case GncTransPropType::VOID_REASON:
+            m_void_reason = other.m_void_reason;
+            break;
+
+        default:
+            /* Issue a warning for all other prop_types. */
+            PWARN ("%d is an invalid property for a transaction", static_cast<int>(prop_type));
+            break;
+    }
+}
+
 std::string GncPreTrans::verify_essentials (void)
 {
     /* Make sure this transaction has the minimum required set of properties defined */
@@ -115,6 +115,10 @@ public:
     void set (GncTransPropType prop_type, const std::string& value);
     void set_date_format (int date_format) { m_date_format = date_format ;}
     void reset (GncTransPropType prop_type);
+    /** Copy a single property, and the error for it if any, from another
+     *  instance. This allows values to be parsed ahead of time, possibly
+     *  in another thread, and applied later on. */
+    void copy_prop (GncTransPropType prop_type, const GncPreTrans& other);
     std::string verify_essentials (void);
     Transaction *create_trans (QofBook* book, gnc_commodity* currency);
 
@@ -33,7 +33,7 @@ extern "C"
 {
 #include <config.h>
 
-#include <gtk/gtk.h>
+#include <glib.h>
 #include <glib/gi18n.h>
 
 #include "Account.h"
@@ -0,0 +1,76 @@
+/********************************************************************\
+ * gnc-import-batch.hpp - non-interactive csv imports               *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+
+/** @file
+     @brief Functions to run a csv import without user interaction
+     *
+     gnc-import-batch.hpp
+ */
+
+#ifndef GNC_IMPORT_BATCH_HPP
+#define GNC_IMPORT_BATCH_HPP
+
+#include <cstddef>
+#include <string>
+
+/** Counts reported by a batch import. */
+struct GncImportBatchCounts
+{
+    size_t imported = 0;    /**< Transactions or prices added to the book */
+    size_t matched = 0;     /**< Transactions balanced from the import map */
+    size_t unbalanced = 0;  /**< Transactions no account was found for */
+    size_t replaced = 0;    /**< Prices that replaced an existing one */
+    size_t duplicated = 0;  /**< Prices skipped as they already existed */
+};
+
+/** Imports the transactions in filename into the current book using the
+ *  saved transaction import settings named preset_name. Unbalanced
+ *  transactions are balanced with the account found in the bayesian
+ *  import map of their account, like the generic importer does.
+ *  Transactions are committed in batches with xaccTransCommitBulk(),
+ *  which delivers each batch's events together, while the file is still
+ *  being read. If reading fails part way, the transactions of the batch
+ *  being filled are dropped but earlier batches stay in the book.
+ *  @param filename the csv or fixed width file to import
+ *  @param preset_name the name of the saved import settings to use
+ *  @param counts is filled in with the outcome of the import
+ *  @exception std::invalid_argument if the settings can't be found or
+ *             the file doesn't match them
+ *  @exception std::ifstream::failure if the file can't be read
+ */
+void gnc_import_batch_transactions (const std::string& filename,
+                                    const std::string& preset_name,
+                                    GncImportBatchCounts& counts);
+
+/** Imports the prices in filename into the current book's price
+ *  database using the saved price import settings named preset_name.
+ *  @param filename the csv or fixed width file to import
+ *  @param preset_name the name of the saved import settings to use
+ *  @param counts is filled in with the outcome of the import
+ *  @exception std::invalid_argument if the settings can't be found or
+ *             the file doesn't match them
+ *  @exception std::ifstream::failure if the file can't be read
+ */
+void gnc_import_batch_prices (const std::string& filename,
+                              const std::string& preset_name,
+                              GncImportBatchCounts& counts);
+
+#endif
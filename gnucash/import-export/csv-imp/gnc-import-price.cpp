@@ -36,6 +36,7 @@ extern "C" {
 }
 
 #include <algorithm>
+#include <chrono>
 #include <exception>
 #include <iostream>
 #include <memory>
@@ -48,6 +49,7 @@ extern "C" {
 #include <boost/optional.hpp>
 
 #include "gnc-import-price.hpp"
+#include "gnc-import-batch.hpp"
 #include "gnc-imp-props-price.hpp"
 #include "gnc-tokenizer-csv.hpp"
 #include "gnc-tokenizer-fw.hpp"
@@ -554,7 +556,8 @@ static void price_properties_verify_essentials (std::vector<parse_line_t>::itera
         throw std::invalid_argument(error_message);
 }
 
-void GncPriceImport::create_price (std::vector<parse_line_t>::iterator& parsed_line)
+void GncPriceImport::create_price (std::vector<parse_line_t>::iterator& parsed_line,
+                                   GList*& prices)
 {
     StrVec line;
     std::string error_message;
@@ -606,17 +609,11 @@ void GncPriceImport::create_price (std::vector<parse_line_t>::iterator& parsed_l
     {
         price_properties_verify_essentials (parsed_line);
 
-        QofBook* book = gnc_get_current_book();
-        GNCPriceDB *pdb = gnc_pricedb_get_db (book);
-
         /* If all went well, add this price to the list. */
-        auto price_created = price_props->create_price (book, pdb, m_over_write);
-        if (price_created == ADDED)
-            m_prices_added++;
-        else if (price_created == DUPLICATED)
-            m_prices_duplicated++;
-        else if (price_created == REPLACED)
-            m_prices_replaced++;
+        auto price = price_props->create_price (gnc_get_current_book());
+        if (!price)
+            throw std::invalid_argument (_("Failed to create price from selected columns."));
+        prices = g_list_prepend (prices, price);
     }
     catch (const std::invalid_argument& e)
     {
@@ -643,6 +640,9 @@ void GncPriceImport::create_prices ()
     m_prices_duplicated = 0;
     m_prices_replaced = 0;
 
+    auto start = std::chrono::steady_clock::now();
+    GList *prices = nullptr;
+
     /* Iterate over all parsed lines */
     for (auto parsed_lines_it = m_parsed_lines.begin();
             parsed_lines_it != m_parsed_lines.end();
@@ -653,10 +653,41 @@ void GncPriceImport::create_prices ()
             continue;
 
         /* Should not throw anymore, otherwise verify needs revision */
-        create_price (parsed_lines_it);
+        create_price (parsed_lines_it, prices);
     }
-    PINFO("Number of lines is %d, added %d, duplicated %d, replaced %d",
-         (int)m_parsed_lines.size(), m_prices_added, m_prices_duplicated, m_prices_replaced);
+    prices = g_list_reverse (prices);
+
+    /* Add all prices in one go. Later lines for the same day take
+     * precedence over earlier ones when over writing, like they did
+     * when the prices were added one at a time. */
+    auto pdb = gnc_pricedb_get_db (gnc_get_current_book());
+    PriceAddCounts counts;
+    gnc_pricedb_add_prices (pdb, prices,
+                            m_over_write ? PRICE_ADD_REPLACE : PRICE_ADD_KEEP_EXISTING,
+                            &counts);
+    g_list_free_full (prices, (GDestroyNotify)gnc_price_unref);
+
+    /* Count per line, as adding the prices one at a time did: the first
+     * line of a day is added or replaces a price already in the book,
+     * every later line of that day replaces the one before it when over
+     * writing or is a duplicate otherwise. The pricedb counts a price
+     * replaced by a later line of this file as skipped instead. */
+    m_prices_added = counts.added - counts.replaced;
+    if (m_over_write)
+    {
+        m_prices_duplicated = 0;
+        m_prices_replaced = counts.replaced + counts.skipped;
+    }
+    else
+    {
+        m_prices_duplicated = counts.skipped;
+        m_prices_replaced = 0;
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    PINFO("Number of lines is %d, added %d, duplicated %d, replaced %d in %.3fs (%.0f rows/s)",
+         (int)m_parsed_lines.size(), m_prices_added, m_prices_duplicated, m_prices_replaced,
+         elapsed.count(), elapsed.count() > 0 ? m_parsed_lines.size() / elapsed.count() : 0.0);
 }
 
 bool
@@ -785,3 +816,41 @@ std::vector<GncPricePropType> GncPriceImport::column_types_price ()
     return m_settings.m_column_types_price;
 }
 
+
+void
+gnc_import_batch_prices (const std::string& filename,
+                         const std::string& preset_name,
+                         GncImportBatchCounts& counts)
+{
+    auto& presets = get_import_presets_price();
+    auto preset_it = std::find_if (presets.begin(), presets.end(),
+                                   [&preset_name](const std::shared_ptr<CsvPriceImpSettings>& preset)
+                                   { return preset->m_name == preset_name; });
+    if (preset_it == presets.end())
+    {
+        auto msg = g_strdup_printf (_("No saved import settings named \"%s\" were found."),
+                                    preset_name.c_str());
+        auto err_str = std::string (msg);
+        g_free (msg);
+        throw std::invalid_argument (err_str);
+    }
+    if ((*preset_it)->m_load_error)
+        PWARN ("There were problems reading import settings \"%s\", continuing to load.",
+               preset_name.c_str());
+
+    GncPriceImport price_imp;
+    price_imp.load_file (filename);
+    price_imp.tokenize (true);
+    price_imp.settings (**preset_it);
+
+    /* Applying settings only restores the column types, parse them now */
+    auto column_types = price_imp.column_types_price();
+    for (uint32_t col = 0; col < column_types.size(); col++)
+        price_imp.set_column_type_price (col, column_types[col], true);
+
+    price_imp.create_prices ();
+
+    counts.imported = price_imp.m_prices_added + price_imp.m_prices_replaced;
+    counts.replaced = price_imp.m_prices_replaced;
+    counts.duplicated = price_imp.m_prices_duplicated;
+}
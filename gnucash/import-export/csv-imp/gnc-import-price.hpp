@@ -150,9 +150,10 @@ public:
 private:
     /** A helper function used by create_prices. It will attempt
      *  to convert a single tokenized line into a price using
-     *  the column types the user has set.
+     *  the column types the user has set and prepend it to prices.
      */
-    void create_price (std::vector<parse_line_t>::iterator& parsed_line);
+    void create_price (std::vector<parse_line_t>::iterator& parsed_line,
+                       GList*& prices);
 
     void verify_column_selections (ErrorListPrice& error_msg);
 
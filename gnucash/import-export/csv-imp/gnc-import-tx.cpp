@@ -30,13 +30,18 @@ extern "C" {
 #endif
 
 #include <glib/gi18n.h>
+#include <gnc-locale-utils.h>
 }
 
 #include <algorithm>
+#include <atomic>
+#include <deque>
 #include <exception>
+#include <functional>
 #include <iostream>
 #include <memory>
 #include <string>
+#include <set>
 #include <tuple>
 #include <utility>
 #include <vector>
@@ -45,6 +50,7 @@ extern "C" {
 #include <boost/regex/icu.hpp>
 
 #include "gnc-import-tx.hpp"
+#include "gnc-import-batch.hpp"
 #include "gnc-imp-props-tx.hpp"
 #include "gnc-tokenizer-csv.hpp"
 #include "gnc-tokenizer-fw.hpp"
@@ -52,6 +58,67 @@ extern "C" {
 
 G_GNUC_UNUSED static QofLogModule log_module = GNC_MOD_IMPORT;
 
+/* Column updates parse the lines in blocks of this size, which bounds the
+ * memory held by values parsed ahead on worker threads. */
+static constexpr size_t parse_block_size = 8192;
+/* Worker threads claim lines in chunks of this size */
+static constexpr size_t parse_chunk_size = 128;
+/* Below this many lines starting threads isn't worth it */
+static constexpr size_t parse_min_parallel = 1024;
+static constexpr guint parse_max_threads = 8;
+
+struct ParseJob
+{
+    const std::function<void(size_t)>& func;
+    std::atomic<size_t> next;
+    size_t end;
+};
+
+static gpointer
+parse_worker (gpointer data)
+{
+    auto job = static_cast<ParseJob*>(data);
+    while (true)
+    {
+        auto start = job->next.fetch_add (parse_chunk_size);
+        if (start >= job->end)
+            break;
+        auto stop = std::min (start + parse_chunk_size, job->end);
+        for (auto row = start; row < stop; row++)
+            job->func (row);
+    }
+    return nullptr;
+}
+
+/* Calls func for each line in [begin, end), using up to max_threads
+ * threads (0 for one per processor) if there are enough lines. func must
+ * only modify the line it's passed and must not throw. */
+static void
+parse_lines_parallel (size_t begin, size_t end, guint max_threads,
+                      const std::function<void(size_t)>& func)
+{
+    auto n_threads = std::min (max_threads ? max_threads : g_get_num_processors (),
+                               parse_max_threads);
+    if ((end - begin < parse_min_parallel) || (n_threads < 2))
+    {
+        for (auto row = begin; row < end; row++)
+            func (row);
+        return;
+    }
+
+    /* The locale info used to parse amounts is set up on first use,
+     * make sure that has happened before the workers start. */
+    gnc_localeconv ();
+
+    ParseJob job {func, {begin}, end};
+    std::vector<GThread*> threads;
+    for (guint i = 1; i < n_threads; i++)
+        threads.push_back (g_thread_new ("csv-parse", parse_worker, &job));
+    parse_worker (&job);
+    for (auto thread : threads)
+        g_thread_join (thread);
+}
+
 const int num_currency_formats = 3;
 const gchar* currency_format_user[] = {N_("Locale"),
                                        N_("Period: 123,456.78"),
@@ -563,13 +630,13 @@ std::string GncTxImport::verify ()
  * @param parsed_line The line we are checking
  * @exception std::invalid_argument in an essential property is missing
  */
-static void trans_properties_verify_essentials (std::vector<parse_line_t>::iterator& parsed_line)
+static void trans_properties_verify_essentials (parse_line_t& parsed_line)
 {
     std::string error_message;
     std::shared_ptr<GncPreTrans> trans_props;
     std::shared_ptr<GncPreSplit> split_props;
 
-    std::tie(std::ignore, error_message, trans_props, split_props, std::ignore) = *parsed_line;
+    std::tie(std::ignore, error_message, trans_props, split_props, std::ignore) = parsed_line;
 
     auto trans_error = trans_props->verify_essentials();
     auto split_error = split_props->verify_essentials();
@@ -594,13 +661,13 @@ static void trans_properties_verify_essentials (std::vector<parse_line_t>::itera
  * @param parsed_line The current line being parsed
  * @return On success, a shared pointer to a DraftTransaction object; on failure a nullptr
  */
-std::shared_ptr<DraftTransaction> GncTxImport::trans_properties_to_trans (std::vector<parse_line_t>::iterator& parsed_line)
+std::shared_ptr<DraftTransaction> GncTxImport::trans_properties_to_trans (parse_line_t& parsed_line)
 {
     auto created_trans = false;
     std::string error_message;
     std::shared_ptr<GncPreTrans> trans_props;
     std::shared_ptr<GncPreSplit> split_props;
-    std::tie(std::ignore, error_message, trans_props, split_props, std::ignore) = *parsed_line;
+    std::tie(std::ignore, error_message, trans_props, split_props, std::ignore) = parsed_line;
     auto account = split_props->get_account();
 
     QofBook* book = gnc_account_get_book (account);
@@ -644,14 +711,14 @@ std::shared_ptr<DraftTransaction> GncTxImport::trans_properties_to_trans (std::v
     return created_trans ? m_current_draft : nullptr;
 }
 
-void GncTxImport::create_transaction (std::vector<parse_line_t>::iterator& parsed_line)
+void GncTxImport::create_transaction (parse_line_t& parsed_line)
 {
     StrVec line;
     std::string error_message;
     std::shared_ptr<GncPreTrans> trans_props = nullptr;
     std::shared_ptr<GncPreSplit> split_props = nullptr;
     bool skip_line = false;
-    std::tie(line, error_message, trans_props, split_props, skip_line) = *parsed_line;
+    std::tie(line, error_message, trans_props, split_props, skip_line) = parsed_line;
 
     if (skip_line)
         return;
@@ -725,7 +792,120 @@ void GncTxImport::create_transactions ()
             continue;
 
         /* Should not throw anymore, otherwise verify needs revision */
-        create_transaction (parsed_lines_it);
+        create_transaction (*parsed_lines_it);
+    }
+}
+
+/** Creates a list of transactions straight from an import file, without
+ * loading and tokenizing the whole file first. Each row is parsed into its
+ * GncPreTrans and GncPreSplit objects as it is read and handed to
+ * create_transaction right away, after which it is dropped. Only the last
+ * skip_end_lines() rows are held back until the end of the file is known.
+ * As there's no user to correct them, a row with errors that is not
+ * skipped aborts the import, unless skip_err_lines() is set.
+ * All settings (file format, separators or column widths, column types,
+ * accounts,...) must be set before calling this function.
+ * Without a sink, all draft transactions end up in m_transactions as with
+ * create_transactions. With a sink, a draft is passed on as soon as the
+ * row starting the next transaction is read (or the file ends), so only
+ * the transaction being read is held on to.
+ * @param filename the file to import
+ * @param sink if set, receives each completed draft transaction
+ * @exception std::ifstream::failure if the file can't be read
+ * @exception std::invalid_argument if the column selections are
+ *            inconsistent or a row fails to parse
+ */
+void GncTxImport::create_transactions_streaming (const std::string& filename,
+                                                 DraftTransSink sink)
+{
+    auto error_msg = ErrorList();
+    verify_column_selections (error_msg);
+    if (!error_msg.empty())
+        throw std::invalid_argument (error_msg.str());
+
+    try
+    {
+        m_tokenizer->open_stream (filename);
+    }
+    catch (std::ifstream::failure& ios_err)
+    {
+        PWARN ("Error: %s", ios_err.what());
+        throw;
+    }
+
+    m_parsed_lines.clear();
+    m_transactions.clear();
+    m_parent = nullptr;
+    m_current_draft = nullptr;
+
+    auto pending = std::deque<parse_line_t>();
+    uint32_t row = 0;
+    StrVec tokens;
+    while (m_tokenizer->next_row (tokens))
+    {
+        /* Empty rows are dropped, as in tokenize */
+        if (tokens.empty())
+            continue;
+
+        auto skip = (row < skip_start_lines()) ||
+                    (((row - skip_start_lines()) % 2 == 1) && skip_alt_lines());
+        auto parsed_line = std::make_tuple (std::move(tokens), std::string(),
+                std::make_shared<GncPreTrans>(date_format()),
+                std::make_shared<GncPreSplit>(date_format(), currency_format()),
+                skip);
+        if (m_settings.m_base_account)
+            std::get<PL_PRESPLIT>(parsed_line)->set_account (m_settings.m_base_account);
+
+        /* Parse all rows, including skipped ones, in order, so multi-split
+         * transactions are grouped exactly as in the interactive import */
+        for (uint32_t col = 0; col < m_settings.m_column_types.size(); col++)
+        {
+            auto type = m_settings.m_column_types[col];
+            if ((type > GncTransPropType::NONE) && (type <= GncTransPropType::TRANS_PROPS))
+                update_pre_trans_props (parsed_line, col, type);
+            else if ((type > GncTransPropType::TRANS_PROPS) && (type <= GncTransPropType::SPLIT_PROPS))
+                update_pre_split_props (parsed_line, col, type);
+        }
+        update_line_errors (parsed_line);
+
+        pending.push_back (std::move (parsed_line));
+        tokens = StrVec();
+        row++;
+        if (pending.size() <= skip_end_lines())
+            continue;
+
+        auto& line = pending.front();
+        if (!std::get<PL_SKIP>(line) && !std::get<PL_ERROR>(line).empty())
+        {
+            if (!m_skip_errors)
+            {
+                auto msg = g_strdup_printf (_("Error on line %u:\n%s"),
+                        row - static_cast<uint32_t>(pending.size()) + 1,
+                        std::get<PL_ERROR>(line).c_str());
+                auto err_str = std::string (msg);
+                g_free (msg);
+                throw std::invalid_argument (err_str);
+            }
+            std::get<PL_SKIP>(line) = true;
+        }
+
+        auto prev_draft = m_current_draft;
+        create_transaction (line);
+        pending.pop_front();
+        if (sink)
+        {
+            /* m_current_draft holds on to the transaction being read. Once
+             * another one is started, the previous one is complete. */
+            m_transactions.clear();
+            if (prev_draft && prev_draft != m_current_draft)
+                sink (std::move (prev_draft));
+        }
+    }
+
+    if (sink && m_current_draft)
+    {
+        sink (std::move (m_current_draft));
+        m_current_draft = nullptr;
     }
 }
 
@@ -738,40 +918,53 @@ GncTxImport::check_for_column_type (GncTransPropType type)
                         != m_settings.m_column_types.end());
 }
 
-/* A helper function intended to be called only from set_column_type */
-void GncTxImport::update_pre_trans_props (uint32_t row, uint32_t col, GncTransPropType prop_type)
+/* Parses the value in column col of parsed_line as prop_type into trans_props. */
+static void parse_pre_trans_prop (GncPreTrans& trans_props, const parse_line_t& parsed_line,
+                                  uint32_t col, GncTransPropType prop_type)
 {
-    if ((prop_type == GncTransPropType::NONE) || (prop_type > GncTransPropType::TRANS_PROPS))
-        return; /* Only deal with transaction related properties. */
-
-    /* Deliberately make a copy of the GncPreTrans. It may be the original one was shared
-     * with a previous line and should no longer be after the transprop is changed. */
-    auto trans_props = std::make_shared<GncPreTrans> (*(std::get<PL_PRETRANS>(m_parsed_lines[row])).get());
     auto value = std::string();
 
-    if (col < std::get<PL_INPUT>(m_parsed_lines[row]).size())
-        value = std::get<PL_INPUT>(m_parsed_lines[row]).at(col);
+    if (col < std::get<PL_INPUT>(parsed_line).size())
+        value = std::get<PL_INPUT>(parsed_line).at(col);
 
     if (value.empty())
-        trans_props->reset (prop_type);
+        trans_props.reset (prop_type);
     else
     {
         try
         {
-            trans_props->set(prop_type, value);
+            trans_props.set(prop_type, value);
         }
         catch (const std::exception& e)
         {
             /* Do nothing, just prevent the exception from escalating up
              * However log the error if it happens on a row that's not skipped
              */
-            if (!std::get<PL_SKIP>(m_parsed_lines[row]))
+            if (!std::get<PL_SKIP>(parsed_line))
                 PINFO("User warning: %s", e.what());
         }
     }
+}
+
+/* A helper function intended to be called only from set_column_type.
+ * If parsed is set, the property's value is taken from there instead
+ * of being parsed from column col. */
+void GncTxImport::update_pre_trans_props (parse_line_t& parsed_line, uint32_t col, GncTransPropType prop_type,
+                                          const GncPreTrans* parsed)
+{
+    if ((prop_type == GncTransPropType::NONE) || (prop_type > GncTransPropType::TRANS_PROPS))
+        return; /* Only deal with transaction related properties. */
+
+    /* Deliberately make a copy of the GncPreTrans. It may be the original one was shared
+     * with a previous line and should no longer be after the transprop is changed. */
+    auto trans_props = std::make_shared<GncPreTrans> (*(std::get<PL_PRETRANS>(parsed_line)).get());
+    if (parsed)
+        trans_props->copy_prop (prop_type, *parsed);
+    else
+        parse_pre_trans_prop (*trans_props, parsed_line, col, prop_type);
 
     /* Store the result */
-    std::get<PL_PRETRANS>(m_parsed_lines[row]) = trans_props;
+    std::get<PL_PRETRANS>(parsed_line) = trans_props;
 
     /* For multi-split input data, we need to check whether this line is part of
      * a transaction that has already been started by a previous line. */
@@ -782,7 +975,7 @@ void GncTxImport::update_pre_trans_props (uint32_t row, uint32_t col, GncTransPr
             /* This line is part of an already started transaction
              * continue with that one instead to make sure the split from this line
              * gets added to the proper transaction */
-            std::get<PL_PRETRANS>(m_parsed_lines[row]) = m_parent;
+            std::get<PL_PRETRANS>(parsed_line) = m_parent;
         }
         else
         {
@@ -794,12 +987,12 @@ void GncTxImport::update_pre_trans_props (uint32_t row, uint32_t col, GncTransPr
 }
 
 /* A helper function intended to be called only from set_column_type */
-void GncTxImport::update_pre_split_props (uint32_t row, uint32_t col, GncTransPropType prop_type)
+void GncTxImport::update_pre_split_props (parse_line_t& parsed_line, uint32_t col, GncTransPropType prop_type)
 {
     if ((prop_type > GncTransPropType::SPLIT_PROPS) || (prop_type <= GncTransPropType::TRANS_PROPS))
         return; /* Only deal with split related properties. */
 
-    auto split_props = std::get<PL_PRESPLIT>(m_parsed_lines[row]);
+    auto split_props = std::get<PL_PRESPLIT>(parsed_line);
 
     split_props->reset (prop_type);
     try
@@ -809,7 +1002,7 @@ void GncTxImport::update_pre_split_props (uint32_t row, uint32_t col, GncTransPr
         if ((prop_type != GncTransPropType::DEPOSIT) &&
             (prop_type != GncTransPropType::WITHDRAWAL))
         {
-            auto value = std::get<PL_INPUT>(m_parsed_lines[row]).at(col);
+            auto value = std::get<PL_INPUT>(parsed_line).at(col);
             split_props->set(prop_type, value);
         }
         else
@@ -822,7 +1015,7 @@ void GncTxImport::update_pre_split_props (uint32_t row, uint32_t col, GncTransPr
                 if (*col_it == prop_type)
                 {
                     auto col_num = col_it - m_settings.m_column_types.cbegin();
-                    auto value = std::get<PL_INPUT>(m_parsed_lines[row]).at(col_num);
+                    auto value = std::get<PL_INPUT>(parsed_line).at(col_num);
                     split_props->add (prop_type, value);
                 }
             }
@@ -833,7 +1026,7 @@ void GncTxImport::update_pre_split_props (uint32_t row, uint32_t col, GncTransPr
         /* Do nothing, just prevent the exception from escalating up
             * However log the error if it happens on a row that's not skipped
             */
-        if (!std::get<PL_SKIP>(m_parsed_lines[row]))
+        if (!std::get<PL_SKIP>(parsed_line))
             PINFO("User warning: %s", e.what());
     }
 }
@@ -862,52 +1055,94 @@ GncTxImport::set_column_type (uint32_t position, GncTransPropType type, bool for
     if (type == GncTransPropType::ACCOUNT)
         base_account (nullptr);
 
-    /* Update the preparsed data */
+    /* Update the preparsed data. Parsing a value only depends on the line
+     * it's on, so that is spread over worker threads, one block of lines
+     * at a time. Properties that are looked up in the book (accounts and
+     * commodities) or that go through the expression parser (prices) are
+     * parsed serially though, as is grouping the lines of multi-split
+     * transactions, which depends on the order of the lines. */
+    auto is_trans_prop = [](GncTransPropType prop_type)
+        { return (prop_type > GncTransPropType::NONE) && (prop_type <= GncTransPropType::TRANS_PROPS); };
+    auto is_split_prop = [](GncTransPropType prop_type)
+        { return (prop_type > GncTransPropType::TRANS_PROPS) && (prop_type <= GncTransPropType::SPLIT_PROPS); };
+    auto in_parallel = [](GncTransPropType prop_type)
+        { return (prop_type != GncTransPropType::COMMODITY) &&
+                 (prop_type != GncTransPropType::ACCOUNT) &&
+                 (prop_type != GncTransPropType::TACCOUNT) &&
+                 (prop_type != GncTransPropType::PRICE); };
+    auto reset_old = (old_type != type);
+    auto t_start = g_get_monotonic_time ();
+
     m_parent = nullptr;
-    for (auto parsed_lines_it = m_parsed_lines.begin();
-            parsed_lines_it != m_parsed_lines.end();
-            ++parsed_lines_it)
+    for (size_t block = 0; block < m_parsed_lines.size(); block += parse_block_size)
     {
+        auto block_end = std::min (block + parse_block_size, m_parsed_lines.size());
+
         /* Reset date and currency formats for each trans/split props object
          * to ensure column updates use the most recent one
          */
-        std::get<PL_PRETRANS>(*parsed_lines_it)->set_date_format (m_settings.m_date_format);
-        std::get<PL_PRESPLIT>(*parsed_lines_it)->set_date_format (m_settings.m_date_format);
-        std::get<PL_PRESPLIT>(*parsed_lines_it)->set_currency_format (m_settings.m_currency_format);
+        for (auto row = block; row < block_end; row++)
+        {
+            std::get<PL_PRETRANS>(m_parsed_lines[row])->set_date_format (m_settings.m_date_format);
+            std::get<PL_PRESPLIT>(m_parsed_lines[row])->set_date_format (m_settings.m_date_format);
+            std::get<PL_PRESPLIT>(m_parsed_lines[row])->set_currency_format (m_settings.m_currency_format);
+        }
 
-        uint32_t row = parsed_lines_it - m_parsed_lines.begin();
+        auto parsed_trans = std::vector<GncPreTrans> ();
+        if (is_trans_prop (type) && in_parallel (type))
+            parsed_trans.assign (block_end - block, GncPreTrans (m_settings.m_date_format));
 
-        /* If the column type actually changed, first reset the property
-         * represented by the old column type
-         */
-        if (old_type != type)
+        parse_lines_parallel (block, block_end, m_parse_threads, [&](size_t row)
         {
-            auto old_col = std::get<PL_INPUT>(*parsed_lines_it).size(); // Deliberately out of bounds to trigger a reset!
-            if ((old_type > GncTransPropType::NONE)
-                    && (old_type <= GncTransPropType::TRANS_PROPS))
-                update_pre_trans_props (row, old_col, old_type);
-            else if ((old_type > GncTransPropType::TRANS_PROPS)
-                    && (old_type <= GncTransPropType::SPLIT_PROPS))
-                update_pre_split_props (row, old_col, old_type);
-        }
+            auto& parsed_line = m_parsed_lines[row];
+            if (reset_old && is_split_prop (old_type) && in_parallel (old_type))
+                update_pre_split_props (parsed_line, std::get<PL_INPUT>(parsed_line).size(), old_type);
+            if (is_split_prop (type) && in_parallel (type))
+                update_pre_split_props (parsed_line, position, type);
+            else if (!parsed_trans.empty())
+                parse_pre_trans_prop (parsed_trans[row - block], parsed_line, position, type);
+        });
+
+        for (auto row = block; row < block_end; row++)
+        {
+            auto& parsed_line = m_parsed_lines[row];
 
-        /* Then set the property represented by the new column type */
-        if ((type > GncTransPropType::NONE)
-                && (type <= GncTransPropType::TRANS_PROPS))
-            update_pre_trans_props (row, position, type);
-        else if ((type > GncTransPropType::TRANS_PROPS)
-                && (type <= GncTransPropType::SPLIT_PROPS))
-            update_pre_split_props (row, position, type);
+            /* If the column type actually changed, first reset the property
+             * represented by the old column type
+             */
+            if (reset_old)
+            {
+                auto old_col = std::get<PL_INPUT>(parsed_line).size(); // Deliberately out of bounds to trigger a reset!
+                if (is_trans_prop (old_type))
+                    update_pre_trans_props (parsed_line, old_col, old_type);
+                else if (is_split_prop (old_type) && !in_parallel (old_type))
+                    update_pre_split_props (parsed_line, old_col, old_type);
+            }
 
-        /* Report errors if there are any */
-        auto trans_errors = std::get<PL_PRETRANS>(*parsed_lines_it)->errors();
-        auto split_errors = std::get<PL_PRESPLIT>(*parsed_lines_it)->errors(m_req_mapped_accts);
-        std::get<PL_ERROR>(*parsed_lines_it) =
-                trans_errors +
-                (trans_errors.empty() && split_errors.empty() ? std::string() : "\n") +
-                split_errors;
+            /* Then set the property represented by the new column type */
+            if (is_trans_prop (type))
+                update_pre_trans_props (parsed_line, position, type,
+                        parsed_trans.empty() ? nullptr : &parsed_trans[row - block]);
+            else if (is_split_prop (type) && !in_parallel (type))
+                update_pre_split_props (parsed_line, position, type);
 
+            /* Report errors if there are any */
+            update_line_errors (parsed_line);
+        }
     }
+    PINFO ("Parsed column %u of %zu lines as %s in %" G_GINT64_FORMAT " ms",
+           position, m_parsed_lines.size(), gnc_csv_col_type_strs[type],
+           (g_get_monotonic_time () - t_start) / 1000);
+}
+
+void GncTxImport::update_line_errors (parse_line_t& parsed_line)
+{
+    auto trans_errors = std::get<PL_PRETRANS>(parsed_line)->errors();
+    auto split_errors = std::get<PL_PRESPLIT>(parsed_line)->errors(m_req_mapped_accts);
+    std::get<PL_ERROR>(parsed_line) =
+            trans_errors +
+            (trans_errors.empty() && split_errors.empty() ? std::string() : "\n") +
+            split_errors;
 }
 
 std::vector<GncTransPropType> GncTxImport::column_types ()
@@ -946,3 +1181,162 @@ GncTxImport::accounts ()
 
     return accts;
 }
+
+
+/* Number of transactions a batch import commits with each call to
+ * xaccTransCommitBulk, which sorts and rebalances the accounts once per
+ * call instead of for every transaction. */
+static constexpr size_t import_batch_size = 1000;
+
+/* Splits text on spaces into tokens for the bayesian import map. This
+ * mirrors the tokens the generic importer uses, so both find and train
+ * the same map entries. */
+static void
+import_batch_add_tokens (std::set<std::string>& tokens, const char* text)
+{
+    if (!text)
+        return;
+
+    auto str = std::string (text);
+    std::string::size_type start = 0;
+    while (start < str.size())
+    {
+        auto end = str.find (' ', start);
+        if (end == std::string::npos)
+            end = str.size();
+        if (end > start)
+            tokens.insert (str.substr (start, end - start));
+        start = end + 1;
+    }
+}
+
+/* Looks up the account to balance trans with in the bayesian import map
+ * of the account of its first split. */
+static Account*
+import_batch_find_destination (Transaction* trans)
+{
+    auto fsplit = xaccTransGetSplit (trans, 0);
+    auto acct = fsplit ? xaccSplitGetAccount (fsplit) : nullptr;
+    if (!acct)
+        return nullptr;
+
+    auto tokens = std::set<std::string>();
+    import_batch_add_tokens (tokens, xaccTransGetDescription (trans));
+
+    /* The day of week the transaction occurred on is a token as well */
+    auto transtime = xaccTransGetDate (trans);
+    auto tm_struct = gnc_gmtime (&transtime);
+    char local_day_of_week[16];
+    if (qof_strftime (local_day_of_week, sizeof (local_day_of_week), "%A", tm_struct))
+        tokens.insert (local_day_of_week);
+    gnc_tm_free (tm_struct);
+
+    for (auto node = xaccTransGetSplitList (trans); node; node = node->next)
+        import_batch_add_tokens (tokens, xaccSplitGetMemo (static_cast<Split*>(node->data)));
+
+    GList *token_list = nullptr;
+    for (const auto& token : tokens)
+        token_list = g_list_prepend (token_list, g_strdup (token.c_str()));
+
+    auto imap = gnc_account_imap_create_imap (acct);
+    auto dest = gnc_account_imap_find_account_bayes (imap, token_list);
+    g_free (imap);
+    g_list_free_full (token_list, g_free);
+
+    return dest;
+}
+
+/* Finishes a draft transaction the way the generic importer adds a new
+ * one: if it's unbalanced a split is added in the account found in the
+ * import map, and the imported split is marked cleared. The transaction
+ * is left open for xaccTransCommitBulk. */
+static void
+import_batch_finish_trans (Transaction* trans, GncImportBatchCounts& counts)
+{
+    auto imbalance = xaccTransGetImbalanceValue (trans);
+    if (!gnc_numeric_zero_p (imbalance))
+    {
+        /* Like the generic importer, assume the destination account
+         * is in the transaction's currency. */
+        auto dest = import_batch_find_destination (trans);
+        if (dest && gnc_commodity_equal (xaccAccountGetCommodity (dest),
+                                         xaccTransGetCurrency (trans)))
+        {
+            auto split = xaccMallocSplit (gnc_account_get_book (dest));
+            auto value = gnc_numeric_neg (imbalance);
+            xaccTransAppendSplit (trans, split);
+            xaccAccountInsertSplit (dest, split);
+            xaccSplitSetValue (split, value);
+            xaccSplitSetAmount (split, value);
+            counts.matched++;
+        }
+        else
+            counts.unbalanced++;
+    }
+
+    auto fsplit = xaccTransGetSplit (trans, 0);
+    xaccSplitSetReconcile (fsplit, CREC);
+    xaccSplitSetDateReconciledSecs (fsplit, gnc_time (nullptr));
+    counts.imported++;
+}
+
+void
+gnc_import_batch_transactions (const std::string& filename,
+                               const std::string& preset_name,
+                               GncImportBatchCounts& counts)
+{
+    auto& presets = get_import_presets_trans();
+    auto preset_it = std::find_if (presets.begin(), presets.end(),
+                                   [&preset_name](const std::shared_ptr<CsvTransImpSettings>& preset)
+                                   { return preset->m_name == preset_name; });
+    if (preset_it == presets.end())
+    {
+        auto msg = g_strdup_printf (_("No saved import settings named \"%s\" were found."),
+                                    preset_name.c_str());
+        auto err_str = std::string (msg);
+        g_free (msg);
+        throw std::invalid_argument (err_str);
+    }
+    if ((*preset_it)->m_load_error)
+        PWARN ("There were problems reading import settings \"%s\", continuing to load.",
+               preset_name.c_str());
+
+    /* The drafts keep ownership of their transactions until the batch
+     * is committed, so an error part way destroys the ones not committed
+     * yet. */
+    auto batch = std::vector<std::shared_ptr<DraftTransaction>>();
+    batch.reserve (import_batch_size);
+    auto commit_batch = [&batch]()
+    {
+        TransList* trans_list = nullptr;
+        for (auto it = batch.rbegin(); it != batch.rend(); ++it)
+        {
+            trans_list = g_list_prepend (trans_list, (*it)->trans);
+            (*it)->trans = nullptr;
+        }
+        g_list_free (xaccTransCommitBulk (trans_list, TRANS_BULK_SCRUB));
+        g_list_free (trans_list);
+        batch.clear();
+    };
+
+    GncTxImport tx_imp;
+    tx_imp.settings (**preset_it);
+    tx_imp.create_transactions_streaming (filename,
+        [&batch, &counts, &commit_batch](std::shared_ptr<DraftTransaction> draft_trans)
+        {
+            /* Voided transactions have been committed while they were created */
+            if (!draft_trans->trans || !xaccTransIsOpen (draft_trans->trans))
+            {
+                draft_trans->trans = nullptr;
+                return;
+            }
+            import_batch_finish_trans (draft_trans->trans, counts);
+            batch.push_back (std::move (draft_trans));
+            if (batch.size() == import_batch_size)
+                commit_batch();
+        });
+    commit_batch();
+
+    PINFO ("Imported %zu transactions from %s, balanced %zu from the import map, left %zu unbalanced",
+           counts.imported, filename.c_str(), counts.matched, counts.unbalanced);
+}
@@ -40,6 +40,7 @@ extern "C" {
 #include <set>
 #include <map>
 #include <memory>
+#include <functional>
 
 #include "gnc-tokenizer.hpp"
 #include "gnc-imp-props-tx.hpp"
@@ -60,6 +61,10 @@ struct DraftTransaction
     boost::optional<std::string> void_reason;
 };
 
+/** Receives each draft transaction of a streaming import once all its
+ *  splits have been read. */
+using DraftTransSink = std::function<void(std::shared_ptr<DraftTransaction>)>;
+
 /* A set of currency formats that the user sees. */
 extern const int num_currency_formats;
 extern const gchar* currency_format_user[];
@@ -133,6 +138,11 @@ public:
 
     void req_mapped_accts (bool val) {m_req_mapped_accts = val; }
 
+    /** Sets the number of threads set_column_type parses lines on. 0, the
+     *  default, uses one per processor up to a fixed maximum, 1 parses all
+     *  lines on the calling thread. */
+    void parse_threads (uint32_t n_threads) { m_parse_threads = n_threads; }
+
     void separators (std::string separators);
     std::string separators ();
 
@@ -153,6 +163,16 @@ public:
      *  transactions using the column types the user has set.
      */
     void create_transactions ();
+    /** Imports filename without loading and tokenizing it as a whole.
+     *  Rows are read one at a time, turned into (part of) a draft
+     *  transaction and dropped again. Intended for non-interactive
+     *  imports, so all settings must be in place before calling this.
+     *  If sink is set, each draft transaction is handed to it as soon as
+     *  it is complete instead of being kept in m_transactions, so the
+     *  memory used doesn't grow with the size of the file.
+     */
+    void create_transactions_streaming (const std::string& filename,
+                                        DraftTransSink sink = nullptr);
     bool check_for_column_type (GncTransPropType type);
     void set_column_type (uint32_t position, GncTransPropType type, bool force = false);
     std::vector<GncTransPropType> column_types ();
@@ -171,7 +191,7 @@ private:
      *  to convert a single tokenized line into a transaction using
      *  the column types the user has set.
      */
-    void create_transaction (std::vector<parse_line_t>::iterator& parsed_line);
+    void create_transaction (parse_line_t& parsed_line);
 
     void verify_column_selections (ErrorList& error_msg);
 
@@ -181,18 +201,21 @@ private:
     /* Internal helper function that does the actual conversion from property lists
      * to real (possibly unbalanced) transaction with splits.
      */
-    std::shared_ptr<DraftTransaction> trans_properties_to_trans (std::vector<parse_line_t>::iterator& parsed_line);
+    std::shared_ptr<DraftTransaction> trans_properties_to_trans (parse_line_t& parsed_line);
 
     /* Two internal helper functions that should only be called from within
      * set_column_type for consistency (otherwise error messages may not be (re)set)
      */
-    void update_pre_trans_props (uint32_t row, uint32_t col, GncTransPropType prop_type);
-    void update_pre_split_props (uint32_t row, uint32_t col, GncTransPropType prop_type);
+    void update_pre_trans_props (parse_line_t& parsed_line, uint32_t col, GncTransPropType prop_type,
+                                 const GncPreTrans* parsed = nullptr);
+    void update_pre_split_props (parse_line_t& parsed_line, uint32_t col, GncTransPropType prop_type);
+    void update_line_errors (parse_line_t& parsed_line);
 
     struct CsvTranImpSettings; //FIXME do we need this line
     CsvTransImpSettings m_settings;
     bool m_skip_errors;
     bool m_req_mapped_accts;
+    uint32_t m_parse_threads = 0;
 
     /* The parameters below are only used while creating
      * transactions. They keep state information while processing multi-split
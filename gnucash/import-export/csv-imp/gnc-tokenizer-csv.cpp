@@ -11,29 +11,214 @@
 #include <boost/locale.hpp>
 #include <boost/algorithm/string.hpp>
 
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define CSV_SCAN_SSE2 1
+#endif
+
 extern "C" {
     #include <glib/gi18n.h>
 }
 
+/* The fast scanner compares against at most this many separators */
+static constexpr size_t max_fast_separators = 4;
+
 void
 GncCsvTokenizer::set_separators(const std::string& separators)
 {
     m_sep_str = separators;
+    /* Quotes, backslashes or non-ascii bytes as separator are left
+     * to the boost based tokenizer, as are long lists of separators. */
+    m_fast_scan = (separators.size() <= max_fast_separators) &&
+        std::none_of (separators.begin(), separators.end(),
+                      [](char c){ return c == '"' || c == '\\' || (c & 0x80); });
 }
 
 
-int GncCsvTokenizer::tokenize()
+/* Collects the offsets of all quote and separator characters in line,
+ * 16 bytes at a time where SSE2 is available.
+ * Returns false if the line holds a backslash: escapes are left to
+ * the boost based tokenizer. */
+static bool
+csv_find_specials (const std::string& line, const std::string& seps,
+                   std::vector<size_t>& specials)
+{
+    auto data = line.data();
+    auto len = line.size();
+    size_t pos = 0;
+
+    specials.clear();
+#ifdef CSV_SCAN_SSE2
+    const auto quote = _mm_set1_epi8 ('"');
+    const auto bslash = _mm_set1_epi8 ('\\');
+    __m128i sep_vec[max_fast_separators];
+    for (size_t i = 0; i < seps.size(); i++)
+        sep_vec[i] = _mm_set1_epi8 (seps[i]);
+
+    for (; pos + 16 <= len; pos += 16)
+    {
+        auto block = _mm_loadu_si128 (reinterpret_cast<const __m128i*>(data + pos));
+        if (_mm_movemask_epi8 (_mm_cmpeq_epi8 (block, bslash)))
+            return false;
+        auto hits = _mm_cmpeq_epi8 (block, quote);
+        for (size_t i = 0; i < seps.size(); i++)
+            hits = _mm_or_si128 (hits, _mm_cmpeq_epi8 (block, sep_vec[i]));
+        auto mask = static_cast<unsigned>(_mm_movemask_epi8 (hits));
+        while (mask)
+        {
+            specials.push_back (pos + __builtin_ctz (mask));
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; pos < len; pos++)
+    {
+        auto c = data[pos];
+        if (c == '\\')
+            return false;
+        if (c == '"' || seps.find (c) != std::string::npos)
+            specials.push_back (pos);
+    }
+    return true;
+}
+
+/* Splits line at the offsets found by csv_find_specials. For lines
+ * without backslashes this gives the same fields as the boost based
+ * path in tokenize_line: quotes are dropped, separators inside quotes
+ * are kept and a "" inside a field is a literal quote. Text between
+ * special characters is copied in one go.
+ * Each field still becomes a std::string of its own: rows are StrVecs for
+ * all tokenizers and their users, and a field isn't a plain slice of
+ * m_utf8_contents anyway once quotes are dropped, "" pairs collapsed and
+ * quoted line breaks joined. */
+static StrVec
+csv_split_fields (const std::string& line, const std::string& seps,
+                  const std::vector<size_t>& specials)
+{
+    StrVec fields;
+    if (line.empty())
+        return fields;
+
+    auto is_sep = [&seps](char c) { return seps.find (c) != std::string::npos; };
+    std::string field;
+    bool inside_quotes = false;
+    size_t last = 0;    // start of the text not yet copied into field
+
+    for (auto pos : specials)
+    {
+        if (pos < last)
+            continue;   // second half of a "" pair
+
+        field.append (line, last, pos - last);
+        if (line[pos] == '"')
+        {
+            if (pos + 1 < line.size() && line[pos + 1] == '"')
+            {
+                // A field only holding "" is empty, otherwise it's a quote
+                auto empty_field = (pos == 0 || is_sep (line[pos - 1])) &&
+                                   (pos + 2 >= line.size() || is_sep (line[pos + 2]));
+                if (!empty_field)
+                    field.push_back ('"');
+                last = pos + 2;
+                continue;
+            }
+            inside_quotes = !inside_quotes;
+            last = pos + 1;
+        }
+        else if (inside_quotes)
+            last = pos; // keep the separator as part of the field
+        else
+        {
+            fields.push_back (std::move (field));
+            field.clear();
+            last = pos + 1;
+        }
+    }
+    field.append (line, last, std::string::npos);
+    fields.push_back (std::move (field));
+
+    return fields;
+}
+
+
+/* Returns whether a quoted field is still open after buffer,
+ * given whether one was open before it. Used to join line breaks
+ * in quoted strings. */
+static bool
+update_inside_quotes (const std::string& buffer, bool inside_quotes)
 {
+    auto last_quote = buffer.find_first_of('"');
+    while (last_quote != std::string::npos)
+    {
+        if (last_quote == 0) // Test separately because last_quote - 1 would be out of range
+            inside_quotes = !inside_quotes;
+        else if (buffer[ last_quote - 1 ] != '\\')
+            inside_quotes = !inside_quotes;
+
+        last_quote = buffer.find_first_of('"',last_quote+1);
+    }
+    return inside_quotes;
+}
+
+/* Splits one complete (possibly joined) line into its fields. Lines
+ * without escapes take the fast scanner, others are preprocessed and
+ * handed to boost::tokenizer. Note line may be modified in the process.
+ * @exception boost::escaped_list_error if the line can't be parsed */
+StrVec
+GncCsvTokenizer::tokenize_line (std::string& line)
+{
+    if (m_fast_scan && csv_find_specials (line, m_sep_str, m_specials))
+        return csv_split_fields (line, m_sep_str, m_specials);
+
     using Tokenizer = boost::tokenizer< boost::escaped_list_separator<char>>;
 
     boost::escaped_list_separator<char> sep("\\", m_sep_str, "\"");
 
-    StrVec vec;
+    // Deal with backslashes that are not meant to be escapes
+    // The boost::tokenizer with escaped_list_separator as we use
+    // it would choke on this.
+    auto bs_pos = line.find ('\\');
+    while (bs_pos != std::string::npos)
+    {
+        if ((bs_pos == line.size()) ||                                 // got trailing single backslash
+            (line.find_first_of ("\"\\n", bs_pos + 1) != bs_pos + 1))  // backslash is not part of known escapes \\, \" or \n
+            line = line.substr(0, bs_pos) + "\\\\" + line.substr(bs_pos + 1);
+        bs_pos += 2;
+        bs_pos = line.find ('\\', bs_pos);
+    }
+
+    // Deal with repeated " ("") in strings.
+    // This is commonly used as escape mechanism for double quotes in csv files.
+    // However boost just eats them.
+    bs_pos = line.find ("\"\"");
+    while (bs_pos != std::string::npos)
+    {
+        // Only make changes in case the double quotes are part of a larger field
+        // In other words a field which only contains two double quotes represent an
+        // empty field. We don't need to touch those.
+        // The way to determine whether the double quotes represent an empty string
+        // is by checking whether the character in front or after are either
+        // a field separator or the beginning or end of of the string.
+        if (!(((bs_pos == 0) ||                                          // quotes are at start of line
+               (m_sep_str.find (line[bs_pos-1]) != std::string::npos))    // quotes preceded by field separator
+              &&
+              ((bs_pos + 2 >= line.length()) ||                          // quotes are at end of line
+               (m_sep_str.find (line[bs_pos+2]) != std::string::npos))))   // quotes followed by field separator
+            // Only make changes in case the double quotes are not an empty field
+            line.replace (bs_pos, 2, "\\\"");
+        bs_pos = line.find ("\"\"", bs_pos + 2);
+    }
+
+    Tokenizer tok(line, sep);
+    return StrVec(tok.begin(), tok.end());
+}
+
+int GncCsvTokenizer::tokenize()
+{
     std::string line;
     std::string buffer;
 
     bool inside_quotes(false);
-    size_t last_quote(0);
 
     m_tokenized_contents.clear();
     std::istringstream in_stream(m_utf8_contents);
@@ -44,16 +229,7 @@ int GncCsvTokenizer::tokenize()
         {
             // --- deal with line breaks in quoted strings
             buffer = boost::trim_copy (buffer); // Removes trailing newline and spaces
-            last_quote = buffer.find_first_of('"');
-            while (last_quote != std::string::npos)
-            {
-                if (last_quote == 0) // Test separately because last_quote - 1 would be out of range
-                    inside_quotes = !inside_quotes;
-                else if (buffer[ last_quote - 1 ] != '\\')
-                    inside_quotes = !inside_quotes;
-
-                last_quote = buffer.find_first_of('"',last_quote+1);
-            }
+            inside_quotes = update_inside_quotes (buffer, inside_quotes);
 
             line.append(buffer);
             if (inside_quotes)
@@ -63,44 +239,7 @@ int GncCsvTokenizer::tokenize()
             }
             // ---
 
-            // Deal with backslashes that are not meant to be escapes
-            // The boost::tokenizer with escaped_list_separator as we use
-            // it would choke on this.
-            auto bs_pos = line.find ('\\');
-            while (bs_pos != std::string::npos)
-            {
-                if ((bs_pos == line.size()) ||                                 // got trailing single backslash
-                    (line.find_first_of ("\"\\n", bs_pos + 1) != bs_pos + 1))  // backslash is not part of known escapes \\, \" or \n
-                    line = line.substr(0, bs_pos) + "\\\\" + line.substr(bs_pos + 1);
-                bs_pos += 2;
-                bs_pos = line.find ('\\', bs_pos);
-            }
-
-            // Deal with repeated " ("") in strings.
-            // This is commonly used as escape mechanism for double quotes in csv files.
-            // However boost just eats them.
-            bs_pos = line.find ("\"\"");
-            while (bs_pos != std::string::npos)
-            {
-                // Only make changes in case the double quotes are part of a larger field
-                // In other words a field which only contains two double quotes represent an
-                // empty field. We don't need to touch those.
-                // The way to determine whether the double quotes represent an empty string
-                // is by checking whether the character in front or after are either
-                // a field separator or the beginning or end of of the string.
-                if (!(((bs_pos == 0) ||                                          // quotes are at start of line
-                       (m_sep_str.find (line[bs_pos-1]) != std::string::npos))    // quotes preceded by field separator
-                      &&
-                      ((bs_pos + 2 >= line.length()) ||                          // quotes are at end of line
-                       (m_sep_str.find (line[bs_pos+2]) != std::string::npos))))   // quotes followed by field separator
-                    // Only make changes in case the double quotes are not an empty field
-                    line.replace (bs_pos, 2, "\\\"");
-                bs_pos = line.find ("\"\"", bs_pos + 2);
-            }
-
-            Tokenizer tok(line, sep);
-            vec.assign(tok.begin(),tok.end());
-            m_tokenized_contents.push_back(vec);
+            m_tokenized_contents.push_back(tokenize_line (line));
             line.clear();
         }
     }
@@ -111,3 +250,37 @@ int GncCsvTokenizer::tokenize()
 
     return 0;
 }
+
+bool GncCsvTokenizer::next_row(StrVec& row)
+{
+    std::string line;
+    std::string buffer;
+
+    bool inside_quotes(false);
+
+    while (next_line (buffer))
+    {
+        boost::trim (buffer);
+        inside_quotes = update_inside_quotes (buffer, inside_quotes);
+
+        line.append(buffer);
+        if (inside_quotes)
+        {
+            line.append(" ");
+            continue;
+        }
+
+        try
+        {
+            row = tokenize_line (line);
+        }
+        catch (boost::escaped_list_error &e)
+        {
+            throw (std::range_error N_("There was an error parsing the file."));
+        }
+        return true;
+    }
+
+    // As in tokenize, an unterminated quoted field at the end is dropped
+    return false;
+}
@@ -46,6 +46,7 @@ extern "C" {
 
 class GncCsvTokenizer : public GncTokenizer
 {
+friend GncTokenizerTest;
 public:
     GncCsvTokenizer() = default;                                  // default constructor
     GncCsvTokenizer(const GncCsvTokenizer&) = default;            // copy constructor
@@ -56,9 +57,14 @@ public:
 
     void set_separators(const std::string& separators);
     int  tokenize() override;
+    bool next_row(StrVec& row) override;
 
 private:
+    StrVec tokenize_line(std::string& line);
+
     std::string m_sep_str = ",";
+    bool m_fast_scan = true;            // separators are handled by the fast scanner
+    std::vector<size_t> m_specials;     // scratch space for the fast scanner
 };
 
 #endif
@@ -29,3 +29,13 @@ int GncDummyTokenizer::tokenize()
 
     return 0;
 }
+
+bool GncDummyTokenizer::next_row(StrVec& row)
+{
+    std::string line;
+    if (!next_line (line))
+        return false;
+
+    row.assign (1, line);
+    return true;
+}
@@ -56,6 +56,7 @@ public:
     ~GncDummyTokenizer() = default;                                // destructor
 
     int  tokenize() override;
+    bool next_row(StrVec& row) override;
 };
 
 #endif
@@ -159,7 +159,7 @@ void GncFwTokenizer::load_file(const std::string& path)
  * multi-byte characters (like the € sign in utf-8) could be inadvertently
  * split. This doesn't happen with wide characters.
  */
-int GncFwTokenizer::tokenize()
+StrVec GncFwTokenizer::tokenize_line(const std::wstring& line)
 {
     using boost::locale::conv::utf_to_utf;
     using Tokenizer = boost::tokenizer< boost::offset_separator,
@@ -167,10 +167,25 @@ int GncFwTokenizer::tokenize()
 
     boost::offset_separator sep(m_col_vec.begin(), m_col_vec.end(), false);
 
+    StrVec vec;
+    Tokenizer tok(line, sep);
+    for (auto token : tok)
+    {
+        auto stripped = boost::trim_copy(token); // strips newlines as well as whitespace
+        auto narrow = utf_to_utf<char>(stripped.c_str(), stripped.c_str()
+            + stripped.size());
+        vec.push_back (narrow);
+    }
+    return vec;
+}
+
+int GncFwTokenizer::tokenize()
+{
+    using boost::locale::conv::utf_to_utf;
+
     std::wstring wchar_contents = utf_to_utf<wchar_t>(m_utf8_contents.c_str(),
         m_utf8_contents.c_str() + m_utf8_contents.size());
 
-    StrVec vec;
     std::wstring line;
 
     m_tokenized_contents.clear();
@@ -178,18 +193,23 @@ int GncFwTokenizer::tokenize()
 
     while (std::getline (in_stream, line))
     {
-        Tokenizer tok(line, sep);
-        vec.clear();
-        for (auto token : tok)
-        {
-            auto stripped = boost::trim_copy(token); // strips newlines as well as whitespace
-            auto narrow = utf_to_utf<char>(stripped.c_str(), stripped.c_str()
-                + stripped.size());
-            vec.push_back (narrow);
-        }
-        m_tokenized_contents.push_back(vec);
+        m_tokenized_contents.push_back(tokenize_line (line));
         line.clear(); // clear here, next check could fail
     }
 
     return 0;
 }
+
+/* Unlike load_file, streaming can't find the longest line up front,
+ * so the column widths should be set before reading rows. */
+bool GncFwTokenizer::next_row(StrVec& row)
+{
+    using boost::locale::conv::utf_to_utf;
+
+    std::string line;
+    if (!next_line (line))
+        return false;
+
+    row = tokenize_line (utf_to_utf<wchar_t>(line.c_str(), line.c_str() + line.size()));
+    return true;
+}
@@ -73,9 +73,12 @@ public:
 
     void load_file (const std::string& path) override;
     int  tokenize() override;
+    bool next_row(StrVec& row) override;
 
 
 private:
+    StrVec tokenize_line(const std::wstring& line);
+
     std::vector<uint32_t> m_col_vec;
     uint32_t m_longest_line = 0;
 };
@@ -18,8 +18,30 @@ extern "C" {
 #include <go-glib-extras.h>
 #include <glib.h>
 #include <glib/gstdio.h>
+#include <errno.h>
 }
 
+/* Size of the blocks read by the streaming interface */
+static constexpr size_t stream_chunk_size = 64 * 1024;
+
+/* State of a file opened with GncTokenizer::open_stream */
+struct GncTokenizerStream
+{
+    GncTokenizerStream(const std::string& path) : in(path, std::ios::binary) {}
+    ~GncTokenizerStream()
+    {
+        if (conv != (GIConv)-1)
+            g_iconv_close (conv);
+    }
+
+    std::ifstream in;
+    GIConv conv = (GIConv)-1;
+    std::string raw;        // bytes read but not converted yet (partial character)
+    std::string buf;        // converted text not handed out yet
+    size_t pos = 0;         // start of the next line in buf
+    bool eof = false;
+};
+
 std::unique_ptr<GncTokenizer> gnc_tokenizer_factory(GncImpFileFormat fmt)
 {
     std::unique_ptr<GncTokenizer> tok(nullptr);
@@ -99,3 +121,114 @@ GncTokenizer::get_tokens()
 {
     return m_tokenized_contents;
 }
+
+/* Convert as much of stream.raw as possible to UTF-8 and append it to
+ * stream.buf. An incomplete character at the end is kept for the next
+ * chunk. Invalid bytes are skipped, like boost's to_utf does by default.
+ */
+static void
+stream_convert (GncTokenizerStream& stream)
+{
+    char out[16 * 1024];
+    gchar *inbuf = &stream.raw[0];
+    gsize inleft = stream.raw.size();
+
+    while (inleft > 0)
+    {
+        gchar *outbuf = out;
+        gsize outleft = sizeof(out);
+        auto res = g_iconv (stream.conv, &inbuf, &inleft, &outbuf, &outleft);
+        stream.buf.append (out, outbuf - out);
+        if (res != (gsize)-1 || errno == E2BIG)
+            continue;
+        if (errno == EINVAL && !stream.eof)
+            break;
+        ++inbuf;
+        --inleft;
+    }
+    stream.raw.erase (0, stream.raw.size() - inleft);
+}
+
+static void
+stream_read_chunk (GncTokenizerStream& stream)
+{
+    auto old_size = stream.raw.size();
+    stream.raw.resize (old_size + stream_chunk_size);
+    stream.in.read (&stream.raw[old_size], stream_chunk_size);
+    stream.raw.resize (old_size + stream.in.gcount());
+    if (!stream.in)
+        stream.eof = true;
+}
+
+void
+GncTokenizer::open_stream(const std::string& path)
+{
+    auto stream = std::make_shared<GncTokenizerStream>(path);
+    if (!stream->in.is_open())
+        throw std::ifstream::failure(g_strerror(errno));
+
+    m_imp_file_str = path;
+    stream_read_chunk (*stream);
+
+    if (m_enc_str.empty())
+    {
+        /* Guess from complete lines only, a character cut in half at the
+         * end of the chunk would make valid UTF-8 look invalid. */
+        auto len = stream->raw.find_last_of ("\r\n");
+        if (len == std::string::npos || stream->eof)
+            len = stream->raw.size();
+        auto guessed_enc = go_guess_encoding (stream->raw.c_str(), len,
+                                              "UTF-8", NULL);
+        m_enc_str = guessed_enc ? guessed_enc : "UTF-8";
+    }
+
+    stream->conv = g_iconv_open ("UTF-8", m_enc_str.c_str());
+    if (stream->conv == (GIConv)-1)
+        throw std::ifstream::failure(std::string("Unsupported encoding ") + m_enc_str);
+
+    stream_convert (*stream);
+    m_stream = stream;
+}
+
+/* Hands out the stream line by line, normalizing line endings the same
+ * way encoding() does for files loaded in one go. */
+bool
+GncTokenizer::next_line(std::string& line)
+{
+    if (!m_stream)
+        return false;
+
+    auto& stream = *m_stream;
+    while (true)
+    {
+        auto eol = stream.buf.find_first_of ("\r\n", stream.pos);
+        /* A trailing '\r' may be the first half of a "\r\n" pair */
+        if (eol != std::string::npos &&
+            (stream.buf[eol] == '\n' || eol + 1 < stream.buf.size() || stream.eof))
+        {
+            line.assign (stream.buf, stream.pos, eol - stream.pos);
+            stream.pos = eol + 1;
+            if (stream.buf[eol] == '\r' && stream.pos < stream.buf.size() &&
+                stream.buf[stream.pos] == '\n')
+                ++stream.pos;
+            return true;
+        }
+
+        if (stream.eof)
+        {
+            if (stream.pos >= stream.buf.size())
+            {
+                m_stream.reset();
+                return false;
+            }
+            line.assign (stream.buf, stream.pos, std::string::npos);
+            stream.pos = stream.buf.size();
+            return true;
+        }
+
+        stream.buf.erase (0, stream.pos);
+        stream.pos = 0;
+        stream_read_chunk (stream);
+        stream_convert (stream);
+    }
+}
@@ -55,6 +55,7 @@ enum class GncImpFileFormat {
 };
 
 class GncTokenizerTest;
+struct GncTokenizerStream;
 
 class GncTokenizer
 {
@@ -74,7 +75,26 @@ public:
     virtual int  tokenize() = 0;
     const std::vector<StrVec>& get_tokens();
 
+    /** Opens a file to be read row by row with next_row instead of
+     *  loading it completely with load_file. The file is read and
+     *  converted to UTF-8 in fixed size chunks, so memory use doesn't
+     *  grow with the file size. If no encoding was set, it is guessed
+     *  from the first chunk.
+     *  @param path the file to open
+     *  @exception std::ifstream::failure if the file can't be opened
+     */
+    void open_stream(const std::string& path);
+    /** Tokenizes the next row of a file opened with open_stream.
+     *  @param row receives the fields of the row
+     *  @return false if there are no more rows
+     */
+    virtual bool next_row(StrVec& row) = 0;
+
 protected:
+    /** Returns the next line of the stream opened with open_stream,
+     *  with line endings already stripped. */
+    bool next_line(std::string& line);
+
     std::string m_utf8_contents;
     std::vector<StrVec> m_tokenized_contents;
 
@@ -82,6 +102,7 @@ private:
     std::string m_imp_file_str;
     std::string m_raw_contents;
     std::string m_enc_str;
+    std::shared_ptr<GncTokenizerStream> m_stream;
 };
 
 
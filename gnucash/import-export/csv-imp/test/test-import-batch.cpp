@@ -0,0 +1,330 @@
+/********************************************************************
+ * test-import-batch.cpp: test suite for the headless csv imports.  *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, you can retrieve it from        *
+ * https://www.gnu.org/licenses/old-licenses/gpl-2.0.html            *
+ * or contact:                                                      *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ ********************************************************************/
+
+#include <config.h>
+#include <gtest/gtest.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+extern "C"
+{
+#include <Account.h>
+#include <Transaction.h>
+#include <cashobjects.h>
+#include <gnc-commodity.h>
+#include <gnc-pricedb.h>
+#include <gnc-session.h>
+#include <gnc-ui-util.h>
+}
+
+#include <gnc-datetime.hpp>
+
+#include "../gnc-import-batch.hpp"
+#include "../gnc-import-price.hpp"
+#include "../gnc-imp-settings-csv-price.hpp"
+#include "../gnc-imp-settings-csv-tx.hpp"
+
+class TestEnvironment : public testing::Environment
+{
+public:
+    void SetUp() override
+    {
+        qof_init ();
+        cashobjects_register ();
+    }
+
+    void TearDown() override
+    {
+        qof_close ();
+    }
+};
+
+testing::Environment* const env = testing::AddGlobalTestEnvironment(new TestEnvironment);
+
+class ImportBatchTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        auto book = gnc_get_current_book ();
+        auto table = gnc_commodity_table_get_table (book);
+        m_usd = gnc_commodity_table_lookup (table, GNC_COMMODITY_NS_CURRENCY, "USD");
+        m_bank = make_account ("Bank", ACCT_TYPE_BANK);
+        m_groceries = make_account ("Groceries", ACCT_TYPE_EXPENSE);
+    }
+
+    void TearDown() override
+    {
+        for (const auto& filename : m_files)
+            g_remove (filename.c_str());
+        gnc_clear_current_session ();
+    }
+
+    Account* make_account (const char* name, GNCAccountType type)
+    {
+        auto acc = xaccMallocAccount (gnc_get_current_book ());
+        xaccAccountBeginEdit (acc);
+        xaccAccountSetName (acc, name);
+        xaccAccountSetType (acc, type);
+        xaccAccountSetCommodity (acc, m_usd);
+        gnc_account_append_child (gnc_get_current_root_account (), acc);
+        xaccAccountCommitEdit (acc);
+        return acc;
+    }
+
+    /* Saves a preset reading Date, Description and Deposit columns into
+     * the Bank account, the way the import assistant would. */
+    void save_trans_preset (const std::string& name)
+    {
+        CsvTransImpSettings preset;
+        preset.m_name = name;
+        preset.m_file_format = GncImpFileFormat::CSV;
+        preset.m_separators = ",";
+        preset.m_date_format = 0;       // y-m-d
+        preset.m_currency_format = 1;   // Period: 123,456.78
+        preset.m_skip_start_lines = 1;
+        preset.m_base_account = m_bank;
+        preset.m_column_types = { GncTransPropType::DATE,
+                                  GncTransPropType::DESCRIPTION,
+                                  GncTransPropType::DEPOSIT };
+        ASSERT_FALSE (preset.save());
+    }
+
+    /* Price import settings reading Date and Amount columns as prices of
+     * ACME in USD. */
+    CsvPriceImpSettings price_settings (const std::string& name)
+    {
+        auto book = gnc_get_current_book ();
+        auto table = gnc_commodity_table_get_table (book);
+        auto acme = gnc_commodity_new (book, "Acme Corp", "NASDAQ", "ACME", "", 10000);
+        m_acme = gnc_commodity_table_insert (table, acme);
+
+        CsvPriceImpSettings preset;
+        preset.m_name = name;
+        preset.m_file_format = GncImpFileFormat::CSV;
+        preset.m_separators = ",";
+        preset.m_date_format = 0;       // y-m-d
+        preset.m_currency_format = 1;   // Period: 123,456.78
+        preset.m_skip_start_lines = 1;
+        preset.m_from_commodity = m_acme;
+        preset.m_to_currency = m_usd;
+        preset.m_column_types_price = { GncPricePropType::DATE,
+                                        GncPricePropType::AMOUNT };
+        return preset;
+    }
+
+    static time64 price_day (int day)
+    {
+        return static_cast<time64>(GncDateTime (GncDate (2020, 1, day), DayPart::neutral));
+    }
+
+    /* Adds a price of ACME in USD on day of January 2020 to the book. */
+    void add_price (int day, gint64 cents)
+    {
+        auto book = gnc_get_current_book ();
+        auto price = gnc_price_create (book);
+        gnc_price_begin_edit (price);
+        gnc_price_set_commodity (price, m_acme);
+        gnc_price_set_currency (price, m_usd);
+        gnc_price_set_time64 (price, price_day (day));
+        gnc_price_set_value (price, gnc_numeric_create (cents, 100));
+        gnc_price_set_source (price, PRICE_SOURCE_USER_PRICE);
+        gnc_price_set_typestr (price, PRICE_TYPE_LAST);
+        gnc_price_commit_edit (price);
+        gnc_pricedb_add_price (gnc_pricedb_get_db (book), price);
+        gnc_price_unref (price);
+    }
+
+    /* The value of the price of ACME on day of January 2020, in cents. */
+    gint64 price_cents (int day)
+    {
+        auto pdb = gnc_pricedb_get_db (gnc_get_current_book ());
+        auto price = gnc_pricedb_lookup_day_t64 (pdb, m_acme, m_usd, price_day (day));
+        if (!price)
+            return -1;
+        auto cents = gnc_numeric_convert (gnc_price_get_value (price), 100,
+                                          GNC_HOW_RND_ROUND_HALF_UP).num;
+        gnc_price_unref (price);
+        return cents;
+    }
+
+    /* Four prices, two of them on the same day. */
+    std::string write_price_file ()
+    {
+        return write_file ("Date,Price\n"
+                           "2020-01-02,10.00\n"
+                           "2020-01-03,11.00\n"
+                           "2020-01-03,11.50\n"
+                           "2020-01-04,12.00\n");
+    }
+
+    std::string write_file (const std::string& contents)
+    {
+        gchar* filename = nullptr;
+        auto fd = g_file_open_tmp ("test-import-batch-XXXXXX.csv", &filename, nullptr);
+        EXPECT_NE (fd, -1);
+        close (fd);
+        std::ofstream out (filename);
+        out << contents;
+        m_files.push_back (filename);
+        g_free (filename);
+        return m_files.back();
+    }
+
+    gnc_commodity* m_usd = nullptr;
+    gnc_commodity* m_acme = nullptr;
+    Account* m_bank = nullptr;
+    Account* m_groceries = nullptr;
+    std::vector<std::string> m_files;
+};
+
+TEST_F (ImportBatchTest, unknown_preset)
+{
+    auto counts = GncImportBatchCounts();
+    auto filename = write_file ("Date,Description,Amount\n");
+    EXPECT_THROW (gnc_import_batch_transactions (filename, "no such preset", counts),
+                  std::invalid_argument);
+    EXPECT_EQ (counts.imported, 0u);
+}
+
+TEST_F (ImportBatchTest, import_transactions)
+{
+    /* Teach the Bank account's import map that "Grocer" goes to Groceries */
+    auto imap = gnc_account_imap_create_imap (m_bank);
+    auto tokens = g_list_prepend (nullptr, g_strdup ("Grocer"));
+    gnc_account_imap_add_account_bayes (imap, tokens, m_groceries);
+    g_list_free_full (tokens, g_free);
+    g_free (imap);
+
+    save_trans_preset ("batch-test");
+    auto filename = write_file ("Date,Description,Amount\n"
+                                "2020-01-02,Grocer,-12.50\n"
+                                "2020-01-03,Salary,1000.00\n"
+                                "2020-01-04,Grocer,-20.00\n"
+                                "2020-01-05,Unknown,-5.00\n");
+
+    auto counts = GncImportBatchCounts();
+    gnc_import_batch_transactions (filename, "batch-test", counts);
+    EXPECT_EQ (counts.imported, 4u);
+    EXPECT_EQ (counts.matched, 2u);
+    EXPECT_EQ (counts.unbalanced, 2u);
+
+    EXPECT_TRUE (gnc_numeric_equal (xaccAccountGetBalance (m_bank),
+                                    gnc_numeric_create (96250, 100)));
+    EXPECT_TRUE (gnc_numeric_equal (xaccAccountGetBalance (m_groceries),
+                                    gnc_numeric_create (3250, 100)));
+    auto splits = xaccAccountGetSplitList (m_bank);
+    EXPECT_EQ (g_list_length (splits), 4u);
+    for (auto node = splits; node; node = node->next)
+    {
+        auto split = static_cast<Split*>(node->data);
+        EXPECT_FALSE (xaccTransIsOpen (xaccSplitGetParent (split)));
+        EXPECT_EQ (xaccSplitGetReconcile (split), CREC);
+    }
+}
+
+TEST_F (ImportBatchTest, import_transactions_several_batches)
+{
+    save_trans_preset ("batch-test");
+    std::string contents = "Date,Description,Amount\n";
+    for (int i = 0; i < 2500; i++)
+        contents += "2020-02-01,Row " + std::to_string (i) + ",1.00\n";
+    auto filename = write_file (contents);
+
+    auto counts = GncImportBatchCounts();
+    gnc_import_batch_transactions (filename, "batch-test", counts);
+    EXPECT_EQ (counts.imported, 2500u);
+    EXPECT_EQ (counts.matched, 0u);
+    EXPECT_EQ (counts.unbalanced, 2500u);
+    EXPECT_EQ (g_list_length (xaccAccountGetSplitList (m_bank)), 2500u);
+    EXPECT_TRUE (gnc_numeric_equal (xaccAccountGetBalance (m_bank),
+                                    gnc_numeric_create (2500, 1)));
+}
+
+TEST_F (ImportBatchTest, import_transactions_bad_row)
+{
+    save_trans_preset ("batch-test");
+    auto filename = write_file ("Date,Description,Amount\n"
+                                "2020-01-02,Good,1.00\n"
+                                "not a date,Bad,1.00\n");
+
+    auto counts = GncImportBatchCounts();
+    EXPECT_THROW (gnc_import_batch_transactions (filename, "batch-test", counts),
+                  std::invalid_argument);
+    EXPECT_EQ (counts.imported, 0u);
+    EXPECT_EQ (g_list_length (xaccAccountGetSplitList (m_bank)), 0u);
+}
+
+/* The price counts are per line of the file: with over writing the second
+ * price of Jan 3 replaces the first one and the price of Jan 4 the one
+ * already in the book. */
+TEST_F (ImportBatchTest, import_prices_over_write)
+{
+    auto settings = price_settings ("price-test");
+    add_price (4, 900);
+    auto filename = write_price_file ();
+
+    GncPriceImport price_imp;
+    price_imp.load_file (filename);
+    price_imp.tokenize (true);
+    price_imp.settings (settings);
+    auto column_types = price_imp.column_types_price();
+    for (uint32_t col = 0; col < column_types.size(); col++)
+        price_imp.set_column_type_price (col, column_types[col], true);
+    price_imp.over_write (true);
+    price_imp.create_prices ();
+
+    EXPECT_EQ (price_imp.m_prices_added, 2);
+    EXPECT_EQ (price_imp.m_prices_replaced, 2);
+    EXPECT_EQ (price_imp.m_prices_duplicated, 0);
+    EXPECT_EQ (gnc_pricedb_get_num_prices (gnc_pricedb_get_db (gnc_get_current_book ())), 3u);
+    EXPECT_EQ (price_cents (2), 1000);
+    EXPECT_EQ (price_cents (3), 1150);
+    EXPECT_EQ (price_cents (4), 1200);
+}
+
+/* Without over writing, the second price of Jan 3 and the price of Jan 4
+ * are duplicates. The batch import never over writes. */
+TEST_F (ImportBatchTest, import_prices_keep_existing)
+{
+    auto settings = price_settings ("price-test");
+    ASSERT_FALSE (settings.save());
+    add_price (4, 900);
+    auto filename = write_price_file ();
+
+    auto counts = GncImportBatchCounts();
+    gnc_import_batch_prices (filename, "price-test", counts);
+    EXPECT_EQ (counts.imported, 2u);
+    EXPECT_EQ (counts.replaced, 0u);
+    EXPECT_EQ (counts.duplicated, 2u);
+    EXPECT_EQ (gnc_pricedb_get_num_prices (gnc_pricedb_get_db (gnc_get_current_book ())), 3u);
+    EXPECT_EQ (price_cents (2), 1000);
+    EXPECT_EQ (price_cents (3), 1100);
+    EXPECT_EQ (price_cents (4), 900);
+}
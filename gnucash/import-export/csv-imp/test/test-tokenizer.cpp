@@ -32,7 +32,10 @@
 #include <iostream>
 #include <fstream>      // fstream
 
+#include <chrono>
+#include <random>
 #include <string>
+#include <cstdio>
 #include <stdlib.h>     /* getenv */
 
 
@@ -67,6 +70,8 @@ protected:
     { return tokenizer->m_utf8_contents; }
     void set_utf8_contents(std::unique_ptr<GncTokenizer> &tokenizer, const std::string& newcontents)
     { tokenizer->m_utf8_contents = newcontents; }
+    void set_fast_scan(std::unique_ptr<GncTokenizer> &tokenizer, bool fast_scan)
+    { dynamic_cast<GncCsvTokenizer*>(tokenizer.get())->m_fast_scan = fast_scan; }
     void test_gnc_tokenize_helper (const std::string& separators, tokenize_csv_test_data* test_data); // for csv tokenizer
     void test_gnc_tokenize_helper (tokenize_fw_test_data* test_data); // for csv tokenizer
 
@@ -129,6 +134,60 @@ TEST_F (GncTokenizerTest, tokenize_from_csv_file)
     EXPECT_EQ(std::string("1,100.00"), tokens.at(1).at(6));
 }
 
+TEST_F (GncTokenizerTest, stream_from_csv_file)
+{
+    auto file = get_filepath ("sample1.csv");
+
+    csv_tok->open_stream (file);
+    StrVec row;
+    ASSERT_TRUE (csv_tok->next_row (row));
+    EXPECT_EQ(8ul, row.size());
+    EXPECT_EQ(std::string("Date"), row.at(0));
+    ASSERT_TRUE (csv_tok->next_row (row));
+    EXPECT_EQ(8ul, row.size());
+    EXPECT_EQ(std::string("1,100.00"), row.at(6));
+    EXPECT_FALSE (csv_tok->next_row (row));
+
+    EXPECT_THROW (csv_tok->open_stream (get_filepath ("notexist.csv")),
+                  std::ios_base::failure);
+}
+
+/* Streaming reads the file in chunks, so feed it a file with multi-byte
+ * characters, quoted line breaks and mixed line endings that spans
+ * several chunks and compare with the result of loading it in one go.
+ */
+TEST_F (GncTokenizerTest, stream_matches_tokenize)
+{
+    auto file = std::string ("test-tokenizer-stream.csv");
+    {
+        std::ofstream out (file, std::ios::binary);
+        for (auto i = 0; i < 5000; i++)
+        {
+            out << "05/01/15," << i << ",Caf\xc3\xa9 \xe2\x82\xac" << i;
+            if (i % 7 == 0)
+                out << ",\"multi\r\nline\"";
+            out << (i % 3 == 0 ? "\n" : (i % 3 == 1 ? "\r\n" : "\r"));
+        }
+    }
+
+    csv_tok->load_file (file);
+    csv_tok->tokenize();
+    auto tokens = csv_tok->get_tokens();
+
+    auto stream_tok = gnc_tokenizer_factory(GncImpFileFormat::CSV);
+    stream_tok->encoding ("UTF-8");
+    stream_tok->open_stream (file);
+    StrVec row;
+    auto rows = std::vector<StrVec>();
+    while (stream_tok->next_row (row))
+        rows.push_back (row);
+    std::remove (file.c_str());
+
+    ASSERT_EQ(5000ul, rows.size());
+    EXPECT_EQ(tokens, rows);
+    EXPECT_EQ(std::string ("Caf\xc3\xa9 \xe2\x82\xac" "4999"), rows.back().at(2));
+}
+
 /* Test parsing for several different prepared strings
  * These tests bypass file loading, rather taking a
  * prepared set of strings as input. This makes it
@@ -179,6 +238,8 @@ static tokenize_csv_test_data comma_separated [] = {
         { "Test with \\\" escaped quote,nextfield", 2, { "Test with \" escaped quote","nextfield",NULL,NULL,NULL,NULL,NULL,NULL } },
         { "Test with \"\" escaped quote,nextfield", 2, { "Test with \" escaped quote","nextfield",NULL,NULL,NULL,NULL,NULL,NULL } },
         { "\"Unescaped quote test\",nextfield", 2, { "Unescaped quote test","nextfield",NULL,NULL,NULL,NULL,NULL,NULL } },
+        { "\"Quoted, with separator\",\"\",a\"\"b,,", 5, { "Quoted, with separator","","a\"b","","",NULL,NULL,NULL } },
+        { "\"\"\"Quoted quote\"\"\",a long field to fill more than one vector block,last", 3, { "\"Quoted quote\"","a long field to fill more than one vector block","last",NULL,NULL,NULL,NULL,NULL } },
         { NULL, 0, { NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL } },
 };
 
@@ -198,6 +259,99 @@ TEST_F (GncTokenizerTest, tokenize_semicolon_sep)
     test_gnc_tokenize_helper (";", semicolon_separated);
 }
 
+/* Reports the csv tokenizer throughput on a generated file, so changes to
+ * the scanner can be compared. Only the result is checked, not the speed.
+ */
+TEST_F (GncTokenizerTest, tokenize_csv_throughput)
+{
+    const auto num_lines = 100000ul;
+    auto contents = std::string();
+    for (auto i = 0ul; i < num_lines; i++)
+        contents += "05/01/15," + std::to_string (i) +
+            ",\"Acme, Inc.\",Monthly \"\"premium\"\" plan,Expenses:Miscellaneous,,\"1,100.00\",\n";
+
+    set_utf8_contents (csv_tok, contents);
+    auto start = std::chrono::steady_clock::now();
+    csv_tok->tokenize();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    auto tokens = csv_tok->get_tokens();
+    ASSERT_EQ(num_lines, tokens.size());
+    EXPECT_EQ(8ul, tokens.back().size());
+    EXPECT_EQ(std::string("Acme, Inc."), tokens.back().at(2));
+    EXPECT_EQ(std::string("Monthly \"premium\" plan"), tokens.back().at(3));
+    EXPECT_EQ(std::string("1,100.00"), tokens.back().at(6));
+    std::cout << "Tokenized " << contents.size() / 1024 << " KiB in "
+              << elapsed.count() << " s ("
+              << contents.size() / (1024.0 * 1024.0) / elapsed.count() << " MiB/s)"
+              << std::endl;
+}
+
+
+/* Random csv lines of plain, quoted and partly quoted fields, with ""
+ * pairs, separators inside quotes and multibyte characters, but no
+ * backslashes, so the fast scanner handles all of them. */
+static std::string
+random_csv (std::mt19937& rng, size_t num_lines)
+{
+    static const StrVec plain { "a", "b", "1", " ", "\xc3\xa9" };
+    static const StrVec quoted { "a", " ", ",", ";", "\"\"", "\xc3\xa9" };
+    static const StrVec seps { ",", ";" };
+    auto pick = [&rng](const StrVec& from) { return from[rng() % from.size()]; };
+    auto run = [&rng, &pick](const StrVec& from)
+               {
+                   auto str = std::string();
+                   for (auto n = rng() % 5; n > 0; n--)
+                       str += pick (from);
+                   return str;
+               };
+
+    auto contents = std::string();
+    for (auto i = 0ul; i < num_lines; i++)
+    {
+        for (auto n = rng() % 8; n > 0; n--)
+        {
+            switch (rng() % 4)
+            {
+            case 0:
+                contents += run (plain);
+                break;
+            case 1:
+                contents += "\"" + run (quoted) + "\"";
+                break;
+            case 2:
+                contents += "\"\"";
+                break;
+            default:
+                contents += run (plain) + "\"" + run (quoted) + "\"" + run (plain);
+                break;
+            }
+            contents += pick (seps);
+        }
+        contents += run (plain) + "\n";
+    }
+    return contents;
+}
+
+/* The fast scanner must split lines exactly like the boost based path. */
+TEST_F (GncTokenizerTest, tokenize_csv_fast_matches_boost)
+{
+    std::mt19937 rng (20151005);    // fixed seed, failures are reproducible
+    auto csvtok = dynamic_cast<GncCsvTokenizer*>(csv_tok.get());
+    csvtok->set_separators (",;");
+
+    set_utf8_contents (csv_tok, random_csv (rng, 10000));
+    csv_tok->tokenize();
+    auto fast_tokens = csv_tok->get_tokens();
+
+    set_fast_scan (csv_tok, false);
+    csv_tok->tokenize();
+    auto boost_tokens = csv_tok->get_tokens();
+
+    ASSERT_EQ(boost_tokens.size(), fast_tokens.size());
+    for (auto i = 0ul; i < fast_tokens.size(); i++)
+        EXPECT_EQ(boost_tokens[i], fast_tokens[i]) << "line " << i;
+}
 
 
 void
@@ -22,19 +22,36 @@
  * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
  ********************************************************************/
 
+#include <config.h>
 #include <guid.hpp>
 #include "../gnc-tokenizer.hpp"
 #include "../gnc-tokenizer-csv.hpp"
 #include "../gnc-tokenizer-fw.hpp"
 #include <gtest/gtest.h>
+#include <glib.h>
+#include <glib/gstdio.h>
 #include <iostream>
 #include <fstream>      // fstream
 
+#include <cstdio>
 #include <string>
+#include <vector>
 #include <stdlib.h>     /* getenv */
+#include <unistd.h>
+
+extern "C"
+{
+#include <Account.h>
+#include <Transaction.h>
+#include <cashobjects.h>
+#include <gnc-commodity.h>
+#include <gnc-session.h>
+#include <gnc-ui-util.h>
+}
 
 /* Add specific headers for this class */
 #include "../gnc-import-tx.hpp"
+#include "../gnc-csv-account-map.h"
 
 //typedef struct
 //{
@@ -62,3 +79,204 @@ public:
 protected:
     std::unique_ptr<GncTxImport> tx_importer;
 };
+
+class TestEnvironment : public testing::Environment
+{
+public:
+    void SetUp() override
+    {
+        qof_init ();
+        cashobjects_register ();
+    }
+
+    void TearDown() override
+    {
+        qof_close ();
+    }
+};
+
+testing::Environment* const env = testing::AddGlobalTestEnvironment(new TestEnvironment);
+
+/* Set up for the tests comparing a serial parse with a parallel one:
+ * a multi-split file long enough to span more than one block of lines
+ * and the accounts its Account column maps to. */
+class GncTxImportParseTest : public GncTxImportTest
+{
+protected:
+    void SetUp() override
+    {
+        auto book = gnc_get_current_book ();
+        auto table = gnc_commodity_table_get_table (book);
+        m_usd = gnc_commodity_table_lookup (table, GNC_COMMODITY_NS_CURRENCY, "USD");
+        make_account ("Bank", ACCT_TYPE_BANK);
+        make_account ("Expenses", ACCT_TYPE_EXPENSE);
+        m_filename = write_multi_split_file ();
+    }
+
+    void TearDown() override
+    {
+        g_remove (m_filename.c_str());
+        gnc_clear_current_session ();
+    }
+
+    void make_account (const char* name, GNCAccountType type)
+    {
+        auto book = gnc_get_current_book ();
+        auto acc = xaccMallocAccount (book);
+        xaccAccountBeginEdit (acc);
+        xaccAccountSetName (acc, name);
+        xaccAccountSetType (acc, type);
+        xaccAccountSetCommodity (acc, m_usd);
+        gnc_account_append_child (gnc_book_get_root_account (book), acc);
+        xaccAccountCommitEdit (acc);
+        gnc_csv_account_map_change_mappings (nullptr, acc, name);
+    }
+
+    /* Each transaction has a Bank split and an Expenses split on a
+     * continuation line with empty transaction columns. Every third one
+     * gets a third split that repeats the transaction columns. Some
+     * transactions have a bad date, some splits a bad amount or an
+     * account that can't be mapped. */
+    std::string write_multi_split_file ()
+    {
+        gchar* filename = nullptr;
+        auto fd = g_file_open_tmp ("test-tx-import-XXXXXX.csv", &filename, nullptr);
+        EXPECT_NE (fd, -1);
+        close (fd);
+        std::ofstream out (filename);
+        out << "Date,Num,Description,Account,Amount,Memo\n";
+        for (int k = 0; k < 4000; k++)
+        {
+            auto amount = std::to_string (1 + k / 100) + "." + std::to_string (10 + k % 90);
+            char date[11];
+            snprintf (date, sizeof(date), "2020-%02d-%02d", 1 + k % 12, 1 + k % 28);
+            auto trans_cols = std::string (date) + "," + std::to_string (k) +
+                              ",Payee " + std::to_string (k % 13);
+            if (k % 97 == 5)
+            {
+                out << "2020-13-45," << k << ",Bad date,Bank," << amount << ",\n";
+                continue;
+            }
+            out << trans_cols << ",Bank," << amount << ",memo " << k << "\n";
+            if (k % 89 == 7)
+                out << ",,,Expenses,x12,\n";
+            else if (k % 101 == 9)
+                out << ",,,Nowhere,-" << amount << ",\n";
+            else
+                out << ",,,Expenses,-" << amount << ",split " << k << "\n";
+            if (k % 3 == 0)
+                out << trans_cols << ",Expenses,0.01,third\n";
+        }
+        std::string result (filename);
+        g_free (filename);
+        return result;
+    }
+
+    /* Loads and parses m_filename the way the import assistant does,
+     * returning the time spent parsing the columns in microseconds. */
+    gint64 parse_file (GncTxImport& importer, uint32_t n_threads)
+    {
+        importer.file_format (GncImpFileFormat::CSV);
+        importer.multi_split (true);
+        importer.parse_threads (n_threads);
+        importer.load_file (m_filename);
+        importer.tokenize (true);
+        importer.separators (",");
+        importer.tokenize (false);
+        importer.date_format (0);       // y-m-d
+        importer.currency_format (1);   // Period: 123,456.78
+        importer.update_skipped_lines (1, 0, false, false);
+
+        auto t_start = g_get_monotonic_time ();
+        uint32_t col = 0;
+        for (auto type : { GncTransPropType::DATE, GncTransPropType::NUM,
+                           GncTransPropType::DESCRIPTION, GncTransPropType::ACCOUNT,
+                           GncTransPropType::DEPOSIT, GncTransPropType::MEMO })
+            importer.set_column_type (col++, type);
+        return g_get_monotonic_time () - t_start;
+    }
+
+    /* Per line, the errors and the first line of the transaction it was
+     * grouped into. */
+    std::vector<std::string> describe_lines (GncTxImport& importer)
+    {
+        std::vector<std::string> result;
+        size_t first_line = 0;
+        for (size_t i = 0; i < importer.m_parsed_lines.size(); i++)
+        {
+            auto& line = importer.m_parsed_lines[i];
+            if (i == 0 || std::get<PL_PRETRANS>(line) !=
+                          std::get<PL_PRETRANS>(importer.m_parsed_lines[i - 1]))
+                first_line = i;
+            result.push_back (std::to_string (first_line) + ": " +
+                              std::get<PL_ERROR>(line));
+        }
+        return result;
+    }
+
+    std::vector<std::string> describe_transactions (GncTxImport& importer)
+    {
+        std::vector<std::string> result;
+        for (auto& draft : importer.m_transactions)
+        {
+            auto trans = draft.second->trans;
+            auto desc = std::to_string (xaccTransGetDate (trans)) + " " +
+                        xaccTransGetNum (trans) + " " +
+                        xaccTransGetDescription (trans) + ":";
+            for (auto node = xaccTransGetSplitList (trans); node; node = node->next)
+            {
+                auto split = static_cast<Split*>(node->data);
+                auto amount = gnc_numeric_to_string (xaccSplitGetAmount (split));
+                desc = desc + " " + xaccAccountGetName (xaccSplitGetAccount (split)) +
+                       " " + amount + " " + xaccSplitGetMemo (split) + ";";
+                g_free (amount);
+            }
+            result.push_back (desc);
+        }
+        return result;
+    }
+
+    gnc_commodity* m_usd = nullptr;
+    std::string m_filename;
+};
+
+TEST_F (GncTxImportParseTest, parallel_parse_matches_serial)
+{
+    auto parallel_importer = std::unique_ptr<GncTxImport>(new GncTxImport);
+    auto serial_usecs = parse_file (*tx_importer, 1);
+    auto parallel_usecs = parse_file (*parallel_importer, 4);
+    std::cout << "Parsed " << tx_importer->m_parsed_lines.size()
+              << " lines in " << serial_usecs / 1000 << " ms on one thread, "
+              << parallel_usecs / 1000 << " ms on four threads\n";
+    RecordProperty ("serial_ms", static_cast<int>(serial_usecs / 1000));
+    RecordProperty ("parallel_ms", static_cast<int>(parallel_usecs / 1000));
+
+    /* The file should be long enough to be parsed in more than one block */
+    ASSERT_GT (tx_importer->m_parsed_lines.size(), 8192u);
+
+    auto serial_lines = describe_lines (*tx_importer);
+    auto parallel_lines = describe_lines (*parallel_importer);
+    ASSERT_EQ (serial_lines.size(), parallel_lines.size());
+    for (size_t i = 0; i < serial_lines.size(); i++)
+        ASSERT_EQ (serial_lines[i], parallel_lines[i]) << "line " << i;
+
+    /* Spot check the grouping and the errors themselves */
+    EXPECT_EQ (serial_lines[1], "1: ");
+    EXPECT_EQ (serial_lines[2], "1: ");
+    EXPECT_EQ (serial_lines[3], "1: ");
+    EXPECT_EQ (serial_lines[4], "4: ");
+    auto n_errors = 0;
+    for (auto& line : tx_importer->m_parsed_lines)
+        if (!std::get<PL_ERROR>(line).empty())
+            n_errors++;
+    /* The header, 42 bad dates, 45 bad amounts and 40 unmapped accounts */
+    EXPECT_EQ (n_errors, 1 + 42 + 45 + 40);
+
+    tx_importer->update_skipped_lines (boost::none, boost::none, boost::none, true);
+    parallel_importer->update_skipped_lines (boost::none, boost::none, boost::none, true);
+    tx_importer->create_transactions ();
+    parallel_importer->create_transactions ();
+    EXPECT_EQ (tx_importer->m_transactions.size(), 4000u - 42u);
+    EXPECT_EQ (describe_transactions (*tx_importer),
+               describe_transactions (*parallel_importer));
+}
@@ -389,10 +389,11 @@ GdkPixbuf* gen_probability_pixbuf(gint score_original, GNCImportSettings *settin
  */
 
 /* Tokenize a string and append to an existing GList(or an empty GList)
- * the tokens
+ * the tokens.  seen holds the tokens already in the list, so that
+ * duplicates are skipped without walking the list.
  */
 static GList*
-tokenize_string(GList* existing_tokens, const char *string)
+tokenize_string(GList* existing_tokens, const char *string, GHashTable *seen)
 {
     char **tokenized_strings; /* array of strings returned by g_strsplit() */
     char **stringpos;
@@ -403,23 +404,13 @@ tokenize_string(GList* existing_tokens, const char *string)
     /* add each token to the token GList */
     while (stringpos && *stringpos)
     {
-        if (strlen(*stringpos) > 0)
+        /* skip empty and duplicated tokens */
+        if (strlen(*stringpos) > 0 && !g_hash_table_contains (seen, *stringpos))
         {
-            /* check for duplicated tokens */
-            gboolean duplicated = FALSE;
-            for (GList* token = existing_tokens; token != NULL; token = token->next)
-            {
-                if (g_strcmp0(token->data, *stringpos) == 0)
-                {
-                    duplicated = TRUE;
-                    break;
-                }
-            }
-            if (duplicated == FALSE)
-            {
-                /* prepend the char* to the token GList */
-                existing_tokens = g_list_prepend(existing_tokens, g_strdup(*stringpos));
-            }
+            char *token = g_strdup(*stringpos);
+            g_hash_table_add (seen, token);
+            /* prepend the char* to the token GList */
+            existing_tokens = g_list_prepend(existing_tokens, token);
         }
 
         /* then move to the next string */
@@ -442,6 +433,7 @@ TransactionGetTokens(GNCImportTransInfo *info)
     time64 transtime;
     struct tm *tm_struct;
     char local_day_of_week[16];
+    GHashTable *seen;
 
     g_return_val_if_fail (info, NULL);
     if (info->match_tokens) return info->match_tokens;
@@ -450,10 +442,12 @@ TransactionGetTokens(GNCImportTransInfo *info)
     g_assert(transaction);
 
     tokens = 0; /* start off with an empty list */
+    /* the list owns the strings; the set only points at them */
+    seen = g_hash_table_new (g_str_hash, g_str_equal);
 
     /* make tokens from the transaction description */
     text = xaccTransGetDescription(transaction);
-    tokens = tokenize_string(tokens, text);
+    tokens = tokenize_string(tokens, text, seen);
 
     /* The day of week the transaction occurred is a good indicator of
      * what account this transaction belongs in.  Get the date and covert
@@ -470,13 +464,15 @@ TransactionGetTokens(GNCImportTransInfo *info)
      * it frees the same way the rest do
      */
     tokens = g_list_prepend(tokens, g_strdup(local_day_of_week));
+    g_hash_table_add (seen, tokens->data);
 
     /* make tokens from the memo of each split of this transaction */
     for (GList *split=xaccTransGetSplitList (transaction); split; split=split->next)
     {
         text = xaccSplitGetMemo(split->data);
-        tokens = tokenize_string(tokens, text);
+        tokens = tokenize_string(tokens, text, seen);
     }
+    g_hash_table_destroy (seen);
 
     /* remember the list of tokens for later.. */
     info->match_tokens = tokens;
@@ -829,6 +825,250 @@ void split_find_match (GNCImportTransInfo * trans_info,
     }
 }/* end split_find_match */
 
+/***********************************************************************
+ * Candidate index for split_find_match
+ *
+ * Scoring every candidate split against every imported transaction is
+ * quadratic.  The amount and date heuristics above dominate the score: the
+ * number, memo and description heuristics add at most MATCH_MAX_TEXT_SCORE,
+ * so a candidate whose amount and date scores can't reach the display
+ * threshold with that bonus will never be listed.  The index keeps the
+ * candidates of each account sorted by amount and by date, and only the
+ * ones that can still make the threshold are scored.
+ */
+
+/* Number +4, memo +2, description +2 */
+#define MATCH_MAX_TEXT_SCORE 8
+#define MATCH_AMOUNT_EPSILON 1e-6
+
+typedef struct
+{
+    Split *split;
+    time64 date;
+    double amount;
+    guint ordinal;
+} MatchCandidate;
+
+typedef struct
+{
+    GArray *by_amount;          /* of MatchCandidate */
+    GArray *by_date;            /* of MatchCandidate */
+} MatchAccountIndex;
+
+struct _GNCImportMatchIndex
+{
+    GHashTable *accounts;       /* Account* -> MatchAccountIndex* */
+};
+
+static gint
+compare_candidate_amount (gconstpointer a, gconstpointer b)
+{
+    double da = ((const MatchCandidate*)a)->amount;
+    double db = ((const MatchCandidate*)b)->amount;
+    return (da > db) - (da < db);
+}
+
+static gint
+compare_candidate_date (gconstpointer a, gconstpointer b)
+{
+    time64 ta = ((const MatchCandidate*)a)->date;
+    time64 tb = ((const MatchCandidate*)b)->date;
+    return (ta > tb) - (ta < tb);
+}
+
+static gint
+compare_candidate_ordinal (gconstpointer a, gconstpointer b)
+{
+    guint oa = (*(MatchCandidate * const *)a)->ordinal;
+    guint ob = (*(MatchCandidate * const *)b)->ordinal;
+    return (oa > ob) - (oa < ob);
+}
+
+static void
+match_account_index_free (MatchAccountIndex *acc_index)
+{
+    g_array_free (acc_index->by_amount, TRUE);
+    g_array_free (acc_index->by_date, TRUE);
+    g_free (acc_index);
+}
+
+GNCImportMatchIndex *
+gnc_import_match_index_new (GList *candidate_splits)
+{
+    GNCImportMatchIndex *index = g_new0 (GNCImportMatchIndex, 1);
+    GHashTableIter iter;
+    gpointer value;
+    guint ordinal = 0;
+
+    index->accounts = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+                                             (GDestroyNotify)match_account_index_free);
+    for (GList *node = candidate_splits; node; node = node->next)
+    {
+        Split *split = node->data;
+        Account *account = xaccSplitGetAccount (split);
+        MatchAccountIndex *acc_index = g_hash_table_lookup (index->accounts, account);
+        MatchCandidate candidate;
+
+        if (!acc_index)
+        {
+            acc_index = g_new0 (MatchAccountIndex, 1);
+            acc_index->by_amount = g_array_new (FALSE, FALSE, sizeof (MatchCandidate));
+            acc_index->by_date = g_array_new (FALSE, FALSE, sizeof (MatchCandidate));
+            g_hash_table_insert (index->accounts, account, acc_index);
+        }
+        candidate.split = split;
+        candidate.date = xaccTransGetDate (xaccSplitGetParent (split));
+        candidate.amount = gnc_numeric_to_double (xaccSplitGetAmount (split));
+        candidate.ordinal = ordinal++;
+        g_array_append_val (acc_index->by_amount, candidate);
+        g_array_append_val (acc_index->by_date, candidate);
+    }
+
+    g_hash_table_iter_init (&iter, index->accounts);
+    while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+        MatchAccountIndex *acc_index = value;
+        g_array_sort (acc_index->by_amount, compare_candidate_amount);
+        g_array_sort (acc_index->by_date, compare_candidate_date);
+    }
+    return index;
+}
+
+void
+gnc_import_match_index_destroy (GNCImportMatchIndex *index)
+{
+    if (!index) return;
+    g_hash_table_destroy (index->accounts);
+    g_free (index);
+}
+
+/* The amount test of split_find_match that doesn't give the -5 penalty. */
+static inline gboolean
+match_amount_close (double a, double b, double fuzzy_amount_difference)
+{
+    return fabs (a - b) < MATCH_AMOUNT_EPSILON ||
+           fabs (a - b) <= fuzzy_amount_difference;
+}
+
+/* Index of the first candidate whose amount is >= amount. */
+static guint
+candidate_amount_lower_bound (GArray *array, double amount)
+{
+    guint lo = 0, hi = array->len;
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+        if (g_array_index (array, MatchCandidate, mid).amount < amount)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* Index of the first candidate whose date is >= date. */
+static guint
+candidate_date_lower_bound (GArray *array, time64 date)
+{
+    guint lo = 0, hi = array->len;
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+        if (g_array_index (array, MatchCandidate, mid).date < date)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+void
+gnc_import_match_index_find_matches (GNCImportMatchIndex *index,
+                                     GNCImportTransInfo *trans_info,
+                                     gint display_threshold,
+                                     double fuzzy_amount_difference)
+{
+    Split *fsplit;
+    MatchAccountIndex *acc_index;
+    GPtrArray *hits;
+    double amount, width;
+    time64 date;
+    gint date_score_needed;
+    gint max_days = -1;
+    guint i;
+
+    g_return_if_fail (index && trans_info);
+    fsplit = gnc_import_TransInfo_get_fsplit (trans_info);
+    acc_index = g_hash_table_lookup (index->accounts, xaccSplitGetAccount (fsplit));
+    if (!acc_index) return;
+
+    amount = gnc_numeric_to_double (xaccSplitGetAmount (fsplit));
+    date = xaccTransGetDate (gnc_import_TransInfo_get_trans (trans_info));
+    hits = g_ptr_array_new ();
+
+    /* Candidates whose amount is off get -5 for it, so their date score
+     * must make up the rest. */
+    date_score_needed = display_threshold - MATCH_MAX_TEXT_SCORE + 5;
+    if (date_score_needed <= -5)
+        max_days = G_MAXINT;
+    else if (date_score_needed <= 0)
+        max_days = MATCH_DATE_NOT_THRESHOLD;
+    else if (date_score_needed <= 2)
+        max_days = MATCH_DATE_THRESHOLD;
+    else if (date_score_needed <= 3)
+        max_days = 0;
+
+    if (max_days == G_MAXINT)
+    {
+        for (i = 0; i < acc_index->by_date->len; i++)
+            g_ptr_array_add (hits, &g_array_index (acc_index->by_date,
+                                                   MatchCandidate, i));
+    }
+    else
+    {
+        /* Amount within the fuzzy range, any date; a little slack on the
+         * bounds keeps rounding from dropping anything the exact test in
+         * match_amount_close accepts. */
+        width = MAX (fuzzy_amount_difference, MATCH_AMOUNT_EPSILON) * (1 + 1e-9) + 1e-9;
+        for (i = candidate_amount_lower_bound (acc_index->by_amount, amount - width);
+             i < acc_index->by_amount->len; i++)
+        {
+            MatchCandidate *candidate = &g_array_index (acc_index->by_amount,
+                                                        MatchCandidate, i);
+            if (candidate->amount > amount + width) break;
+            if (match_amount_close (amount, candidate->amount,
+                                    fuzzy_amount_difference))
+                g_ptr_array_add (hits, candidate);
+        }
+
+        /* Any other amount, close enough in date. */
+        if (max_days >= 0)
+        {
+            time64 span = ((time64)max_days + 1) * 86400;
+            for (i = candidate_date_lower_bound (acc_index->by_date, date - span + 1);
+                 i < acc_index->by_date->len; i++)
+            {
+                MatchCandidate *candidate = &g_array_index (acc_index->by_date,
+                                                            MatchCandidate, i);
+                if (candidate->date >= date + span) break;
+                if (!match_amount_close (amount, candidate->amount,
+                                         fuzzy_amount_difference))
+                    g_ptr_array_add (hits, candidate);
+            }
+        }
+    }
+
+    /* Score in candidate order, so that ties sort as before. */
+    g_ptr_array_sort (hits, compare_candidate_ordinal);
+    for (i = 0; i < hits->len; i++)
+    {
+        MatchCandidate *candidate = g_ptr_array_index (hits, i);
+        split_find_match (trans_info, candidate->split, display_threshold,
+                          fuzzy_amount_difference);
+    }
+    g_ptr_array_free (hits, TRUE);
+}
+
 /***********************************************************************
  */
 
@@ -81,6 +81,37 @@ void split_find_match (GNCImportTransInfo * trans_info,
                        gint display_threshold,
                        double fuzzy_amount_difference);
 
+/** An index of candidate splits for split_find_match(), by account,
+ * amount and date. */
+typedef struct _GNCImportMatchIndex GNCImportMatchIndex;
+
+/** Build a match index over the given candidate splits.  The splits
+ * are scored in list order, which decides between matches of equal
+ * probability.
+ *
+ * @param candidate_splits The register splits that may match.
+ */
+GNCImportMatchIndex *gnc_import_match_index_new (GList *candidate_splits);
+
+/** Calls split_find_match() on the candidates of the index that are in
+ * the account of trans_info and can reach display_threshold at all,
+ * judged by their amount and date.
+ *
+ * @param index The match index.
+ *
+ * @param trans_info The TransInfo for the imported transaction
+ *
+ * @param display_threshold Minimum match score to include split in the list of matches.
+ *
+ * @param fuzzy_amount_difference Maximum amount difference to consider the match good.
+ */
+void gnc_import_match_index_find_matches (GNCImportMatchIndex *index,
+                                          GNCImportTransInfo *trans_info,
+                                          gint display_threshold,
+                                          double fuzzy_amount_difference);
+
+void gnc_import_match_index_destroy (GNCImportMatchIndex *index);
+
 /** Iterates through all splits of the originating account of
  * trans_info. Sorts the resulting list and sets the selected_match
  * and action fields in the trans_info.
@@ -474,6 +474,8 @@ on_matcher_ok_clicked (GtkButton *button, GNCImportMainMatcher *info)
     /* Don't run any queries and/or split sorts while processing the matcher
     results. */
     gnc_suspend_gui_refresh ();
+    /* Collapse the many modify events fired per committed transaction. */
+    qof_event_begin_batch ();
     do
     {
         gtk_tree_model_get (model, &iter,
@@ -493,6 +495,7 @@ on_matcher_ok_clicked (GtkButton *button, GNCImportMainMatcher *info)
         }
     }
     while (gtk_tree_model_iter_next (model, &iter));
+    qof_event_end_batch ();
 
     gnc_gen_trans_list_delete (info);
 
@@ -1773,44 +1776,26 @@ query_imported_transaction_accounts (GNCImportMainMatcher *gui)
     return retval;
 }
 
-/* Create a hash by account of all splits that could match one of the imported
- * transactions based on their account and date and organized per account.
+/* Index all splits that could match one of the imported transactions, based
+ * on their account and date, by account, amount and date.
  */
-static GHashTable*
-create_hash_of_potential_matches (GList *candidate_txns,
-                                  GHashTable *account_hash)
+static GNCImportMatchIndex*
+create_index_of_potential_matches (GList *candidate_txns)
 {
+    GNCImportMatchIndex *index;
+    GList *candidates = NULL;
+
+    /* Prepending keeps the order candidates were always scored in. */
     for (GList* candidate = candidate_txns; candidate != NULL;
          candidate = g_list_next (candidate))
     {
-        Account* split_account;
-        GSList* split_list;
         if (gnc_import_split_has_online_id (candidate->data))
             continue;
-        split_account = xaccSplitGetAccount (candidate->data);
-        /* g_hash_table_steal_extended would do the two calls in one shot but is
-         * not available until GLib 2.58.
-         */
-        split_list = g_hash_table_lookup (account_hash, split_account);
-        g_hash_table_steal (account_hash, split_account);
-        split_list = g_slist_prepend (split_list, candidate->data);
-        g_hash_table_insert (account_hash, split_account, split_list);
+        candidates = g_list_prepend (candidates, candidate->data);
     }
-    return account_hash;
-}
-
-typedef struct _match_struct
-{
-    GNCImportTransInfo* transaction_info;
-    gint display_threshold;
-    double fuzzy_amount;
-} match_struct;
-
-static void
-match_helper (Split* data, match_struct* s)
-{
-    split_find_match (s->transaction_info, data,
-                      s->display_threshold, s->fuzzy_amount);
+    index = gnc_import_match_index_new (candidates);
+    g_list_free (candidates);
+    return index;
 }
 
 /* Iterate through the imported transactions selecting matches from the
@@ -1819,7 +1804,7 @@ match_helper (Split* data, match_struct* s)
  */
 
 static void
-perform_matching (GNCImportMainMatcher *gui, GHashTable *account_hash)
+perform_matching (GNCImportMainMatcher *gui, GNCImportMatchIndex *match_index)
 {
     GtkTreeModel* model = gtk_tree_view_get_model (gui->view);
     gint display_threshold =
@@ -1834,11 +1819,9 @@ perform_matching (GNCImportMainMatcher *gui, GHashTable *account_hash)
         GNCImportMatchInfo *selected_match;
         gboolean match_selected_manually;
         GNCImportTransInfo* txn_info = imported_txn->data;
-        Account *importaccount = xaccSplitGetAccount (gnc_import_TransInfo_get_fsplit (txn_info));
-        match_struct s = {txn_info, display_threshold, fuzzy_amount};
 
-        g_slist_foreach (g_hash_table_lookup (account_hash, importaccount),
-                         (GFunc) match_helper, &s);
+        gnc_import_match_index_find_matches (match_index, txn_info,
+                                             display_threshold, fuzzy_amount);
 
         // Sort the matches, select the best match, and set the action.
         gnc_import_TransInfo_init_matches (txn_info, gui->user_settings);
@@ -1860,18 +1843,16 @@ perform_matching (GNCImportMainMatcher *gui, GHashTable *account_hash)
 void
 gnc_gen_trans_list_create_matches (GNCImportMainMatcher *gui)
 {
-    GHashTable* account_hash =
-        g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
-                              (GDestroyNotify)g_slist_free);
+    GNCImportMatchIndex *match_index;
     GList *candidate_txns;
     g_assert (gui);
     candidate_txns = query_imported_transaction_accounts (gui);
 
-    create_hash_of_potential_matches (candidate_txns, account_hash);
-    perform_matching (gui, account_hash);
+    match_index = create_index_of_potential_matches (candidate_txns);
+    perform_matching (gui, match_index);
 
     g_list_free (candidate_txns);
-    g_hash_table_destroy (account_hash);
+    gnc_import_match_index_destroy (match_index);
     return;
 }
 
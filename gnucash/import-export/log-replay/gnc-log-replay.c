@@ -359,21 +359,185 @@ static void dump_split_record(split_record record)
     }
 }
 
+/* The transaction being replayed. */
+typedef struct
+{
+    Transaction *trans;
+    char *trans_ro;
+    int first_record;
+} replay_state;
+
+static void replay_split_record (split_record *record, replay_state *state)
+{
+    Split * split = NULL;
+    Account * acct = NULL;
+    QofBook * book = gnc_get_current_book();
+
+    if (record->log_action_present)
+    {
+        switch (record->log_action)
+        {
+        case LOG_BEGIN_EDIT:
+            DEBUG("replay_split_record():Ignoring log action: LOG_BEGIN_EDIT"); /*Do nothing, there is no point*/
+            break;
+        case LOG_ROLLBACK:
+            DEBUG("replay_split_record():Ignoring log action: LOG_ROLLBACK");/*Do nothing, since we didn't do the begin_edit either*/
+            break;
+        case LOG_DELETE:
+            DEBUG("replay_split_record(): Playing back LOG_DELETE");
+            if ((state->trans = xaccTransLookup (&(record->trans_guid), book)) != NULL
+                    && state->first_record == TRUE)
+            {
+                state->first_record = FALSE;
+                if (xaccTransGetReadOnly(state->trans))
+                {
+                    PWARN("Destroying a read only transaction.");
+                    xaccTransClearReadOnly(state->trans);
+                }
+                xaccTransBeginEdit(state->trans);
+                xaccTransDestroy(state->trans);
+            }
+            else if (state->first_record == TRUE)
+            {
+                PERR("The transaction to delete was not found!");
+            }
+            else
+                xaccTransDestroy(state->trans);
+            break;
+        case LOG_COMMIT:
+            DEBUG("replay_split_record(): Playing back LOG_COMMIT");
+            if (record->trans_guid_present == TRUE
+                    && state->first_record == TRUE)
+            {
+                state->trans = xaccTransLookupDirect (record->trans_guid, book);
+                if (state->trans != NULL)
+                {
+                    DEBUG("replay_split_record(): Transaction to be edited was found");
+                    xaccTransBeginEdit(state->trans);
+                    state->trans_ro = g_strdup(xaccTransGetReadOnly(state->trans));
+                    if (state->trans_ro)
+                    {
+                        PWARN("Replaying a read only transaction.");
+                        xaccTransClearReadOnly(state->trans);
+                    }
+                }
+                else
+                {
+                    DEBUG("replay_split_record(): Creating a new transaction");
+                    state->trans = xaccMallocTransaction (book);
+                    xaccTransBeginEdit(state->trans);
+                }
+
+                qof_instance_set_guid (QOF_INSTANCE (state->trans),
+                                       &(record->trans_guid));
+                /*Fill the transaction info*/
+                if (record->date_entered_present)
+                {
+                    xaccTransSetDateEnteredSecs(state->trans, record->date_entered);
+                }
+                if (record->date_posted_present)
+                {
+                    xaccTransSetDatePostedSecs(state->trans, record->date_posted);
+                }
+                if (record->trans_num_present)
+                {
+                    xaccTransSetNum(state->trans, record->trans_num);
+                }
+                if (record->trans_descr_present)
+                {
+                    xaccTransSetDescription(state->trans, record->trans_descr);
+                }
+                if (record->trans_notes_present)
+                {
+                    xaccTransSetNotes(state->trans, record->trans_notes);
+                }
+            }
+            if (record->split_guid_present == TRUE) /*Fill the split info*/
+            {
+                gboolean is_new_split;
+
+                split = xaccSplitLookupDirect (record->split_guid, book);
+                if (split != NULL)
+                {
+                    DEBUG("replay_split_record(): Split to be edited was found");
+                    is_new_split = FALSE;
+                }
+                else
+                {
+                    DEBUG("replay_split_record(): Creating a new split");
+                    split = xaccMallocSplit(book);
+                    is_new_split = TRUE;
+                }
+                xaccSplitSetGUID (split, &(record->split_guid));
+                if (record->acc_guid_present)
+                {
+                    acct = xaccAccountLookupDirect(record->acc_guid, book);
+                    xaccAccountInsertSplit(acct, split);
+
+                    // No currency in the txn yet? Set one now.
+                    if (!xaccTransGetCurrency(state->trans))
+                        xaccTransSetCurrency(state->trans, gnc_account_or_default_currency(acct, NULL));
+                }
+                if (is_new_split)
+                    xaccTransAppendSplit(state->trans, split);
+
+                if (record->split_memo_present)
+                {
+                    xaccSplitSetMemo(split, record->split_memo);
+                }
+                if (record->split_action_present)
+                {
+                    xaccSplitSetAction(split, record->split_action);
+                }
+                if (record->date_reconciled_present)
+                {
+                    xaccSplitSetDateReconciledSecs (split, record->date_reconciled);
+                }
+                if (record->split_reconcile_present)
+                {
+                    xaccSplitSetReconcile(split, record->split_reconcile);
+                }
+
+                if (record->amount_present)
+                {
+                    xaccSplitSetAmount(split, record->amount);
+                }
+                if (record->value_present)
+                {
+                    xaccSplitSetValue(split, record->value);
+                }
+            }
+            state->first_record = FALSE;
+            break;
+        }
+    }
+    else
+    {
+        PERR("Corrupted record");
+    }
+}
+
+static void replay_end_transaction (replay_state *state)
+{
+    if (state->trans != NULL) /*If we played with a transaction, commit it here*/
+    {
+        xaccTransScrubCurrency(state->trans);
+        xaccTransSetReadOnly(state->trans, state->trans_ro);
+        xaccTransCommitEdit(state->trans);
+        g_free(state->trans_ro);
+    }
+}
+
 /* File pointer must already be at the beginning of a record */
 static void  process_trans_record(  FILE *log_file)
 {
     char read_buf[2048];
     char *read_retval;
-    char * trans_ro = NULL;
     const char * record_end_str = "===== END";
-    int first_record = TRUE;
     int record_ended = FALSE;
     int split_num = 0;
     split_record record;
-    Transaction * trans = NULL;
-    Split * split = NULL;
-    Account * acct = NULL;
-    QofBook * book = gnc_get_current_book();
+    replay_state state = { NULL, NULL, TRUE };
 
     DEBUG("process_trans_record(): Begin...\n");
 
@@ -388,164 +552,109 @@ static void  process_trans_record(  FILE *log_file)
 
             record = interpret_split_record(g_strchomp(read_buf));
             dump_split_record( record);
-            if (record.log_action_present)
-            {
-                switch (record.log_action)
-                {
-                case LOG_BEGIN_EDIT:
-                    DEBUG("process_trans_record():Ignoring log action: LOG_BEGIN_EDIT"); /*Do nothing, there is no point*/
-                    break;
-                case LOG_ROLLBACK:
-                    DEBUG("process_trans_record():Ignoring log action: LOG_ROLLBACK");/*Do nothing, since we didn't do the begin_edit either*/
-                    break;
-                case LOG_DELETE:
-                    DEBUG("process_trans_record(): Playing back LOG_DELETE");
-                    if ((trans = xaccTransLookup (&(record.trans_guid), book)) != NULL
-                            && first_record == TRUE)
-                    {
-                        first_record = FALSE;
-                        if (xaccTransGetReadOnly(trans))
-                        {
-                            PWARN("Destroying a read only transaction.");
-                            xaccTransClearReadOnly(trans);
-                        }
-                        xaccTransBeginEdit(trans);
-                        xaccTransDestroy(trans);
-                    }
-                    else if (first_record == TRUE)
-                    {
-                        PERR("The transaction to delete was not found!");
-                    }
-                    else
-                        xaccTransDestroy(trans);
-                    break;
-                case LOG_COMMIT:
-                    DEBUG("process_trans_record(): Playing back LOG_COMMIT");
-                    if (record.trans_guid_present == TRUE
-                            && first_record == TRUE)
-                    {
-                        trans = xaccTransLookupDirect (record.trans_guid, book);
-                        if (trans != NULL)
-                        {
-                            DEBUG("process_trans_record(): Transaction to be edited was found");
-                            xaccTransBeginEdit(trans);
-                            trans_ro = g_strdup(xaccTransGetReadOnly(trans));
-                            if (trans_ro)
-                            {
-                                PWARN("Replaying a read only transaction.");
-                                xaccTransClearReadOnly(trans);
-                            }
-                        }
-                        else
-                        {
-                            DEBUG("process_trans_record(): Creating a new transaction");
-                            trans = xaccMallocTransaction (book);
-                            xaccTransBeginEdit(trans);
-                        }
-
-                        qof_instance_set_guid (QOF_INSTANCE (trans),
-					       &(record.trans_guid));
-                        /*Fill the transaction info*/
-                        if (record.date_entered_present)
-                        {
-                            xaccTransSetDateEnteredSecs(trans, record.date_entered);
-                        }
-                        if (record.date_posted_present)
-                        {
-                            xaccTransSetDatePostedSecs(trans, record.date_posted);
-                        }
-                        if (record.trans_num_present)
-                        {
-                            xaccTransSetNum(trans, record.trans_num);
-                        }
-                        if (record.trans_descr_present)
-                        {
-                            xaccTransSetDescription(trans, record.trans_descr);
-                        }
-                        if (record.trans_notes_present)
-                        {
-                            xaccTransSetNotes(trans, record.trans_notes);
-                        }
-                    }
-                    if (record.split_guid_present == TRUE) /*Fill the split info*/
-                    {
-                        gboolean is_new_split;
-
-                        split = xaccSplitLookupDirect (record.split_guid, book);
-                        if (split != NULL)
-                        {
-                            DEBUG("process_trans_record(): Split to be edited was found");
-                            is_new_split = FALSE;
-                        }
-                        else
-                        {
-                            DEBUG("process_trans_record(): Creating a new split");
-                            split = xaccMallocSplit(book);
-                            is_new_split = TRUE;
-                        }
-                        xaccSplitSetGUID (split, &(record.split_guid));
-                        if (record.acc_guid_present)
-                        {
-                            acct = xaccAccountLookupDirect(record.acc_guid, book);
-                            xaccAccountInsertSplit(acct, split);
-
-                            // No currency in the txn yet? Set one now.
-                            if (!xaccTransGetCurrency(trans))
-                                xaccTransSetCurrency(trans, gnc_account_or_default_currency(acct, NULL));
-                        }
-                        if (is_new_split)
-                            xaccTransAppendSplit(trans, split);
-
-                        if (record.split_memo_present)
-                        {
-                            xaccSplitSetMemo(split, record.split_memo);
-                        }
-                        if (record.split_action_present)
-                        {
-                            xaccSplitSetAction(split, record.split_action);
-                        }
-                        if (record.date_reconciled_present)
-                        {
-                            xaccSplitSetDateReconciledSecs (split, record.date_reconciled);
-                        }
-                        if (record.split_reconcile_present)
-                        {
-                            xaccSplitSetReconcile(split, record.split_reconcile);
-                        }
-
-                        if (record.amount_present)
-                        {
-                            xaccSplitSetAmount(split, record.amount);
-                        }
-                        if (record.value_present)
-                        {
-                            xaccSplitSetValue(split, record.value);
-                        }
-                    }
-                    first_record = FALSE;
-                    break;
-                }
-            }
-            else
-            {
-                PERR("Corrupted record");
-            }
+            replay_split_record(&record, &state);
         }
         else /* The record ended */
         {
             record_ended = TRUE;
             DEBUG("process_trans_record(): Record ended\n");
-            if (trans != NULL) /*If we played with a transaction, commit it here*/
-            {
-                xaccTransScrubCurrency(trans);
-                xaccTransSetReadOnly(trans, trans_ro);
-                xaccTransCommitEdit(trans);
-                g_free(trans_ro);
-            }
+            replay_end_transaction(&state);
         }
     }
 }
 
+static int journal_log_action (char flag)
+{
+    switch (flag)
+    {
+    case 'B':
+        return LOG_BEGIN_EDIT;
+    case 'D':
+        return LOG_DELETE;
+    case 'C':
+        return LOG_COMMIT;
+    case 'R':
+        return LOG_ROLLBACK;
+    }
+    return -1;
+}
+
+/* Replays one record of a binary journal, the equivalent of a START/END
+ * block of the text log. */
+static void replay_journal_record (const TransLogRecord *trans, gpointer data)
+{
+    replay_state state = { NULL, NULL, TRUE };
+    split_record record;
+    int action;
+    guint i;
+
+    memset(&record, 0, sizeof(record));
+    action = journal_log_action(trans->flag);
+    if (action >= 0)
+    {
+        record.log_action = action;
+        record.log_action_present = TRUE;
+    }
+    record.log_date = trans->log_date;
+    record.log_date_present = TRUE;
+    record.date_entered = trans->date_entered;
+    record.date_entered_present = TRUE;
+    record.date_posted = trans->date_posted;
+    record.date_posted_present = TRUE;
+    record.trans_guid = trans->trans_guid;
+    record.trans_guid_present = TRUE;
+    g_strlcpy(record.trans_num, trans->num, STRING_FIELD_SIZE);
+    record.trans_num_present = *trans->num != '\0';
+    g_strlcpy(record.trans_descr, trans->description, STRING_FIELD_SIZE);
+    record.trans_descr_present = *trans->description != '\0';
+    g_strlcpy(record.trans_notes, trans->notes, STRING_FIELD_SIZE);
+    record.trans_notes_present = *trans->notes != '\0';
+
+    for (i = 0; i < trans->n_splits; i++)
+    {
+        const TransLogSplit *split = &trans->splits[i];
+
+        record.split_guid = split->split_guid;
+        record.split_guid_present = TRUE;
+        record.acc_guid = split->acc_guid;
+        record.acc_guid_present = !guid_equal(&record.acc_guid, guid_null());
+        g_strlcpy(record.acc_name, split->acc_name, STRING_FIELD_SIZE);
+        record.acc_name_present = *split->acc_name != '\0';
+        g_strlcpy(record.split_memo, split->memo, STRING_FIELD_SIZE);
+        record.split_memo_present = *split->memo != '\0';
+        g_strlcpy(record.split_action, split->action, STRING_FIELD_SIZE);
+        record.split_action_present = *split->action != '\0';
+        record.split_reconcile = split->reconciled;
+        record.split_reconcile_present = TRUE;
+        record.amount = split->amount;
+        record.amount_present = TRUE;
+        record.value = split->value;
+        record.value_present = TRUE;
+        record.date_reconciled = split->date_reconciled;
+        record.date_reconciled_present = TRUE;
+
+        dump_split_record(record);
+        replay_split_record(&record, &state);
+    }
+    replay_end_transaction(&state);
+}
+
+/* The file pointer must be just after TRANS_LOG_BINARY_MAGIC. */
+static void process_journal (FILE *log_file)
+{
+    switch (xaccLogReadJournal(log_file, replay_journal_record, NULL))
+    {
+    case TRANS_LOG_JOURNAL_TRUNCATED:
+        PERR("The journal ends with an incomplete record.");
+        break;
+    case TRANS_LOG_JOURNAL_CORRUPT:
+        PERR("Corrupted journal record, stopping here.");
+        break;
+    default:
+        break;
+    }
+}
+
 void gnc_file_log_replay (GtkWindow *parent)
 {
     char *selected_filename;
@@ -603,7 +712,7 @@ void gnc_file_log_replay (GtkWindow *parent)
         else
         {
             DEBUG("Opening selected file");
-            log_file = g_fopen(selected_filename, "r");
+            log_file = g_fopen(selected_filename, "rb");
             if (!log_file || ferror(log_file) != 0)
             {
                 int err = errno;
@@ -616,8 +725,17 @@ void gnc_file_log_replay (GtkWindow *parent)
                                  selected_filename,
                                  strerror(err));
             }
+            else if (fread(read_buf, 1, strlen(TRANS_LOG_BINARY_MAGIC),
+                           log_file) == strlen(TRANS_LOG_BINARY_MAGIC) &&
+                     strncmp(read_buf, TRANS_LOG_BINARY_MAGIC,
+                             strlen(TRANS_LOG_BINARY_MAGIC)) == 0)
+            {
+                process_journal(log_file);
+                fclose(log_file);
+            }
             else
             {
+                rewind(log_file);
                 if ((read_retval = fgets(read_buf, sizeof(read_buf), log_file)) == NULL)
                 {
                     DEBUG("Read error or EOF");
@@ -2,6 +2,9 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <utility>
+#include <vector>
+
 #include <config.h>
 
 #include <gnc-datetime.hpp>
@@ -284,3 +287,231 @@ TEST_F(ImportBackendBayesTest, CreateTransInfo)
     // delete transaction info
     gnc_import_TransInfo_delete(trans_info);
 };
+
+
+
+// Test fixture for the candidate index of the main matcher
+class ImportMatchIndexTest : public ImportBackendTest
+{
+protected:
+    using Matches = std::vector<std::pair<Split*, gint>>;
+
+    void SetUp()
+    {
+        ImportBackendTest::SetUp();
+
+        using namespace testing;
+
+        // the imported transaction: 100.00 paid on 2020-03-18
+        m_date = static_cast<time64>(GncDateTime(GncDate(2020, 3, 18)));
+        ON_CALL(*m_trans, get_split(0))
+            .WillByDefault(Return(m_split));
+        ON_CALL(*m_trans, get_split_list())
+            .WillByDefault(Return(m_splitList));
+        ON_CALL(*m_trans, get_date())
+            .WillByDefault(Return(m_date));
+        ON_CALL(*m_trans, get_description())
+            .WillByDefault(Return("Grocery store"));
+        ON_CALL(*m_trans, get_num())
+            .WillByDefault(Return("42"));
+        ON_CALL(*m_split, get_account())
+            .WillByDefault(Return(m_import_acc));
+        ON_CALL(*m_split, get_amount())
+            .WillByDefault(Return(gnc_numeric_create(-10000, 100)));
+        ON_CALL(*m_split, get_memo())
+            .WillByDefault(Return("weekly"));
+        ON_CALL(*m_split, get_parent())
+            .WillByDefault(Return(m_trans));
+    }
+
+    void TearDown()
+    {
+        for (auto split : m_candidates)
+        {
+            gnc_mocktransaction(xaccSplitGetParent(split))->free();
+            gnc_mocksplit(split)->free();
+        }
+        g_list_free(m_candidate_list);
+        ImportBackendTest::TearDown();
+    }
+
+    // Adds a split that may match the imported transaction. With text set
+    // its number, memo and description all match, adding 8 to its score.
+    Split* add_candidate(MockAccount* account, gint64 cents, time64 date,
+                         bool text = false)
+    {
+        using namespace testing;
+
+        auto trans = new MockTransaction();
+        auto split = new MockSplit();
+        ON_CALL(*trans, get_date())
+            .WillByDefault(Return(date));
+        ON_CALL(*trans, get_description())
+            .WillByDefault(Return(text ? "Grocery store" : "Salary"));
+        ON_CALL(*trans, get_num())
+            .WillByDefault(Return(text ? "42" : ""));
+        ON_CALL(*trans, is_open())
+            .WillByDefault(Return(false));
+        ON_CALL(*split, get_account())
+            .WillByDefault(Return(account));
+        ON_CALL(*split, get_amount())
+            .WillByDefault(Return(gnc_numeric_create(cents, 100)));
+        ON_CALL(*split, get_memo())
+            .WillByDefault(Return(text ? "weekly" : "monthly"));
+        ON_CALL(*split, get_parent())
+            .WillByDefault(Return(trans));
+
+        m_candidates.push_back(split);
+        m_candidate_list = g_list_append(m_candidate_list, split);
+        return split;
+    }
+
+    static time64 days(double n) { return static_cast<time64>(n * 86400); }
+
+    Matches collect_matches(GNCImportTransInfo* trans_info)
+    {
+        Matches matches;
+        auto list = gnc_import_TransInfo_get_match_list(trans_info);
+        // split_find_match prepends, so walk the list backwards
+        for (auto node = g_list_last(list); node; node = node->prev)
+        {
+            auto info = static_cast<GNCImportMatchInfo*>(node->data);
+            matches.emplace_back(gnc_import_MatchInfo_get_split(info),
+                                 gnc_import_MatchInfo_get_probability(info));
+            g_free(info);
+        }
+        gnc_import_TransInfo_delete(trans_info);
+        return matches;
+    }
+
+    // What the main matcher did before the index: score every candidate
+    // in the import account.
+    Matches scan_matches(gint display_threshold, double fuzzy_amount)
+    {
+        testing::NiceMock<GncMockImportMatchMap> imap(m_import_acc);
+        auto trans_info = gnc_import_TransInfo_new(m_trans, &imap);
+        for (auto node = m_candidate_list; node; node = node->next)
+        {
+            auto split = static_cast<Split*>(node->data);
+            if (xaccSplitGetAccount(split) == m_import_acc)
+                split_find_match(trans_info, split, display_threshold, fuzzy_amount);
+        }
+        return collect_matches(trans_info);
+    }
+
+    Matches index_matches(gint display_threshold, double fuzzy_amount)
+    {
+        testing::NiceMock<GncMockImportMatchMap> imap(m_import_acc);
+        auto trans_info = gnc_import_TransInfo_new(m_trans, &imap);
+        auto index = gnc_import_match_index_new(m_candidate_list);
+        gnc_import_match_index_find_matches(index, trans_info, display_threshold,
+                                            fuzzy_amount);
+        gnc_import_match_index_destroy(index);
+        return collect_matches(trans_info);
+    }
+
+    gint probability_of(const Matches& matches, Split* split)
+    {
+        for (const auto& match : matches)
+            if (match.first == split)
+                return match.second;
+        ADD_FAILURE() << "split not among the matches";
+        return G_MININT;
+    }
+
+    time64 m_date;
+    std::vector<Split*> m_candidates;
+    GList* m_candidate_list = nullptr;
+};
+
+
+
+/* Tests using fixture ImportMatchIndexTest */
+
+//! Test that the index finds what scoring every candidate finds, in the same order
+TEST_F(ImportMatchIndexTest, SameAsFullScan)
+{
+    const gint64 amounts[] = { -10000, -10001, -10050, -10100, -10101, -10300,
+                               -15000, -9900, 10000 };
+    const double offsets[] = { 0, 0.5, 1, 4, 4.9, 5, 13.9, 14, 14.9, 15, 40,
+                               -1, -4.9, -5, -14.9, -15 };
+
+    for (auto cents : amounts)
+        for (auto offset : offsets)
+        {
+            add_candidate(m_import_acc, cents, m_date + days(offset));
+            add_candidate(m_import_acc, cents, m_date + days(offset), true);
+        }
+    // candidates in other accounts are never matched
+    add_candidate(m_dest_acc, -10000, m_date, true);
+
+    for (auto fuzzy : { 0.0, 1.0, 3.0 })
+        for (gint threshold = -12; threshold <= 16; threshold++)
+            EXPECT_EQ(index_matches(threshold, fuzzy), scan_matches(threshold, fuzzy))
+                << "display threshold " << threshold << ", fuzzy amount " << fuzzy;
+}
+
+//! Test the date heuristics at the 4 and 14 day thresholds
+TEST_F(ImportMatchIndexTest, DateThresholds)
+{
+    auto same_day  = add_candidate(m_import_acc, -10000, m_date + days(0.9));
+    auto four_days = add_candidate(m_import_acc, -10000, m_date - days(4.9));
+    auto five_days = add_candidate(m_import_acc, -10000, m_date + days(5));
+    auto fourteen  = add_candidate(m_import_acc, -10000, m_date - days(14.9));
+    auto fifteen   = add_candidate(m_import_acc, -10000, m_date + days(15));
+    auto far_off   = add_candidate(m_import_acc, -15000, m_date + days(4), true);
+    auto too_far   = add_candidate(m_import_acc, -15000, m_date + days(5), true);
+
+    // amount +3, date +3/+2/0/0/-5
+    auto matches = index_matches(-10, 1.0);
+    EXPECT_EQ(matches, scan_matches(-10, 1.0));
+    EXPECT_EQ(probability_of(matches, same_day), 6);
+    EXPECT_EQ(probability_of(matches, four_days), 5);
+    EXPECT_EQ(probability_of(matches, five_days), 3);
+    EXPECT_EQ(probability_of(matches, fourteen), 3);
+    EXPECT_EQ(probability_of(matches, fifteen), -2);
+    // amount -5, date +2, text +8
+    EXPECT_EQ(probability_of(matches, far_off), 5);
+    // amount -5, date 0, text +8
+    EXPECT_EQ(probability_of(matches, too_far), 3);
+
+    // at threshold 5 an amount off candidate needs its +2 date score
+    matches = index_matches(5, 1.0);
+    EXPECT_EQ(matches, scan_matches(5, 1.0));
+    EXPECT_EQ(matches, (Matches{ { same_day, 6 }, { four_days, 5 }, { far_off, 5 } }));
+
+    // at threshold 3 it may be up to 14 days off
+    matches = index_matches(3, 1.0);
+    EXPECT_EQ(matches, scan_matches(3, 1.0));
+    EXPECT_EQ(matches.size(), 6u);
+}
+
+//! Test the fuzzy amount range and the -5 penalty outside of it
+TEST_F(ImportMatchIndexTest, FuzzyAmount)
+{
+    auto exact   = add_candidate(m_import_acc, -10000, m_date);
+    auto fuzzy   = add_candidate(m_import_acc, -10100, m_date);
+    auto outside = add_candidate(m_import_acc, -10101, m_date);
+    auto above   = add_candidate(m_import_acc, -9900, m_date);
+    auto text    = add_candidate(m_import_acc, -10101, m_date, true);
+
+    // date +3, amount +3/+2/-5/+2, text +8
+    auto matches = index_matches(-10, 1.0);
+    EXPECT_EQ(matches, scan_matches(-10, 1.0));
+    EXPECT_EQ(probability_of(matches, exact), 6);
+    EXPECT_EQ(probability_of(matches, fuzzy), 5);
+    EXPECT_EQ(probability_of(matches, outside), -2);
+    EXPECT_EQ(probability_of(matches, above), 5);
+    EXPECT_EQ(probability_of(matches, text), 6);
+
+    // without a fuzzy range only the exact amount escapes the penalty
+    matches = index_matches(-10, 0.0);
+    EXPECT_EQ(matches, scan_matches(-10, 0.0));
+    EXPECT_EQ(probability_of(matches, fuzzy), -2);
+    EXPECT_EQ(probability_of(matches, above), -2);
+
+    // the penalty keeps everything but the text match out at threshold 6
+    matches = index_matches(6, 0.0);
+    EXPECT_EQ(matches, scan_matches(6, 0.0));
+    EXPECT_EQ(matches, (Matches{ { exact, 6 }, { text, 6 } }));
+}
@@ -394,13 +394,12 @@
       ))
 
   (define (book-add-prices! book prices)
-    (let ((pricedb (gnc-pricedb-get-db book)))
-      (for-each
-       (lambda (price)
-         (when price
-           (gnc-pricedb-add-price pricedb price)
-           (gnc-price-unref price)))
-       prices)))
+    (let ((pricedb (gnc-pricedb-get-db book))
+          (prices (filter identity prices)))
+      ;; add them in one go, which commits the pricedb and signals the
+      ;; price editor once instead of once per quote.
+      (gnc-pricedb-add-prices pricedb prices PRICE-ADD-BY-SOURCE '())
+      (for-each gnc-price-unref prices)))
 
   (define (show-error msg)
     (gnc:gui-error msg (G_ msg)))
@@ -50,6 +50,22 @@ static QofLogModule log_module = GNC_MOD_GUI;
 static GHashTable *reports = NULL;
 static gint report_next_serial_id = 0;
 
+/* Rendered html of reports, keyed by gnc:report-render-cache-key. Any
+ * engine event bumps the book generation and empties the cache, as
+ * reports can look at about anything in the book. */
+#define RENDER_CACHE_MAX_ENTRIES 32
+
+typedef struct
+{
+    gchar *html;
+    time64 day;         /* reports can depend on today's date */
+} RenderCacheEntry;
+
+static GHashTable *render_cache = NULL;
+static guint64 book_generation = 0;
+static guint render_cache_hits = 0;
+static guint render_cache_misses = 0;
+
 static gboolean
 try_load_config_array(const gchar *fns[])
 {
@@ -98,9 +114,93 @@ load_custom_reports_stylesheets(void)
     try_load_config_array(stylesheet_files);
 }
 
+static void
+render_cache_entry_free (gpointer data)
+{
+    RenderCacheEntry *entry = data;
+    g_free (entry->html);
+    g_free (entry);
+}
+
+static void
+render_cache_event_handler (QofInstance *entity, QofEventId event_type,
+                            gpointer handler_data, gpointer event_data)
+{
+    book_generation++;
+    if (render_cache && g_hash_table_size (render_cache))
+        g_hash_table_remove_all (render_cache);
+}
+
+void
+gnc_report_render_cache_invalidate (void)
+{
+    book_generation++;
+    if (render_cache)
+        g_hash_table_remove_all (render_cache);
+}
+
+guint
+gnc_report_render_cache_hits (void)
+{
+    return render_cache_hits;
+}
+
+guint
+gnc_report_render_cache_misses (void)
+{
+    return render_cache_misses;
+}
+
+static gchar *
+render_cache_key (SCM report)
+{
+    SCM get_key = scm_c_eval_string ("gnc:report-render-cache-key");
+    return gnc_scm_call_1_to_string (get_key, report);
+}
+
+static gchar *
+render_cache_lookup (const gchar *key)
+{
+    RenderCacheEntry *entry;
+
+    if (!render_cache || !key)
+        return NULL;
+
+    entry = g_hash_table_lookup (render_cache, key);
+    if (entry && entry->day != gnc_time64_get_today_start ())
+    {
+        g_hash_table_remove (render_cache, key);
+        entry = NULL;
+    }
+    return entry ? g_strdup (entry->html) : NULL;
+}
+
+static void
+render_cache_insert (gchar *key, const gchar *html)
+{
+    RenderCacheEntry *entry;
+
+    if (!render_cache)
+        render_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                              render_cache_entry_free);
+    if (g_hash_table_size (render_cache) >= RENDER_CACHE_MAX_ENTRIES)
+        g_hash_table_remove_all (render_cache);
+
+    entry = g_new (RenderCacheEntry, 1);
+    entry->html = g_strdup (html);
+    entry->day = gnc_time64_get_today_start ();
+    g_hash_table_replace (render_cache, key, entry);
+}
+
 void
 gnc_report_init (void)
 {
+    static gint render_cache_handler_id = 0;
+
+    if (!render_cache_handler_id)
+        render_cache_handler_id =
+            qof_event_register_handler (render_cache_event_handler, NULL);
+
     scm_init_sw_report_module();
     scm_c_use_module ("gnucash report");
     scm_c_use_module ("gnucash reports");
@@ -210,12 +310,26 @@ gboolean
 gnc_run_report_with_error_handling (gint report_id, gchar ** data, gchar **errmsg)
 {
     SCM report, res, html, captured_error;
+    guint64 generation = book_generation;
+    gchar *key;
 
     report = gnc_report_find (report_id);
     g_return_val_if_fail (data, FALSE);
     g_return_val_if_fail (errmsg, FALSE);
     g_return_val_if_fail (!scm_is_false (report), FALSE);
 
+    key = render_cache_key (report);
+    *data = render_cache_lookup (key);
+    if (*data)
+    {
+        render_cache_hits++;
+        PINFO ("Report %d rendered from cache", report_id);
+        g_free (key);
+        *errmsg = NULL;
+        return TRUE;
+    }
+    render_cache_misses++;
+
     res = scm_call_1 (scm_c_eval_string ("gnc:render-report"), report);
     html = scm_car (res);
     captured_error = scm_cadr (res);
@@ -224,10 +338,16 @@ gnc_run_report_with_error_handling (gint report_id, gchar ** data, gchar **errms
     {
         *data = gnc_scm_to_utf8_string (html);
         *errmsg = NULL;
+        /* Don't keep html of data that changed while rendering */
+        if (key && generation == book_generation)
+            render_cache_insert (key, *data);
+        else
+            g_free (key);
         return TRUE;
     }
     else
     {
+        g_free (key);
         *errmsg = gnc_scm_to_utf8_string (captured_error);
         *data = NULL;
         PWARN ("Error in report: %s", *errmsg);
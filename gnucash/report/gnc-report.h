@@ -60,6 +60,23 @@ void gnc_report_remove_by_id(gint id);
 gint gnc_report_add(SCM report);
 
 void gnc_reports_flush_global(void);
+
+/** @name Report render cache
+ *
+ *  gnc_run_report_with_error_handling() keeps the html of the reports it
+ *  renders and hands it out again when the same report is run with the
+ *  same options until the book changes or the day ends.
+ *  @{ */
+
+/** Drop all cached report html, e.g. after a style sheet changed. */
+void gnc_report_render_cache_invalidate (void);
+
+/** The number of renders served from the cache. */
+guint gnc_report_render_cache_hits (void);
+
+/** The number of renders that had to run the report. */
+guint gnc_report_render_cache_misses (void);
+/** @} */
 GHashTable *gnc_reports_get_global(void);
 
 gchar* gnc_get_default_report_font_family(void);
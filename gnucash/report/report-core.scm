@@ -75,6 +75,7 @@
 (export gnc:report-name)
 (export gnc:report-needs-save?)
 (export gnc:report-options)
+(export gnc:report-render-cache-key)
 (export gnc:report-render-html)
 (export gnc:render-report)
 (export gnc:report-run)
@@ -730,6 +731,19 @@ not found.")))
           (gnc:custom-report-templates-list))))
 
 
+;; a string identifying what a report renders: its id, type and options,
+;; including those of the reports embedded in it. reports with equal
+;; keys render the same html from the same book. the id is part of the
+;; key as the html links back to the report, e.g. to its options.
+(define (gnc:report-render-cache-key report)
+  (let ((options (gnc:report-options report)))
+    (string-append
+     (object->string (gnc:report-id report)) " "
+     (gnc:report-type report) " " (gnc:report-custom-template report) "\n"
+     (gnc:generate-restore-forms options "options")
+     (gnc:report-serialize-embedded (gnc:report-embedded-list options)))))
+
+
 ;; gets the renderer from the report template;
 ;; gets the stylesheet from the report;
 ;; renders the html doc and caches the resulting string;
@@ -920,3 +934,10 @@ not found.")))
   (match (reportname->templates report)
     ((template) (gnc:make-report (gnc:report-template-report-guid template)))
     (_ (gnc:error report " does not match unique report") #f)))
+
+;; In: report - string matching reportname or report template guid
+;; Out: the guid of the report template, or #f if error
+(define-public (gnc:cmdline-get-report-guid report)
+  (match (reportname->templates report)
+    ((template) (gnc:report-template-report-guid template))
+    (_ (gnc:error report " does not match unique report") #f)))
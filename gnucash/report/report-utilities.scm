@@ -56,6 +56,7 @@
 (export gnc:account-accumulate-at-dates)
 (export gnc:account-get-balance-at-date)
 (export gnc:account-get-balances-at-dates)
+(export gnc:accounts-get-balances-at-dates)
 (export gnc:account-get-comm-balance-at-date)
 (export gnc:account-get-comm-value-interval)
 (export gnc:account-get-comm-value-at-date)
@@ -450,12 +451,30 @@
   (define (amount->monetary bal)
     (gnc:make-gnc-monetary (xaccAccountGetCommodity account) (or bal 0)))
   (define balance 0)
-  (map amount->monetary
-       (gnc:account-accumulate-at-dates
-        account dates-list #:split->elt
-        (lambda (s)
-          (if s (set! balance (+ balance (or (split->amount s) 0))))
-          balance))))
+  (if (eq? split->amount xaccSplitGetAmount)
+      (car (gnc:accounts-get-balances-at-dates (list account) dates-list))
+      (map amount->monetary
+           (gnc:account-accumulate-at-dates
+            account dates-list #:split->elt
+            (lambda (s)
+              (if s (set! balance (+ balance (or (split->amount s) 0))))
+              balance)))))
+
+;; the balances of several accounts at the dates in dates-list, computed
+;; in the engine which walks each account's splits once for all the dates.
+;; in:  accounts - a list of accounts
+;;      dates-list - a list of time64, it will be sorted
+;;      ignore-closing? - leave out closing transactions
+;; out: (list (list bal0 bal1 ...) ...), a list of gnc-monetary objects
+;;      for each account
+(define* (gnc:accounts-get-balances-at-dates
+          accounts dates-list #:key ignore-closing?)
+  (map
+   (lambda (acc balances)
+     (let ((comm (xaccAccountGetCommodity acc)))
+       (map (lambda (bal) (gnc:make-gnc-monetary comm bal)) balances)))
+   accounts
+   (gnc-accounts-get-balances-at-dates accounts dates-list ignore-closing? #f)))
 
 
 ;; this function will scan through account splitlist, building a list
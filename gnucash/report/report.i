@@ -40,5 +40,25 @@ gint gnc_report_add(SCM report);
 %newobject gnc_get_default_report_font_family;
 gchar* gnc_get_default_report_font_family();
 
+void gnc_report_render_cache_invalidate (void);
+guint gnc_report_render_cache_hits (void);
+guint gnc_report_render_cache_misses (void);
+
+%inline %{
+/* Runs a report through gnc_run_report_with_error_handling, and so
+ * through the render cache. Returns the html, or #f if it failed. */
+SCM gnc_run_report_html (gint report_id)
+{
+    gchar *html = NULL, *errmsg = NULL;
+    SCM result = SCM_BOOL_F;
+
+    if (gnc_run_report_with_error_handling (report_id, &html, &errmsg) && html)
+        result = scm_from_utf8_string (html);
+    g_free (html);
+    g_free (errmsg);
+    return result;
+}
+%}
+
 void gnc_saved_reports_backup (void);
 gboolean gnc_saved_reports_write_to_file (const gchar* report_def, gboolean overwrite);
@@ -672,6 +672,24 @@
         '(("USD" . 0) ("USD" . 18) ("USD" . 18) ("USD" . 18))
         (map monetary->pair (gnc:account-get-balances-at-dates bank4 dates)))
 
+      (test-equal "several accounts at once"
+        '((("USD" . 0) ("USD" . 10) ("USD" . 30) ("USD" . 150))
+          (("USD" . 32) ("USD" . 32) ("USD" . 73) ("USD" . 73))
+          (("USD" . 0) ("USD" . 0) ("USD" . 0) ("USD" . 14)))
+        (map (lambda (bals) (map monetary->pair bals))
+             (gnc:accounts-get-balances-at-dates
+              (list bank1 bank2 bank3) (reverse dates))))
+
+      (test-equal "several accounts at once, ignoring closing"
+        '((("USD" . 0) ("USD" . 10) ("USD" . 30) ("USD" . 70)))
+        (map (lambda (bals) (map monetary->pair bals))
+             (gnc:accounts-get-balances-at-dates
+              (list bank1) dates #:ignore-closing? #t)))
+
+      (test-equal "balance changes"
+        '((0 10 20 120) (32 0 41 0))
+        (gnc-accounts-get-balances-at-dates (list bank1 bank2) dates #f #t))
+
       (test-equal "1 txn in each slot"
         '(#f 10 30 150)
         (gnc:account-accumulate-at-dates bank1 dates))
@@ -220,4 +220,51 @@
        #f))
     (test-assert "gnc:report-serialize = string"
       (string?
-       (gnc:report-serialize report)))))
+       (gnc:report-serialize report)))
+    (let* ((options2 (gnc:make-report-options test-uuid))
+           (report2 (constructor test-uuid "bar" options2 #t #t #f #f ""))
+           (report3 (constructor test-uuid "baz" (gnc:make-report-options test-uuid)
+                                 #t #t #f #f "")))
+      (test-equal "gnc:report-render-cache-key, same options"
+        (gnc:report-render-cache-key report)
+        (gnc:report-render-cache-key report2))
+      (test-assert "gnc:report-render-cache-key, other report id"
+        (not (string=? (gnc:report-render-cache-key report)
+                       (gnc:report-render-cache-key report3))))
+      (gnc:option-set-value
+       (gnc:lookup-option options2 gnc:pagename-general gnc:optname-reportname)
+       "other name")
+      (test-assert "gnc:report-render-cache-key, changed options"
+        (not (string=? (gnc:report-render-cache-key report)
+                       (gnc:report-render-cache-key report2)))))
+    (test-report-render-cache test-uuid)))
+
+;; renders two reports with the same options through the render cache:
+;; rendering one again is a hit, the other one isn't as its html links
+;; to its own id.
+(define (test-report-render-cache test-uuid)
+  (let ((id1 (gnc:make-report test-uuid))
+        (id2 (gnc:make-report test-uuid)))
+    (gnc-report-render-cache-invalidate)
+    (let ((hits (gnc-report-render-cache-hits))
+          (misses (gnc-report-render-cache-misses)))
+      (test-equal "render cache, first render"
+        "return-string"
+        (gnc-run-report-html id1))
+      (test-equal "render cache, same report again"
+        "return-string"
+        (gnc-run-report-html id1))
+      (test-equal "render cache, other report"
+        "return-string"
+        (gnc-run-report-html id2))
+      (test-equal "render cache hits"
+        (1+ hits)
+        (gnc-report-render-cache-hits))
+      (test-equal "render cache misses"
+        (+ 2 misses)
+        (gnc-report-render-cache-misses))
+      (gnc-report-render-cache-invalidate)
+      (gnc-run-report-html id1)
+      (test-equal "render cache, rendered again after invalidate"
+        (+ 3 misses)
+        (gnc-report-render-cache-misses)))))
@@ -0,0 +1,85 @@
+# Runs "gnucash-cli --report run-batch" the way a user would and checks
+# the reports it writes. Called from CMakeLists.txt with
+#   GNUCASH_CLI: the gnucash-cli executable
+#   DATA_FILE:   the book to run the reports on
+#   TEST_DIR:    a scratch directory, emptied first
+
+file(REMOVE_RECURSE ${TEST_DIR})
+file(MAKE_DIRECTORY ${TEST_DIR})
+set(ENV{LANG} C)
+set(ENV{LC_ALL} C)
+
+set(balance_sheet_guid c4173ac99b2b448289bf4d11c731af13)
+set(account_summary_guid 3298541c236b494998b236dfad6ad752)
+
+# Runs a batch and sets result, output and files (the html files written)
+# in the caller's scope.
+function(run_batch batch_file output_dir jobs)
+  execute_process(
+    COMMAND ${GNUCASH_CLI} --report run-batch
+      --batch-file ${batch_file} --output-dir ${output_dir} --jobs=${jobs}
+      ${DATA_FILE}
+    RESULT_VARIABLE result
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE output)
+  file(GLOB files RELATIVE ${output_dir} ${output_dir}/*.html)
+  list(SORT files)
+  set(result ${result} PARENT_SCOPE)
+  set(output "${output}" PARENT_SCOPE)
+  set(files "${files}" PARENT_SCOPE)
+endfunction()
+
+function(fail message)
+  message(FATAL_ERROR "${message}\nOutput:\n${output}")
+endfunction()
+
+# Account Summary is listed by guid and again by name, it must only be
+# written once.
+file(WRITE ${TEST_DIR}/batch.txt
+  "# Reports for the test\n"
+  "\n"
+  "Balance Sheet\n"
+  "  ${account_summary_guid}\n"
+  "Account Summary\n")
+set(expected_files
+  "Account Summary-${account_summary_guid}.html"
+  "Balance Sheet-${balance_sheet_guid}.html")
+
+foreach(jobs 1 2)
+  run_batch(${TEST_DIR}/batch.txt ${TEST_DIR}/out-${jobs} ${jobs})
+  if (NOT result EQUAL 0)
+    fail("run-batch with --jobs ${jobs} failed with ${result}")
+  endif()
+  if (NOT files STREQUAL expected_files)
+    fail("run-batch with --jobs ${jobs} wrote '${files}' instead of '${expected_files}'")
+  endif()
+  foreach(file ${files})
+    file(SIZE ${TEST_DIR}/out-${jobs}/${file} size)
+    if (NOT size GREATER 0)
+      fail("${file} is empty")
+    endif()
+  endforeach()
+endforeach()
+
+# A report that doesn't exist fails the batch, the others are still run.
+file(WRITE ${TEST_DIR}/bad-batch.txt
+  "Balance Sheet\n"
+  "No Such Report\n")
+run_batch(${TEST_DIR}/bad-batch.txt ${TEST_DIR}/out-bad 1)
+if (result EQUAL 0)
+  fail("run-batch with an unknown report didn't fail")
+endif()
+if (NOT files STREQUAL "Balance Sheet-${balance_sheet_guid}.html")
+  fail("run-batch with an unknown report wrote '${files}'")
+endif()
+
+# At least one job is needed.
+foreach(jobs 0 -1)
+  run_batch(${TEST_DIR}/batch.txt ${TEST_DIR}/out-jobs${jobs} ${jobs})
+  if (result EQUAL 0)
+    fail("run-batch accepted --jobs ${jobs}")
+  endif()
+  if (files)
+    fail("run-batch with --jobs ${jobs} wrote '${files}'")
+  endif()
+endforeach()
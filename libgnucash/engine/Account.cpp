@@ -27,6 +27,7 @@
 
 extern "C" {
 #include "gnc-prefs.h"
+#include "SplitP.h"
 }
 
 #include <glib.h>
@@ -47,8 +48,15 @@ extern "C" {
 #include "gnc-features.h"
 #include "guid.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <numeric>
 #include <map>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 static QofLogModule log_module = GNC_MOD_ACCOUNT;
 
@@ -72,6 +80,8 @@ static const std::string AB_BANK_CODE("bank-code");
 static const std::string AB_TRANS_RETRIEVAL("trans-retrieval");
 
 static gnc_numeric GetBalanceAsOfDate (Account *acc, time64 date, gboolean ignclosing);
+static void open_lot_index_free (AccountPrivate *priv);
+static void imap_bayes_index_forget (Account const * acc);
 
 using FinalProbabilityVec=std::vector<std::pair<std::string, int32_t>>;
 using ProbabilityVec=std::vector<std::pair<std::string, struct AccountProbability>>;
@@ -327,6 +337,7 @@ gnc_account_init(Account* acc)
 
     priv->policy = xaccGetFIFOPolicy();
     priv->lots = NULL;
+    priv->open_lots = NULL;
 
     priv->commodity = NULL;
     priv->commodity_scu = 0;
@@ -1329,6 +1340,7 @@ xaccFreeAccount (Account *acc)
 
     priv = GET_PRIVATE(acc);
     qof_event_gen (&acc->inst, QOF_EVENT_DESTROY, NULL);
+    imap_bayes_index_forget (acc);
 
     if (priv->children)
     {
@@ -1353,6 +1365,7 @@ xaccFreeAccount (Account *acc)
         g_list_free (priv->lots);
         priv->lots = NULL;
     }
+    open_lot_index_free (priv);
 
     /* Next, clean up the splits */
     /* NB there shouldn't be any splits by now ... they should
@@ -1518,6 +1531,7 @@ xaccAccountCommitEdit (Account *acc)
         }
         g_list_free(priv->lots);
         priv->lots = NULL;
+        open_lot_index_free (priv);
 
         qof_instance_set_dirty(&acc->inst);
         qof_instance_decrease_editlevel(acc);
@@ -1940,6 +1954,38 @@ gnc_account_insert_split (Account *acc, Split *s)
     return TRUE;
 }
 
+guint
+gnc_account_insert_splits (Account *acc, GList *splits)
+{
+    g_return_val_if_fail(GNC_IS_ACCOUNT(acc), 0);
+
+    auto priv = GET_PRIVATE(acc);
+    std::unordered_set<Split*> pending;
+    for (auto node = splits; node; node = node->next)
+        if (GNC_IS_SPLIT(node->data))
+            pending.insert (static_cast<Split*>(node->data));
+    for (auto node = priv->splits; node && !pending.empty(); node = node->next)
+        pending.erase (static_cast<Split*>(node->data));
+    if (pending.empty())
+        return 0;
+
+    guint added = 0;
+    for (auto node = splits; node; node = node->next)
+    {
+        auto s = static_cast<Split*>(node->data);
+        if (pending.erase (s) == 0)
+            continue;
+        priv->splits = g_list_prepend (priv->splits, s);
+        qof_event_gen (&acc->inst, GNC_EVENT_ITEM_ADDED, s);
+        ++added;
+    }
+    qof_event_gen (&acc->inst, QOF_EVENT_MODIFY, NULL);
+
+    priv->sort_dirty = TRUE;
+    priv->balance_dirty = TRUE;
+    return added;
+}
+
 gboolean
 gnc_account_remove_split (Account *acc, Split *s)
 {
@@ -1965,6 +2011,49 @@ gnc_account_remove_split (Account *acc, Split *s)
     return TRUE;
 }
 
+/* Sorts splits into xaccSplitOrder() order. The fields that decide most
+ * comparisons are extracted into a SplitSortKey for each split first, so
+ * the book option and the transaction's KVP aren't consulted and its
+ * number isn't parsed again on every comparison. The list's nodes are
+ * reused. */
+static GList *
+sort_splits (GList *splits)
+{
+    if (!splits || !splits->next)
+        return splits;
+
+    auto first = static_cast<Split*>(splits->data);
+    auto action_for_num =
+        qof_book_use_split_action_for_num_field (xaccSplitGetBook (first));
+    std::vector<std::pair<SplitSortKey, Split*>> keyed;
+    keyed.reserve (g_list_length (splits));
+    for (auto node = splits; node; node = node->next)
+    {
+        auto s = static_cast<Split*>(node->data);
+        SplitSortKey key;
+        if (!xaccSplitGetSortKey (s, action_for_num, &key))
+            return g_list_sort (splits, (GCompareFunc)xaccSplitOrder);
+        keyed.emplace_back (key, s);
+    }
+
+    std::sort (keyed.begin (), keyed.end (),
+               [](const auto& a, const auto& b)
+               {
+                   auto comp = xaccSplitSortKeyCompare (&a.first, &b.first);
+                   if (comp)
+                       return comp < 0;
+                   return xaccSplitOrder (a.second, b.second) < 0;
+               });
+
+    auto node = splits;
+    for (const auto& entry : keyed)
+    {
+        node->data = entry.second;
+        node = node->next;
+    }
+    return splits;
+}
+
 void
 xaccAccountSortSplits (Account *acc, gboolean force)
 {
@@ -1975,7 +2064,7 @@ xaccAccountSortSplits (Account *acc, gboolean force)
     priv = GET_PRIVATE(acc);
     if (!priv->sort_dirty || (!force && qof_instance_get_editlevel(acc) > 0))
         return;
-    priv->splits = g_list_sort(priv->splits, (GCompareFunc)xaccSplitOrder);
+    priv->splits = sort_splits (priv->splits);
     priv->sort_dirty = FALSE;
     priv->balance_dirty = TRUE;
 }
@@ -2083,6 +2172,184 @@ gnc_account_set_policy (Account *acc, GNCPolicy *policy)
     priv->policy = policy ? policy : xaccGetFIFOPolicy();
 }
 
+/********************************************************************\
+ * Open lot index
+ *
+ * The FIFO and LIFO policies look for the earliest or latest open lot
+ * for every split they assign.  Rather than visiting every lot of the
+ * account each time, keep the open lots ordered by the posted date of
+ * their opening split, one set per sign of that split.  Lots that may
+ * have changed are only queued and re-filed on the next lookup, so a
+ * burst of split edits doesn't cost a resort per edit.
+ *
+ * Among lots opened on the same date the one most recently added to the
+ * account wins, which is what the old linear scan of the prepended lot
+ * list returned.
+\********************************************************************/
+
+namespace {
+
+struct OpenLotEntry
+{
+    gint64 seq;                 /* higher is more recently inserted */
+    int bucket;                 /* 0/1 by opening sign, -1 if not filed */
+    time64 date;
+};
+
+using OpenLotKey = std::tuple<time64, gint64, GNCLot*>;
+
+struct OpenLotIndex
+{
+    std::set<OpenLotKey> open[2];
+    std::unordered_map<GNCLot*, OpenLotEntry> lots;
+    std::unordered_set<GNCLot*> dirty;
+    gint64 next_seq = 1;
+};
+
+}
+
+static void
+open_lot_index_free (AccountPrivate *priv)
+{
+    delete static_cast<OpenLotIndex*>(priv->open_lots);
+    priv->open_lots = NULL;
+}
+
+static void
+open_lot_index_unfile (OpenLotIndex *index, GNCLot *lot, OpenLotEntry& entry)
+{
+    if (entry.bucket < 0) return;
+    index->open[entry.bucket].erase (OpenLotKey{entry.date, -entry.seq, lot});
+    entry.bucket = -1;
+}
+
+static void
+open_lot_index_file (OpenLotIndex *index, GNCLot *lot, OpenLotEntry& entry)
+{
+    Split *split;
+    gboolean positive;
+
+    open_lot_index_unfile (index, lot, entry);
+    if (gnc_lot_is_closed (lot)) return;
+    split = gnc_lot_get_earliest_split (lot);
+    if (!split) return;
+    if (gnc_numeric_zero_p (split->amount)) return;
+
+    /* Overfull lots don't take any more splits. */
+    positive = gnc_numeric_positive_p (split->amount);
+    if (positive != gnc_numeric_positive_p (gnc_lot_get_balance (lot)))
+        return;
+
+    entry.bucket = positive ? 1 : 0;
+    entry.date = xaccTransRetDatePosted (split->parent);
+    index->open[entry.bucket].emplace (entry.date, -entry.seq, lot);
+}
+
+static OpenLotIndex *
+open_lot_index_get (AccountPrivate *priv)
+{
+    auto index = static_cast<OpenLotIndex*>(priv->open_lots);
+
+    if (!index)
+    {
+        gint64 seq = 0;
+        index = new OpenLotIndex;
+        for (auto node = priv->lots; node; node = node->next)
+        {
+            auto lot = static_cast<GNCLot*>(node->data);
+            index->lots.emplace (lot, OpenLotEntry{seq--, -1, 0});
+            index->dirty.insert (lot);
+        }
+        priv->open_lots = index;
+    }
+
+    std::unordered_set<GNCLot*> dirty;
+    dirty.swap (index->dirty);
+    for (auto lot : dirty)
+    {
+        auto entry = index->lots.find (lot);
+        if (entry != index->lots.end ())
+            open_lot_index_file (index, lot, entry->second);
+    }
+    return index;
+}
+
+static void
+open_lot_index_remove (AccountPrivate *priv, GNCLot *lot)
+{
+    auto index = static_cast<OpenLotIndex*>(priv->open_lots);
+    if (!index) return;
+
+    auto entry = index->lots.find (lot);
+    if (entry == index->lots.end ()) return;
+    open_lot_index_unfile (index, lot, entry->second);
+    index->lots.erase (entry);
+    index->dirty.erase (lot);
+}
+
+static void
+open_lot_index_insert (AccountPrivate *priv, GNCLot *lot)
+{
+    auto index = static_cast<OpenLotIndex*>(priv->open_lots);
+    if (!index) return;
+
+    index->lots[lot] = OpenLotEntry{index->next_seq++, -1, 0};
+    index->dirty.insert (lot);
+}
+
+void
+xaccAccountLotChanged (Account *acc, GNCLot *lot)
+{
+    OpenLotIndex *index;
+
+    if (!acc || !lot) return;
+    index = static_cast<OpenLotIndex*>(GET_PRIVATE(acc)->open_lots);
+    if (index && index->lots.count (lot))
+        index->dirty.insert (lot);
+}
+
+static gboolean
+open_lot_currency_matches (GNCLot *lot, gnc_commodity *currency)
+{
+    Split *split;
+
+    if (!currency) return TRUE;
+    split = gnc_lot_get_earliest_split (lot);
+    return gnc_commodity_equiv (currency, split->parent->common_currency);
+}
+
+GNCLot *
+xaccAccountFindOpenLotByDate (Account *acc, gboolean opening_positive,
+                              gnc_commodity *currency, gboolean latest)
+{
+    g_return_val_if_fail (GNC_IS_ACCOUNT(acc), NULL);
+
+    auto index = open_lot_index_get (GET_PRIVATE(acc));
+    auto& lots = index->open[opening_positive ? 1 : 0];
+
+    if (!latest)
+    {
+        for (auto& key : lots)
+            if (open_lot_currency_matches (std::get<2>(key), currency))
+                return std::get<2>(key);
+        return NULL;
+    }
+
+    /* Walk the dates backwards, but within a date keep the newest lot
+     * first, as the earliest lookup does. */
+    auto end = lots.end ();
+    while (end != lots.begin ())
+    {
+        auto date = std::get<0>(*std::prev (end));
+        auto begin = lots.lower_bound (OpenLotKey{date, G_MININT64, nullptr});
+        for (auto it = begin; it != end; ++it)
+            if (open_lot_currency_matches (std::get<2>(*it), currency))
+                return std::get<2>(*it);
+        end = begin;
+    }
+    return NULL;
+}
+
 /********************************************************************\
 \********************************************************************/
 
@@ -2099,6 +2366,7 @@ xaccAccountRemoveLot (Account *acc, GNCLot *lot)
 
     ENTER ("(acc=%p, lot=%p)", acc, lot);
     priv->lots = g_list_remove(priv->lots, lot);
+    open_lot_index_remove (priv, lot);
     qof_event_gen (QOF_INSTANCE(lot), QOF_EVENT_REMOVE, NULL);
     qof_event_gen (&acc->inst, QOF_EVENT_MODIFY, NULL);
     LEAVE ("(acc=%p, lot=%p)", acc, lot);
@@ -2128,10 +2396,12 @@ xaccAccountInsertLot (Account *acc, GNCLot *lot)
         old_acc = lot_account;
         opriv = GET_PRIVATE(old_acc);
         opriv->lots = g_list_remove(opriv->lots, lot);
+        open_lot_index_remove (opriv, lot);
     }
 
     priv = GET_PRIVATE(acc);
     priv->lots = g_list_prepend(priv->lots, lot);
+    open_lot_index_insert (priv, lot);
     gnc_lot_set_account(lot, acc);
 
     /* Don't move the splits to the new account.  The caller will do this
@@ -3536,6 +3806,109 @@ xaccAccountGetReconciledBalanceAsOfDate (Account *acc, time64 date)
     return balance;
 }
 
+/* Balances at dates
+ *
+ * Reports want the balances of many accounts at a series of dates. Once
+ * an account's splits are sorted and its running balances computed, the
+ * balance at a date is the running balance of the last split on or
+ * before it, so one walk down the split list serves all the dates.
+ * The walk only reads the accounts, which lets a few threads each take
+ * an account at a time.
+ */
+
+/* Below this many splits starting threads isn't worth it */
+static constexpr guint balances_min_parallel = 4096;
+static constexpr guint balances_max_threads = 8;
+
+struct BalancesJob
+{
+    Account **accounts;
+    guint n_accounts;
+    const time64 *dates;
+    guint n_dates;
+    gboolean ignore_closing;
+    gboolean changes;
+    gnc_numeric *results;
+    std::atomic<guint> next;
+};
+
+static void
+account_balances_at_dates (BalancesJob *job, guint index)
+{
+    auto results = job->results + (gsize)index * job->n_dates;
+    auto balance = gnc_numeric_zero ();
+    auto node = GET_PRIVATE(job->accounts[index])->splits;
+
+    for (guint i = 0; i < job->n_dates; i++)
+    {
+        for (; node; node = node->next)
+        {
+            auto split = static_cast<Split*>(node->data);
+            if (xaccTransGetDate (xaccSplitGetParent (split)) > job->dates[i])
+                break;
+            balance = job->ignore_closing ? xaccSplitGetNoclosingBalance (split)
+                                          : xaccSplitGetBalance (split);
+        }
+        results[i] = balance;
+    }
+
+    if (job->changes)
+        for (guint i = job->n_dates - 1; i > 0; i--)
+            results[i] = gnc_numeric_sub_fixed (results[i], results[i - 1]);
+}
+
+static gpointer
+balances_worker (gpointer data)
+{
+    auto job = static_cast<BalancesJob*>(data);
+    guint index;
+    while ((index = job->next.fetch_add (1)) < job->n_accounts)
+        account_balances_at_dates (job, index);
+    return nullptr;
+}
+
+void
+xaccAccountsGetBalancesAtDates (Account **accounts, guint n_accounts,
+                                const time64 *dates, guint n_dates,
+                                gboolean ignore_closing, gboolean changes,
+                                gnc_numeric *results)
+{
+    guint n_splits = 0;
+
+    g_return_if_fail (accounts || !n_accounts);
+    g_return_if_fail (dates && results);
+    if (!n_accounts || !n_dates) return;
+
+    /* Bring the split lists and running balances up to date here, the
+     * workers mustn't change the accounts. */
+    for (guint i = 0; i < n_accounts; i++)
+    {
+        g_return_if_fail (GNC_IS_ACCOUNT (accounts[i]));
+        /* force only skips the editlevel check: a dirty list is sorted
+         * even while the account is being edited, a clean one is left
+         * alone.  The workers rely on it being sorted. */
+        xaccAccountSortSplits (accounts[i], TRUE);
+        xaccAccountRecomputeBalance (accounts[i]);
+        n_splits += g_list_length (GET_PRIVATE(accounts[i])->splits);
+    }
+
+    BalancesJob job {accounts, n_accounts, dates, n_dates,
+                     ignore_closing, changes, results, {0}};
+    auto n_threads = std::min ({g_get_num_processors (), balances_max_threads,
+                                n_accounts});
+    std::vector<GThread*> threads;
+    if (n_splits >= balances_min_parallel)
+        for (guint i = 1; i < n_threads; i++)
+            threads.push_back (g_thread_new ("account-balances",
+                                             balances_worker, &job));
+    balances_worker (&job);
+    for (auto thread : threads)
+        g_thread_join (thread);
+
+    PINFO ("%u accounts, %u splits, %u dates on %zu threads",
+           n_accounts, n_splits, n_dates, threads.size () + 1);
+}
+
 /*
  * Originally gsr_account_present_balance in gnc-split-reg.c
  */
@@ -5432,21 +5805,6 @@ struct AccountProbability
     double product_difference; /* product of (1-probabilities) */
 };
 
-struct AccountTokenCount
-{
-    std::string account_guid;
-    int64_t token_count; /** occurrences of a given token for this account_guid */
-};
-
-/** total_count and the token_count for a given account let us calculate the
- * probability of a given account with any single token
- */
-struct TokenAccountsInfo
-{
-    std::vector<AccountTokenCount> accounts;
-    int64_t total_count;
-};
-
 /** holds an account guid and its corresponding integer probability
   the integer probability is some factor of 10
  */
@@ -5456,17 +5814,6 @@ struct AccountInfo
     int32_t probability;
 };
 
-static void
-build_token_info(char const * suffix, KvpValue * value, TokenAccountsInfo & tokenInfo)
-{
-    if (strlen(suffix) == GUID_ENCODING_LENGTH)
-    {
-        tokenInfo.total_count += value->get<int64_t>();
-        /*By convention, the key ends with the account GUID.*/
-        tokenInfo.accounts.emplace_back(AccountTokenCount{std::string{suffix}, value->get<int64_t>()});
-    }
-}
-
 /** We scale the probability values by probability_factor.
   ie. with probability_factor of 100000, 10% would be
   0.10 * 100000 = 10000 */
@@ -5500,41 +5847,176 @@ highest_probability(FinalProbabilityVec const & probabilities)
     return ret;
 }
 
+/** The flat bayes entries of an account live in the root frame of its
+ * KVP, keyed "import-map-bayes/<token>/<account guid>", so looking up a
+ * token means walking every slot of the account.  Instead, the book keeps
+ * an index of each source account's entries, built the first time the
+ * account is matched against and kept current by the functions below
+ * that change the entries.  Tokens and account GUIDs are interned to
+ * integer ids, shared by all the accounts of the book.
+ *
+ * The index is checked against the KVP frame and its size before use, so
+ * entries written to the frame directly cause a rebuild as well.
+ */
+struct ImapTokenAccounts
+{
+    int64_t total_count;
+    /* account id and count, ordered by account GUID string like the
+     * slots of the frame */
+    std::vector<std::pair<uint32_t, int64_t>> accounts;
+};
+
+struct ImapAccountIndex
+{
+    KvpFrame const * frame;
+    std::size_t n_slots;
+    std::unordered_map<uint32_t, ImapTokenAccounts> tokens;
+};
+
+struct ImapBayesIndex
+{
+    std::unordered_map<std::string, uint32_t> token_ids;
+    std::unordered_map<std::string, uint32_t> account_ids;
+    std::vector<std::string> account_guids;
+    std::unordered_map<Account const *, ImapAccountIndex> accounts;
+};
+
+#define IMAP_BAYES_INDEX "gnc-imap-bayes-index"
+
+static void
+imap_bayes_index_free (QofBook *book, gpointer key, gpointer data)
+{
+    delete static_cast<ImapBayesIndex*>(data);
+}
+
+static ImapBayesIndex *
+imap_bayes_index_peek (QofBook *book)
+{
+    /* The book data is finalized before the accounts are destroyed. */
+    if (!book || qof_book_shutting_down (book)) return nullptr;
+    return static_cast<ImapBayesIndex*>(qof_book_get_data (book, IMAP_BAYES_INDEX));
+}
+
+static uint32_t
+imap_intern (std::unordered_map<std::string, uint32_t> & ids, std::string const & str)
+{
+    return ids.emplace (str, ids.size ()).first->second;
+}
+
+static uint32_t
+imap_intern_account (ImapBayesIndex & index, std::string const & guid)
+{
+    auto id = imap_intern (index.account_ids, guid);
+    if (id == index.account_guids.size ())
+        index.account_guids.push_back (guid);
+    return id;
+}
+
+static void
+imap_index_add_count (ImapBayesIndex & index, ImapAccountIndex & acc_index,
+                      std::string const & token, std::string const & guid,
+                      int64_t count)
+{
+    auto & info = acc_index.tokens[imap_intern (index.token_ids, token)];
+    auto account_id = imap_intern_account (index, guid);
+    auto spot = std::lower_bound (info.accounts.begin (), info.accounts.end (), guid,
+                                  [&index] (std::pair<uint32_t, int64_t> const & a,
+                                            std::string const & b)
+                                  { return index.account_guids[a.first] < b; });
+    if (spot != info.accounts.end () && spot->first == account_id)
+        spot->second += count;
+    else
+        info.accounts.emplace (spot, account_id, count);
+    info.total_count += count;
+}
+
+/** Drop the index of the account's bayes entries; it is rebuilt when
+ * the account is next matched against. */
+static void
+imap_bayes_index_forget (Account const * acc)
+{
+    auto index = imap_bayes_index_peek (gnc_account_get_book (acc));
+    if (index)
+        index->accounts.erase (acc);
+}
+
+static ImapAccountIndex &
+imap_bayes_index_get (GncImportMatchMap * imap)
+{
+    auto index = imap_bayes_index_peek (imap->book);
+    if (!index)
+    {
+        index = new ImapBayesIndex;
+        qof_book_set_data_fin (imap->book, IMAP_BAYES_INDEX, index,
+                               imap_bayes_index_free);
+    }
+    auto frame = qof_instance_get_slots (QOF_INSTANCE (imap->acc));
+    auto & acc_index = index->accounts[imap->acc];
+    if (acc_index.frame == frame && acc_index.n_slots == frame->size ())
+        return acc_index;
+
+    acc_index.tokens.clear ();
+    acc_index.frame = frame;
+    acc_index.n_slots = frame->size ();
+    std::string const prefix {IMAP_FRAME_BAYES "/"};
+    frame->for_each_slot_prefix (prefix, [index]
+        (char const * suffix, KvpValue * value, ImapAccountIndex & acc_index)
+        {
+            /* By convention, the key ends with "/<account GUID>". */
+            auto len = strlen (suffix);
+            if (len <= GUID_ENCODING_LENGTH + 1 ||
+                suffix[len - GUID_ENCODING_LENGTH - 1] != '/')
+                return;
+            std::string token {suffix, len - GUID_ENCODING_LENGTH - 1};
+            std::string guid {suffix + len - GUID_ENCODING_LENGTH};
+            imap_index_add_count (*index, acc_index, token, guid,
+                                  value->get<int64_t>());
+        }, acc_index);
+    return acc_index;
+}
+
 static ProbabilityVec
 get_first_pass_probabilities(GncImportMatchMap * imap, GList * tokens)
 {
-    ProbabilityVec ret;
+    auto & acc_index = imap_bayes_index_get (imap);
+    auto index = imap_bayes_index_peek (imap->book);
+    std::vector<std::pair<uint32_t, AccountProbability>> first_pass;
+    std::unordered_map<uint32_t, std::size_t> position;
     /* find the probability for each account that contains any of the tokens
      * in the input tokens list. */
     for (auto current_token = tokens; current_token; current_token = current_token->next)
     {
-        TokenAccountsInfo tokenInfo{};
-        auto path = std::string{IMAP_FRAME_BAYES "/"} + static_cast <char const *> (current_token->data) + "/";
-        qof_instance_foreach_slot_prefix (QOF_INSTANCE (imap->acc), path, &build_token_info, tokenInfo);
+        auto token_id = index->token_ids.find (static_cast <char const *> (current_token->data));
+        if (token_id == index->token_ids.end ())
+            continue;
+        auto info = acc_index.tokens.find (token_id->second);
+        if (info == acc_index.tokens.end ())
+            continue;
+        auto const & tokenInfo = info->second;
         for (auto const & current_account_token : tokenInfo.accounts)
         {
-            auto item = std::find_if(ret.begin(), ret.end(), [&current_account_token]
-                (std::pair<std::string, AccountProbability> const & a) {
-                    return current_account_token.account_guid == a.first;
-                });
-            if (item != ret.end())
+            auto probability = (double)current_account_token.second /
+                               (double)tokenInfo.total_count;
+            auto item = position.find (current_account_token.first);
+            if (item != position.end ())
             {/* This account is already in the map */
-                item->second.product = ((double)current_account_token.token_count /
-                                      (double)tokenInfo.total_count) * item->second.product;
-                item->second.product_difference = ((double)1 - ((double)current_account_token.token_count /
-                                              (double)tokenInfo.total_count)) * item->second.product_difference;
+                auto & account_probability = first_pass[item->second].second;
+                account_probability.product *= probability;
+                account_probability.product_difference *= 1 - probability;
             }
             else
             {
                 /* add a new entry */
-                AccountProbability new_probability;
-                new_probability.product = ((double)current_account_token.token_count /
-                                      (double)tokenInfo.total_count);
-                new_probability.product_difference = 1 - (new_probability.product);
-                ret.push_back({current_account_token.account_guid, std::move(new_probability)});
+                position.emplace (current_account_token.first, first_pass.size ());
+                first_pass.push_back ({current_account_token.first,
+                                       AccountProbability {probability, 1 - probability}});
             }
         } /* for all accounts in tokenInfo */
     }
+    ProbabilityVec ret;
+    ret.reserve (first_pass.size ());
+    for (auto const & entry : first_pass)
+        ret.push_back ({index->account_guids[entry.first], entry.second});
     return ret;
 }
 
@@ -5637,6 +6119,7 @@ convert_imap_account_bayes_to_flat (Account *acc)
     auto flat_imap = get_flat_imap(acc);
     if (!flat_imap.size ())
         return false;
+    imap_bayes_index_forget (acc);
     xaccAccountBeginEdit(acc);
     frame->set({IMAP_FRAME_BAYES}, nullptr);
     std::for_each(flat_imap.begin(), flat_imap.end(),
@@ -5790,6 +6273,18 @@ gnc_account_imap_add_account_bayes (GncImportMatchMap *imap,
 
     guid_string = guid_to_string (xaccAccountGetGUID (acc));
 
+    /* Update the index along with the entries if it is current. */
+    auto index = imap_bayes_index_peek (imap->book);
+    auto frame = qof_instance_get_slots (QOF_INSTANCE (imap->acc));
+    ImapAccountIndex *acc_index = nullptr;
+    if (index)
+    {
+        auto spot = index->accounts.find (imap->acc);
+        if (spot != index->accounts.end () && spot->second.frame == frame &&
+            spot->second.n_slots == frame->size ())
+            acc_index = &spot->second;
+    }
+
     /* process each token in the list */
     for (current_token = g_list_first(tokens); current_token;
             current_token = current_token->next)
@@ -5806,6 +6301,13 @@ gnc_account_imap_add_account_bayes (GncImportMatchMap *imap,
         auto path = std::string {IMAP_FRAME_BAYES} + '/' + static_cast<char*>(current_token->data) + '/' + guid_string;
         /* change the imap entry for the account */
         change_imap_entry (imap, path, token_count);
+        if (acc_index)
+        {
+            imap_index_add_count (*index, *acc_index,
+                                  static_cast<char*>(current_token->data),
+                                  guid_string, token_count);
+            acc_index->n_slots = frame->size ();
+        }
     }
     /* free up the account fullname and guid string */
     qof_instance_set_dirty (QOF_INSTANCE (imap->acc));
@@ -5949,6 +6451,7 @@ gnc_account_delete_map_entry (Account *acc, char *head, char *category,
 
         if (qof_instance_has_path_slot (QOF_INSTANCE (acc), path))
         {
+            imap_bayes_index_forget (acc);
             xaccAccountBeginEdit (acc);
             if (empty)
                 qof_instance_slot_path_delete_if_empty (QOF_INSTANCE(acc), path);
@@ -5969,6 +6472,7 @@ gnc_account_delete_all_bayes_maps (Account *acc)
     {
         auto slots = qof_instance_get_slots_prefix (QOF_INSTANCE (acc), IMAP_FRAME_BAYES);
         if (!slots.size()) return;
+        imap_bayes_index_forget (acc);
         for (auto const & entry : slots)
         {
              qof_instance_slot_path_delete (QOF_INSTANCE (acc), {entry.first});
@@ -568,6 +568,29 @@ gnc_numeric xaccAccountGetBalanceAsOfDate (Account *account,
 /** Get the reconciled balance of the account as of the date specified */
 gnc_numeric xaccAccountGetReconciledBalanceAsOfDate (Account *account, time64 date);
 
+/** Get the balances of several accounts at several dates in one go.
+ *
+ *  This walks each account's split list once for all the dates and
+ *  spreads large jobs over a few threads, so it's much faster than
+ *  asking for each balance separately. Unlike
+ *  xaccAccountGetBalanceAsOfDate() the balance at a date includes the
+ *  splits posted at that very time, matching what the reports expect.
+ *
+ *  @param accounts The accounts, none of which may be open for editing
+ *  @param n_accounts The number of accounts
+ *  @param dates The dates, sorted in ascending order
+ *  @param n_dates The number of dates
+ *  @param ignore_closing Leave out the splits of closing transactions
+ *  @param changes Return the change in balance since the previous date
+ *  instead of the balance; the first entry is still the balance.
+ *  @param results Filled in with n_accounts times n_dates balances, the
+ *  balance of accounts[i] at dates[j] going to results[i * n_dates + j].
+ */
+void xaccAccountsGetBalancesAtDates (Account **accounts, guint n_accounts,
+                                     const time64 *dates, guint n_dates,
+                                     gboolean ignore_closing, gboolean changes,
+                                     gnc_numeric *results);
+
 /* These two functions convert a given balance from one commodity to
    another.  The account argument is only used to get the Book, and
    may have nothing to do with the supplied balance.  Likewise, the
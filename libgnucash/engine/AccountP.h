@@ -120,6 +120,8 @@ typedef struct AccountPrivate
     gboolean sort_dirty;        /* sort order of splits is bad */
 
     LotList   *lots;		/* list of lot pointers */
+    gpointer   open_lots;	/* date-ordered index of open lots, built
+                                 * on demand; see xaccAccountFindOpenLotByDate */
     GNCPolicy *policy;		/* Cached pointer to policy method */
 
     /* The "mark" flag can be used by the user to mark this account
@@ -139,6 +141,28 @@ struct account_s
  * call this on an existing account! */
 void xaccAccountSetGUID (Account *account, const GncGUID *guid);
 
+/* Tell the account that the opening split, balance or closed state of one
+ * of its lots may have changed, so that the open-lot index is refreshed
+ * before the next lookup.  Called from gnc-lot.c. */
+void xaccAccountLotChanged (Account *acc, GNCLot *lot);
+
+/* Find the open lot whose opening split is the earliest (or, if latest is
+ * TRUE, the latest) among those opened with a split of the given sign and,
+ * if currency is not NULL, in that currency.  Overfull lots, whose balance
+ * has the opposite sign of their opening split, are skipped.  This is the
+ * back end of xaccAccountFindEarliestOpenLot() and
+ * xaccAccountFindLatestOpenLot(). */
+GNCLot *xaccAccountFindOpenLotByDate (Account *acc, gboolean opening_positive,
+                                      gnc_commodity *currency,
+                                      gboolean latest);
+
+/* Add the splits, which should be new to the account, as
+ * gnc_account_insert_split() would one at a time. A single pass over the
+ * account's splits finds those it already has, which are skipped, and
+ * the others are left to be sorted with the next sort. Called from
+ * xaccTransCommitBulk(); returns the number of splits added. */
+guint gnc_account_insert_splits (Account *acc, GList *splits);
+
 /* Register Accounts with the engine */
 gboolean xaccAccountRegister (void);
 
@@ -57,19 +57,19 @@
 #define G_LOG_DOMAIN "gnc.engine.scrub"
 
 static QofLogModule log_module = G_LOG_DOMAIN;
-static gboolean abort_now = FALSE;
+static gint abort_now = FALSE;   /* read by the check threads, atomic */
 static gint scrub_depth = 0;
 
 void
 gnc_set_abort_scrub (gboolean abort)
 {
-    abort_now = abort;
+    g_atomic_int_set (&abort_now, abort);
 }
 
 gboolean
 gnc_get_abort_scrub (void)
 {
-    return abort_now;
+    return g_atomic_int_get (&abort_now);
 }
 
 gboolean
@@ -80,18 +80,290 @@ gnc_get_ongoing_scrub (void)
 
 /* ================================================================ */
 
+/* Tree-wide transaction scrubbing
+ *
+ * Walking every split of every account and scrubbing its transaction
+ * visits each transaction once per split, and almost all of them are
+ * fine.  Instead, collect the transactions of the tree once, copy what
+ * the scrubbers look at into a plain snapshot, and let a few worker
+ * threads check the snapshot for anything the scrubbers would change.
+ * Only the engine objects of the transactions found that way are then
+ * scrubbed, serially, on the calling thread.  The check errs on the side
+ * of flagging: a flagged transaction that turns out to be clean costs
+ * nothing but the scrub it would have had anyway.
+ */
+
+#define SCRUB_CHUNK 256
+#define SCRUB_MAX_THREADS 8
+#define SCRUB_MIN_PARALLEL 2048
+
+enum
+{
+    SCRUB_NEEDS_ORPHANS = 1 << 0,
+    SCRUB_NEEDS_REPAIR  = 1 << 1,
+};
+
+typedef struct
+{
+    gnc_numeric amount;
+    gnc_numeric value;
+    gboolean orphan;
+    gboolean no_commodity;
+    gboolean in_currency;       /* account commodity is the txn currency */
+    gboolean trading;           /* split is in a trading account */
+    gint64 amount_scu;          /* account commodity SCU */
+    gint64 value_scu;           /* txn currency fraction */
+} ScrubSplitInfo;
+
+typedef struct
+{
+    Transaction *trans;
+    guint first_split;
+    guint n_splits;
+    gboolean bad_currency;
+    gboolean use_trading;
+    guint flags;                /* result of the check */
+} ScrubTransInfo;
+
+typedef struct
+{
+    GArray *trans;              /* of ScrubTransInfo */
+    GArray *splits;             /* of ScrubSplitInfo */
+    gint next;                  /* next chunk to check, atomic */
+} ScrubSnapshot;
+
+static void TransScrubOrphansFast (Transaction *trans, Account *root);
+
+static void
+scrub_snapshot_add_trans (ScrubSnapshot *snap, Transaction *trans)
+{
+    ScrubTransInfo ti;
+    gnc_commodity *currency = trans->common_currency;
+    GList *node;
+
+    ti.trans = trans;
+    ti.first_split = snap->splits->len;
+    ti.n_splits = 0;
+    ti.bad_currency = !currency || !gnc_commodity_is_currency (currency);
+    ti.use_trading = xaccTransUseTradingAccounts (trans);
+    ti.flags = 0;
+
+    for (node = trans->splits; node; node = node->next)
+    {
+        Split *split = node->data;
+        ScrubSplitInfo si;
+        gnc_commodity *comm;
+
+        if (!xaccTransStillHasSplit (trans, split)) continue;
+        comm = split->acc ? xaccAccountGetCommodity (split->acc) : NULL;
+        si.amount = split->amount;
+        si.value = split->value;
+        si.orphan = (split->acc == NULL);
+        si.no_commodity = (split->acc && !comm);
+        si.in_currency = comm && gnc_commodity_equiv (comm, currency);
+        si.trading = split->acc &&
+                     xaccAccountGetType (split->acc) == ACCT_TYPE_TRADING;
+        si.amount_scu = comm ? xaccAccountGetCommoditySCU (split->acc) : 0;
+        si.value_scu = currency ? gnc_commodity_get_fraction (currency) : 0;
+        g_array_append_val (snap->splits, si);
+        ti.n_splits++;
+    }
+    g_array_append_val (snap->trans, ti);
+}
+
+static void
+scrub_snapshot_add_account (Account *acc, gpointer data)
+{
+    gpointer *args = data;
+    ScrubSnapshot *snap = args[0];
+    GHashTable *seen = args[1];
+    GList *node;
+
+    for (node = xaccAccountGetSplitList (acc); node; node = node->next)
+    {
+        Transaction *trans = xaccSplitGetParent (node->data);
+        if (!trans || !g_hash_table_add (seen, trans)) continue;
+        scrub_snapshot_add_trans (snap, trans);
+    }
+}
+
+/* TRUE if n would change when rounded to scu, the way xaccSplitScrub and
+ * xaccSplitSetAmount/Value round it. */
+static gboolean
+scrub_off_scu (gnc_numeric n, gint64 scu)
+{
+    if (scu <= 0) return FALSE;
+    return !gnc_numeric_equal (n, gnc_numeric_convert (n, scu,
+                                                       GNC_HOW_RND_ROUND_HALF_UP));
+}
+
+/* Works only on the snapshot, so it is safe to run off the main thread. */
+static guint
+scrub_check_trans (const ScrubTransInfo *ti, const ScrubSplitInfo *splits)
+{
+    gnc_numeric imbal = gnc_numeric_zero ();
+    gnc_numeric imbal_trading = gnc_numeric_zero ();
+    guint flags = 0;
+    guint i;
+
+    if (ti->bad_currency)
+        flags |= SCRUB_NEEDS_REPAIR;
+
+    for (i = 0; i < ti->n_splits; i++)
+    {
+        const ScrubSplitInfo *si = &splits[ti->first_split + i];
+
+        if (si->orphan)
+            flags |= SCRUB_NEEDS_ORPHANS | SCRUB_NEEDS_REPAIR;
+        if (si->no_commodity ||
+            gnc_numeric_check (si->amount) || gnc_numeric_check (si->value))
+        {
+            flags |= SCRUB_NEEDS_REPAIR;
+            continue;
+        }
+        if (si->in_currency && !gnc_numeric_equal (si->amount, si->value))
+            flags |= SCRUB_NEEDS_REPAIR;
+        if (scrub_off_scu (si->amount, si->amount_scu) ||
+            scrub_off_scu (si->value, si->value_scu))
+            flags |= SCRUB_NEEDS_REPAIR;
+        /* Per-commodity balancing is left to the real scrubber. */
+        if (ti->use_trading && !si->in_currency)
+            flags |= SCRUB_NEEDS_REPAIR;
+
+        if (ti->use_trading && si->trading)
+            imbal_trading = gnc_numeric_add (imbal_trading, si->value,
+                                             GNC_DENOM_AUTO,
+                                             GNC_HOW_DENOM_EXACT);
+        else
+            imbal = gnc_numeric_add (imbal, si->value, GNC_DENOM_AUTO,
+                                     GNC_HOW_DENOM_EXACT);
+    }
+    if (!gnc_numeric_zero_p (imbal) || !gnc_numeric_zero_p (imbal_trading))
+        flags |= SCRUB_NEEDS_REPAIR;
+
+    return flags;
+}
+
+/* Check the next chunk of the snapshot; returns the index of its first
+ * transaction, or -1 when there is nothing left to do. */
+static gint
+scrub_check_chunk (ScrubSnapshot *snap)
+{
+    ScrubTransInfo *trans = (ScrubTransInfo*)snap->trans->data;
+    const ScrubSplitInfo *splits = (const ScrubSplitInfo*)snap->splits->data;
+    gint start, end, i;
+
+    if (g_atomic_int_get (&abort_now)) return -1;
+    start = g_atomic_int_add (&snap->next, SCRUB_CHUNK);
+    if (start >= (gint)snap->trans->len) return -1;
+
+    end = MIN (start + SCRUB_CHUNK, (gint)snap->trans->len);
+    for (i = start; i < end; i++)
+        trans[i].flags = scrub_check_trans (&trans[i], splits);
+    return start;
+}
+
+static gpointer
+scrub_check_thread (gpointer data)
+{
+    while (scrub_check_chunk (data) >= 0)
+        ;
+    return NULL;
+}
+
+static void
+scrub_tree_transactions (Account *acc, QofPercentageFunc percentagefunc,
+                         guint wanted)
+{
+    const char *check_msg = _("Checking transactions: %u of %u");
+    const char *fix_msg = _("Repairing transactions: %u of %u");
+    Account *root = gnc_account_get_root (acc);
+    ScrubSnapshot snap;
+    GHashTable *seen;
+    gpointer args[2];
+    GPtrArray *threads;
+    gint64 t_start, t_snap, t_check, t_fix;
+    guint n_threads = 0, n_fixed = 0, total, i;
+    gint start;
+
+    t_start = g_get_monotonic_time ();
+    snap.trans = g_array_new (FALSE, FALSE, sizeof (ScrubTransInfo));
+    snap.splits = g_array_new (FALSE, FALSE, sizeof (ScrubSplitInfo));
+    snap.next = 0;
+    seen = g_hash_table_new (g_direct_hash, g_direct_equal);
+    args[0] = &snap;
+    args[1] = seen;
+    scrub_snapshot_add_account (acc, args);
+    gnc_account_foreach_descendant (acc, scrub_snapshot_add_account, args);
+    g_hash_table_destroy (seen);
+    total = snap.trans->len;
+    t_snap = g_get_monotonic_time ();
+
+    /* The calling thread checks chunks too, in between keeping the
+     * progress bar (and with it the abort key) alive. */
+    threads = g_ptr_array_new ();
+    if (total >= SCRUB_MIN_PARALLEL)
+        n_threads = MIN (g_get_num_processors (), SCRUB_MAX_THREADS) - 1;
+    for (i = 0; i < n_threads; i++)
+        g_ptr_array_add (threads, g_thread_new ("scrub-check",
+                                                scrub_check_thread, &snap));
+    while ((start = scrub_check_chunk (&snap)) >= 0)
+    {
+        char *progress_msg = g_strdup_printf (check_msg, start, total);
+        (percentagefunc)(progress_msg, (100 * start) / total);
+        g_free (progress_msg);
+    }
+    for (i = 0; i < threads->len; i++)
+        g_thread_join (g_ptr_array_index (threads, i));
+    g_ptr_array_free (threads, TRUE);
+    t_check = g_get_monotonic_time ();
+
+    for (i = 0; i < total && !g_atomic_int_get (&abort_now); i++)
+    {
+        ScrubTransInfo *ti = &g_array_index (snap.trans, ScrubTransInfo, i);
+        if (!(ti->flags & wanted)) continue;
+
+        if (n_fixed % 10 == 0)
+        {
+            char *progress_msg = g_strdup_printf (fix_msg, i, total);
+            (percentagefunc)(progress_msg, (100 * i) / total);
+            g_free (progress_msg);
+        }
+        n_fixed++;
+
+        TransScrubOrphansFast (ti->trans, root);
+        if (wanted & SCRUB_NEEDS_REPAIR)
+        {
+            xaccTransScrubCurrency (ti->trans);
+            xaccTransScrubImbalance (ti->trans, root, NULL);
+        }
+    }
+    t_fix = g_get_monotonic_time ();
+    (percentagefunc)(NULL, -1.0);
+
+    PINFO ("Scrubbed %u of %u transactions%s: snapshot %" G_GINT64_FORMAT
+           " ms, check %" G_GINT64_FORMAT " ms (%u threads), repair %"
+           G_GINT64_FORMAT " ms", n_fixed, total,
+           g_atomic_int_get (&abort_now) ? " (aborted)" : "",
+           (t_snap - t_start) / 1000, (t_check - t_snap) / 1000,
+           n_threads + 1, (t_fix - t_check) / 1000);
+
+    g_array_free (snap.trans, TRUE);
+    g_array_free (snap.splits, TRUE);
+}
+
+/* ================================================================ */
+
 void
 xaccAccountTreeScrubOrphans (Account *acc, QofPercentageFunc percentagefunc)
 {
     if (!acc) return;
 
-    if (abort_now)
+    if (g_atomic_int_get (&abort_now))
         (percentagefunc)(NULL, -1.0);
 
     scrub_depth ++;
-    xaccAccountScrubOrphans (acc, percentagefunc);
-    gnc_account_foreach_descendant(acc,
-                                   (AccountCb)xaccAccountScrubOrphans, percentagefunc);
+    scrub_tree_transactions (acc, percentagefunc, SCRUB_NEEDS_ORPHANS);
     scrub_depth--;
 }
 
@@ -108,7 +380,7 @@ TransScrubOrphansFast (Transaction *trans, Account *root)
     {
         Split *split = node->data;
         Account *orph;
-        if (abort_now) break;
+        if (g_atomic_int_get (&abort_now)) break;
 
         if (split->acc) continue;
 
@@ -152,7 +424,7 @@ xaccAccountScrubOrphans (Account *acc, QofPercentageFunc percentagefunc)
             char *progress_msg = g_strdup_printf (message, str, current_split, total_splits);
             (percentagefunc)(progress_msg, (100 * current_split) / total_splits);
             g_free (progress_msg);
-            if (abort_now) break;
+            if (g_atomic_int_get (&abort_now)) break;
         }
 
         TransScrubOrphansFast (xaccSplitGetParent (split),
@@ -176,7 +448,7 @@ xaccTransScrubOrphans (Transaction *trans)
     for (node = trans->splits; node; node = node->next)
     {
         Split *split = node->data;
-        if (abort_now) break;
+        if (g_atomic_int_get (&abort_now)) break;
 
         if (split->acc)
         {
@@ -215,7 +487,7 @@ xaccAccountScrubSplits (Account *account)
     scrub_depth++;
     for (node = xaccAccountGetSplitList (account); node; node = node->next)
     {
-        if (abort_now) break;
+        if (g_atomic_int_get (&abort_now)) break;
         xaccSplitScrub (node->data);
     }
     scrub_depth--;
@@ -326,13 +598,11 @@ xaccAccountTreeScrubImbalance (Account *acc, QofPercentageFunc percentagefunc)
 {
     if (!acc) return;
 
-    if (abort_now)
+    if (g_atomic_int_get (&abort_now))
         (percentagefunc)(NULL, -1.0);
 
     scrub_depth++;
-    xaccAccountScrubImbalance (acc, percentagefunc);
-    gnc_account_foreach_descendant(acc,
-                                   (AccountCb)xaccAccountScrubImbalance, percentagefunc);
+    scrub_tree_transactions (acc, percentagefunc, SCRUB_NEEDS_REPAIR);
     scrub_depth--;
 }
 
@@ -357,7 +627,7 @@ xaccAccountScrubImbalance (Account *acc, QofPercentageFunc percentagefunc)
     {
         Split *split = node->data;
         Transaction *trans = xaccSplitGetParent(split);
-        if (abort_now) break;
+        if (g_atomic_int_get (&abort_now)) break;
 
         PINFO("Start processing split %d of %d",
               curr_split_no + 1, split_count);
@@ -91,7 +91,9 @@ void xaccTransScrubOrphans (Transaction *trans);
 void xaccAccountScrubOrphans (Account *acc, QofPercentageFunc percentagefunc);
 
 /** The xaccAccountTreeScrubOrphans() method performs this scrub for the
- *    indicated account and its children.
+ *    indicated account and its children.  Each transaction is visited
+ *    once; they are checked on several threads first and only those
+ *    that need it are scrubbed.
  */
 void xaccAccountTreeScrubOrphans (Account *acc, QofPercentageFunc percentagefunc);
 
@@ -120,6 +122,11 @@ void xaccAccountTreeScrubSplits (Account *account);
 void xaccTransScrubImbalance (Transaction *trans, Account *root,
                               Account *parent);
 void xaccAccountScrubImbalance (Account *acc, QofPercentageFunc percentagefunc);
+/** Like xaccAccountTreeScrubOrphans(), the tree version checks every
+ *    transaction in the tree once, on several threads, and then fixes
+ *    orphans, currency and imbalance of those that need it.  It honors
+ *    gnc_set_abort_scrub() and reports progress through percentagefunc.
+ */
 void xaccAccountTreeScrubImbalance (Account *acc, QofPercentageFunc percentagefunc);
 
 /** The xaccTransScrubCurrency method fixes transactions without a
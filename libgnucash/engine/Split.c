@@ -731,7 +731,7 @@ void mark_split (Split *s)
     }
 
     /* set dirty flag on lot too. */
-    if (s->lot) gnc_lot_set_closed_unknown(s->lot);
+    if (s->lot) gnc_lot_split_changed (s->lot, s);
 }
 
 /*
@@ -1022,6 +1022,21 @@ xaccSplitCommitEdit(Split *s)
     }
 }
 
+/* An engine-private helper for xaccTransCommitBulk(). It does what
+ * xaccSplitCommitEdit() does after inserting a split into its new
+ * account, and records the account so that the commit doesn't insert
+ * the split again. */
+void
+xaccSplitAccountInserted(Split *s)
+{
+    g_return_if_fail(s && s->acc);
+
+    if (s->lot && (NULL == gnc_lot_get_account(s->lot)))
+        xaccAccountInsertLot (s->acc, s->lot);
+    xaccSplitSetAmount(s, xaccSplitGetAmount(s));
+    s->orig_acc = s->acc;
+}
+
 /* An engine-private helper for completing xaccTransRollbackEdit(). */
 void
 xaccSplitRollbackEdit(Split *s)
@@ -1205,6 +1220,9 @@ qofSplitSetAmount (Split *split, gnc_numeric amt)
     {
         split->amount = amt;
     }
+    /* Backends set the amount directly; keep the lot's cached balance
+     * honest. */
+    if (split->lot) gnc_lot_split_changed (split->lot, split);
 }
 
 /* The amount of the split in the _account's_ commodity. */
@@ -1542,6 +1560,47 @@ xaccSplitOrder (const Split *sa, const Split *sb)
     return 0;
 }
 
+gboolean
+xaccSplitGetSortKey (const Split *s, gboolean action_for_num,
+                     SplitSortKey *key)
+{
+    Transaction *trans;
+
+    g_return_val_if_fail (s && key, FALSE);
+    memset (key, 0, sizeof (*key));
+    if (action_for_num && !s->action)
+        return FALSE;
+
+    trans = s->parent;
+    if (!trans)
+    {
+        key->no_parent = 1;
+        return TRUE;
+    }
+    key->date_posted = trans->date_posted;
+    key->closing = xaccTransGetIsClosingTxn (trans) ? 1 : 0;
+    key->num = atoi (action_for_num ? s->action : trans->num);
+    key->date_entered = trans->date_entered;
+    return TRUE;
+}
+
+#define CMP_FIELD(a, b, field) \
+    if ((a)->field != (b)->field) \
+        return ((a)->field > (b)->field) - ((a)->field < (b)->field)
+
+gint
+xaccSplitSortKeyCompare (const SplitSortKey *ka, const SplitSortKey *kb)
+{
+    CMP_FIELD (ka, kb, no_parent);
+    CMP_FIELD (ka, kb, date_posted);
+    CMP_FIELD (ka, kb, closing);
+    CMP_FIELD (ka, kb, num);
+    CMP_FIELD (ka, kb, date_entered);
+    return 0;
+}
+
+#undef CMP_FIELD
+
 gint
 xaccSplitOrderDateOnly (const Split *sa, const Split *sb)
 {
@@ -156,8 +156,31 @@ void mark_split (Split *s);
 void xaccSplitVoid(Split *split);
 void xaccSplitUnvoid(Split *split);
 void xaccSplitCommitEdit(Split *s);
+/* The split's account was given it by gnc_account_insert_splits(), so
+ * finish the insertion here rather than in xaccSplitCommitEdit(). */
+void xaccSplitAccountInserted(Split *s);
 void xaccSplitRollbackEdit(Split *s);
 
+/* The leading fields xaccSplitOrder() compares, extracted once so that a
+ * sort of many splits can compare them as integers and only call
+ * xaccSplitOrder() when they're equal. */
+typedef struct
+{
+    gint no_parent;
+    time64 date_posted;
+    gint closing;
+    gint num;
+    time64 date_entered;
+} SplitSortKey;
+
+/* Fill in the sort key of s. Returns FALSE if xaccSplitOrder() has to
+ * look at both splits to compare s, i.e. if action_for_num is set and s
+ * has no action string. */
+gboolean xaccSplitGetSortKey(const Split *s, gboolean action_for_num,
+                             SplitSortKey *key);
+/* Compare two sort keys the way xaccSplitOrder() compares their splits. */
+gint xaccSplitSortKeyCompare(const SplitSortKey *ka, const SplitSortKey *kb);
+
 /* Compute the value of a list of splits in the given currency,
  * excluding the skip_me split. */
 gnc_numeric xaccSplitsComputeValue (GList *splits, const Split * skip_me,
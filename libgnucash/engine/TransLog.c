@@ -29,16 +29,24 @@
 #include <glib.h>
 #include <glib/gstdio.h>
 #include <string.h>
+#ifdef G_OS_WIN32
+# include <io.h>
+#else
+# include <unistd.h>
+#endif
 
 #include "Account.h"
 #include "Transaction.h"
 #include "TransactionP.h"
 #include "TransLog.h"
+#include "gnc-prefs.h"
 #include "qof.h"
 #ifdef _MSC_VER
 # define g_fopen fopen
 #endif
 
+#define GNC_PREF_BINARY_TRANSLOG "binary-transaction-log"
+
 static QofLogModule log_module = "gnc.translog";
 
 /*
@@ -80,6 +88,14 @@ static QofLogModule log_module = "gnc.translog";
  *     occurred at a certain time, it can be located.
  * (-) hack alert -- something better than just the account name
  *     is needed for identifying the account.
+ *
+ * Formatting every split on each edit is too slow to leave the log on
+ * for bulk imports, so there is also a binary journal. It records the
+ * same fields, but the UI thread only packs them into a buffer. A
+ * background thread writes the buffers and syncs the file once for
+ * each batch it finds waiting. The format is described at
+ * journal_pack_trans() and must match
+ * gnucash/import-export/log-replay/gnc-log-replay.c.
  */
 /* ------------------------------------------------------------------ */
 
@@ -88,6 +104,20 @@ static int gen_logs = 1;
 static FILE * trans_log = NULL; /**< current log file handle */
 static char * trans_log_name = NULL; /**< current log file name */
 static char * log_base_name = NULL;
+static int log_binary = -1; /**< -1 until set, then use the preference */
+
+typedef struct
+{
+    GAsyncQueue *queue;      /**< packed records for the writer thread */
+    GThread     *thread;
+    GMutex       lock;
+    GCond        synced;
+    guint64      queued;     /**< records queued, only used by the UI thread */
+    guint64      written;    /**< records written and synced, under lock */
+} TransJournal;
+
+static TransJournal *journal = NULL; /**< set when the log is binary */
+static char journal_stop;            /**< queued to stop the writer */
 
 /********************************************************************\
 \********************************************************************/
@@ -152,6 +182,115 @@ xaccFileIsCurrentLog (const gchar *name)
     return result;
 }
 
+void
+xaccLogSetBinary (gboolean binary)
+{
+    log_binary = binary ? 1 : 0;
+
+    if (trans_log && (journal != NULL) != binary)
+    {
+        xaccCloseLog();
+        xaccOpenLog();
+    }
+}
+
+/********************************************************************\
+\********************************************************************/
+
+static void
+journal_sync (FILE *file)
+{
+    fflush (file);
+#ifdef G_OS_WIN32
+    _commit (fileno (file));
+#else
+    fsync (fileno (file));
+#endif
+}
+
+static gpointer
+journal_write_thread (gpointer data)
+{
+    gboolean stop = FALSE;
+
+    while (!stop)
+    {
+        gpointer msg = g_async_queue_pop (journal->queue);
+        guint64 count = 0;
+
+        /* Write whatever else is waiting too and sync once for the lot. */
+        for (; msg && !stop; msg = g_async_queue_try_pop (journal->queue))
+        {
+            GByteArray *record = msg;
+
+            if (msg == &journal_stop)
+            {
+                stop = TRUE;
+                break;
+            }
+            if (fwrite (record->data, 1, record->len, trans_log) != record->len)
+                PERR ("Error writing the transaction journal: %s",
+                      g_strerror (errno));
+            g_byte_array_unref (record);
+            ++count;
+        }
+        journal_sync (trans_log);
+
+        g_mutex_lock (&journal->lock);
+        journal->written += count;
+        g_cond_broadcast (&journal->synced);
+        g_mutex_unlock (&journal->lock);
+    }
+    return NULL;
+}
+
+static void
+journal_start (void)
+{
+    /* Note: this must match gnucash/import-export/log-replay/gnc-log-replay.c */
+    fseek (trans_log, 0, SEEK_END);
+    if (ftell (trans_log) == 0)
+    {
+        fwrite (TRANS_LOG_BINARY_MAGIC, 1, strlen (TRANS_LOG_BINARY_MAGIC),
+                trans_log);
+        fflush (trans_log);
+    }
+
+    journal = g_new0 (TransJournal, 1);
+    g_mutex_init (&journal->lock);
+    g_cond_init (&journal->synced);
+    journal->queue = g_async_queue_new ();
+    journal->thread = g_thread_new ("translog", journal_write_thread, NULL);
+}
+
+static void
+journal_stop_writer (void)
+{
+    g_async_queue_push (journal->queue, &journal_stop);
+    g_thread_join (journal->thread);
+    g_async_queue_unref (journal->queue);
+    g_mutex_clear (&journal->lock);
+    g_cond_clear (&journal->synced);
+    g_free (journal);
+    journal = NULL;
+}
+
+void
+xaccLogFlush (void)
+{
+    if (journal)
+    {
+        g_mutex_lock (&journal->lock);
+        while (journal->written < journal->queued)
+            g_cond_wait (&journal->synced, &journal->lock);
+        g_mutex_unlock (&journal->lock);
+    }
+    else if (trans_log)
+    {
+        fflush (trans_log);
+    }
+}
+
 /********************************************************************\
 \********************************************************************/
 
@@ -175,7 +314,11 @@ xaccOpenLog (void)
 
     filename = g_strconcat (log_base_name, ".", timestamp, ".log", NULL);
 
-    trans_log = g_fopen (filename, "a");
+    if (log_binary < 0)
+        log_binary = gnc_prefs_get_bool (GNC_PREFS_GROUP_GENERAL,
+                                         GNC_PREF_BINARY_TRANSLOG);
+
+    trans_log = g_fopen (filename, log_binary ? "ab" : "a");
     if (!trans_log)
     {
         int norr = errno;
@@ -195,6 +338,12 @@ xaccOpenLog (void)
     g_free (filename);
     g_free (timestamp);
 
+    if (log_binary)
+    {
+        journal_start ();
+        return;
+    }
+
     /*  Note: this must match src/import-export/log-replay/gnc-log-replay.c */
     fprintf (trans_log, "mod\ttrans_guid\tsplit_guid\ttime_now\t"
              "date_entered\tdate_posted\t"
@@ -211,6 +360,8 @@ void
 xaccCloseLog (void)
 {
     if (!trans_log) return;
+    if (journal)
+        journal_stop_writer ();
     fflush (trans_log);
     fclose (trans_log);
     trans_log = NULL;
@@ -219,6 +370,110 @@ xaccCloseLog (void)
 /********************************************************************\
 \********************************************************************/
 
+static void
+journal_put_u32 (GByteArray *record, guint32 val)
+{
+    val = GUINT32_TO_LE (val);
+    g_byte_array_append (record, (const guint8*)&val, sizeof (val));
+}
+
+static void
+journal_put_i64 (GByteArray *record, gint64 val)
+{
+    guint64 le = GUINT64_TO_LE ((guint64)val);
+    g_byte_array_append (record, (const guint8*)&le, sizeof (le));
+}
+
+static void
+journal_put_guid (GByteArray *record, const GncGUID *guid)
+{
+    if (!guid)
+        guid = guid_null ();
+    g_byte_array_append (record, guid->reserved, GUID_DATA_SIZE);
+}
+
+static void
+journal_put_string (GByteArray *record, const char *str)
+{
+    guint32 len = str ? strlen (str) : 0;
+    journal_put_u32 (record, len);
+    g_byte_array_append (record, (const guint8*)str, len);
+}
+
+/* FNV-1a, to spot a record torn by a crash. */
+static guint32
+journal_checksum (const guint8 *data, guint len)
+{
+    guint32 hash = 2166136261u;
+    for (guint i = 0; i < len; ++i)
+        hash = (hash ^ data[i]) * 16777619u;
+    return hash;
+}
+
+/* A binary journal starts with TRANS_LOG_BINARY_MAGIC followed by one
+ * record for each transaction logged. All integers are little-endian
+ * and strings are a guint32 length followed by that many bytes of UTF-8.
+ *
+ * guint32 length of the rest of the record, excluding the checksum
+ * guint8  flag, as for the text log
+ * gint64  time_now, date_entered, date_posted
+ * guid    trans_guid (16 bytes)
+ * string  num, description, notes
+ * guint32 the number of splits, then for each split:
+ *     guid    split_guid, acc_guid (all zeroes if there is no account)
+ *     string  acc_name, memo, action
+ *     guint8  reconciled
+ *     gint64  amount num and denom, value num and denom, date_reconciled
+ * guint32 FNV-1a checksum of the bytes after the length
+ */
+static GByteArray *
+journal_pack_trans (Transaction *trans, char flag)
+{
+    GByteArray *record = g_byte_array_sized_new (256);
+    guint8 byte = flag;
+    GList *node;
+
+    journal_put_u32 (record, 0);
+    g_byte_array_append (record, &byte, 1);
+    journal_put_i64 (record, gnc_time (NULL));
+    journal_put_i64 (record, trans->date_entered);
+    journal_put_i64 (record, trans->date_posted);
+    journal_put_guid (record, xaccTransGetGUID (trans));
+    journal_put_string (record, trans->num);
+    journal_put_string (record, trans->description);
+    journal_put_string (record, xaccTransGetNotes (trans));
+    journal_put_u32 (record, g_list_length (trans->splits));
+
+    for (node = trans->splits; node; node = node->next)
+    {
+        Split *split = node->data;
+        Account *acc = xaccSplitGetAccount (split);
+        gnc_numeric amt = xaccSplitGetAmount (split);
+        gnc_numeric val = xaccSplitGetValue (split);
+
+        journal_put_guid (record, xaccSplitGetGUID (split));
+        journal_put_guid (record, acc ? xaccAccountGetGUID (acc) : NULL);
+        journal_put_string (record, acc ? xaccAccountGetName (acc) : NULL);
+        journal_put_string (record, split->memo);
+        journal_put_string (record, split->action);
+        byte = split->reconciled;
+        g_byte_array_append (record, &byte, 1);
+        journal_put_i64 (record, gnc_numeric_num (amt));
+        journal_put_i64 (record, gnc_numeric_denom (amt));
+        journal_put_i64 (record, gnc_numeric_num (val));
+        journal_put_i64 (record, gnc_numeric_denom (val));
+        journal_put_i64 (record, split->date_reconciled);
+    }
+
+    {
+        guint32 len = GUINT32_TO_LE (record->len - sizeof (guint32));
+        memcpy (record->data, &len, sizeof (len));
+    }
+    journal_put_u32 (record, journal_checksum (record->data + sizeof (guint32),
+                                               record->len - sizeof (guint32)));
+    return record;
+}
+
 void
 xaccTransWriteLog (Transaction *trans, char flag)
 {
@@ -235,6 +490,13 @@ xaccTransWriteLog (Transaction *trans, char flag)
     }
     if (!trans_log) return;
 
+    if (journal)
+    {
+        g_async_queue_push (journal->queue, journal_pack_trans (trans, flag));
+        ++journal->queued;
+        return;
+    }
+
     gnc_time64_to_iso8601_buff (gnc_time(NULL), dnow);
     gnc_time64_to_iso8601_buff (trans->date_entered, dent);
     gnc_time64_to_iso8601_buff (trans->date_posted, dpost);
@@ -300,5 +562,173 @@ xaccTransWriteLog (Transaction *trans, char flag)
     fflush (trans_log);
 }
 
+/********************************************************************\
+\********************************************************************/
+
+/* Reading the journal back, see journal_pack_trans() for the format. */
+#define JOURNAL_MAX_RECORD (64 * 1024 * 1024)
+
+typedef struct
+{
+    const guint8 *pos;
+    const guint8 *end;
+    GStringChunk *strings;   /**< holds the strings of the record */
+} JournalReader;
+
+static gboolean
+journal_get (JournalReader *reader, void *buf, gsize len)
+{
+    if ((gsize)(reader->end - reader->pos) < len)
+        return FALSE;
+    memcpy (buf, reader->pos, len);
+    reader->pos += len;
+    return TRUE;
+}
+
+static gboolean
+journal_get_u32 (JournalReader *reader, guint32 *val)
+{
+    if (!journal_get (reader, val, sizeof (*val)))
+        return FALSE;
+    *val = GUINT32_FROM_LE (*val);
+    return TRUE;
+}
+
+static gboolean
+journal_get_i64 (JournalReader *reader, gint64 *val)
+{
+    guint64 le;
+    if (!journal_get (reader, &le, sizeof (le)))
+        return FALSE;
+    *val = (gint64)GUINT64_FROM_LE (le);
+    return TRUE;
+}
+
+static gboolean
+journal_get_numeric (JournalReader *reader, gnc_numeric *val)
+{
+    gint64 num, denom;
+    if (!journal_get_i64 (reader, &num) || !journal_get_i64 (reader, &denom))
+        return FALSE;
+    *val = gnc_numeric_create (num, denom);
+    return TRUE;
+}
+
+static gboolean
+journal_get_string (JournalReader *reader, const char **str)
+{
+    guint32 len;
+    if (!journal_get_u32 (reader, &len) ||
+        (gsize)(reader->end - reader->pos) < len)
+        return FALSE;
+    *str = g_string_chunk_insert_len (reader->strings,
+                                      (const gchar*)reader->pos, len);
+    reader->pos += len;
+    return TRUE;
+}
+
+/* Decodes the record without its length and checksum, the splits go
+ * into the splits array. */
+static gboolean
+journal_unpack_trans (JournalReader *reader, TransLogRecord *record,
+                      GArray *splits)
+{
+    guint8 byte;
+    guint32 n_splits, i;
+
+    if (!journal_get (reader, &byte, 1) ||
+        !journal_get_i64 (reader, &record->log_date) ||
+        !journal_get_i64 (reader, &record->date_entered) ||
+        !journal_get_i64 (reader, &record->date_posted) ||
+        !journal_get (reader, record->trans_guid.reserved, GUID_DATA_SIZE) ||
+        !journal_get_string (reader, &record->num) ||
+        !journal_get_string (reader, &record->description) ||
+        !journal_get_string (reader, &record->notes) ||
+        !journal_get_u32 (reader, &n_splits))
+        return FALSE;
+    record->flag = byte;
+
+    /* Don't trust a count that the record can't hold. */
+    if (n_splits > (gsize)(reader->end - reader->pos))
+        return FALSE;
+    g_array_set_size (splits, n_splits);
+    for (i = 0; i < n_splits; i++)
+    {
+        TransLogSplit *split = &g_array_index (splits, TransLogSplit, i);
+
+        if (!journal_get (reader, split->split_guid.reserved, GUID_DATA_SIZE) ||
+            !journal_get (reader, split->acc_guid.reserved, GUID_DATA_SIZE) ||
+            !journal_get_string (reader, &split->acc_name) ||
+            !journal_get_string (reader, &split->memo) ||
+            !journal_get_string (reader, &split->action) ||
+            !journal_get (reader, &byte, 1) ||
+            !journal_get_numeric (reader, &split->amount) ||
+            !journal_get_numeric (reader, &split->value) ||
+            !journal_get_i64 (reader, &split->date_reconciled))
+            return FALSE;
+        split->reconciled = byte;
+    }
+    record->n_splits = n_splits;
+    record->splits = (const TransLogSplit*)splits->data;
+    return reader->pos == reader->end;
+}
+
+TransLogJournalStatus
+xaccLogReadJournal (FILE *file, TransLogRecordCB cb, gpointer data)
+{
+    TransLogJournalStatus status = TRANS_LOG_JOURNAL_OK;
+    GByteArray *buf;
+    GArray *splits;
+    GStringChunk *strings;
+
+    g_return_val_if_fail (file && cb, TRANS_LOG_JOURNAL_CORRUPT);
+
+    buf = g_byte_array_new ();
+    splits = g_array_new (FALSE, TRUE, sizeof (TransLogSplit));
+    strings = g_string_chunk_new (256);
+    while (TRUE)
+    {
+        JournalReader reader = { NULL, NULL, strings };
+        TransLogRecord record;
+        guint32 len, sum;
+        gsize got = fread (&len, 1, sizeof (len), file);
+
+        if (got == 0)
+            break;
+        if (got != sizeof (len))
+        {
+            status = TRANS_LOG_JOURNAL_TRUNCATED;
+            break;
+        }
+        len = GUINT32_FROM_LE (len);
+        if (len > JOURNAL_MAX_RECORD)
+        {
+            status = TRANS_LOG_JOURNAL_CORRUPT;
+            break;
+        }
+        g_byte_array_set_size (buf, len);
+        if (fread (buf->data, 1, len, file) != len ||
+            fread (&sum, sizeof (sum), 1, file) != 1)
+        {
+            status = TRANS_LOG_JOURNAL_TRUNCATED;
+            break;
+        }
+        reader.pos = buf->data;
+        reader.end = buf->data + len;
+        if (GUINT32_FROM_LE (sum) != journal_checksum (buf->data, len) ||
+            !journal_unpack_trans (&reader, &record, splits))
+        {
+            status = TRANS_LOG_JOURNAL_CORRUPT;
+            break;
+        }
+        cb (&record, data);
+        g_string_chunk_clear (strings);
+    }
+    g_string_chunk_free (strings);
+    g_array_free (splits, TRUE);
+    g_byte_array_unref (buf);
+    return status;
+}
+
 /************************ END OF ************************************\
 \************************* FILE *************************************/
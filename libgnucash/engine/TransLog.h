@@ -43,13 +43,23 @@
 #ifndef XACC_TRANS_LOG_H
 #define XACC_TRANS_LOG_H
 
+#include <stdio.h>
 #include "Account.h"
 #include "Transaction.h"
 
+/** The bytes a binary transaction journal starts with. */
+#define TRANS_LOG_BINARY_MAGIC "GNCJRNL1"
+
 void    xaccOpenLog (void);
 void    xaccCloseLog (void);
 void    xaccReopenLog (void);
 
+/** Wait until everything logged so far is written to disk. Only the
+ *  binary journal needs this, as the text log is flushed after each
+ *  transaction; it's also done by xaccCloseLog().
+ */
+void    xaccLogFlush (void);
+
 /**
  * @param trans The transaction to write out to the log
  * @param flag The engine currently uses the log mechanism with flag char set as
@@ -65,6 +75,55 @@ void    xaccReopenLog (void);
  */
 void    xaccTransWriteLog (Transaction *trans, char flag);
 
+/** One split of a transaction read back from a binary journal. */
+typedef struct
+{
+    GncGUID split_guid;
+    GncGUID acc_guid;         /**< all zeroes if the split had no account */
+    const char *acc_name;
+    const char *memo;
+    const char *action;
+    char reconciled;
+    gnc_numeric amount;
+    gnc_numeric value;
+    time64 date_reconciled;
+} TransLogSplit;
+
+/** A transaction read back from a binary journal, as written by
+ *  xaccTransWriteLog(). The strings and splits are only valid until the
+ *  callback it was passed to returns. */
+typedef struct
+{
+    char flag;                /**< as passed to xaccTransWriteLog() */
+    time64 log_date;
+    time64 date_entered;
+    time64 date_posted;
+    GncGUID trans_guid;
+    const char *num;
+    const char *description;
+    const char *notes;
+    guint n_splits;
+    const TransLogSplit *splits;
+} TransLogRecord;
+
+typedef enum
+{
+    TRANS_LOG_JOURNAL_OK,        /**< all records were read */
+    TRANS_LOG_JOURNAL_TRUNCATED, /**< it ends with an incomplete record */
+    TRANS_LOG_JOURNAL_CORRUPT,   /**< a record is damaged */
+} TransLogJournalStatus;
+
+typedef void (*TransLogRecordCB) (const TransLogRecord *record, gpointer data);
+
+/** The xaccLogReadJournal() method reads a binary journal, calling cb
+ *    for each record in it. The file position must be just after
+ *    TRANS_LOG_BINARY_MAGIC. Reading stops at the first incomplete or
+ *    damaged record, e.g. the tail of a journal cut short by a crash;
+ *    the records before it have been passed to cb.
+ */
+TransLogJournalStatus xaccLogReadJournal (FILE *file, TransLogRecordCB cb,
+                                          gpointer data);
+
 /** document me */
 void    xaccLogEnable (void);
 
@@ -78,6 +137,15 @@ void    xaccLogDisable (void);
  */
 void    xaccLogSetBaseName (const char *);
 
+/** The xaccLogSetBinary() method chooses between the text log and a
+ *    binary journal, which is written by a background thread and is
+ *    much cheaper to keep on for bulk imports. Until it's called the
+ *    general binary-transaction-log preference is used. If the log is
+ *    already open in the other format it is closed and a new one is
+ *    opened.
+ */
+void    xaccLogSetBinary (gboolean binary);
+
 /** Test a filename to see if it is the name of the current logfile */
 gboolean xaccFileIsCurrentLog (const gchar *name);
 
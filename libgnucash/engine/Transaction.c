@@ -1703,6 +1703,160 @@ xaccTransCommitEdit (Transaction *trans)
     LEAVE ("(trans=%p)", trans);
 }
 
+/* A transaction that xaccTransScrubImbalance() would leave alone:
+ * every split has an account with a commodity and valid numbers, splits
+ * in the transaction's currency have matching amounts and values, and
+ * it's balanced. */
+static gboolean
+trans_needs_no_scrub (const Transaction *trans)
+{
+    gnc_commodity *currency = trans->common_currency;
+    gnc_numeric imbal = gnc_numeric_zero();
+    GList *node;
+
+    if (!currency)
+        return FALSE;
+
+    for (node = trans->splits; node; node = node->next)
+    {
+        Split *s = node->data;
+        gnc_commodity *comm;
+
+        if (!xaccTransStillHasSplit(trans, s))
+            continue;
+        if (!s->acc || gnc_numeric_check(s->value) ||
+            gnc_numeric_check(s->amount))
+            return FALSE;
+        comm = xaccAccountGetCommodity(s->acc);
+        if (!comm)
+            return FALSE;
+        if (gnc_commodity_equiv(comm, currency))
+        {
+            int scu = MIN (xaccAccountGetCommoditySCU (s->acc),
+                           gnc_commodity_get_fraction (currency));
+            if (!gnc_numeric_same (s->amount, s->value, scu,
+                                   GNC_HOW_RND_ROUND_HALF_UP))
+                return FALSE;
+        }
+        imbal = gnc_numeric_add(imbal, s->value,
+                                GNC_DENOM_AUTO, GNC_HOW_DENOM_EXACT);
+    }
+
+    if (xaccTransUseTradingAccounts(trans))
+        return xaccTransIsBalanced(trans);
+    return gnc_numeric_zero_p(imbal);
+}
+
+static void
+bulk_open_account (GHashTable *accounts, Account *acc)
+{
+    if (acc && !g_hash_table_contains (accounts, acc))
+    {
+        xaccAccountBeginEdit (acc);
+        g_hash_table_insert (accounts, acc, NULL);
+    }
+}
+
+TransList *
+xaccTransCommitBulk (TransList *transactions, TransBulkMode mode)
+{
+    GHashTable *accounts = g_hash_table_new (g_direct_hash, g_direct_equal);
+    GHashTable *no_scrub = g_hash_table_new (g_direct_hash, g_direct_equal);
+    GList *commit = NULL, *skipped = NULL, *node, *snode;
+    GHashTableIter iter;
+    gpointer key, value;
+    gboolean scrub_lots = g_getenv("GNC_AUTO_SCRUB_LOTS") != NULL;
+    int saved_scrub_data = scrub_data;
+
+    ENTER ("(%u transactions)", g_list_length (transactions));
+    qof_event_begin_batch ();
+
+    /* Check them all first, then give each account its new splits. */
+    for (node = transactions; node; node = node->next)
+    {
+        Transaction *trans = node->data;
+        gboolean simple;
+
+        if (!GNC_IS_TRANSACTION (trans) || !xaccTransIsOpen (trans))
+        {
+            PWARN ("Skipping a transaction that isn't open for editing");
+            continue;
+        }
+
+        simple = !scrub_lots && qof_instance_get_editlevel (trans) == 1 &&
+                 !qof_instance_get_destroying (trans) &&
+                 !qof_book_shutting_down (xaccTransGetBook (trans)) &&
+                 trans_needs_no_scrub (trans);
+        if (!simple && mode == TRANS_BULK_SKIP_UNBALANCED &&
+            !xaccTransIsBalanced (trans))
+        {
+            skipped = g_list_prepend (skipped, trans);
+            continue;
+        }
+        commit = g_list_prepend (commit, trans);
+
+        for (snode = trans->splits; snode; snode = snode->next)
+        {
+            Split *s = snode->data;
+
+            if (!xaccTransStillHasSplit (trans, s))
+                continue;
+            bulk_open_account (accounts, s->acc);
+            if (simple && s->acc && !s->orig_acc &&
+                qof_instance_is_dirty (QOF_INSTANCE (s)))
+            {
+                GList *splits = g_hash_table_lookup (accounts, s->acc);
+                g_hash_table_insert (accounts, s->acc,
+                                     g_list_prepend (splits, s));
+            }
+        }
+        if (simple)
+            g_hash_table_add (no_scrub, trans);
+    }
+
+    g_hash_table_iter_init (&iter, accounts);
+    while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+        GList *splits = g_list_reverse (value);
+
+        if (!splits)
+            continue;
+        gnc_account_insert_splits (key, splits);
+        for (snode = splits; snode; snode = snode->next)
+            xaccSplitAccountInserted (snode->data);
+        g_list_free (splits);
+        g_hash_table_iter_replace (&iter, NULL);
+    }
+
+    commit = g_list_reverse (commit);
+    for (node = commit; node; node = node->next)
+    {
+        Transaction *trans = node->data;
+
+        if (g_hash_table_contains (no_scrub, trans))
+        {
+            scrub_data = 0;
+            xaccTransCommitEdit (trans);
+            scrub_data = saved_scrub_data;
+        }
+        else
+            xaccTransCommitEdit (trans);
+    }
+
+    g_hash_table_iter_init (&iter, accounts);
+    while (g_hash_table_iter_next (&iter, &key, NULL))
+        xaccAccountCommitEdit (key);
+
+    qof_event_end_batch ();
+    LEAVE ("committed %u, skipped %u", g_list_length (commit),
+           g_list_length (skipped));
+
+    g_list_free (commit);
+    g_hash_table_destroy (no_scrub);
+    g_hash_table_destroy (accounts);
+    return g_list_reverse (skipped);
+}
+
 #define SWAP(a, b) do { gpointer tmp = (a); (a) = (b); (b) = tmp; } while (0);
 
 /* Ughhh. The Rollback function is terribly complex, and, what's worse,
@@ -1776,7 +1930,10 @@ xaccTransRollbackEdit (Transaction *trans)
             s->reconciled = so->reconciled;
             s->amount = so->amount;
             s->value = so->value;
+            /* The lot caches its balance and running totals by date. */
+            if (s->lot) gnc_lot_split_changed (s->lot, s);
             s->lot = so->lot;
+            if (s->lot) gnc_lot_split_changed (s->lot, s);
             s->gains_split = so->gains_split;
             //SET_GAINS_A_VDIRTY(s);
             s->date_reconciled = so->date_reconciled;
@@ -1803,6 +1960,9 @@ xaccTransRollbackEdit (Transaction *trans)
                more than one transaction during the begin/commit block! */
             if (NULL == xaccSplitGetParent(s))
             {
+                /* xaccTransCommitBulk may have given it to its account. */
+                if (s->acc)
+                    gnc_account_remove_split(s->acc, s);
                 xaccFreeSplit(s);  // a newly malloc'd split
             }
         }
@@ -2951,6 +3111,23 @@ destroy_tx_on_book_close(QofInstance *ent, gpointer data)
     xaccTransDestroy(tx);
 }
 
+/* When the whole book is going away there's no point in unlinking each
+ * split from its account and lot, recomputing balances and announcing
+ * every destruction: the accounts drop their split lists without looking
+ * at them and the book's own destroy event has told the listeners. So
+ * transactions that aren't being edited are simply freed together with
+ * their splits. */
+static void
+free_tx_on_book_close(QofInstance *ent, gpointer data)
+{
+    Transaction* tx = GNC_TRANSACTION(ent);
+
+    if (qof_instance_get_editlevel(tx) > 0)
+        xaccTransDestroy(tx);
+    else
+        xaccFreeTransaction(tx);
+}
+
 /** Handles book end - frees all transactions from the book
  *
  * @param book Book being closed
@@ -2961,7 +3138,11 @@ gnc_transaction_book_end(QofBook* book)
     QofCollection *col;
 
     col = qof_book_get_collection(book, GNC_ID_TRANS);
-    qof_collection_foreach(col, destroy_tx_on_book_close, NULL);
+    /* A backend would have to be told about each transaction. */
+    if (qof_book_get_backend(book))
+        qof_collection_foreach(col, destroy_tx_on_book_close, NULL);
+    else
+        qof_collection_foreach(col, free_tx_on_book_close, NULL);
 }
 
 #ifdef _MSC_VER
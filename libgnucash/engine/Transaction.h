@@ -208,6 +208,34 @@ void          xaccTransBeginEdit (Transaction *trans);
     of xaccTransDestroy() was called on the transaction. */
 void          xaccTransCommitEdit (Transaction *trans);
 
+/** What xaccTransCommitBulk() does with a transaction that isn't
+ *  balanced. */
+typedef enum
+{
+    TRANS_BULK_SCRUB,            // balance it as xaccTransCommitEdit() does
+    TRANS_BULK_SKIP_UNBALANCED,  // leave it open and return it
+} TransBulkMode;
+
+/** The xaccTransCommitBulk() method commits many transactions at once,
+ *  with the same result as calling xaccTransCommitEdit() on each of
+ *  them. It is meant for importers and scripts that create transactions
+ *  in bulk, and each transaction must have been opened with
+ *  xaccTransBeginEdit().
+ *
+ *  All the transactions are checked before any is committed. Those that
+ *  are balanced and need no other repairs are committed without the
+ *  commit-time scrubbing. Their new splits are added to each account in
+ *  one batch. The accounts are held open until the end, so that each is
+ *  sorted and has its balances recomputed only once. The events are
+ *  delivered as a single batch.
+ *
+ *  @param transactions The open transactions to commit.
+ *  @param mode What to do with unbalanced transactions.
+ *  @return The transactions that were left open, which the caller must
+ *  commit, roll back or destroy. Free the list with g_list_free().
+ */
+TransList *   xaccTransCommitBulk (TransList *transactions, TransBulkMode mode);
+
 /** The xaccTransRollbackEdit() routine rejects all edits made, and
     sets the transaction back to where it was before the editing
     started.  This includes restoring any deleted splits, removing
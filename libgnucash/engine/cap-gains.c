@@ -102,89 +102,11 @@ xaccAccountHasTrades (const Account *acc)
 
 /* ============================================================== */
 
-struct find_lot_s
-{
-    GNCLot *lot;
-    gnc_commodity *currency;
-    time64 time;
-    int (*numeric_pred)(gnc_numeric);
-    gboolean (*date_pred)(time64 e, time64 tr);
-};
-
-static gboolean
-earliest_pred (time64 earl, time64 tran)
-{
-    return earl > tran;
-}
-
-static gboolean
-latest_pred (time64 earl, time64 tran)
-{
-    return earl < tran;
-}
-
-static gpointer
-finder_helper (GNCLot *lot,  gpointer user_data)
-{
-    struct find_lot_s *els = user_data;
-    Split *s;
-    Transaction *trans;
-    gnc_numeric bal;
-    gboolean opening_is_positive, bal_is_positive;
-    time64 posted = 0;
-
-    if (gnc_lot_is_closed (lot)) return NULL;
-
-    s = gnc_lot_get_earliest_split (lot);
-    if (s == NULL) return NULL;
-
-    /* We want a lot whose balance is of the correct sign.  All splits
-       in a lot must be the opposite sign of the opening split.  We also
-       want to ignore lots that are overfull, i.e., where the balance in
-       the lot is of opposite sign to the opening split in the lot. */
-    if (0 == (els->numeric_pred) (s->amount)) return NULL;
-    bal = gnc_lot_get_balance (lot);
-    opening_is_positive = gnc_numeric_positive_p (s->amount);
-    bal_is_positive = gnc_numeric_positive_p (bal);
-    if (opening_is_positive != bal_is_positive) return NULL;
-
-    trans = s->parent;
-    if (els->currency &&
-            (FALSE == gnc_commodity_equiv (els->currency,
-                                           trans->common_currency)))
-    {
-        return NULL;
-    }
-
-    posted = trans->date_posted;
-    if (els->date_pred (els->time, posted))
-    {
-        els->time = trans->date_posted;
-        els->lot = lot;
-    }
-
-    return NULL;
-}
-
-static inline GNCLot *
-xaccAccountFindOpenLot (Account *acc, gnc_numeric sign,
-                        gnc_commodity *currency,
-                        gint64 guess,
-                        gboolean (*date_pred)(time64, time64))
-{
-    struct find_lot_s es;
-
-    es.lot = NULL;
-    es.currency = currency;
-    es.time = guess;
-    es.date_pred = date_pred;
-
-    if (gnc_numeric_positive_p(sign)) es.numeric_pred = gnc_numeric_negative_p;
-    else es.numeric_pred = gnc_numeric_positive_p;
-
-    xaccAccountForEachLot (acc, finder_helper, &es);
-    return es.lot;
-}
+/* The open lots of an account are kept ordered by the date of their
+ * opening split (see xaccAccountFindOpenLotByDate in Account.cpp), so
+ * the lookups below don't have to visit every lot in the account.  We
+ * want a lot whose opening split is of the opposite sign of the split
+ * being assigned. */
 
 GNCLot *
 xaccAccountFindEarliestOpenLot (Account *acc, gnc_numeric sign,
@@ -194,8 +116,8 @@ xaccAccountFindEarliestOpenLot (Account *acc, gnc_numeric sign,
     ENTER (" sign=%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT, sign.num,
            sign.denom);
 
-    lot = xaccAccountFindOpenLot (acc, sign, currency,
-                                  G_MAXINT64, earliest_pred);
+    lot = xaccAccountFindOpenLotByDate (acc, !gnc_numeric_positive_p (sign),
+                                        currency, FALSE);
     LEAVE ("found lot=%p %s baln=%s", lot, gnc_lot_get_title (lot),
            gnc_num_dbg_to_string(gnc_lot_get_balance(lot)));
     return lot;
@@ -209,8 +131,8 @@ xaccAccountFindLatestOpenLot (Account *acc, gnc_numeric sign,
     ENTER (" sign=%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT,
            sign.num, sign.denom);
 
-    lot = xaccAccountFindOpenLot (acc, sign, currency,
-                                  G_MININT64, latest_pred);
+    lot = xaccAccountFindOpenLotByDate (acc, !gnc_numeric_positive_p (sign),
+                                        currency, TRUE);
     LEAVE ("found lot=%p %s", lot, gnc_lot_get_title (lot));
     return lot;
 }
@@ -118,7 +118,7 @@ gnc_localtime_r (const time64 *secs, struct tm* time)
 {
     try
     {
-        *time = static_cast<struct tm>(GncDateTime(*secs));
+        *time = GncDateTime::local_tm(*secs);
         return time;
     }
     catch(std::invalid_argument&)
@@ -232,9 +232,7 @@ gnc_mktime (struct tm* time)
     try
     {
         normalize_struct_tm (time);
-        GncDateTime gncdt(*time);
-        *time = static_cast<struct tm>(gncdt);
-        return static_cast<time64>(gncdt);
+        return GncDateTime::local_tm_to_time64(*time);
     }
     catch(std::invalid_argument&)
     {
@@ -1120,8 +1118,7 @@ gnc_iso8601_to_time64_gmt(const char *cstr)
     if (!cstr) return INT64_MAX;
     try
     {
-        GncDateTime gncdt(cstr);
-        return static_cast<time64>(gncdt);
+        return GncDateTime::time64_from_string(cstr);
     }
     catch(std::logic_error& err)
     {
@@ -1141,17 +1138,10 @@ gnc_iso8601_to_time64_gmt(const char *cstr)
 char *
 gnc_time64_to_iso8601_buff (time64 time, char * buff)
 {
-    constexpr size_t max_iso_date_length = 32;
-
     if (! buff) return NULL;
     try
     {
-        GncDateTime gncdt(time);
-        auto sstr = gncdt.format_iso8601();
-
-        memset(buff, 0, sstr.length() + 1);
-        strncpy(buff, sstr.c_str(), sstr.length());
-        return buff + sstr.length();
+        return GncDateTime::format_iso8601(time, buff);
     }
     catch(std::logic_error& err)
     {
@@ -33,6 +33,9 @@ extern "C"
 #include <boost/locale.hpp>
 #include <boost/regex.hpp>
 #include <libintl.h>
+#include <array>
+#include <atomic>
+#include <cstring>
 #include <locale.h>
 #include <map>
 #include <memory>
@@ -63,6 +66,8 @@ using time64 = int64_t;
 
 static const TimeZoneProvider ltzp;
 static const TimeZoneProvider* tzp = &ltzp;
+/* Changed with tzp so that cached timezone data can be invalidated. */
+static std::atomic<unsigned> tzp_generation{0};
 
 // For converting to/from POSIX time.
 static const PTime unix_epoch (Date(1970, boost::gregorian::Jan, 1),
@@ -217,12 +222,14 @@ void
 _set_tzp(TimeZoneProvider& new_tzp)
 {
     tzp = &new_tzp;
+    ++tzp_generation;
 }
 
 void
 _reset_tzp()
 {
     tzp = &ltzp;
+    ++tzp_generation;
 }
 
 class GncDateTimeImpl
@@ -686,6 +693,280 @@ GncDateTime::timestamp()
     return GncDateTimeImpl::timestamp();
 }
 
+/* The static conversions below are called for every date that's loaded,
+ * saved or displayed so they avoid boost::date_time where they can. They
+ * work in seconds on the proleptic Gregorian calendar using Howard
+ * Hinnant's algorithms, http://howardhinnant.github.io/date_algorithms.html,
+ * and fall back on GncDateTimeImpl for anything they can't be sure of.
+ */
+static constexpr int64_t secs_per_day = INT64_C(86400);
+static constexpr int fast_min_year = 1401;
+static constexpr int fast_max_year = 9998;
+
+static inline int64_t
+floor_div(int64_t num, int64_t den) noexcept
+{
+    auto quot = num / den;
+    return num % den < 0 ? quot - 1 : quot;
+}
+
+static inline int64_t
+days_from_civil(int64_t year, unsigned month, unsigned day) noexcept
+{
+    year -= month <= 2;
+    auto era = floor_div(year, 400);
+    auto yoe = static_cast<unsigned>(year - era * 400);
+    auto doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    auto doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+static inline ymd
+civil_from_days(int64_t days) noexcept
+{
+    days += 719468;
+    auto era = floor_div(days, 146097);
+    auto doe = static_cast<unsigned>(days - era * 146097);
+    auto yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    auto doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    auto mp = (5 * doy + 2) / 153;
+    int day = doy - (153 * mp + 2) / 5 + 1;
+    int month = mp < 10 ? mp + 3 : mp - 9;
+    int year = static_cast<int>(yoe + era * 400) + (month <= 2);
+    return {year, month, day};
+}
+
+static inline int
+days_in_month(int year, int month) noexcept
+{
+    static constexpr int days[] {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if (month == 2 && year % 4 == 0 && (year % 100 != 0 || year % 400 == 0))
+        return 29;
+    return days[month - 1];
+}
+
+/* Fill tm with the broken-down time of secs, leaving tm_isdst to the caller. */
+static void
+secs_to_tm(int64_t secs, struct tm& tm) noexcept
+{
+    auto days = floor_div(secs, secs_per_day);
+    auto day_secs = static_cast<int>(secs - days * secs_per_day);
+    auto date = civil_from_days(days);
+    memset(&tm, 0, sizeof(tm));
+    tm.tm_year = date.year - 1900;
+    tm.tm_mon = date.month - 1;
+    tm.tm_mday = date.day;
+    tm.tm_hour = day_secs / 3600;
+    tm.tm_min = day_secs / 60 % 60;
+    tm.tm_sec = day_secs % 60;
+    tm.tm_wday = static_cast<int>((days % 7 + 11) % 7); // 1970-01-01 was a Thursday.
+    tm.tm_yday = static_cast<int>(days - days_from_civil(date.year, 1, 1));
+}
+
+/* One year of the current timezone, in seconds from the epoch as if local
+ * time were UTC. dst_start and dst_end are the local times at which DST
+ * starts and ends as reported by the timezone.
+ */
+struct TZYear
+{
+    unsigned generation = 0;
+    int year = 0;
+    int64_t base_offset = 0;
+    int64_t dst_offset = 0;
+    bool has_dst = false;
+    int64_t dst_start = 0;
+    int64_t dst_end = 0;
+    int64_t year_start = 0;
+    int64_t year_end = 0;
+};
+
+static const TZYear&
+tz_year(int year)
+{
+    static thread_local std::array<TZYear, 8> cache;
+    auto& entry = cache[year % cache.size()];
+    auto generation = tzp_generation.load(std::memory_order_relaxed);
+    if (entry.year == year && entry.generation == generation)
+        return entry;
+
+    auto tz = tzp->get(year);
+    entry.generation = generation;
+    entry.year = year;
+    entry.base_offset = tz->base_utc_offset().total_seconds();
+    entry.has_dst = tz->has_dst();
+    if (entry.has_dst)
+    {
+        entry.dst_offset = tz->dst_offset().total_seconds();
+        entry.dst_start = (tz->dst_local_start_time(year) - unix_epoch).total_seconds();
+        entry.dst_end = (tz->dst_local_end_time(year) - unix_epoch).total_seconds();
+    }
+    else
+    {
+        entry.dst_offset = entry.dst_start = entry.dst_end = 0;
+    }
+    entry.year_start = days_from_civil(year, 1, 1) * secs_per_day;
+    entry.year_end = days_from_civil(year + 1, 1, 1) * secs_per_day;
+    return entry;
+}
+
+/* Decide whether local, a local time in seconds, is in DST. boost decides by
+ * day except on the days of the transitions and picks the timezone by year,
+ * so this declines to answer within two days of a transition or of the
+ * turn of the year, which also covers the DST gap and overlap.
+ */
+static bool
+tz_year_is_dst(const TZYear& zone, int64_t local, bool& is_dst) noexcept
+{
+    constexpr int64_t margin = 2 * secs_per_day;
+    if (local < zone.year_start + margin || local >= zone.year_end - margin)
+        return false;
+    is_dst = false;
+    if (!zone.has_dst)
+        return true;
+    if (std::abs(local - zone.dst_start) < margin ||
+        std::abs(local - zone.dst_end) < margin)
+        return false;
+    if (zone.dst_start < zone.dst_end)
+        is_dst = local > zone.dst_start && local < zone.dst_end;
+    else // Southern hemisphere
+        is_dst = local > zone.dst_start || local < zone.dst_end;
+    return true;
+}
+
+static inline void
+set_tm_zone(struct tm& tm, bool is_dst, int64_t offset) noexcept
+{
+    tm.tm_isdst = is_dst;
+#if HAVE_STRUCT_TM_GMTOFF
+    tm.tm_gmtoff = offset;
+#endif
+}
+
+struct tm
+GncDateTime::local_tm(time64 time)
+{
+    auto year = civil_from_days(floor_div(time, secs_per_day)).year;
+    if (year >= fast_min_year && year <= fast_max_year)
+    {
+        auto& zone = tz_year(year);
+        bool is_dst;
+        if (tz_year_is_dst(zone, time + zone.base_offset, is_dst))
+        {
+            auto offset = zone.base_offset + (is_dst ? zone.dst_offset : 0);
+            struct tm tm;
+            secs_to_tm(time + offset, tm);
+            set_tm_zone(tm, is_dst, offset);
+            return tm;
+        }
+    }
+    return static_cast<struct tm>(GncDateTime(time));
+}
+
+time64
+GncDateTime::local_tm_to_time64(struct tm& tm)
+{
+    auto year = tm.tm_year + 1900;
+    if (year >= fast_min_year && year <= fast_max_year &&
+        tm.tm_mon >= 0 && tm.tm_mon < 12 && tm.tm_mday >= 1 &&
+        tm.tm_mday <= days_in_month(year, tm.tm_mon + 1) &&
+        tm.tm_hour >= 0 && tm.tm_hour < 24 && tm.tm_min >= 0 &&
+        tm.tm_min < 60 && tm.tm_sec >= 0 && tm.tm_sec < 60)
+    {
+        auto& zone = tz_year(year);
+        auto local = days_from_civil(year, tm.tm_mon + 1, tm.tm_mday) *
+            secs_per_day + tm.tm_hour * 3600 + tm.tm_min * 60 + tm.tm_sec;
+        bool is_dst;
+        if (tz_year_is_dst(zone, local, is_dst))
+        {
+            auto offset = zone.base_offset + (is_dst ? zone.dst_offset : 0);
+            secs_to_tm(local, tm);
+            set_tm_zone(tm, is_dst, offset);
+            return local - offset;
+        }
+    }
+    GncDateTime gncdt(tm);
+    tm = static_cast<struct tm>(gncdt);
+    return static_cast<time64>(gncdt);
+}
+
+/* Read count decimal digits from str into value and advance str past them. */
+static inline bool
+read_digits(const char*& str, int count, int& value) noexcept
+{
+    value = 0;
+    for (; count; --count, ++str)
+    {
+        if (*str < '0' || *str > '9')
+            return false;
+        value = value * 10 + *str - '0';
+    }
+    return true;
+}
+
+time64
+GncDateTime::time64_from_string(const char* str)
+{
+    auto p = str;
+    int year, month, day, hour, min, sec;
+    if (read_digits(p, 4, year) && *p++ == '-' && read_digits(p, 2, month) &&
+        *p++ == '-' && read_digits(p, 2, day) && *p++ == ' ' &&
+        read_digits(p, 2, hour) && *p++ == ':' && read_digits(p, 2, min) &&
+        *p++ == ':' && read_digits(p, 2, sec))
+    {
+        int tz_sign = 1, tz_hour = 0, tz_min = 0;
+        auto valid = true;
+        while (*p == ' ')
+            ++p;
+        if (*p == '+' || *p == '-')
+        {
+            tz_sign = *p++ == '-' ? -1 : 1;
+            valid = read_digits(p, 2, tz_hour);
+            if (valid && *p)
+            {
+                if (*p == ':')
+                    ++p;
+                valid = read_digits(p, 2, tz_min);
+            }
+        }
+        if (valid && !*p && year >= fast_min_year && year <= fast_max_year &&
+            month >= 1 && month <= 12 && day >= 1 &&
+            day <= days_in_month(year, month) && hour < 24 && min < 60 &&
+            sec < 60 && tz_hour < 24 && tz_min < 60)
+            return days_from_civil(year, month, day) * secs_per_day +
+                hour * 3600 + min * 60 + sec -
+                tz_sign * (tz_hour * 3600 + tz_min * 60);
+    }
+    return static_cast<time64>(GncDateTime(std::string(str)));
+}
+
+char*
+GncDateTime::format_iso8601(time64 time, char* buf)
+{
+    auto days = floor_div(time, secs_per_day);
+    auto date = civil_from_days(days);
+    if (date.year < fast_min_year || date.year > fast_max_year)
+    {
+        auto str = GncDateTime(time).format_iso8601();
+        strcpy(buf, str.c_str());
+        return buf + str.size();
+    }
+
+    auto day_secs = static_cast<int>(time - days * secs_per_day);
+    auto put = [&buf](int value, int width, char sep) {
+        for (auto i = width - 1; i >= 0; --i, value /= 10)
+            buf[i] = '0' + value % 10;
+        buf += width;
+        *buf++ = sep;
+    };
+    put(date.year, 4, '-');
+    put(date.month, 2, '-');
+    put(date.day, 2, ' ');
+    put(day_secs / 3600, 2, ':');
+    put(day_secs / 60 % 60, 2, ':');
+    put(day_secs % 60, 2, '\0');
+    return buf - 1;
+}
+
 /* GncDate */
 GncDate::GncDate() : m_impl{new GncDateImpl} {}
 GncDate::GncDate(int year, int month, int day) :
@@ -156,7 +156,47 @@ public:
  *  @return a std::string in the format YYYYMMDDHHMMSS.
  */
     static std::string timestamp();
-    
+/** Convert a time64 to a struct tm in the current timezone.
+ *
+ * Gives the same result as converting a GncDateTime constructed from
+ * time but caches each year's offsets and DST transitions so that the
+ * usual case doesn't need the boost::date_time machinery.
+ *  @param time Seconds since the POSIX epoch.
+ *  @return a struct tm including tm_isdst and, where available, tm_gmtoff.
+ *  @exception std::invalid_argument if the year is outside the constraints.
+ */
+    static struct tm local_tm(time64 time);
+/** Convert a struct tm in the current timezone to a time64 and
+ * normalize the struct tm to the resulting local time, like mktime(3).
+ *
+ * Gives the same result as constructing a GncDateTime from tm and uses
+ * the same cache as local_tm().
+ *  @param tm The local time to convert, updated in place.
+ *  @return Seconds since the POSIX epoch.
+ *  @exception std::invalid_argument if the year is outside the constraints
+ *  or if tm doesn't resolve to a valid time.
+ */
+    static time64 local_tm_to_time64(struct tm& tm);
+/** Parse a date and time string, as the string constructor does.
+ *
+ * The YYYY-MM-DD HH:MM:SS +HHMM form written by the XML backend is
+ * read directly; anything else is handed to the string constructor.
+ *  @param str The string to parse.
+ *  @return Seconds since the POSIX epoch.
+ *  @exception std::invalid_argument if the string can't be parsed.
+ *  @exception std::out_of_range if the date is invalid or outside the
+ *  constraints.
+ */
+    static time64 time64_from_string(const char* str);
+/** Format a time64 into a gnucash-style iso8601 string in UTC without
+ *  constructing a GncDateTime.
+ *  @param time Seconds since the POSIX epoch.
+ *  @param buf A buffer with room for at least 20 characters.
+ *  @return a pointer to the terminating null written to buf.
+ *  @exception std::invalid_argument if the year is outside the constraints.
+ */
+    static char* format_iso8601(time64 time, char* buf);
+
 private:
     std::unique_ptr<GncDateTimeImpl> m_impl;
 };
@@ -31,6 +31,7 @@
 #include "SX-book-p.h"
 #include "gnc-budget.h"
 #include "TransactionP.h"
+#include "TransLog.h"
 #include "gnc-commodity.h"
 #include "gnc-pricedb-p.h"
 
@@ -140,6 +141,7 @@ gnc_engine_init_static(int argc, char ** argv)
 void
 gnc_engine_shutdown (void)
 {
+    xaccCloseLog();
     qof_log_shutdown();
     qof_close();
     engine_is_initialized = 0;
@@ -37,7 +37,15 @@ extern "C"
 /* All algorithms from Donald E. Knuth, "The Art of Computer
  * Programming, Volume 2: Seminumerical Algorithms", 3rd Ed.,
  * Addison-Wesley, 1998.
+ *
+ * Compilers providing a native 128-bit integer type do the magnitude
+ * arithmetic of multiplication, division and gcd in hardware instead;
+ * define GNC_INT128_PORTABLE to use the algorithms above regardless. The
+ * sign and flags handling is shared, so both give the same results.
  */
+#if defined(__SIZEOF_INT128__) && !defined(GNC_INT128_PORTABLE)
+#define GNC_INT128_NATIVE 1
+#endif
 
 namespace {
     static const unsigned int upper_num_bits = 61;
@@ -62,6 +70,23 @@ namespace {
     {
         return leg & nummask;
     }
+#ifdef GNC_INT128_NATIVE
+    using uint128_t = unsigned __int128;
+    static inline uint128_t magnitude(uint64_t hi, uint64_t lo)
+    {
+        return (static_cast<uint128_t>(get_num(hi)) << GncInt128::legbits) + lo;
+    }
+    static inline uint64_t upper_leg(uint128_t value)
+    {
+        return static_cast<uint64_t>(value >> GncInt128::legbits);
+    }
+    static inline unsigned int trailing_zeroes(uint128_t value)
+    {
+        auto lo = static_cast<uint64_t>(value);
+        return lo ? __builtin_ctzll(lo) :
+            GncInt128::legbits + __builtin_ctzll(upper_leg(value));
+    }
+#endif
 }
 
 GncInt128::GncInt128 () : m_hi {0}, m_lo {0}{}
@@ -194,6 +219,21 @@ GncInt128::gcd(GncInt128 b) const noexcept
     if (isOverflow() || isNan())
         return *this;
 
+#ifdef GNC_INT128_NATIVE
+    auto u = magnitude(m_hi, m_lo), v = magnitude(b.m_hi, b.m_lo);
+    auto k = trailing_zeroes(u | v);
+    u >>= trailing_zeroes(u);
+    do
+    {
+        v >>= trailing_zeroes(v);
+        if (u > v)
+            std::swap(u, v);
+        v -= u;
+    }
+    while (v);
+    u <<= k;
+    return GncInt128(upper_leg(u), static_cast<uint64_t>(u));
+#else
     GncInt128 a (isNeg() ? -(*this) : *this);
     if (b.isNeg()) b = -b;
 
@@ -216,6 +256,7 @@ GncInt128::gcd(GncInt128 b) const noexcept
         t = a - b;  //B6
     }
     return a << k;
+#endif
 }
 
 /* Since u * v = gcd(u, v) * lcm(u, v), we find lcm by u / gcd * v. */
@@ -298,9 +339,13 @@ GncInt128::bits() const noexcept
     auto hi = get_num(m_hi);
     unsigned int bits {static_cast<unsigned int>(hi == 0 ? 0 : 64)};
     uint64_t temp {(hi == 0 ? m_lo : hi)};
+#ifdef GNC_INT128_NATIVE
+    return temp ? bits + legbits - __builtin_clzll(temp) : bits;
+#else
     for (;temp > 0; temp >>= 1)
         ++bits;
     return bits;
+#endif
 }
 
 
@@ -518,6 +563,15 @@ GncInt128::operator*= (const GncInt128& b) noexcept
         return *this;
     }
 
+#ifdef GNC_INT128_NATIVE
+    auto product = magnitude(hi, m_lo) * magnitude(bhi, b.m_lo);
+    m_lo = static_cast<uint64_t>(product);
+    hi = upper_leg(product);
+    if (hi & flagmask)
+        flags |= overflow;
+    m_hi = set_flags(hi, flags);
+    return *this;
+#else
     /* The trivial case */
     if (abits + bbits <= legbits)
     {
@@ -527,7 +581,7 @@ GncInt128::operator*= (const GncInt128& b) noexcept
     }
 
 /* This is Knuth's "classical" multi-precision multiplication algorithm
- * truncated to a GncInt128 result with the loop unrolled for clarity and with
+ * truncated to a GncInt128 result, working in 32-bit sublegs, and with
  * overflow and zero checks beforehand to save time. See Donald Knuth, "The Art
  * of Computer Programming Volume 2: Seminumerical Algorithms", Addison-Wesley,
  * 1998, p 268.
@@ -543,43 +597,43 @@ GncInt128::operator*= (const GncInt128& b) noexcept
     uint64_t bv[sublegs] {(b.m_lo & sublegmask), (b.m_lo >> sublegbits),
             (bhi & sublegmask), (bhi >> sublegbits)};
     uint64_t rv[sublegs] {};
-    uint64_t carry {}, scratch {};
-
-    rv[0] = av[0] * bv[0];
-
-    rv[1] = av[1] * bv [0];
-    scratch = rv[1] + av[0] * bv[1];
-    carry = rv[1] > scratch ? 1 : 0;
-    rv[1] = scratch;
-
-    rv[2] = av[2] * bv[0] + carry; //0xffff^2 + 1 < 0xffffffff, can't overflow
-    scratch = rv[2] + av[1] * bv[1];
-    carry = rv[2] > scratch ? 1 : 0;
-    rv[2] = scratch + av[0] * bv[2];
-    carry += scratch > rv[2] ? 1 : 0;
-
-    rv[3] = av[3] * bv[0] + carry;
-    scratch = rv[3] + av[2] * bv[1];
-    carry = rv[3] > scratch ? 1 : 0;
-    rv[3] = scratch + av[1] * bv[2];
-    carry += scratch > rv[3] ? 1 : 0;
-    scratch = rv[3] + av[0] * bv[3];
-    carry += rv[3] > scratch ? 1 : 0;
-    rv[3] = scratch;
-
-    if (carry) //Shouldn't happen because of the checks above
+
+    /* Each step adds a product of two sublegs, a result subleg and a
+     * carry, at most (2^32 - 1)^2 + 2 * (2^32 - 1) = 2^64 - 1, so it
+     * can't overflow. Anything that would land beyond the top subleg
+     * overflows the result. */
+    for (unsigned int i = 0; i < sublegs; ++i)
     {
-        flags |= overflow;
-        m_hi = set_flags(m_hi, flags);
-        return *this;
+        if (!av[i])
+            continue;
+        uint64_t carry {};
+        for (unsigned int j = 0; j < sublegs; ++j)
+        {
+            if (i + j >= sublegs)
+            {
+                if (bv[j] || carry)
+                {
+                    flags |= overflow;
+                    m_hi = set_flags(m_hi, flags);
+                    return *this;
+                }
+                continue;
+            }
+            auto scratch = av[i] * bv[j] + rv[i + j] + carry;
+            rv[i + j] = scratch & sublegmask;
+            carry = scratch >> sublegbits;
+        }
+        if (carry)
+        {
+            flags |= overflow;
+            m_hi = set_flags(m_hi, flags);
+            return *this;
+        }
     }
 
     m_lo = rv[0] + (rv[1] << sublegbits);
-    carry = rv[1] >> sublegbits;
-    carry += (rv[1] << sublegbits) > m_lo || rv[0] > m_lo ? 1 : 0;
-    hi = rv[2] + (rv[3] << sublegbits) + carry;
-    if ((rv[3] << sublegbits) > hi || rv[2] > hi || (rv[3] >> sublegbits) ||
-        hi & flagmask)
+    hi = rv[2] + (rv[3] << sublegbits);
+    if (hi & flagmask)
     {
         flags |= overflow;
         m_hi = set_flags(hi, flags);
@@ -587,8 +641,10 @@ GncInt128::operator*= (const GncInt128& b) noexcept
     }
     m_hi = set_flags(hi, flags);
     return *this;
+#endif
 }
 
+#ifndef GNC_INT128_NATIVE
 namespace {
 /* Algorithm from Knuth (full citation at operator*=) p272ff.  Again, there
  * are faster algorithms out there, but they require much larger numbers to
@@ -632,7 +688,7 @@ div_multi_leg (uint64_t* u, size_t m, uint64_t* v, size_t n,
         }
         else
             carry = UINT64_C(0);
-        assert (v[i] < sublegmask);
+        assert (v[i] <= sublegmask);
     }
     assert (carry == UINT64_C(0));
     for (int j = m - n; j >= 0; j--) //D3
@@ -648,49 +704,47 @@ div_multi_leg (uint64_t* u, size_t m, uint64_t* v, size_t n,
             --qhat;
             rhat += v[n - 1];
         }
-        carry = UINT64_C(0);
-        uint64_t borrow {};
+        /* The borrow is carried as a signed value so that it propagates
+         * all the way up, and a negative result of the subtraction is
+         * what D5 tests for.
+         */
+        int64_t borrow {}, diff {};
         for (size_t k = 0; k < n; ++k) //D4
         {
-            auto subend = qhat * v[k] + carry;
-            carry = subend >> sublegbits;
-            subend &= sublegmask;
-            if (u[j + k] >= subend)
-            {
-                u[j + k] = u[j + k] - subend;
-                borrow = UINT64_C(0);
-            }
-            else
-            {
-                if (u[j + k + 1] > 0)
-                    --u[j + k + 1];
-                else
-                    ++borrow;
-                u[j + k] = u[j + k] + sublegmask + 1 - subend;
-                u[j + k] &= sublegmask;
-            }
+            auto product = qhat * v[k];
+            diff = static_cast<int64_t>(u[j + k]) - borrow -
+                static_cast<int64_t>(product & sublegmask);
+            u[j + k] = static_cast<uint64_t>(diff) & sublegmask;
+            borrow = static_cast<int64_t>(product >> sublegbits) -
+                (diff >> sublegbits);
         }
-        u[j + n] -= carry;
+        diff = static_cast<int64_t>(u[j + n]) - borrow;
+        u[j + n] = static_cast<uint64_t>(diff) & sublegmask;
         qv[j] = qhat;
-        if (borrow) //D5
+        if (diff < 0) //D5
         { //D6
             --qv[j];
             carry = UINT64_C(0);
             for (size_t k = 0; k < n; ++k)
             {
                 u[j + k] += v[k] + carry;
-                if (u[j + k] > sublegmask)
-                {
-                    carry = u[j + k] >> sublegbits;
-                    u[j + k] &= sublegmask;
-                }
+                carry = u[j + k] >> sublegbits;
+                u[j + k] &= sublegmask;
             }
-            u[j + n] += carry;
+            u[j + n] = (u[j + n] + carry) & sublegmask;
         }
     }//D7
+    /* D8, unnormalize the remainder while it's still in sublegs; multiplied
+     * by d it may be too big for a GncInt128. */
+    carry = UINT64_C(0);
+    for (int i = n - 1; i >= 0; --i)
+    {
+        auto part = (carry << sublegbits) + u[i];
+        u[i] = part / d;
+        carry = part % d;
+    }
     q = GncInt128 ((qv[3] << sublegbits) + qv[2], (qv[1] << sublegbits) + qv[0]);
     r = GncInt128 ((u[3] << sublegbits) + u[2], (u[1] << sublegbits) + u[0]);
-    r /= d;
     if (negative) q = -q;
     if (rnegative) r = -r;
 }
@@ -722,6 +776,7 @@ div_single_leg (uint64_t* u, size_t m, uint64_t v,
 }
 
 }// namespace
+#endif
 
 void
 GncInt128::div (const GncInt128& b, GncInt128& q, GncInt128& r) const noexcept
@@ -793,6 +848,14 @@ GncInt128::div (const GncInt128& b, GncInt128& q, GncInt128& r) const noexcept
         return;
     }
 
+#ifdef GNC_INT128_NATIVE
+    auto dividend = magnitude(hi, m_lo), divisor = magnitude(bhi, b.m_lo);
+    auto quotient = dividend / divisor, remainder = dividend % divisor;
+    q.m_lo = static_cast<uint64_t>(quotient);
+    q.m_hi = set_flags(upper_leg(quotient), qflags);
+    r.m_lo = static_cast<uint64_t>(remainder);
+    r.m_hi = set_flags(upper_leg(remainder), rflags);
+#else
     uint64_t u[sublegs + 2] {(m_lo & sublegmask), (m_lo >> sublegbits),
             (hi & sublegmask), (hi >> sublegbits), 0, 0};
     uint64_t v[sublegs] {(b.m_lo & sublegmask), (b.m_lo >> sublegbits),
@@ -805,6 +868,7 @@ GncInt128::div (const GncInt128& b, GncInt128& q, GncInt128& r) const noexcept
         return div_single_leg (u, m, v[0], q, r);
 
     return div_multi_leg (u, m, v, n, q, r);
+#endif
 }
 
 GncInt128&
@@ -53,6 +53,7 @@
 #include "Transaction.h"
 #include "TransactionP.h"
 #include "gncInvoice.h"
+#include "gncOwnerP.h"
 
 /* This static indicates the debugging module that this .o belongs to.  */
 static QofLogModule log_module = GNC_MOD_LOT;
@@ -76,6 +77,24 @@ enum
     PROP_MARKER,        /* Runtime */
 };
 
+/* An entry of the lot's balance index, see gnc_lot_get_balance_before. */
+typedef struct
+{
+    Split *split;
+    /* The split whose transaction orders this one: the split itself or,
+     * for a gains split, the split whose gains it records. */
+    const Split *source;
+    /* The date posted of the source's transaction and of the split's own
+     * transaction, as of when the entry was placed. */
+    time64 date;
+    time64 posted;
+    /* Running sums of the amounts and values up to this entry. */
+    gnc_numeric amount;
+    gnc_numeric value;
+} LotIndexEntry;
+
+#define INDEX_ENTRY(index, i) (&g_array_index ((index), LotIndexEntry, (i)))
+
 typedef struct GNCLotPrivate
 {
     /* Account to which this lot applies.  All splits in the lot must
@@ -83,8 +102,22 @@ typedef struct GNCLotPrivate
      */
     Account * account;
 
-    /* List of splits that belong to this lot. */
+    /* List of splits that belong to this lot, and its last node. The
+     * list is kept in xaccSplitOrderDateOnly order while splits_sorted is
+     * set; appending a later split preserves that. */
     SplitList *splits;
+    SplitList *last_split;
+    gboolean splits_sorted;
+
+    /* Cached sum of the split amounts, valid unless is_closed is
+     * LOT_CLOSED_UNKNOWN. */
+    gnc_numeric balance;
+
+    /* The splits in order of their source's date, with running totals
+     * valid for the first totals_valid entries.  Built by the first
+     * gnc_lot_get_balance_before, NULL until then. */
+    GArray *index;
+    guint totals_valid;
 
     GncInvoice *cached_invoice;
     /* Handy cached value to indicate if lot is closed. */
@@ -101,6 +134,152 @@ typedef struct GNCLotPrivate
 
 #define gnc_lot_set_guid(L,G)  qof_instance_set_guid(QOF_INSTANCE(L),&(G))
 
+/* ============================================================= */
+/* The balance index: the lot's splits ordered by the date of their
+ * source transaction, with running totals of their amounts and values. */
+
+static void
+gnc_lot_index_entry_init (LotIndexEntry *entry, Split *split)
+{
+    const Split *source = xaccSplitGetGainsSourceSplit (split);
+
+    entry->split = split;
+    entry->source = source ? source : split;
+    entry->date = xaccTransRetDatePosted (xaccSplitGetParent (entry->source));
+    entry->posted = xaccTransRetDatePosted (xaccSplitGetParent (split));
+    entry->amount = entry->value = gnc_numeric_zero ();
+}
+
+static gint
+gnc_lot_index_entry_order (gconstpointer a, gconstpointer b)
+{
+    time64 da = ((const LotIndexEntry*) a)->date;
+    time64 db = ((const LotIndexEntry*) b)->date;
+    return (da > db) - (da < db);
+}
+
+/* The first entry dated after date, or not before it if !after. */
+static guint
+gnc_lot_index_bound (GArray *index, time64 date, gboolean after)
+{
+    guint lo = 0, hi = index->len;
+
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+        time64 d = INDEX_ENTRY (index, mid)->date;
+        if (d < date || (after && d == date))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* The position of split, whose source is dated date unless that just
+ * changed, or index->len if it isn't in the index. */
+static guint
+gnc_lot_index_find (GArray *index, const Split *split, time64 date)
+{
+    guint i;
+
+    for (i = gnc_lot_index_bound (index, date, FALSE);
+         i < index->len && INDEX_ENTRY (index, i)->date == date; i++)
+        if (INDEX_ENTRY (index, i)->split == split)
+            return i;
+    for (i = 0; i < index->len; i++)
+        if (INDEX_ENTRY (index, i)->split == split)
+            return i;
+    return index->len;
+}
+
+/* Extend the running totals over the first count entries. */
+static void
+gnc_lot_index_sum (GNCLotPrivate *priv, guint count)
+{
+    guint i;
+
+    for (i = priv->totals_valid; i < count; i++)
+    {
+        LotIndexEntry *entry = INDEX_ENTRY (priv->index, i);
+        entry->amount = xaccSplitGetAmount (entry->split);
+        entry->value = xaccSplitGetValue (entry->split);
+        if (i > 0)
+        {
+            LotIndexEntry *prev = INDEX_ENTRY (priv->index, i - 1);
+            entry->amount = gnc_numeric_add_fixed (prev->amount, entry->amount);
+            entry->value = gnc_numeric_add_fixed (prev->value, entry->value);
+        }
+    }
+    priv->totals_valid = MAX (priv->totals_valid, count);
+}
+
+static void
+gnc_lot_index_insert (GNCLotPrivate *priv, const LotIndexEntry *entry)
+{
+    guint pos = gnc_lot_index_bound (priv->index, entry->date, TRUE);
+
+    g_array_insert_vals (priv->index, pos, entry, 1);
+    priv->totals_valid = MIN (priv->totals_valid, pos);
+    /* Keep the totals going when the lot is filled in date order. */
+    if (pos + 1 == priv->index->len && priv->totals_valid == pos)
+        gnc_lot_index_sum (priv, pos + 1);
+}
+
+/* Place the gains splits of source again after its date changed. */
+static void
+gnc_lot_index_move_gains (GNCLotPrivate *priv, const Split *source)
+{
+    GSList *gains = NULL, *node;
+    guint i = 0;
+
+    while (i < priv->index->len)
+    {
+        LotIndexEntry *entry = INDEX_ENTRY (priv->index, i);
+        if (entry->source != source || entry->split == source)
+        {
+            i++;
+            continue;
+        }
+        gains = g_slist_prepend (gains, entry->split);
+        g_array_remove_index (priv->index, i);
+        priv->totals_valid = MIN (priv->totals_valid, i);
+    }
+    for (node = gains; node; node = node->next)
+    {
+        LotIndexEntry entry;
+        gnc_lot_index_entry_init (&entry, node->data);
+        gnc_lot_index_insert (priv, &entry);
+    }
+    g_slist_free (gains);
+}
+
+static void
+gnc_lot_index_build (GNCLotPrivate *priv)
+{
+    GList *node;
+
+    priv->index = g_array_sized_new (FALSE, FALSE, sizeof (LotIndexEntry),
+                                     g_list_length (priv->splits));
+    for (node = priv->splits; node; node = node->next)
+    {
+        LotIndexEntry entry;
+        gnc_lot_index_entry_init (&entry, node->data);
+        g_array_append_val (priv->index, entry);
+    }
+    g_array_sort (priv->index, gnc_lot_index_entry_order);
+    priv->totals_valid = 0;
+}
+
+static void
+gnc_lot_index_free (GNCLotPrivate *priv)
+{
+    if (priv->index)
+        g_array_free (priv->index, TRUE);
+    priv->index = NULL;
+    priv->totals_valid = 0;
+}
+
 /* ============================================================= */
 
 /* GObject Initialization */
@@ -114,6 +293,11 @@ gnc_lot_init(GNCLot* lot)
     priv = GET_PRIVATE(lot);
     priv->account = NULL;
     priv->splits = NULL;
+    priv->last_split = NULL;
+    priv->splits_sorted = TRUE;
+    priv->balance = gnc_numeric_zero();
+    priv->index = NULL;
+    priv->totals_valid = 0;
     priv->cached_invoice = NULL;
     priv->is_closed = LOT_CLOSED_UNKNOWN;
     priv->marker = 0;
@@ -283,6 +467,9 @@ gnc_lot_free(GNCLot* lot)
 
     ENTER ("(lot=%p)", lot);
     qof_event_gen (QOF_INSTANCE(lot), QOF_EVENT_DESTROY, NULL);
+    /* Also done when events are suspended, the index must not keep a
+     * pointer to a freed lot. */
+    gncOwnerLotIndexUpdate (lot);
 
     priv = GET_PRIVATE(lot);
     for (node = priv->splits; node; node = node->next)
@@ -291,8 +478,13 @@ gnc_lot_free(GNCLot* lot)
         s->lot = NULL;
     }
     g_list_free (priv->splits);
+    priv->splits = NULL;
+    priv->last_split = NULL;
+    gnc_lot_index_free (priv);
 
-    if (priv->account && !qof_instance_get_destroying(priv->account))
+    /* A book being shut down drops its accounts' lot lists wholesale. */
+    if (priv->account && !qof_instance_get_destroying(priv->account) &&
+        !qof_book_shutting_down (qof_instance_get_book (lot)))
         xaccAccountRemoveLot (priv->account, lot);
 
     priv->account = NULL;
@@ -412,10 +604,60 @@ gnc_lot_set_closed_unknown(GNCLot* lot)
     if (lot != NULL)
     {
         priv = GET_PRIVATE(lot);
+        /* Something changed, but not said what: drop the cached balance
+         * and the balance index, and check the split order again before
+         * it is next relied on. */
         priv->is_closed = LOT_CLOSED_UNKNOWN;
+        priv->splits_sorted = FALSE;
+        gnc_lot_index_free (priv);
+        xaccAccountLotChanged (priv->account, lot);
     }
 }
 
+void
+gnc_lot_split_changed (GNCLot *lot, Split *split)
+{
+    GNCLotPrivate* priv;
+    LotIndexEntry entry;
+    guint pos;
+
+    if (!lot || !split) return;
+    priv = GET_PRIVATE(lot);
+    priv->is_closed = LOT_CLOSED_UNKNOWN;
+
+    if (!priv->index)
+    {
+        /* Nothing recorded the split's date, so it may have moved. */
+        priv->splits_sorted = FALSE;
+        xaccAccountLotChanged (priv->account, lot);
+        return;
+    }
+
+    gnc_lot_index_entry_init (&entry, split);
+    pos = gnc_lot_index_find (priv->index, split, entry.date);
+    /* Not in the index yet when it's being added to the lot. */
+    if (pos < priv->index->len)
+    {
+        LotIndexEntry *old = INDEX_ENTRY (priv->index, pos);
+        time64 old_date = old->date;
+
+        if (old->posted != entry.posted)
+            priv->splits_sorted = FALSE;
+        priv->totals_valid = MIN (priv->totals_valid, pos);
+        if (old_date != entry.date || old->source != entry.source)
+        {
+            g_array_remove_index (priv->index, pos);
+            gnc_lot_index_insert (priv, &entry);
+        }
+        else
+            old->posted = entry.posted;
+        /* The gains splits of this one are ordered by its date too. */
+        if (old_date != entry.date)
+            gnc_lot_index_move_gains (priv, split);
+    }
+    xaccAccountLotChanged (priv->account, lot);
+}
+
 SplitList *
 gnc_lot_get_split_list (const GNCLot *lot)
 {
@@ -498,10 +740,14 @@ gnc_lot_get_balance (GNCLot *lot)
     priv = GET_PRIVATE(lot);
     if (!priv->splits)
     {
+        priv->balance = zero;
         priv->is_closed = FALSE;
         return zero;
     }
 
+    if (priv->is_closed != LOT_CLOSED_UNKNOWN)
+        return priv->balance;
+
     /* Sum over splits; because they all belong to same account
      * they will have same denominator.
      */
@@ -514,6 +760,7 @@ gnc_lot_get_balance (GNCLot *lot)
     }
 
     /* cache a zero balance as a closed lot */
+    priv->balance = baln;
     if (gnc_numeric_equal (baln, zero))
     {
         priv->is_closed = TRUE;
@@ -526,6 +773,50 @@ gnc_lot_get_balance (GNCLot *lot)
     return baln;
 }
 
+/* Fold a split entering (sign 1) or leaving (sign -1) the lot into the
+ * cached balance, if there is one to maintain. */
+static void
+gnc_lot_update_balance (GNCLotPrivate *priv, const Split *split, int sign)
+{
+    gnc_numeric amt;
+
+    if (priv->is_closed == LOT_CLOSED_UNKNOWN)
+        return;
+
+    amt = xaccSplitGetAmount (split);
+    if (sign > 0)
+        priv->balance = gnc_numeric_add_fixed (priv->balance, amt);
+    else
+        priv->balance = gnc_numeric_sub_fixed (priv->balance, amt);
+
+    if (gnc_numeric_check (priv->balance) != GNC_ERROR_OK)
+    {
+        /* Let gnc_lot_get_balance sort it out from scratch. */
+        priv->is_closed = LOT_CLOSED_UNKNOWN;
+        return;
+    }
+    priv->is_closed = gnc_numeric_zero_p (priv->balance);
+}
+
+/* Sort the split list if it isn't, and find its last node again. A date
+ * change usually leaves the order alone, so look before sorting. */
+static void
+gnc_lot_sort_splits (GNCLotPrivate *priv)
+{
+    GList *node;
+
+    if (priv->splits_sorted)
+        return;
+
+    for (node = priv->splits; node && node->next; node = node->next)
+        if (xaccSplitOrderDateOnly (node->data, node->next->data) > 0)
+            break;
+    if (node && node->next)
+        priv->splits = g_list_sort (priv->splits, (GCompareFunc) xaccSplitOrderDateOnly);
+    priv->last_split = g_list_last (priv->splits);
+    priv->splits_sorted = TRUE;
+}
+
 /* ============================================================= */
 
 void
@@ -533,7 +824,6 @@ gnc_lot_get_balance_before (const GNCLot *lot, const Split *split,
                             gnc_numeric *amount, gnc_numeric *value)
 {
     GNCLotPrivate* priv;
-    GList *node;
     gnc_numeric zero = gnc_numeric_zero();
     gnc_numeric amt = zero;
     gnc_numeric val = zero;
@@ -547,6 +837,9 @@ gnc_lot_get_balance_before (const GNCLot *lot, const Split *split,
     {
         Transaction *ta, *tb;
         const Split *target;
+        time64 date;
+        guint i, pos;
+
         /* If this is a gains split, find the source of the gains and use
            its transaction for the comparison.  Gains splits are in separate
            transactions that may sort after non-gains transactions.  */
@@ -554,19 +847,33 @@ gnc_lot_get_balance_before (const GNCLot *lot, const Split *split,
         if (target == NULL)
             target = split;
         tb = xaccSplitGetParent (target);
-        for (node = priv->splits; node; node = node->next)
+        date = xaccTransRetDatePosted (tb);
+
+        /* Everything dated earlier is in the running totals ... */
+        if (!priv->index)
+            gnc_lot_index_build (priv);
+        pos = tb ? gnc_lot_index_bound (priv->index, date, FALSE)
+                 : priv->index->len;
+        gnc_lot_index_sum (priv, pos);
+        if (pos > 0)
         {
-            Split *s = node->data;
-            Split *source = xaccSplitGetGainsSourceSplit (s);
-            if (source == NULL)
-                source = s;
-            ta = xaccSplitGetParent (source);
-            if ((ta == tb && source != target) ||
+            amt = INDEX_ENTRY (priv->index, pos - 1)->amount;
+            val = INDEX_ENTRY (priv->index, pos - 1)->value;
+        }
+
+        /* ... and on the same day the transaction order decides. */
+        for (i = pos; tb && i < priv->index->len; i++)
+        {
+            LotIndexEntry *entry = INDEX_ENTRY (priv->index, i);
+            if (entry->date != date)
+                break;
+            ta = xaccSplitGetParent (entry->source);
+            if ((ta == tb && entry->source != target) ||
                     xaccTransOrder (ta, tb) < 0)
             {
-                gnc_numeric tmpval = xaccSplitGetAmount (s);
+                gnc_numeric tmpval = xaccSplitGetAmount (entry->split);
                 amt = gnc_numeric_add_fixed (amt, tmpval);
-                tmpval = xaccSplitGetValue (s);
+                tmpval = xaccSplitGetValue (entry->split);
                 val = gnc_numeric_add_fixed (val, tmpval);
             }
         }
@@ -620,10 +927,30 @@ gnc_lot_add_split (GNCLot *lot, Split *split)
     }
     xaccSplitSetLot(split, lot);
 
-    priv->splits = g_list_append (priv->splits, split);
+    /* Append through the tail pointer; the list stays sorted as long as
+     * the new split isn't earlier than the current last one, which is the
+     * usual case when lots are filled in date order. */
+    if (priv->splits_sorted && priv->last_split &&
+        xaccSplitOrderDateOnly (priv->last_split->data, split) > 0)
+        priv->splits_sorted = FALSE;
+    if (priv->last_split)
+    {
+        g_list_append (priv->last_split, split);
+        priv->last_split = priv->last_split->next;
+    }
+    else
+    {
+        priv->splits = priv->last_split = g_list_append (NULL, split);
+    }
+    if (priv->index)
+    {
+        LotIndexEntry entry;
+        gnc_lot_index_entry_init (&entry, split);
+        gnc_lot_index_insert (priv, &entry);
+    }
 
-    /* for recomputation of is-closed */
-    priv->is_closed = LOT_CLOSED_UNKNOWN;
+    gnc_lot_update_balance (priv, split, 1);
+    xaccAccountLotChanged (priv->account, lot);
     gnc_lot_commit_edit(lot);
 
     qof_event_gen (QOF_INSTANCE(lot), QOF_EVENT_MODIFY, NULL);
@@ -634,21 +961,45 @@ void
 gnc_lot_remove_split (GNCLot *lot, Split *split)
 {
     GNCLotPrivate* priv;
+    GList *node;
     if (!lot || !split) return;
     priv = GET_PRIVATE(lot);
 
     ENTER ("(lot=%p, split=%p)", lot, split);
     gnc_lot_begin_edit(lot);
     qof_instance_set_dirty(QOF_INSTANCE(lot));
-    priv->splits = g_list_remove (priv->splits, split);
+    node = g_list_find (priv->splits, split);
+    if (node)
+    {
+        if (node == priv->last_split)
+            priv->last_split = node->prev;
+        priv->splits = g_list_delete_link (priv->splits, node);
+        gnc_lot_update_balance (priv, split, -1);
+    }
+    if (priv->index)
+    {
+        LotIndexEntry entry;
+        guint pos;
+
+        gnc_lot_index_entry_init (&entry, split);
+        pos = gnc_lot_index_find (priv->index, split, entry.date);
+        if (pos < priv->index->len)
+        {
+            g_array_remove_index (priv->index, pos);
+            priv->totals_valid = MIN (priv->totals_valid, pos);
+        }
+    }
     xaccSplitSetLot(split, NULL);
-    priv->is_closed = LOT_CLOSED_UNKNOWN;   /* force an is-closed computation */
 
     if (NULL == priv->splits)
     {
         xaccAccountRemoveLot (priv->account, lot);
         priv->account = NULL;
     }
+    else
+    {
+        xaccAccountLotChanged (priv->account, lot);
+    }
     gnc_lot_commit_edit(lot);
     qof_event_gen (QOF_INSTANCE(lot), QOF_EVENT_MODIFY, NULL);
     LEAVE("removed from lot");
@@ -664,7 +1015,7 @@ gnc_lot_get_earliest_split (GNCLot *lot)
     if (!lot) return NULL;
     priv = GET_PRIVATE(lot);
     if (! priv->splits) return NULL;
-    priv->splits = g_list_sort (priv->splits, (GCompareFunc) xaccSplitOrderDateOnly);
+    gnc_lot_sort_splits (priv);
     return priv->splits->data;
 }
 
@@ -673,17 +1024,12 @@ Split *
 gnc_lot_get_latest_split (GNCLot *lot)
 {
     GNCLotPrivate* priv;
-    SplitList *node;
 
     if (!lot) return NULL;
     priv = GET_PRIVATE(lot);
     if (! priv->splits) return NULL;
-    priv->splits = g_list_sort (priv->splits, (GCompareFunc) xaccSplitOrderDateOnly);
-
-    for (node = priv->splits; node->next; node = node->next)
-        ;
-
-    return node->data;
+    gnc_lot_sort_splits (priv);
+    return priv->last_split->data;
 }
 
 /* ============================================================= */
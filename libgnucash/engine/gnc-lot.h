@@ -136,13 +136,15 @@ void gnc_lot_set_cached_invoice(GNCLot* lot, GncInvoice *invoice);
 
 /** The gnc_lot_get_balance() routine returns the balance of the lot.
  *    The commodity in which this balance is expressed is the commodity
- *    of the account. */
+ *    of the account.  The balance is cached and kept up to date as
+ *    splits are added to and removed from the lot. */
 gnc_numeric gnc_lot_get_balance (GNCLot *);
 
 /** The gnc_lot_get_balance_before routine computes both the balance and
  *  value in the lot considering only splits in transactions prior to the
  *  one containing the given split or other splits in the same transaction.
- *  The first return value is the amount and the second is the value. */
+ *  The first return value is the amount and the second is the value.
+ *  The lot keeps running totals by date, so this is cheap. */
 void gnc_lot_get_balance_before (const GNCLot *, const Split *,
                                  gnc_numeric *, gnc_numeric *);
 
@@ -154,23 +156,27 @@ void gnc_lot_get_balance_before (const GNCLot *, const Split *,
 gboolean gnc_lot_is_closed (GNCLot *);
 
 /** The gnc_lot_get_earliest_split() routine is a convenience routine
- *    that helps identify the earliest date in the lot.   It simply
- *    loops over all of the splits in the lot, and returns the split
- *    with the earliest split->transaction->date_posted.  It may not
+ *    that helps identify the earliest date in the lot.   It returns
+ *    the split with the earliest split->transaction->date_posted; the
+ *    lot keeps its splits sorted by date, so this is cheap.  It may not
  *    necessarily identify the lot opening split.
  */
 Split * gnc_lot_get_earliest_split (GNCLot *lot);
 
 /** The gnc_lot_get_latest_split() routine is a convenience routine
- *    that helps identify the date this lot was closed.   It simply
- *    loops over all of the splits in the lot, and returns the split
- *    with the latest split->transaction->date_posted.
+ *    that helps identify the date this lot was closed.   It returns
+ *    the split with the latest split->transaction->date_posted.
  */
 Split * gnc_lot_get_latest_split (GNCLot *lot);
 
 /** Reset closed flag so that it will be recalculated. */
 void gnc_lot_set_closed_unknown(GNCLot*);
 
+/** Tell the lot that the amount, value or date of one of its splits
+ *    changed.  Like gnc_lot_set_closed_unknown(), but only the cached
+ *    totals from that split on are recomputed. */
+void gnc_lot_split_changed (GNCLot *, Split *);
+
 /** Get and set the account title, or the account notes, or the marker. */
 const char * gnc_lot_get_title (const GNCLot *);
 const char * gnc_lot_get_notes (const GNCLot *);
@@ -660,20 +660,14 @@ gnc_numeric_positive_p(gnc_numeric a)
 int
 gnc_numeric_compare(gnc_numeric a, gnc_numeric b)
 {
-    gint64 aa, bb;
+    if (a.denom == b.denom && a.denom != 0)
+        return (a.num > b.num) - (a.num < b.num);
 
     if (gnc_numeric_check(a) || gnc_numeric_check(b))
     {
         return 0;
     }
 
-    if (a.denom == b.denom)
-    {
-        if (a.num == b.num) return 0;
-        if (a.num > b.num) return 1;
-        return -1;
-    }
-
     GncNumeric an (a), bn (b);
 
     return an.cmp(bn);
@@ -746,6 +740,22 @@ denom_lcd(gnc_numeric a, gnc_numeric b, int64_t denom, int how)
     return denom;
 }
 
+/* Amounts and values nearly always share their commodity's denominator,
+ * and adding or subtracting those needs no GncInt128 arithmetic as long
+ * as the result keeps that denominator. Reducing and significant figures
+ * change the denominator and the exact path rounds a zero result to 0/1,
+ * so those go the long way, as does a result that overflows.
+ */
+static inline bool
+same_denom_fast_path(gnc_numeric a, gnc_numeric b, int64_t denom, int how)
+{
+    auto dtype = how & GNC_NUMERIC_DENOM_MASK;
+    return a.denom == b.denom && a.denom > 0 &&
+        (denom == a.denom || denom == GNC_DENOM_AUTO) &&
+        dtype != GNC_HOW_DENOM_EXACT && dtype != GNC_HOW_DENOM_REDUCE &&
+        dtype != GNC_HOW_DENOM_SIGFIG;
+}
+
 /* *******************************************************************
  *  gnc_numeric_add
  ********************************************************************/
@@ -754,6 +764,11 @@ gnc_numeric
 gnc_numeric_add(gnc_numeric a, gnc_numeric b,
                 gint64 denom, gint how)
 {
+    int64_t num;
+    if (same_denom_fast_path(a, b, denom, how) &&
+        !__builtin_add_overflow(a.num, b.num, &num))
+        return {num, a.denom};
+
     if (gnc_numeric_check(a) || gnc_numeric_check(b))
     {
         return gnc_numeric_error(GNC_ERROR_ARG);
@@ -807,7 +822,11 @@ gnc_numeric
 gnc_numeric_sub(gnc_numeric a, gnc_numeric b,
                 gint64 denom, gint how)
 {
-    gnc_numeric nb;
+    int64_t num;
+    if (same_denom_fast_path(a, b, denom, how) &&
+        !__builtin_sub_overflow(a.num, b.num, &num))
+        return {num, a.denom};
+
     if (gnc_numeric_check(a) || gnc_numeric_check(b))
     {
         return gnc_numeric_error(GNC_ERROR_ARG);
@@ -853,6 +872,42 @@ gnc_numeric_sub(gnc_numeric a, gnc_numeric b,
     }
 }
 
+/* *******************************************************************
+ *  gnc_numeric_sum
+ ********************************************************************/
+
+gnc_numeric
+gnc_numeric_sum(const gnc_numeric *values, size_t n_values,
+                gint64 denom, gint how)
+{
+    if (!values || !n_values)
+        return gnc_numeric_zero();
+
+    auto sum = values[0];
+    if (!same_denom_fast_path(sum, sum, denom, how))
+        sum = gnc_numeric_add(gnc_numeric_zero(), sum, denom, how);
+
+    size_t i = 1;
+    if (same_denom_fast_path(sum, sum, denom, how))
+    {
+        /* Runs of values with the sum's denominator are added up here;
+         * anything else is left to gnc_numeric_add below. */
+        auto num = sum.num;
+        for (; i < n_values && values[i].denom == sum.denom; ++i)
+        {
+            int64_t next;
+            if (__builtin_add_overflow(num, values[i].num, &next))
+                break;
+            num = next;
+        }
+        sum.num = num;
+    }
+
+    for (; i < n_values; ++i)
+        sum = gnc_numeric_add(sum, values[i], denom, how);
+    return sum;
+}
+
 /* *******************************************************************
  *  gnc_numeric_mul
  ********************************************************************/
@@ -396,6 +396,15 @@ gnc_numeric gnc_numeric_add(gnc_numeric a, gnc_numeric b,
 gnc_numeric gnc_numeric_sub(gnc_numeric a, gnc_numeric b,
                             gint64 denom, gint how);
 
+/** Return the sum of the n_values values, as if they were added in turn
+ *  to zero with gnc_numeric_add(). Values sharing the denominator of the
+ *  running sum are added without any conversion, so summing the amounts
+ *  or values of many splits is much cheaper than a gnc_numeric_add()
+ *  loop.
+ */
+gnc_numeric gnc_numeric_sum(const gnc_numeric *values, size_t n_values,
+                            gint64 denom, gint how);
+
 /** Multiply a times b, returning the product.  An overflow
  *  may occur if the result of the multiplication can't
  *  be represented as a ratio of 64-bit int's after removing
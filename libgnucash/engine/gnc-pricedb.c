@@ -40,6 +40,7 @@ static gboolean remove_price(GNCPriceDB *db, GNCPrice *p, gboolean cleanup);
 static GNCPrice *lookup_nearest_in_time(GNCPriceDB *db, const gnc_commodity *c,
                                         const gnc_commodity *currency,
                                         time64 t, gboolean sameday);
+static PriceList *pricedb_price_list_merge (PriceList *a, PriceList *b);
 static gboolean
 pricedb_pricelist_traversal(GNCPriceDB *db,
                             gboolean (*f)(GList *p, gpointer user_data),
@@ -1188,6 +1189,311 @@ gnc_pricedb_add_price(GNCPriceDB *db, GNCPrice *p)
     return TRUE;
 }
 
+/* gnc_pricedb_add_prices() groups the incoming prices per commodity and
+ * currency. Each group then looks up its price lists once, finds prices
+ * on the same day in a hash table of days rather than by walking the list
+ * for every price, and merges all its new prices into the list in one go.
+ */
+
+typedef struct
+{
+    GNCPrice *price;
+    guint index;
+} PriceAddEntry;
+
+/* Orders prices by commodity and currency, keeping the prices of each
+ * pair in the order they were passed in. */
+static gint
+compare_price_add_entries (gconstpointer a, gconstpointer b)
+{
+    const PriceAddEntry *entry_a = a, *entry_b = b;
+    guintptr com_a = (guintptr)entry_a->price->commodity;
+    guintptr com_b = (guintptr)entry_b->price->commodity;
+    guintptr cur_a = (guintptr)entry_a->price->currency;
+    guintptr cur_b = (guintptr)entry_b->price->currency;
+
+    if (com_a != com_b)
+        return com_a < com_b ? -1 : 1;
+    if (cur_a != cur_b)
+        return cur_a < cur_b ? -1 : 1;
+    return entry_a->index < entry_b->index ? -1 :
+           entry_a->index > entry_b->index ? 1 : 0;
+}
+
+static gint64 *
+price_day_key (GNCPrice *p)
+{
+    gint64 *day = g_new (gint64, 1);
+    *day = time64CanonicalDayTime (gnc_price_get_time64 (p));
+    return day;
+}
+
+/* Adds the prices in the list to the table of prices per day, unless
+ * the day already has one. Lists are newest first, so it's the latest
+ * price of each day that is kept. */
+static void
+price_day_index_add_list (GHashTable *days, PriceList *prices)
+{
+    for (GList *node = prices; node; node = node->next)
+    {
+        gint64 *day = price_day_key (node->data);
+        if (g_hash_table_contains (days, day))
+            g_free (day);
+        else
+            g_hash_table_insert (days, day, node->data);
+    }
+}
+
+/* Removes the prices in the removed set from a price list, dropping the
+ * list's reference to them. */
+static PriceList *
+price_list_remove_set (PriceList *prices, GHashTable *removed)
+{
+    GList *node = prices;
+    while (node)
+    {
+        GList *next = node->next;
+        if (g_hash_table_contains (removed, node->data))
+        {
+            gnc_price_unref (node->data);
+            prices = g_list_delete_link (prices, node);
+        }
+        node = next;
+    }
+    return prices;
+}
+
+/* Stores a price list for a commodity and currency, dropping the
+ * currency and if need be the commodity from the hash tables if the list
+ * is empty. */
+static void
+pricedb_store_price_list (GNCPriceDB *db, gnc_commodity *commodity,
+                          gnc_commodity *currency, PriceList *prices)
+{
+    GHashTable *currency_hash = g_hash_table_lookup (db->commodity_hash, commodity);
+
+    if (prices)
+    {
+        if (!currency_hash)
+        {
+            currency_hash = g_hash_table_new (NULL, NULL);
+            g_hash_table_insert (db->commodity_hash, commodity, currency_hash);
+        }
+        g_hash_table_insert (currency_hash, currency, prices);
+    }
+    else if (currency_hash)
+    {
+        g_hash_table_remove (currency_hash, currency);
+        if (g_hash_table_size (currency_hash) == 0)
+        {
+            g_hash_table_remove (db->commodity_hash, commodity);
+            g_hash_table_destroy (currency_hash);
+        }
+    }
+}
+
+static PriceList *
+pricedb_lookup_price_list (GNCPriceDB *db, gnc_commodity *commodity,
+                           gnc_commodity *currency)
+{
+    GHashTable *currency_hash = g_hash_table_lookup (db->commodity_hash, commodity);
+    return currency_hash ? g_hash_table_lookup (currency_hash, currency) : NULL;
+}
+
+/* Adds the prices in entries[first..last) which all have the same
+ * commodity and currency. Prices they replace are added to removed. */
+static void
+pricedb_add_price_series (GNCPriceDB *db, PriceAddEntry *entries,
+                          guint first, guint last, PriceAddMode mode,
+                          GHashTable *removed, PriceAddCounts *counts)
+{
+    gnc_commodity *commodity = entries[first].price->commodity;
+    gnc_commodity *currency = entries[first].price->currency;
+    PriceList *prices = pricedb_lookup_price_list (db, commodity, currency);
+    PriceList *reverse = pricedb_lookup_price_list (db, currency, commodity);
+    PriceList *added = NULL;
+    GHashTable *days = NULL;
+    GHashTable *added_set = NULL;
+    gboolean changed = FALSE, reverse_changed = FALSE;
+
+    /* Like gnc_pricedb_lookup_day_t64, look for prices on the same day in
+     * either direction. */
+    if (!db->bulk_update)
+    {
+        days = g_hash_table_new_full (g_int64_hash, g_int64_equal, g_free, NULL);
+        added_set = g_hash_table_new (NULL, NULL);
+        price_day_index_add_list (days, prices);
+        price_day_index_add_list (days, reverse);
+    }
+
+    for (guint i = first; i < last; i++)
+    {
+        GNCPrice *p = entries[i].price;
+        GNCPrice *old_price = NULL;
+        gint64 *day = NULL;
+
+        if (days)
+        {
+            day = price_day_key (p);
+            old_price = g_hash_table_lookup (days, day);
+        }
+
+        if (old_price)
+        {
+            if (mode == PRICE_ADD_KEEP_EXISTING ||
+                (mode == PRICE_ADD_BY_SOURCE && p->source > old_price->source))
+            {
+                counts->skipped++;
+                g_free (day);
+                continue;
+            }
+
+            if (g_hash_table_remove (added_set, old_price))
+            {
+                /* Replacing a price from this same call */
+                added = g_list_remove (added, old_price);
+                gnc_price_unref (old_price);
+                counts->added--;
+                counts->skipped++;
+            }
+            else
+            {
+                if (old_price->currency == commodity)
+                    reverse_changed = TRUE;
+                else
+                    changed = TRUE;
+                gnc_price_ref (old_price);
+                g_hash_table_add (removed, old_price);
+                counts->replaced++;
+            }
+        }
+
+        gnc_price_ref (p);
+        added = g_list_prepend (added, p);
+        counts->added++;
+        if (days)
+        {
+            g_hash_table_add (added_set, p);
+            g_hash_table_replace (days, day, p);
+        }
+    }
+
+    if (days)
+    {
+        g_hash_table_destroy (days);
+        g_hash_table_destroy (added_set);
+    }
+
+    if (changed)
+        prices = price_list_remove_set (prices, removed);
+    if (reverse_changed)
+    {
+        reverse = price_list_remove_set (reverse, removed);
+        pricedb_store_price_list (db, currency, commodity, reverse);
+    }
+
+    if (added)
+    {
+        PriceList *merged;
+
+        added = g_list_sort (added, compare_prices_by_date);
+        merged = pricedb_price_list_merge (prices, added);
+        for (GList *node = added; node; node = node->next)
+        {
+            GNCPrice *p = node->data;
+            p->db = db;
+            qof_event_gen (&p->inst, QOF_EVENT_ADD, NULL);
+        }
+        g_list_free (prices);
+        g_list_free (added);
+        prices = merged;
+    }
+    pricedb_store_price_list (db, commodity, currency, prices);
+}
+
+guint
+gnc_pricedb_add_prices (GNCPriceDB *db, PriceList *prices, PriceAddMode mode,
+                        PriceAddCounts *counts)
+{
+    PriceAddCounts local_counts = {0, 0, 0};
+    GArray *entries;
+    PriceAddEntry *e;
+    GHashTable *removed;
+    GHashTableIter iter;
+    gpointer key;
+    guint index = 0;
+
+    if (!counts)
+        counts = &local_counts;
+    else
+        memset (counts, 0, sizeof (*counts));
+
+    if (!db || !db->commodity_hash) return 0;
+    ENTER ("db=%p, %u prices", db, g_list_length (prices));
+
+    /* Drop the prices add_price would refuse */
+    entries = g_array_new (FALSE, FALSE, sizeof (PriceAddEntry));
+    for (GList *node = prices; node; node = node->next, index++)
+    {
+        GNCPrice *p = node->data;
+        PriceAddEntry entry = { p, index };
+
+        if (!p || !p->commodity || !p->currency ||
+            !qof_instance_books_equal (db, p))
+        {
+            PWARN ("skipping price %p without commodity, currency or in another book", p);
+            counts->skipped++;
+            continue;
+        }
+        g_array_append_val (entries, entry);
+    }
+    g_array_sort (entries, compare_price_add_entries);
+
+    removed = g_hash_table_new (NULL, NULL);
+    qof_event_begin_batch ();
+
+    e = (PriceAddEntry*)entries->data;
+    for (guint first = 0; first < entries->len;)
+    {
+        guint last = first + 1;
+        while (last < entries->len &&
+               e[last].price->commodity == e[first].price->commodity &&
+               e[last].price->currency == e[first].price->currency)
+            last++;
+
+        pricedb_add_price_series (db, e, first, last, mode, removed, counts);
+        first = last;
+    }
+
+    /* Let the backend delete the replaced prices */
+    g_hash_table_iter_init (&iter, removed);
+    while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+        GNCPrice *p = key;
+        qof_event_gen (&p->inst, QOF_EVENT_REMOVE, NULL);
+        gnc_price_begin_edit (p);
+        qof_instance_set_destroying (p, TRUE);
+        gnc_price_commit_edit (p);
+        p->db = NULL;
+        gnc_price_unref (p);
+    }
+
+    if (counts->added)
+    {
+        gnc_pricedb_begin_edit (db);
+        qof_instance_set_dirty (&db->inst);
+        gnc_pricedb_commit_edit (db);
+    }
+
+    qof_event_end_batch ();
+    g_hash_table_destroy (removed);
+    g_array_free (entries, TRUE);
+
+    LEAVE ("db=%p, added %u, replaced %u, skipped %u",
+           db, counts->added, counts->replaced, counts->skipped);
+    return counts->added;
+}
+
 /* remove_price() is a utility; its only function is to remove the price
  * from the double-hash tables.
  */
@@ -1667,8 +1973,6 @@ gnc_pricedb_remove_old_prices (GNCPriceDB *db, GList *comm_list,
 /* ==================================================================== */
 /* lookup/query functions */
 
-static PriceList *pricedb_price_list_merge (PriceList *a, PriceList *b);
-
 static void
 hash_values_helper(gpointer key, gpointer value, gpointer data)
 {
@@ -370,6 +370,46 @@ void gnc_pricedb_set_bulk_update(GNCPriceDB *db, gboolean bulk_update);
  */
 gboolean     gnc_pricedb_add_price(GNCPriceDB *db, GNCPrice *p);
 
+/** How gnc_pricedb_add_prices() treats a new price when the pricedb already
+ * has a price for the same commodity and currency on the same day.
+ */
+typedef enum
+{
+    PRICE_ADD_BY_SOURCE,     // replace it unless its source takes precedence
+    PRICE_ADD_REPLACE,       // always replace it
+    PRICE_ADD_KEEP_EXISTING, // keep it and skip the new price
+} PriceAddMode;
+
+/** What gnc_pricedb_add_prices() did with the prices it was passed. */
+typedef struct
+{
+    guint added;    // prices added to the pricedb
+    guint replaced; // existing prices that were removed for a new one
+    guint skipped;  // prices that were not added
+} PriceAddCounts;
+
+/** @brief Add a list of prices to the pricedb in one go.
+ *
+ * This gives the same result as adding the prices one by one, but is much
+ * faster for large numbers of prices: the prices are grouped per commodity
+ * and currency and merged into the pricedb a group at a time, the pricedb is
+ * committed once and the events for the prices are delivered as a single
+ * batch. With PRICE_ADD_BY_SOURCE a price on a day that already has one is
+ * handled like gnc_pricedb_add_price() does.
+ *
+ * Unlike gnc_pricedb_add_price() this never takes over the caller's
+ * reference to a price, so you should drop your references afterwards
+ * whether the prices were added or not.
+ * @param db The pricedb
+ * @param prices The GNCPrices to add. Prices for the same commodity,
+ * currency and day are considered in list order.
+ * @param mode How to deal with a price on a day that already has one
+ * @param counts If not NULL, filled in with what happened to the prices
+ * @return The number of prices added.
+ */
+guint        gnc_pricedb_add_prices(GNCPriceDB *db, PriceList *prices,
+                                    PriceAddMode mode, PriceAddCounts *counts);
+
 /** @brief Remove a price from the pricedb and unref the price.
  * @param db The Pricedb
  * @param p The price to remove.
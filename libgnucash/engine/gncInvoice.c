@@ -1252,6 +1252,7 @@ gncInvoiceDetachFromLot (GNCLot *lot)
     qof_instance_set (QOF_INSTANCE (lot), "invoice", NULL, NULL);
     gnc_lot_commit_edit (lot);
     gnc_lot_set_cached_invoice (lot, NULL);
+    gncOwnerLotIndexUpdate (lot);
 }
 
 void
@@ -1268,6 +1269,7 @@ gncInvoiceAttachToLot (GncInvoice *invoice, GNCLot *lot)
     gnc_lot_commit_edit (lot);
     gnc_lot_set_cached_invoice (lot, invoice);
     gncInvoiceSetPostedLot (invoice, lot);
+    gncOwnerLotIndexUpdate (lot);
 }
 
 GncInvoice * gncInvoiceGetInvoiceFromLot (GNCLot *lot)
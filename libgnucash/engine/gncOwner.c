@@ -632,6 +632,7 @@ void gncOwnerAttachToLot (const GncOwner *owner, GNCLot *lot)
 		      GNC_OWNER_GUID, gncOwnerGetGUID (owner),
 		      NULL);
     gnc_lot_commit_edit (lot);
+    gncOwnerLotIndexUpdate (lot);
 }
 
 gboolean gncOwnerGetOwnerFromLot (GNCLot *lot, GncOwner *owner)
@@ -703,28 +704,263 @@ gboolean gncOwnerIsValid (const GncOwner *owner)
     return (owner->owner.undefined != NULL);
 }
 
-gboolean
-gncOwnerLotMatchOwnerFunc (GNCLot *lot, gpointer user_data)
+/* Determine the end owner associated to the lot, using lot_owner as
+ * storage if the owner has to be read from the lot itself. */
+static const GncOwner *
+lot_get_end_owner (GNCLot *lot, GncOwner *lot_owner)
 {
-    const GncOwner *req_owner = user_data;
-    GncOwner lot_owner;
-    const GncOwner *end_owner;
     GncInvoice *invoice = gncInvoiceGetInvoiceFromLot (lot);
 
-    /* Determine the owner associated to the lot */
     if (invoice)
         /* Invoice lots */
-        end_owner = gncOwnerGetEndOwner (gncInvoiceGetOwner (invoice));
-    else if (gncOwnerGetOwnerFromLot (lot, &lot_owner))
+        return gncOwnerGetEndOwner (gncInvoiceGetOwner (invoice));
+    else if (gncOwnerGetOwnerFromLot (lot, lot_owner))
         /* Pre-payment lots */
-        end_owner = gncOwnerGetEndOwner (&lot_owner);
-    else
+        return gncOwnerGetEndOwner (lot_owner);
+
+    return NULL;
+}
+
+gboolean
+gncOwnerLotMatchOwnerFunc (GNCLot *lot, gpointer user_data)
+{
+    const GncOwner *req_owner = user_data;
+    GncOwner lot_owner;
+    const GncOwner *end_owner = lot_get_end_owner (lot, &lot_owner);
+
+    if (!end_owner)
         return FALSE;
 
     /* Is this a lot for the requested owner ? */
     return gncOwnerEqual (end_owner, req_owner);
 }
 
+/* ============================================================== */
+/* Owner to lot index
+ *
+ * Finding an owner's lots would otherwise mean visiting every lot of
+ * every account and reading the owner back from each lot's kvp.  The index
+ * maps the GUID of each end owner (customer, vendor or employee) to the set
+ * of lots belonging to it.  It is built per book on first use and kept up
+ * to date by the lot attach/detach functions and by lot, invoice and job
+ * events.  Whether a lot is open is checked at lookup time, as lots open
+ * and close with every split added to them.
+ */
+
+#define GNC_OWNER_LOT_INDEX "gncOwnerLotIndex"
+
+typedef struct
+{
+    GHashTable *owner_lots;     /* end owner GncGUID* -> set of GNCLot* */
+    GHashTable *lot_owner;      /* GNCLot* -> end owner GncGUID* */
+    gboolean stale;
+} OwnerLotIndex;
+
+static gint owner_lot_index_handler_id = 0;
+static void owner_lot_index_handle_events (QofInstance *entity,
+                                           QofEventId event_type,
+                                           gpointer user_data,
+                                           gpointer event_data);
+
+static void
+owner_lot_index_remove (OwnerLotIndex *index, GNCLot *lot)
+{
+    GncGUID *guid = g_hash_table_lookup (index->lot_owner, lot);
+    GHashTable *lots;
+
+    if (!guid) return;
+
+    lots = g_hash_table_lookup (index->owner_lots, guid);
+    if (lots)
+    {
+        g_hash_table_remove (lots, lot);
+        if (g_hash_table_size (lots) == 0)
+            g_hash_table_remove (index->owner_lots, guid);
+    }
+    g_hash_table_remove (index->lot_owner, lot);
+}
+
+static void
+owner_lot_index_add (OwnerLotIndex *index, GNCLot *lot)
+{
+    GncOwner lot_owner;
+    const GncOwner *end_owner;
+    const GncGUID *guid;
+    GHashTable *lots;
+
+    owner_lot_index_remove (index, lot);
+    if (qof_instance_get_destroying (lot))
+        return;
+
+    end_owner = lot_get_end_owner (lot, &lot_owner);
+    if (!gncOwnerIsValid (end_owner))
+        return;
+
+    guid = gncOwnerGetGUID (end_owner);
+    lots = g_hash_table_lookup (index->owner_lots, guid);
+    if (!lots)
+    {
+        lots = g_hash_table_new (g_direct_hash, g_direct_equal);
+        g_hash_table_insert (index->owner_lots, guid_copy (guid), lots);
+    }
+    g_hash_table_add (lots, lot);
+    g_hash_table_insert (index->lot_owner, lot, guid_copy (guid));
+}
+
+static void
+owner_lot_index_add_cb (QofInstance *inst, gpointer data)
+{
+    owner_lot_index_add ((OwnerLotIndex *)data, GNC_LOT (inst));
+}
+
+static void
+owner_lot_index_free (QofBook *book, gpointer key, gpointer data)
+{
+    OwnerLotIndex *index = data;
+
+    g_hash_table_destroy (index->owner_lots);
+    g_hash_table_destroy (index->lot_owner);
+    g_free (index);
+}
+
+/* Return the index of the book, (re)building it if needed. */
+static OwnerLotIndex *
+owner_lot_index_get (QofBook *book)
+{
+    OwnerLotIndex *index;
+
+    if (!book) return NULL;
+
+    index = qof_book_get_data (book, GNC_OWNER_LOT_INDEX);
+    if (!index)
+    {
+        index = g_new0 (OwnerLotIndex, 1);
+        index->owner_lots = g_hash_table_new_full (guid_hash_to_guint,
+                                                   guid_g_hash_table_equal,
+                                                   (GDestroyNotify)guid_free,
+                                                   (GDestroyNotify)g_hash_table_destroy);
+        index->lot_owner = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                                  NULL, (GDestroyNotify)guid_free);
+        index->stale = TRUE;
+        qof_book_set_data_fin (book, GNC_OWNER_LOT_INDEX, index,
+                               owner_lot_index_free);
+
+        if (owner_lot_index_handler_id == 0)
+            owner_lot_index_handler_id =
+                qof_event_register_handler (owner_lot_index_handle_events, NULL);
+    }
+
+    if (index->stale)
+    {
+        g_hash_table_remove_all (index->lot_owner);
+        g_hash_table_remove_all (index->owner_lots);
+        qof_collection_foreach (qof_book_get_collection (book, GNC_ID_LOT),
+                                owner_lot_index_add_cb, index);
+        index->stale = FALSE;
+    }
+    return index;
+}
+
+/* Return the index of the book only if it has been built, so that
+ * updates don't force building an index nobody asked for. */
+static OwnerLotIndex *
+owner_lot_index_peek (QofBook *book)
+{
+    OwnerLotIndex *index;
+
+    if (!book || qof_book_shutting_down (book)) return NULL;
+
+    index = qof_book_get_data (book, GNC_OWNER_LOT_INDEX);
+    if (!index || index->stale) return NULL;
+    return index;
+}
+
+void
+gncOwnerLotIndexUpdate (GNCLot *lot)
+{
+    OwnerLotIndex *index;
+
+    if (!lot) return;
+    index = owner_lot_index_peek (gnc_lot_get_book (lot));
+    if (index)
+        owner_lot_index_add (index, lot);
+}
+
+static void
+owner_lot_index_handle_events (QofInstance *entity, QofEventId event_type,
+                               gpointer user_data, gpointer event_data)
+{
+    OwnerLotIndex *index;
+
+    if (!(GNC_IS_LOT (entity) || GNC_IS_INVOICE (entity) || GNC_IS_JOB (entity)))
+        return;
+
+    index = owner_lot_index_peek (qof_instance_get_book (entity));
+    if (!index) return;
+
+    if (GNC_IS_LOT (entity))
+    {
+        GNCLot *lot = GNC_LOT (entity);
+        if (event_type & QOF_EVENT_DESTROY)
+            owner_lot_index_remove (index, lot);
+        else if (event_type & (QOF_EVENT_CREATE | QOF_EVENT_MODIFY))
+            owner_lot_index_add (index, lot);
+    }
+    else if (GNC_IS_INVOICE (entity) && (event_type & QOF_EVENT_MODIFY))
+    {
+        GNCLot *lot = gncInvoiceGetPostedLot (GNC_INVOICE (entity));
+        if (lot)
+            owner_lot_index_add (index, lot);
+    }
+    else if (event_type & (QOF_EVENT_MODIFY | QOF_EVENT_DESTROY))
+    {
+        /* A job may have moved to another owner, taking its lots along,
+         * and a destroyed invoice leaves its lot's owner to be reread. */
+        index->stale = TRUE;
+    }
+}
+
+/* Collect the open lots of owner, optionally restricted to account. */
+static GList *
+owner_lot_index_find_open_lots (const GncOwner *owner, const Account *account)
+{
+    OwnerLotIndex *index;
+    GHashTable *lots;
+    GHashTableIter iter;
+    gpointer key;
+    GList *retval = NULL;
+
+    index = owner_lot_index_get (qof_instance_get_book (qofOwnerGetOwner (owner)));
+    if (!index) return NULL;
+
+    lots = g_hash_table_lookup (index->owner_lots, gncOwnerGetGUID (owner));
+    if (!lots) return NULL;
+
+    g_hash_table_iter_init (&iter, lots);
+    while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+        GNCLot *lot = key;
+
+        if (account && gnc_lot_get_account (lot) != account)
+            continue;
+        if (gnc_lot_is_closed (lot))
+            continue;
+        retval = g_list_prepend (retval, lot);
+    }
+    return retval;
+}
+
+GList *
+gncOwnerGetOpenLots (const GncOwner *owner, const Account *account)
+{
+    GList *lots;
+
+    if (!gncOwnerIsValid (owner)) return NULL;
+
+    lots = owner_lot_index_find_open_lots (owner, account);
+    return g_list_sort (lots, (GCompareFunc)gncOwnerLotsSortFunc);
+}
+
 gint
 gncOwnerLotsSortFunc (GNCLot *lotA, GNCLot *lotB)
 {
@@ -1495,42 +1731,36 @@ gncOwnerGetBalanceInCurrency (const GncOwner *owner,
         balance = *cached_balance;
     else
     {
-        /* No valid cache value found for balance. Let's recalculate */
-        GList *acct_list  = gnc_account_get_descendants (gnc_book_get_root_account (book));
+        /* No valid cache value found for balance. Let's recalculate
+         * from the owner's open lots. */
+        GList *lot_list   = owner_lot_index_find_open_lots (owner, NULL);
         GList *acct_types = gncOwnerGetAccountTypesList (owner);
-        GList *acct_node;
+        GList *lot_node;
 
-        /* For each account */
-        for (acct_node = acct_list; acct_node; acct_node = acct_node->next)
+        /* For each lot */
+        for (lot_node = lot_list; lot_node; lot_node = lot_node->next)
         {
-            Account *account = acct_node->data;
-            GList *lot_list = NULL, *lot_node;
-
-            /* Check if this account can have lots for the owner, otherwise skip to next */
-            if (g_list_index (acct_types, (gpointer)xaccAccountGetType (account))
-                    == -1)
+            GNCLot *lot = lot_node->data;
+            Account *account = gnc_lot_get_account (lot);
+            gnc_numeric lot_balance;
+            GncInvoice *invoice;
+
+            /* Only consider lots in accounts that can hold the owner's
+             * documents, in the owner's currency */
+            if (!account ||
+                g_list_index (acct_types, (gpointer)xaccAccountGetType (account)) == -1)
                 continue;
 
-
             if (!gnc_commodity_equal (owner_currency, xaccAccountGetCommodity (account)))
                 continue;
 
-            /* Get a list of open lots for this owner and account */
-            lot_list = xaccAccountFindOpenLots (account, gncOwnerLotMatchOwnerFunc,
-                                                (gpointer)owner, NULL);
-            /* For each lot */
-            for (lot_node = lot_list; lot_node; lot_node = lot_node->next)
-            {
-                GNCLot *lot = lot_node->data;
-                gnc_numeric lot_balance = gnc_lot_get_balance (lot);
-                GncInvoice *invoice = gncInvoiceGetInvoiceFromLot(lot);
-                if (invoice)
+            lot_balance = gnc_lot_get_balance (lot);
+            invoice = gncInvoiceGetInvoiceFromLot(lot);
+            if (invoice)
                 balance = gnc_numeric_add (balance, lot_balance,
-                                            gnc_commodity_get_fraction (owner_currency), GNC_HOW_RND_ROUND_HALF_UP);
-            }
-            g_list_free (lot_list);
+                                           gnc_commodity_get_fraction (owner_currency), GNC_HOW_RND_ROUND_HALF_UP);
         }
-        g_list_free (acct_list);
+        g_list_free (lot_list);
         g_list_free (acct_types);
 
         gncOwnerSetCachedBalance (owner, &balance);
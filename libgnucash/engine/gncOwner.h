@@ -186,6 +186,16 @@ void gncOwnerAttachToLot (const GncOwner *owner, GNCLot *lot);
  */
 gboolean gncOwnerLotMatchOwnerFunc (GNCLot *lot, gpointer user_data);
 
+/** Get the open lots whose end owner is the given owner, sorted with
+ * gncOwnerLotsSortFunc.  If account is not NULL only lots in that
+ * account are returned.  The lots are found through a per-book owner to
+ * lot index, so this is proportional to the number of lots of the owner
+ * rather than to the number of lots in the book.
+ *
+ * The list must be freed by the caller, but not its elements.
+ */
+GList * gncOwnerGetOpenLots (const GncOwner *owner, const Account *account);
+
 /** Helper function used to sort lots by date. If the lot is
  * linked to an invoice, use the invoice posted date, otherwise
  * use the lot's opened date.
@@ -33,6 +33,9 @@
 gboolean gncOwnerRegister (void);
 const gnc_numeric *gncOwnerGetCachedBalance (const GncOwner *owner);
 void gncOwnerSetCachedBalance (const GncOwner *owner, const gnc_numeric *new_bal);
+/** Refresh the lot's entry in the owner to lot index after its owner
+ *  or invoice has been changed. */
+void gncOwnerLotIndexUpdate (GNCLot *lot);
 
 
 #endif /* GNC_OWNERP_H_ */
@@ -50,12 +50,20 @@ extern "C"
 #ifdef HAVE_UNISTD_H
 # include <unistd.h>
 #endif
+#ifdef HAVE_LIBPTHREAD
+# include <pthread.h>
+#endif
 #include "qof.h"
 
 }
+#include <boost/version.hpp>
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_generators.hpp>
 #include <boost/uuid/uuid_io.hpp>
+#if BOOST_VERSION >= 106700
+#include <boost/uuid/detail/random_provider.hpp>
+#endif
+#include <array>
 #include <sstream>
 #include <string>
 
@@ -88,6 +96,118 @@ GncGUID * guid_convert_create (gnc::GUID const &);
 static gnc::GUID s_null_guid {boost::uuids::uuid { {0}}};
 static GncGUID * s_null_gncguid {guid_convert_create (s_null_guid)};
 
+/* Random guids ******************************************************/
+
+/* boost's random_generator reads the system's random source once for
+ * each guid. Read enough for a few hundred at a time instead and hand
+ * them out from a per-thread buffer.
+ */
+static constexpr size_t s_guid_buffer_size = 256;
+
+struct GUIDBuffer
+{
+    std::array<boost::uuids::uuid, s_guid_buffer_size> guids;
+    size_t next = s_guid_buffer_size;
+};
+
+static thread_local GUIDBuffer s_guid_buffer;
+
+#ifdef HAVE_LIBPTHREAD
+/* A forked child must not hand out the same guids as its parent. The
+ * child only has the thread that called fork, so that's the only buffer
+ * to empty.
+ */
+static void
+guid_buffer_discard (void)
+{
+    s_guid_buffer.next = s_guid_buffer_size;
+}
+#endif
+
+static void
+guid_buffer_refill (GUIDBuffer& buffer)
+{
+#ifdef HAVE_LIBPTHREAD
+    static int registered = pthread_atfork (nullptr, nullptr,
+                                            guid_buffer_discard);
+    (void)registered;
+#endif
+#if BOOST_VERSION >= 106700
+    static thread_local boost::uuids::detail::random_provider provider;
+    provider.get_random_bytes (buffer.guids.data (), sizeof (buffer.guids));
+    /* Mark them as version 4 (random) uuids as random_generator does. */
+    for (auto& guid : buffer.guids)
+    {
+        guid.data[6] = (guid.data[6] & 0x0f) | 0x40;
+        guid.data[8] = (guid.data[8] & 0x3f) | 0x80;
+    }
+#else
+    static thread_local boost::uuids::random_generator gen;
+    for (auto& guid : buffer.guids)
+        guid = gen ();
+#endif
+    buffer.next = 0;
+}
+
+/* Hex encoding ******************************************************/
+
+/* guid_to_string_buff and string_to_guid are called for every object
+ * the XML and SQL backends load or save, so they convert a byte at a
+ * time with lookup tables instead of going through boost's streams.
+ */
+static constexpr auto s_hex_pairs = []
+{
+    constexpr char digits[] = "0123456789abcdef";
+    std::array<std::array<char, 2>, 256> pairs {};
+    for (auto i = 0; i < 256; ++i)
+        pairs[i] = {digits[i >> 4], digits[i & 0xf]};
+    return pairs;
+}();
+
+static constexpr unsigned char s_not_hex {0xff};
+static constexpr auto s_hex_values = []
+{
+    std::array<unsigned char, 256> values {};
+    for (auto i = 0; i < 256; ++i)
+        values[i] = s_not_hex;
+    for (auto i = 0; i < 10; ++i)
+        values['0' + i] = i;
+    for (auto i = 0; i < 6; ++i)
+        values['a' + i] = values['A' + i] = 10 + i;
+    return values;
+}();
+
+static char *
+guid_encode_hex (const unsigned char *bytes, char *str) noexcept
+{
+    for (auto i = 0; i < GUID_DATA_SIZE; ++i, str += 2)
+        memcpy (str, s_hex_pairs[bytes[i]].data (), 2);
+    *str = '\0';
+    return str;
+}
+
+/* Decodes exactly GUID_ENCODING_LENGTH hex digits followed by a null.
+ * Anything else is left to boost's more forgiving parser. */
+static bool
+guid_decode_hex (const char *str, unsigned char *bytes) noexcept
+{
+    unsigned char decoded[GUID_DATA_SIZE];
+    for (auto i = 0; i < GUID_DATA_SIZE; ++i)
+    {
+        auto high = s_hex_values[static_cast<unsigned char> (*str++)];
+        if (high == s_not_hex)
+            return false;
+        auto low = s_hex_values[static_cast<unsigned char> (*str++)];
+        if (low == s_not_hex)
+            return false;
+        decoded[i] = (high << 4) | low;
+    }
+    if (*str)
+        return false;
+    memcpy (bytes, decoded, GUID_DATA_SIZE);
+    return true;
+}
+
 /* Memory management routines ***************************************/
 
 /**
@@ -148,6 +268,23 @@ guid_replace (GncGUID *guid)
     guid_assign (*guid, temp_random);
 }
 
+void
+guid_replace_batch (GncGUID *guids, gsize count)
+{
+    if (!guids) return;
+    auto& buffer = s_guid_buffer;
+    while (count)
+    {
+        if (buffer.next == s_guid_buffer_size)
+            guid_buffer_refill (buffer);
+        auto n = std::min (count, s_guid_buffer_size - buffer.next);
+        memcpy (guids, &buffer.guids[buffer.next], n * sizeof (GncGUID));
+        buffer.next += n;
+        guids += n;
+        count -= n;
+    }
+}
+
 GncGUID *
 guid_new (void)
 {
@@ -165,29 +302,24 @@ gchar *
 guid_to_string (const GncGUID * guid)
 {
     if (!guid) return nullptr;
-    gnc::GUID temp {*guid};
-    auto temp_str = temp.to_string ();
-    return g_strdup (temp_str.c_str ());
+    auto str = static_cast<gchar*> (g_malloc (GUID_ENCODING_LENGTH + 1));
+    guid_encode_hex (guid->reserved, str);
+    return str;
 }
 
 gchar *
 guid_to_string_buff (const GncGUID * guid, gchar *str)
 {
     if (!str || !guid) return NULL;
-
-    gnc::GUID temp {*guid};
-    auto val = temp.to_string ();
-    /*We need to be sure to copy the terminating null character.
-     * The standard guarantees that std::basic_string::c_str ()
-     * returns with a terminating null character, too.*/
-    std::copy (val.c_str (), val.c_str () + val.size () + 1, str);
-    return str + val.size ();
+    return guid_encode_hex (guid->reserved, str);
 }
 
 gboolean
 string_to_guid (const char * str, GncGUID * guid)
 {
     if (!guid || !str) return false;
+    if (guid_decode_hex (str, guid->reserved))
+        return true;
 
     try
     {
@@ -205,9 +337,7 @@ guid_equal (const GncGUID *guid_1, const GncGUID *guid_2)
 {
     if (!guid_1 || !guid_2)
         return !guid_1 && !guid_2;
-    gnc::GUID temp1 {*guid_1};
-    gnc::GUID temp2 {*guid_2};
-    return temp1 == temp2;
+    return memcmp (guid_1, guid_2, sizeof (GncGUID)) == 0;
 }
 
 gint
@@ -215,35 +345,39 @@ guid_compare (const GncGUID *guid_1, const GncGUID *guid_2)
 {
     if (!guid_1 || !guid_2)
         return !guid_1 && !guid_2;
-    gnc::GUID temp1 {*guid_1};
-    gnc::GUID temp2 {*guid_2};
-    if (temp1 < temp2)
-        return -1;
-    if (temp1 == temp2)
-        return 0;
-    return 1;
+    auto cmp = memcmp (guid_1, guid_2, sizeof (GncGUID));
+    return cmp < 0 ? -1 : cmp > 0 ? 1 : 0;
 }
 
-guint
-guid_hash_to_guint (gconstpointer ptr)
+guint64
+guid_hash_to_guint64 (gconstpointer ptr)
 {
     if (!ptr)
     {
         PERR ("received NULL guid pointer.");
         return 0;
     }
-    GncGUID const & guid = * reinterpret_cast <GncGUID const *> (ptr);
-    gnc::GUID const & temp {guid};
-
-    guint hash {0};
-    unsigned retspot {0};
-    std::for_each (temp.begin (), temp.end (), [&hash] (unsigned char a) {
-        hash <<=4;
-        hash |= a;
-    });
+    guint64 low, high;
+    memcpy (&low, ptr, sizeof (low));
+    memcpy (&high, static_cast<const char*> (ptr) + sizeof (low), sizeof (high));
+    /* Random guids would hash well enough by themselves but not all guids
+     * are random, so mix them with the murmur3 finalizer. */
+    auto hash = low ^ (high * UINT64_C(0x9e3779b97f4a7c15));
+    hash ^= hash >> 33;
+    hash *= UINT64_C(0xff51afd7ed558ccd);
+    hash ^= hash >> 33;
+    hash *= UINT64_C(0xc4ceb9fe1a85ec53);
+    hash ^= hash >> 33;
     return hash;
 }
 
+guint
+guid_hash_to_guint (gconstpointer ptr)
+{
+    auto hash = guid_hash_to_guint64 (ptr);
+    return static_cast<guint> (hash ^ (hash >> 32));
+}
+
 gint
 guid_g_hash_table_equal (gconstpointer guid_a, gconstpointer guid_b)
 {
@@ -318,8 +452,10 @@ namespace gnc
 GUID
 GUID::create_random () noexcept
 {
-    static boost::uuids::random_generator gen;
-    return {gen ()};
+    auto& buffer = s_guid_buffer;
+    if (buffer.next == s_guid_buffer_size)
+        guid_buffer_refill (buffer);
+    return {buffer.guids[buffer.next++]};
 }
 
 GUID::GUID (boost::uuids::uuid const & other) noexcept
@@ -336,17 +472,18 @@ GUID::null_guid () noexcept
 std::string
 GUID::to_string () const noexcept
 {
-    auto const & val = boost::uuids::to_string (implementation);
-    std::string ret;
-    std::for_each (val.begin (), val.end (), [&ret] (char a) {
-        if (a != '-') ret.push_back (a);
-    });
+    std::string ret (GUID_ENCODING_LENGTH, '0');
+    guid_encode_hex (implementation.data, &ret[0]);
     return ret;
 }
 
 GUID
 GUID::from_string (std::string const & str)
 {
+    GUID ret;
+    if (str.size () == GUID_ENCODING_LENGTH &&
+        guid_decode_hex (str.c_str (), ret.implementation.data))
+        return ret;
     try
     {
         static boost::uuids::string_generator strgen;
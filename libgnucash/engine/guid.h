@@ -96,6 +96,19 @@ void guid_replace (GncGUID *guid);
  */
 GncGUID guid_new_return (void);
 
+/** Generate count new guids.
+ *
+ *  This is quicker than calling guid_replace() count times when many
+ *  guids are needed at once, for example when creating or loading a
+ *  lot of objects.
+ *
+ *  @param guids A pointer to an array of at least count guids, all of
+ *  which are replaced with new values.
+ *
+ *  @param count The number of guids to generate.
+ */
+void guid_replace_batch (GncGUID *guids, gsize count);
+
 /** Returns a GncGUID which is guaranteed to never reference any entity.
  * 
  * Do not free this value! The same pointer is returned on each call.*/
@@ -174,6 +187,11 @@ gint     guid_compare(const GncGUID *g1, const GncGUID *g2);
 /** Hash function for a GUID. Given a GncGUID *, hash it to a guint */
 guint guid_hash_to_guint(gconstpointer ptr);
 
+/** Hash function for a GUID. Given a GncGUID *, hash it to a guint64
+ *  with every bit depending on every byte of the guid, for use in hash
+ *  tables that take their bucket from either end of the hash. */
+guint64 guid_hash_to_guint64(gconstpointer ptr);
+
 /** Equality function for two GUIDs in a GHashTable. */
 gint guid_g_hash_table_equal (gconstpointer guid_a, gconstpointer guid_b);
 
@@ -68,6 +68,38 @@ KvpFrameImpl::~KvpFrameImpl() noexcept
     m_valuemap.clear();
 }
 
+static QofSlab<KvpFrameImpl>&
+kvp_frame_slab ()
+{
+    /* Never destroyed, so frames freed during static destruction are safe. */
+    static auto slab = new QofSlab<KvpFrameImpl>;
+    return *slab;
+}
+
+void*
+KvpFrameImpl::operator new(std::size_t size)
+{
+    return kvp_frame_slab ().allocate(size);
+}
+
+void
+KvpFrameImpl::operator delete(void* ptr, std::size_t size) noexcept
+{
+    kvp_frame_slab ().deallocate(ptr, size);
+}
+
+const QofSlabStats&
+KvpFrameImpl::slab_stats() noexcept
+{
+    return kvp_frame_slab ().stats();
+}
+
+bool
+KvpFrameImpl::release_slab() noexcept
+{
+    return kvp_frame_slab ().release();
+}
+
 KvpFrame *
 KvpFrame::get_child_frame_or_nullptr (Path const & path) noexcept
 {
@@ -85,6 +85,7 @@
 #define GNC_KVP_FRAME_TYPE
 
 #include "kvp-value.hpp"
+#include "qof-slab.hpp"
 #include <map>
 #include <string>
 #include <vector>
@@ -133,6 +134,16 @@ struct KvpFrameImpl
      */
     ~KvpFrameImpl() noexcept;
 
+    /** KvpFrames are allocated from a QofSlab; see qof-slab.hpp. */
+    static void* operator new(std::size_t size);
+    static void operator delete(void* ptr, std::size_t size) noexcept;
+    /** Allocation counts of the slab KvpFrames come from. */
+    static const QofSlabStats& slab_stats() noexcept;
+    /** Return the slab's memory to the system if no KvpFrame is alive.
+     * @return true if the slab is empty.
+     */
+    static bool release_slab() noexcept;
+
     /**
      * Set the value with the key in the immediate frame, replacing and
      * returning the old value if it exists or nullptr if it doesn't. Takes
@@ -224,6 +235,8 @@ struct KvpFrameImpl
      * @return true if the frame contains nothing.
      */
     bool empty() const noexcept { return m_valuemap.empty(); }
+    /** @return the number of slots directly in this frame. */
+    std::size_t size() const noexcept { return m_valuemap.size(); }
     friend int compare(const KvpFrameImpl&, const KvpFrameImpl&) noexcept;
 
     private:
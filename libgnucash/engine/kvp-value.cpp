@@ -387,6 +387,38 @@ KvpValueImpl::~KvpValueImpl() noexcept
     boost::apply_visitor(d, datastore);
 }
 
+static QofSlab<KvpValueImpl>&
+kvp_value_slab ()
+{
+    /* Never destroyed, so values freed during static destruction are safe. */
+    static auto slab = new QofSlab<KvpValueImpl>;
+    return *slab;
+}
+
+void*
+KvpValueImpl::operator new(std::size_t size)
+{
+    return kvp_value_slab ().allocate(size);
+}
+
+void
+KvpValueImpl::operator delete(void* ptr, std::size_t size) noexcept
+{
+    kvp_value_slab ().deallocate(ptr, size);
+}
+
+const QofSlabStats&
+KvpValueImpl::slab_stats() noexcept
+{
+    return kvp_value_slab ().stats();
+}
+
+bool
+KvpValueImpl::release_slab() noexcept
+{
+    return kvp_value_slab ().release();
+}
+
 void
 KvpValueImpl::duplicate(const KvpValueImpl& other) noexcept
 {
@@ -29,6 +29,7 @@ extern "C"
 #include <config.h>
 #include "qof.h"
 }
+#include "qof-slab.hpp"
 #include <boost/version.hpp>
 #if BOOST_VERSION == 105600
 #include <boost/type_traits/is_nothrow_move_assignable.hpp>
@@ -106,6 +107,16 @@ struct KvpValueImpl
      */
     ~KvpValueImpl() noexcept;
 
+    /** KvpValues are allocated from a QofSlab; see qof-slab.hpp. */
+    static void* operator new(std::size_t size);
+    static void operator delete(void* ptr, std::size_t size) noexcept;
+    /** Allocation counts of the slab KvpValues come from. */
+    static const QofSlabStats& slab_stats() noexcept;
+    /** Return the slab's memory to the system if no KvpValue is alive.
+     * @return true if the slab is empty.
+     */
+    static bool release_slab() noexcept;
+
     /**
      * Replaces the frame within this KvpValueImpl.
      *
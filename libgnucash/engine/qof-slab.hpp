@@ -0,0 +1,147 @@
+/********************************************************************\
+ * qof-slab.hpp -- Fixed size slab allocator for engine objects     *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+/** @addtogroup Object_Private
+    @{ */
+/** @file qof-slab.hpp
+    @brief Slab allocation for the small objects every instance carries.
+
+    Loading a book creates a KvpFrame for every instance and a KvpValue
+    for every slot, so a large book makes millions of small allocations
+    of the same few sizes. A QofSlab hands those out of blocks of
+    chunks_per_block objects and keeps freed ones on a free list for
+    reuse. The blocks are only returned to the system by release(), which
+    does nothing while any object from the slab is still alive;
+    qof_book_destroy() calls it once a book's instances are gone.
+
+    Like the string cache, a slab isn't thread safe.
+*/
+
+#ifndef QOF_SLAB_HPP
+#define QOF_SLAB_HPP
+
+#include <cstddef>
+#include <new>
+
+/** Allocation counts for a QofSlab. */
+struct QofSlabStats
+{
+    std::size_t allocated = 0;  /**< Objects handed out since creation */
+    std::size_t live = 0;       /**< Objects handed out and not yet freed */
+    std::size_t blocks = 0;     /**< Blocks currently held */
+    std::size_t bytes = 0;      /**< Bytes currently held in blocks */
+};
+
+template <typename T, std::size_t chunks_per_block = 256>
+class QofSlab
+{
+    union Chunk
+    {
+        Chunk* next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+    struct Block
+    {
+        Block* next;
+        Chunk chunks[chunks_per_block];
+    };
+
+public:
+    QofSlab() = default;
+    QofSlab(const QofSlab&) = delete;
+    QofSlab& operator=(const QofSlab&) = delete;
+    /* Blocks are leaked if objects from the slab outlive it. */
+    ~QofSlab() { release(); }
+
+    /** Allocate storage for one T. Requests of any other size, e.g. from
+     *  a derived class, go to the global operator new.
+     */
+    void* allocate(std::size_t size)
+    {
+        if (size != sizeof(T))
+            return ::operator new(size);
+        if (!m_free)
+            grow();
+        auto chunk = m_free;
+        m_free = chunk->next;
+        ++m_stats.allocated;
+        ++m_stats.live;
+        return chunk;
+    }
+
+    /** Return storage obtained from allocate() with the same size. */
+    void deallocate(void* ptr, std::size_t size) noexcept
+    {
+        if (!ptr)
+            return;
+        if (size != sizeof(T))
+        {
+            ::operator delete(ptr);
+            return;
+        }
+        auto chunk = static_cast<Chunk*>(ptr);
+        chunk->next = m_free;
+        m_free = chunk;
+        --m_stats.live;
+    }
+
+    /** Free all blocks if no object from the slab is alive.
+     *  @return true if the slab is now empty.
+     */
+    bool release() noexcept
+    {
+        if (m_stats.live)
+            return false;
+        while (m_blocks)
+        {
+            auto block = m_blocks;
+            m_blocks = block->next;
+            ::operator delete(block);
+        }
+        m_free = nullptr;
+        m_stats.blocks = m_stats.bytes = 0;
+        return true;
+    }
+
+    const QofSlabStats& stats() const noexcept { return m_stats; }
+
+private:
+    void grow()
+    {
+        auto block = static_cast<Block*>(::operator new(sizeof(Block)));
+        block->next = m_blocks;
+        m_blocks = block;
+        for (std::size_t i = chunks_per_block; i-- > 0;)
+        {
+            block->chunks[i].next = m_free;
+            m_free = &block->chunks[i];
+        }
+        ++m_stats.blocks;
+        m_stats.bytes += sizeof(Block);
+    }
+
+    Chunk* m_free = nullptr;
+    Block* m_blocks = nullptr;
+    QofSlabStats m_stats;
+};
+
+#endif /* QOF_SLAB_HPP */
+/** @} */
@@ -450,6 +450,18 @@ qof_book_destroy (QofBook *book)
     g_hash_table_destroy (cols);
     /*book->hash_of_collections = NULL;*/
 
+    /* With the last book gone the KVP slabs are usually empty and their
+     * memory can go back to the system in one piece. */
+    auto& frames = KvpFrameImpl::slab_stats ();
+    auto& values = KvpValueImpl::slab_stats ();
+    PINFO ("KVP slabs before release: %zu frames, %zu values live, "
+           "%zu bytes held", frames.live, values.live,
+           frames.bytes + values.bytes);
+    KvpFrameImpl::release_slab ();
+    KvpValueImpl::release_slab ();
+    PINFO ("KVP slabs after release: %zu bytes held",
+           frames.bytes + values.bytes);
+
     LEAVE ("book=%p", book);
 }
 
@@ -31,6 +31,7 @@
 typedef struct
 {
     QofEventHandler handler;
+    QofEventBatchHandler batch_handler;
     gpointer user_data;
 
     gint handler_id;
@@ -31,6 +31,10 @@ extern "C"
 #include "qof.h"
 #include "qofevent-p.h"
 
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
 /* Static Variables ************************************************/
 static guint   suspend_counter   = 0;
 static gint    next_handler_id   = 1;
@@ -38,11 +42,31 @@ static guint   handler_run_level = 0;
 static guint   pending_deletes   = 0;
 static GList   *handlers  =   NULL;
 
+/* Batching: events queued in generation order, plus an index from entity
+ * to its queue positions so that duplicates can be coalesced and a
+ * destroyed entity's events discarded without scanning the queue. */
+using EventQueue = std::vector<QofEventRecord>;
+using EntityIndex = std::unordered_map<QofInstance*, std::vector<size_t>>;
+
+static guint       batch_level   = 0;
+static EventQueue  batch_queue;
+static EntityIndex batch_index;
+/* The batch currently being delivered, so that a destroy generated by a
+ * handler can invalidate the records that still refer to the entity. */
+static EventQueue  *delivering   = nullptr;
+static QofEventStats event_stats = {};
+
 /* This static indicates the debugging module that this .o belongs to.  */
 static QofLogModule log_module = QOF_MOD_ENGINE;
 
 /* Implementations *************************************************/
 
+static inline gboolean
+handler_is_live (const HandlerInfo *hi)
+{
+    return hi->handler != NULL || hi->batch_handler != NULL;
+}
+
 static gint
 find_next_handler_id(void)
 {
@@ -72,10 +96,31 @@ find_next_handler_id(void)
     return handler_id;
 }
 
+static gint
+register_handler_info (QofEventHandler handler,
+                       QofEventBatchHandler batch_handler, gpointer user_data)
+{
+    HandlerInfo *hi;
+    gint handler_id;
+
+    /* look for a free handler id */
+    handler_id = find_next_handler_id();
+
+    /* Found one, add the handler */
+    hi = g_new0 (HandlerInfo, 1);
+
+    hi->handler = handler;
+    hi->batch_handler = batch_handler;
+    hi->user_data = user_data;
+    hi->handler_id = handler_id;
+
+    handlers = g_list_prepend (handlers, hi);
+    return handler_id;
+}
+
 gint
 qof_event_register_handler (QofEventHandler handler, gpointer user_data)
 {
-    HandlerInfo *hi;
     gint handler_id;
 
     ENTER ("(handler=%p, data=%p)", handler, user_data);
@@ -87,17 +132,26 @@ qof_event_register_handler (QofEventHandler handler, gpointer user_data)
         return 0;
     }
 
-    /* look for a free handler id */
-    handler_id = find_next_handler_id();
+    handler_id = register_handler_info (handler, NULL, user_data);
+    LEAVE ("(handler=%p, data=%p) handler_id=%d", handler, user_data, handler_id);
+    return handler_id;
+}
 
-    /* Found one, add the handler */
-    hi = g_new0 (HandlerInfo, 1);
+gint
+qof_event_register_batch_handler (QofEventBatchHandler handler,
+                                  gpointer user_data)
+{
+    gint handler_id;
 
-    hi->handler = handler;
-    hi->user_data = user_data;
-    hi->handler_id = handler_id;
+    ENTER ("(handler=%p, data=%p)", handler, user_data);
 
-    handlers = g_list_prepend (handlers, hi);
+    if (!handler)
+    {
+        PERR ("no handler specified");
+        return 0;
+    }
+
+    handler_id = register_handler_info (NULL, handler, user_data);
     LEAVE ("(handler=%p, data=%p) handler_id=%d", handler, user_data, handler_id);
     return handler_id;
 }
@@ -120,12 +174,14 @@ qof_event_unregister_handler (gint handler_id)
            of a generated event, such as QOF_EVENT_DESTROY.  In that case,
            we're in the middle of walking the GList and it is wrong to
            modify the list. So, instead, we just NULL the handler. */
-        if (hi->handler)
+        if (handler_is_live (hi))
             LEAVE ("(handler_id=%d) handler=%p data=%p", handler_id,
-                   hi->handler, hi->user_data);
+                   hi->handler ? (gpointer)hi->handler
+                   : (gpointer)hi->batch_handler, hi->user_data);
 
         /* safety -- clear the handler in case we're running events now */
         hi->handler = NULL;
+        hi->batch_handler = NULL;
 
         if (handler_run_level == 0)
         {
@@ -168,22 +224,39 @@ qof_event_resume (void)
 }
 
 static void
-qof_event_generate_internal (QofInstance *entity, QofEventId event_id,
-                             gpointer event_data)
+remove_pending_deletes (void)
 {
     GList *node;
     GList *next_node = NULL;
 
-    g_return_if_fail(entity);
+    /* If we're the outermost event runner and we have pending deletes
+     * then go delete the handlers now.
+     */
+    if (handler_run_level != 0 || !pending_deletes)
+        return;
 
-    switch (event_id)
-    {
-    case QOF_EVENT_NONE:
+    for (node = handlers; node; node = next_node)
     {
-        /* if none, don't log, just return. */
-        return;
-    }
+        HandlerInfo *hi = static_cast<HandlerInfo*>(node->data);
+        next_node = node->next;
+        if (!handler_is_live (hi))
+        {
+            /* remove this node from the list, then free this node */
+            handlers = g_list_remove_link (handlers, node);
+            g_list_free_1 (node);
+            g_free (hi);
+        }
     }
+    pending_deletes = 0;
+}
+
+/* Hand a set of events to every registered handler. Batch handlers get the
+ * array in one call; legacy handlers get one call per event. */
+static void
+deliver_events (const QofEventRecord *events, guint n_events)
+{
+    GList *node;
+    GList *next_node = NULL;
 
     handler_run_level++;
     for (node = handlers; node; node = next_node)
@@ -191,34 +264,149 @@ qof_event_generate_internal (QofInstance *entity, QofEventId event_id,
         HandlerInfo *hi = static_cast<HandlerInfo*>(node->data);
 
         next_node = node->next;
-        if (hi->handler)
+        if (hi->batch_handler)
+        {
+            PINFO("id=%d hi=%p batch=%p n=%u", hi->handler_id, hi,
+                  hi->batch_handler, n_events);
+            hi->batch_handler (events, n_events, hi->user_data);
+            event_stats.delivered++;
+            continue;
+        }
+
+        for (guint i = 0; i < n_events && hi->handler; ++i)
         {
+            const QofEventRecord *ev = &events[i];
+            if (!ev->entity)
+                continue;
             PINFO("id=%d hi=%p han=%p data=%p", hi->handler_id, hi,
-                  hi->handler, event_data);
-            hi->handler (entity, event_id, hi->user_data, event_data);
+                  hi->handler, ev->event_data);
+            hi->handler (ev->entity, ev->event_id, hi->user_data,
+                         ev->event_data);
+            event_stats.delivered++;
         }
     }
     handler_run_level--;
 
-    /* If we're the outermost event runner and we have pending deletes
-     * then go delete the handlers now.
-     */
-    if (handler_run_level == 0 && pending_deletes)
+    remove_pending_deletes ();
+}
+
+/* Forget the queued (or currently delivering) events of an entity that is
+ * about to go away; they would otherwise be delivered with a dangling
+ * pointer. */
+static void
+drop_entity_events (QofInstance *entity)
+{
+    auto iter = batch_index.find (entity);
+    if (iter != batch_index.end ())
+    {
+        for (auto pos : iter->second)
+            batch_queue[pos].entity = nullptr;
+        event_stats.dropped += iter->second.size ();
+        batch_index.erase (iter);
+    }
+
+    if (delivering)
+        for (auto& ev : *delivering)
+            if (ev.entity == entity)
+                ev.entity = nullptr;
+}
+
+static void
+queue_event (QofInstance *entity, QofEventId event_id)
+{
+    auto& positions = batch_index[entity];
+    for (auto pos : positions)
     {
-        for (node = handlers; node; node = next_node)
+        if (batch_queue[pos].event_id == event_id)
         {
-            HandlerInfo *hi = static_cast<HandlerInfo*>(node->data);
-            next_node = node->next;
-            if (hi->handler == NULL)
-            {
-                /* remove this node from the list, then free this node */
-                handlers = g_list_remove_link (handlers, node);
-                g_list_free_1 (node);
-                g_free (hi);
-            }
+            event_stats.coalesced++;
+            return;
         }
-        pending_deletes = 0;
     }
+    positions.push_back (batch_queue.size ());
+    batch_queue.push_back ({entity, event_id, nullptr});
+    event_stats.queued++;
+}
+
+/* Deliver the queued events of one entity now, in the order they were
+ * queued. Used before an event with a payload, which can't be queued, so
+ * that handlers don't see it ahead of the change it follows. */
+static void
+flush_entity_events (QofInstance *entity)
+{
+    auto iter = batch_index.find (entity);
+    if (iter == batch_index.end ())
+        return;
+
+    EventQueue events;
+    for (auto pos : iter->second)
+    {
+        events.push_back (batch_queue[pos]);
+        batch_queue[pos].entity = nullptr;
+    }
+    batch_index.erase (iter);
+
+    auto outer = delivering;
+    delivering = &events;
+    deliver_events (events.data (), events.size ());
+    delivering = outer;
+}
+
+static void
+flush_batch (void)
+{
+    if (batch_queue.empty ())
+        return;
+
+    /* Take the queue so that events generated by the handlers start a
+     * fresh one (they are delivered immediately, as batch_level is 0). */
+    EventQueue events;
+    events.swap (batch_queue);
+    batch_index.clear ();
+
+    auto last = std::remove_if (events.begin (), events.end (),
+                                [](const QofEventRecord& ev)
+                                { return ev.entity == nullptr; });
+    events.erase (last, events.end ());
+    if (events.empty ())
+        return;
+
+    auto outer = delivering;
+    delivering = &events;
+    event_stats.batches++;
+    deliver_events (events.data (), events.size ());
+    delivering = outer;
+}
+
+static void
+qof_event_generate_internal (QofInstance *entity, QofEventId event_id,
+                             gpointer event_data)
+{
+    g_return_if_fail(entity);
+
+    switch (event_id)
+    {
+    case QOF_EVENT_NONE:
+    {
+        /* if none, don't log, just return. */
+        return;
+    }
+    }
+
+    event_stats.generated++;
+
+    if (event_id & QOF_EVENT_DESTROY)
+        drop_entity_events (entity);
+    else if (batch_level && !event_data)
+    {
+        queue_event (entity, event_id);
+        return;
+    }
+    else if (batch_level)
+        flush_entity_events (entity);
+
+    QofEventRecord ev = {entity, event_id, event_data};
+    deliver_events (&ev, 1);
 }
 
 void
@@ -237,9 +425,58 @@ qof_event_gen (QofInstance *entity, QofEventId event_id, gpointer event_data)
         return;
 
     if (suspend_counter)
+    {
+        /* The entity's queued events mustn't outlive it even if its
+         * destruction isn't announced. */
+        if (event_id & QOF_EVENT_DESTROY)
+            drop_entity_events (entity);
         return;
+    }
 
     qof_event_generate_internal (entity, event_id, event_data);
 }
 
+void
+qof_event_begin_batch (void)
+{
+    batch_level++;
+
+    if (batch_level == 0)
+    {
+        PERR ("batch level overflow");
+    }
+}
+
+void
+qof_event_end_batch (void)
+{
+    if (batch_level == 0)
+    {
+        PERR ("batch level underflow");
+        return;
+    }
+
+    if (--batch_level == 0)
+        flush_batch ();
+}
+
+gboolean
+qof_event_is_batching (void)
+{
+    return batch_level != 0;
+}
+
+void
+qof_event_get_stats (QofEventStats *stats)
+{
+    g_return_if_fail (stats);
+    *stats = event_stats;
+}
+
+void
+qof_event_reset_stats (void)
+{
+    event_stats = {};
+}
+
 /* =========================== END OF FILE ======================= */
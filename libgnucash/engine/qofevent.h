@@ -128,6 +128,80 @@ void qof_event_unregister_handler (gint handler_id);
 void qof_event_gen (QofInstance *entity, QofEventId event_type,
                     gpointer event_data);
 
+/** \brief One queued event, as delivered to a QofEventBatchHandler. */
+typedef struct
+{
+    QofInstance *entity;    /**< Entity generating the event; NULL if the
+                                 entity was destroyed while the batch was
+                                 being delivered. */
+    QofEventId   event_id;  /**< The id of the event. */
+    gpointer     event_data;/**< Always NULL for coalesced events. */
+} QofEventRecord;
+
+/** \brief Handler invoked with a whole batch of events at once.
+ *
+ * Outside of a batch (see qof_event_begin_batch()) a batch handler is
+ * called once per event with n_events == 1.
+ *
+ * @param events:       The events, in the order they were first generated.
+ * @param n_events:     The number of events in the array.
+ * @param handler_data: data supplied when handler was registered.
+ */
+typedef void (*QofEventBatchHandler) (const QofEventRecord *events,
+                                      guint n_events, gpointer handler_data);
+
+/** \brief Register a batch-aware handler for events.
+ *
+ * The returned id shares the namespace of qof_event_register_handler() and
+ * is unregistered with qof_event_unregister_handler().
+ *
+ * @param handler:   handler to register
+ * @param handler_data: data provided when handler is invoked
+ *
+ * @return id identifying handler
+ */
+gint qof_event_register_batch_handler (QofEventBatchHandler handler,
+                                       gpointer handler_data);
+
+/** \brief Start queueing events instead of delivering them.
+ *
+ * While a batch is open, events without event_data are queued and
+ * duplicates (same entity and event id) are coalesced into one. Events
+ * carrying event_data are still delivered immediately because their
+ * payload is frequently stack-allocated by the caller. A QOF_EVENT_DESTROY
+ * event is also delivered immediately and discards any queued events for
+ * the dying entity.
+ *
+ * Batches nest; the queue is delivered when the outermost batch is ended.
+ * Batch-aware handlers receive the whole queue in one call, legacy handlers
+ * are invoked once per queued event.
+ */
+void qof_event_begin_batch (void);
+
+/** \brief End a batch started with qof_event_begin_batch(), delivering
+ * the queued events if this was the outermost batch. */
+void qof_event_end_batch (void);
+
+/** \brief Whether events are currently being queued. */
+gboolean qof_event_is_batching (void);
+
+/** \brief Counters describing event traffic since the last reset. */
+typedef struct
+{
+    guint64 generated;  /**< Events accepted by qof_event_gen/force. */
+    guint64 queued;     /**< Events placed on the batch queue. */
+    guint64 coalesced;  /**< Events merged into an already queued one. */
+    guint64 dropped;    /**< Queued events discarded by a destroy. */
+    guint64 delivered;  /**< Handler invocations, legacy or batch. */
+    guint64 batches;    /**< Non-empty batches delivered. */
+} QofEventStats;
+
+/** \brief Copy the current event counters into stats. */
+void qof_event_get_stats (QofEventStats *stats);
+
+/** \brief Zero the event counters. */
+void qof_event_reset_stats (void);
+
 /** \brief  Suspend all engine events.
  *
  *    This function may be called multiple times. To resume event generation,
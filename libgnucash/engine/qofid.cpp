@@ -29,30 +29,52 @@ extern "C"
 #include <glib.h>
 }
 
+#include <vector>
+
 #include "qof.h"
 #include "qofid-p.h"
 #include "qofinstance-p.h"
 
 static QofLogModule log_module = QOF_MOD_ENGINE;
 
+/* The entities are kept in insertion order in a dense array so that
+ * traversals are a linear scan, and indexed by an open-addressing hash
+ * table with linear probing that keeps each guid alongside its entity so
+ * that lookups don't have to chase pointers.
+ */
+struct QofCollectionSlot
+{
+    GncGUID      guid;
+    QofInstance *ent;        /* NULL if the slot is empty */
+    guint32      index;      /* of ent in QofCollection_s::entities */
+    guint32      hash;
+};
+
 struct QofCollection_s
 {
     QofIdType    e_type;
     gboolean     is_dirty;
 
-    GHashTable * hash_of_entities;
+    std::vector<QofCollectionSlot> slots;  /* empty or a power of 2 long */
+    std::vector<QofInstance*> entities;    /* NULL where one was removed */
+    guint        count;
+    mutable guint iterating; /* depth of qof_collection_foreach calls */
     gpointer     data;       /* place where object class can hang arbitrary data */
 };
 
+static constexpr size_t no_slot = static_cast<size_t>(-1);
+
 /* =============================================================== */
 
 QofCollection *
 qof_collection_new (QofIdType type)
 {
     QofCollection *col;
-    col = g_new0(QofCollection, 1);
+    col = new QofCollection_s;
     col->e_type = static_cast<QofIdType>(CACHE_INSERT (type));
-    col->hash_of_entities = guid_hash_table_new();
+    col->is_dirty = FALSE;
+    col->count = 0;
+    col->iterating = 0;
     col->data = NULL;
     return col;
 }
@@ -61,11 +83,115 @@ void
 qof_collection_destroy (QofCollection *col)
 {
     CACHE_REMOVE (col->e_type);
-    g_hash_table_destroy(col->hash_of_entities);
     col->e_type = NULL;
-    col->hash_of_entities = NULL;
     col->data = NULL;   /** XXX there should be a destroy notifier for this */
-    g_free (col);
+    delete col;
+}
+
+/* =============================================================== */
+/* The entity table */
+
+static size_t
+collection_find_slot (const QofCollection *col, const GncGUID *guid)
+{
+    if (col->slots.empty ())
+        return no_slot;
+    auto mask = col->slots.size () - 1;
+    auto hash = static_cast<guint32>(guid_hash_to_guint64 (guid));
+    for (auto i = hash & mask; ; i = (i + 1) & mask)
+    {
+        auto& slot = col->slots[i];
+        if (!slot.ent)
+            return no_slot;
+        if (slot.hash == hash && guid_equal (&slot.guid, guid))
+            return i;
+    }
+}
+
+static void
+collection_place_slot (QofCollection *col, const QofCollectionSlot& slot)
+{
+    auto mask = col->slots.size () - 1;
+    auto i = slot.hash & mask;
+    while (col->slots[i].ent)
+        i = (i + 1) & mask;
+    col->slots[i] = slot;
+}
+
+static void
+collection_insert (QofCollection *col, const GncGUID *guid, QofInstance *ent)
+{
+    auto i = collection_find_slot (col, guid);
+    if (i != no_slot)
+    {
+        auto& slot = col->slots[i];
+        slot.ent = col->entities[slot.index] = ent;
+        return;
+    }
+    /* Keep the table at most half full so that probe runs stay short. */
+    if ((col->count + 1) * 2 > col->slots.size ())
+    {
+        std::vector<QofCollectionSlot> old (col->slots.empty () ? 16 :
+                                            col->slots.size () * 2);
+        std::swap (old, col->slots);
+        for (const auto& slot : old)
+            if (slot.ent)
+                collection_place_slot (col, slot);
+    }
+    auto hash = static_cast<guint32>(guid_hash_to_guint64 (guid));
+    collection_place_slot (col, {*guid, ent,
+                                 static_cast<guint32>(col->entities.size ()),
+                                 hash});
+    col->entities.push_back (ent);
+    ++col->count;
+}
+
+/* Squeeze the holes left by removed entities out of the dense array once
+ * they outnumber the entities, unless it's being traversed. */
+static void
+collection_compact (QofCollection *col)
+{
+    auto holes = col->entities.size () - col->count;
+    if (col->iterating || holes < 16 || holes < col->count)
+        return;
+    std::vector<guint32> new_index (col->entities.size ());
+    guint32 n = 0;
+    for (size_t i = 0; i < col->entities.size (); ++i)
+    {
+        new_index[i] = n;
+        if (col->entities[i])
+            col->entities[n++] = col->entities[i];
+    }
+    col->entities.resize (n);
+    for (auto& slot : col->slots)
+        if (slot.ent)
+            slot.index = new_index[slot.index];
+}
+
+static void
+collection_remove (QofCollection *col, const GncGUID *guid)
+{
+    auto i = collection_find_slot (col, guid);
+    if (i == no_slot)
+        return;
+    col->entities[col->slots[i].index] = NULL;
+    --col->count;
+
+    /* Shift back any following entries that can move nearer to their
+     * home slot, so that the table needs no tombstones. */
+    auto mask = col->slots.size () - 1;
+    for (auto j = (i + 1) & mask; col->slots[j].ent; j = (j + 1) & mask)
+    {
+        auto home = col->slots[j].hash & mask;
+        auto stays = i < j ? (home > i && home <= j) : (home > i || home <= j);
+        if (!stays)
+        {
+            col->slots[i] = col->slots[j];
+            i = j;
+        }
+    }
+    col->slots[i].ent = NULL;
+    collection_compact (col);
 }
 
 /* =============================================================== */
@@ -89,7 +215,7 @@ qof_collection_remove_entity (QofInstance *ent)
     col = qof_instance_get_collection(ent);
     if (!col) return;
     guid = qof_instance_get_guid(ent);
-    g_hash_table_remove (col->hash_of_entities, guid);
+    collection_remove (col, guid);
     qof_instance_set_collection(ent, NULL);
 }
 
@@ -102,8 +228,12 @@ qof_collection_insert_entity (QofCollection *col, QofInstance *ent)
     guid = qof_instance_get_guid(ent);
     if (guid_equal(guid, guid_null())) return;
     g_return_if_fail (col->e_type == ent->e_type);
+    /* Leave it where it is in the traversal order if it's already here. */
+    if (qof_instance_get_collection(ent) == col &&
+        qof_collection_lookup_entity(col, guid) == ent)
+        return;
     qof_collection_remove_entity (ent);
-    g_hash_table_insert (col->hash_of_entities, (gpointer)guid, ent);
+    collection_insert (col, guid, ent);
     qof_instance_set_collection(ent, col);
 }
 
@@ -129,7 +259,7 @@ qof_collection_add_entity (QofCollection *coll, QofInstance *ent)
     {
         return FALSE;
     }
-    g_hash_table_insert (coll->hash_of_entities, (gpointer)guid, ent);
+    collection_insert (coll, guid, ent);
     return TRUE;
 }
 
@@ -213,12 +343,11 @@ qof_collection_compare (QofCollection *target, QofCollection *merge)
 QofInstance *
 qof_collection_lookup_entity (const QofCollection *col, const GncGUID * guid)
 {
-    QofInstance *ent;
+    size_t i;
     g_return_val_if_fail (col, NULL);
     if (guid == NULL) return NULL;
-    ent = static_cast<QofInstance*>(g_hash_table_lookup (col->hash_of_entities,
-							 guid));
-    return ent;
+    i = collection_find_slot (col, guid);
+    return i == no_slot ? NULL : col->slots[i].ent;
 }
 
 QofCollection *
@@ -244,10 +373,7 @@ qof_collection_from_glist (QofIdType type, const GList *glist)
 guint
 qof_collection_count (const QofCollection *col)
 {
-    guint c;
-
-    c = g_hash_table_size(col->hash_of_entities);
-    return c;
+    return col->count;
 }
 
 /* =============================================================== */
@@ -303,40 +429,32 @@ qof_collection_set_data (QofCollection *col, gpointer user_data)
 
 /* =============================================================== */
 
-struct _qofid_iterate
-{
-    QofInstanceForeachCB      fcn;
-    gpointer                data;
-};
-
-static void
-foreach_cb (gpointer item, gpointer arg)
-{
-    struct _qofid_iterate *iter = static_cast<_qofid_iterate*>(arg);
-    QofInstance *ent = static_cast<QofInstance*>(item);
-
-    iter->fcn (ent, iter->data);
-}
-
 void
 qof_collection_foreach (const QofCollection *col, QofInstanceForeachCB cb_func,
                         gpointer user_data)
 {
-    struct _qofid_iterate iter;
-    GList *entries;
+    size_t n_entities;
 
     g_return_if_fail (col);
     g_return_if_fail (cb_func);
 
-    iter.fcn = cb_func;
-    iter.data = user_data;
+    PINFO("Hash Table size of %s before is %d", col->e_type, col->count);
 
-    PINFO("Hash Table size of %s before is %d", col->e_type, g_hash_table_size(col->hash_of_entities));
-
-    entries = g_hash_table_get_values (col->hash_of_entities);
-    g_list_foreach (entries, foreach_cb, &iter);
-    g_list_free (entries);
+    /* The callback may add or remove entities. Entities it removes have
+     * their place in the array cleared rather than being moved, so
+     * the ones still to come are neither skipped nor repeated. Entities
+     * it adds are appended and, as before, not visited. */
+    ++col->iterating;
+    n_entities = col->entities.size ();
+    for (size_t i = 0; i < n_entities; ++i)
+    {
+        auto ent = col->entities[i];
+        if (ent)
+            cb_func (ent, user_data);
+    }
+    if (--col->iterating == 0)
+        collection_compact (const_cast<QofCollection*>(col));
 
-    PINFO("Hash Table size of %s after is %d", col->e_type, g_hash_table_size(col->hash_of_entities));
+    PINFO("Hash Table size of %s after is %d", col->e_type, col->count);
 }
 /* =============================================================== */
@@ -118,7 +118,8 @@ print error message if its bad  */
 
 @param e_type QofIdType
 @param is_dirty gboolean
-@param hash_of_entities GHashTable
+@param slots hash table of the entities by guid
+@param entities the entities in the order they were added
 @param data gpointer, place where object class can hang arbitrary data
 
 */
@@ -145,7 +146,10 @@ QofInstance * qof_collection_lookup_entity (const QofCollection *, const GncGUID
 /** Callback type for qof_collection_foreach */
 typedef void (*QofInstanceForeachCB) (QofInstance *, gpointer user_data);
 
-/** Call the callback for each entity in the collection. */
+/** Call the callback for each entity in the collection, in the order
+ * they were added. The callback may add or remove entities; those it
+ * adds aren't visited and those it removes before reaching them are
+ * skipped. */
 void qof_collection_foreach (const QofCollection *, QofInstanceForeachCB,
                              gpointer user_data);
 
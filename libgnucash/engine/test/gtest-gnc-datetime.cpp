@@ -530,3 +530,134 @@ TEST(gnc_datetime_functions, test_timezone_offset)
     EXPECT_EQ(-25200, gncdt3.offset());
 }
 */
+
+static ::testing::AssertionResult
+tm_equal(const struct tm& a, const struct tm& b, time64 time)
+{
+    if (a.tm_year == b.tm_year && a.tm_mon == b.tm_mon &&
+        a.tm_mday == b.tm_mday && a.tm_hour == b.tm_hour &&
+        a.tm_min == b.tm_min && a.tm_sec == b.tm_sec &&
+        a.tm_wday == b.tm_wday && a.tm_yday == b.tm_yday &&
+        a.tm_isdst == b.tm_isdst
+#if HAVE_STRUCT_TM_GMTOFF
+        && a.tm_gmtoff == b.tm_gmtoff
+#endif
+        )
+        return ::testing::AssertionSuccess();
+    return ::testing::AssertionFailure() << "time " << time << ": " <<
+        a.tm_year << "-" << a.tm_mon << "-" << a.tm_mday << " " <<
+        a.tm_hour << ":" << a.tm_min << ":" << a.tm_sec << " dst " <<
+        a.tm_isdst << " != " << b.tm_year << "-" << b.tm_mon << "-" <<
+        b.tm_mday << " " << b.tm_hour << ":" << b.tm_min << ":" <<
+        b.tm_sec << " dst " << b.tm_isdst;
+}
+
+/* Steps through eighty years in increments that aren't a multiple of an
+ * hour so that every time of day and the DST transitions are hit, comparing the
+ * cached conversions with constructing GncDateTimes.
+ */
+static void
+test_local_tm_in_zone()
+{
+    const time64 step = 13 * 3600 + 1337;
+    for (time64 time = -315619200; time < 2208988800; time += step)
+    {
+        auto tm = GncDateTime::local_tm(time);
+        auto expected = static_cast<struct tm>(GncDateTime(time));
+        EXPECT_TRUE(tm_equal(tm, expected, time));
+
+        auto local = expected;
+        local.tm_min += 17;
+        if (local.tm_min >= 60)
+            local.tm_min -= 60;
+        GncDateTime gncdt(local);
+        auto converted = GncDateTime::local_tm_to_time64(local);
+        EXPECT_EQ(static_cast<time64>(gncdt), converted);
+        EXPECT_TRUE(tm_equal(local, static_cast<struct tm>(gncdt), time));
+    }
+}
+
+TEST(gnc_datetime_functions, test_local_tm)
+{
+#ifdef __MINGW32__
+    TimeZoneProvider tzp_lon{"GMT Standard Time"};
+    TimeZoneProvider tzp_can{"A.U.S Eastern Standard Time"};
+    TimeZoneProvider tzp_la{"Pacific Standard Time"};
+#else
+    TimeZoneProvider tzp_lon("Europe/London");
+    TimeZoneProvider tzp_can("Australia/Canberra");
+    TimeZoneProvider tzp_la("America/Los_Angeles");
+#endif
+    test_local_tm_in_zone();
+    _set_tzp(tzp_lon);
+    test_local_tm_in_zone();
+    _reset_tzp();
+    _set_tzp(tzp_can);
+    test_local_tm_in_zone();
+    _reset_tzp();
+    _set_tzp(tzp_la);
+    test_local_tm_in_zone();
+    _reset_tzp();
+}
+
+TEST(gnc_datetime_functions, test_local_tm_transitions)
+{
+#ifdef __MINGW32__
+    TimeZoneProvider tzp_la{"Pacific Standard Time"};
+#else
+    TimeZoneProvider tzp_la("America/Los_Angeles");
+#endif
+    _set_tzp(tzp_la);
+    struct tm gap{0, 30, 2, 8, 2, 120, 0, 0, -1}; // 2020-03-08 02:30
+    EXPECT_THROW(GncDateTime::local_tm_to_time64(gap), std::invalid_argument);
+    struct tm overlap{0, 30, 1, 1, 10, 120, 0, 0, -1}; // 2020-11-01 01:30
+    GncDateTime gncdt(overlap);
+    EXPECT_EQ(static_cast<time64>(gncdt),
+              GncDateTime::local_tm_to_time64(overlap));
+    EXPECT_EQ(1, overlap.tm_hour);
+    EXPECT_EQ(30, overlap.tm_min);
+    auto tm = GncDateTime::local_tm(1583661600); // 2020-03-08 10:00 Z
+    EXPECT_EQ(3, tm.tm_hour);
+    EXPECT_EQ(1, tm.tm_isdst);
+    _reset_tzp();
+}
+
+TEST(gnc_datetime_functions, test_time64_from_string)
+{
+    const char* strings[] = {
+        "2020-03-08 10:59:47 +0000",
+        "2020-03-08 10:59:47 -0800",
+        "2020-03-08 10:59:47+05:30",
+        "2020-03-08 10:59:47 +13",
+        "2020-02-29 23:59:59",
+        "1969-12-31 23:59:59 -0100",
+        "1402-01-01 00:00:00 +1200",
+        "9998-12-31 23:59:59 -1200",
+        "2020-03-08 10:59:47.5 +0000",
+        "20200308105947",
+        "1400-01-01 00:00:00",
+    };
+    for (auto str : strings)
+        EXPECT_EQ(static_cast<time64>(GncDateTime(std::string(str))),
+                  GncDateTime::time64_from_string(str)) << str;
+    EXPECT_THROW(GncDateTime::time64_from_string("2020-02-30 10:59:47"),
+                 std::out_of_range);
+    EXPECT_THROW(GncDateTime::time64_from_string("2020-13-03 10:59:47"),
+                 std::out_of_range);
+    EXPECT_THROW(GncDateTime::time64_from_string("2020-03-08 10:59"),
+                 std::invalid_argument);
+}
+
+TEST(gnc_datetime_functions, test_format_iso8601_buffer)
+{
+    const time64 times[] = {0, -1, 1583665187, -17987443200, 253402214399,
+                            -6847804800, 2394187200};
+    for (auto time : times)
+    {
+        char buf[32];
+        auto end = GncDateTime::format_iso8601(time, buf);
+        auto expected = GncDateTime(time).format_iso8601();
+        EXPECT_EQ(expected, buf);
+        EXPECT_EQ(expected.size(), static_cast<size_t>(end - buf));
+    }
+}
@@ -416,6 +416,64 @@ TEST(GncInt128_functions, multiply)
 
 }
 
+TEST(GncInt128_functions, multiply_limits)
+{
+    GncInt128 two_62 (INT64_C(0x4000000000000000));
+    GncInt128 two_124 (UINT64_C(0x1000000000000000), UINT64_C(0));
+    GncInt128 biggest (UINT64_C(0x1fffffffffffffff), UINT64_MAX);
+
+    EXPECT_EQ (two_124, two_62 * two_62);
+    EXPECT_EQ (-two_124, two_62 * -two_62);
+    EXPECT_FALSE ((two_124 * GncInt128 (1)).isOverflow());
+    EXPECT_TRUE ((two_124 * GncInt128 (2)).isOverflow());
+    EXPECT_TRUE ((-two_124 * GncInt128 (2)).isOverflow());
+    EXPECT_TRUE ((biggest * biggest).isOverflow());
+    EXPECT_EQ (biggest, biggest * GncInt128 (1));
+    EXPECT_EQ (-biggest, biggest * GncInt128 (-1));
+    EXPECT_TRUE ((GncInt128 (UINT64_C(1), UINT64_C(0)) *
+                  GncInt128 (UINT64_C(1), UINT64_C(0))).isOverflow());
+}
+
+TEST(GncInt128_functions, multiply_carries)
+{
+    /* Partial products whose sums carry across sublegs; the portable
+     * multiplication used to drop these. */
+    GncInt128 a (UINT64_C(0), UINT64_C(84229286527235215));
+    GncInt128 b (UINT64_C(0), UINT64_MAX);
+    GncInt128 product (UINT64_C(0x12b3e16ff23f48e),
+                       UINT64_C(0xfed4c1e900dc0b71));
+    EXPECT_EQ (product, a * b);
+    EXPECT_EQ (product, b * a);
+    EXPECT_EQ (-product, -a * b);
+    char buf[41];
+    EXPECT_STREQ ("1553756092079059981663828183288122225",
+                  (a * b).asCharBufR (buf));
+    /* 2^62 - 1 squared needs the top subleg of the result. */
+    GncInt128 c (UINT64_C(0), UINT64_C(0x3fffffffffffffff));
+    EXPECT_EQ (GncInt128 (UINT64_C(0x0fffffffffffffff),
+                          UINT64_C(0x8000000000000001)), c * c);
+}
+
+TEST(GncInt128_functions, divide_multi_leg)
+{
+    /* The normalized remainder of this one is too big for a GncInt128. */
+    GncInt128 a (UINT64_C(0x2530e4b3dd99c), UINT64_C(0xc3d2462a526736e5));
+    GncInt128 b (UINT64_C(0xc37a0b80db5), UINT64_C(0x4b0b96f7309e81f2));
+    EXPECT_EQ (48, a / b);
+    EXPECT_EQ (GncInt128 (UINT64_C(0x8a028bb479e), UINT64_C(0xb1a5f7d134aed985)),
+               a % b);
+    EXPECT_EQ (-48, -a / b);
+    EXPECT_EQ (-GncInt128 (UINT64_C(0x8a028bb479e), UINT64_C(0xb1a5f7d134aed985)),
+               -a % b);
+
+    /* And this one has to add back the divisor after the first guess. */
+    GncInt128 c (UINT64_C(0xffff0000ffff), UINT64_C(0xffffffffffff));
+    GncInt128 d (UINT64_C(0x22ae3f6d0), UINT64_C(0xfffffffe00000001));
+    EXPECT_EQ (30234, c / d);
+    EXPECT_EQ (GncInt128 (UINT64_C(0x1911598c5), UINT64_C(0x1ec33ffff89e5)),
+               c % d);
+}
+
 TEST(GncInt128_functions, divide)
 {
     int64_t barg {INT64_C(4878849681579065407)};
@@ -581,6 +639,9 @@ TEST(GncInt128_functions, GCD)
             EXPECT_EQ (one, big.gcd (small));
             EXPECT_EQ (2, bigger.gcd (smallest));
             EXPECT_EQ (big >> 1, smaller.lcm (smallest));
+            EXPECT_EQ (smaller, (-big).gcd (smaller));
+            EXPECT_EQ (smaller << 3, (big << 5).gcd (smaller << 3));
+            EXPECT_EQ (-smaller, GncInt128 (0).gcd (-smaller));
         });
 }
 
@@ -23,6 +23,9 @@
 #include <gtest/gtest.h>
 #include "../gnc-numeric.hpp"
 #include "../gnc-rational.hpp"
+#include <chrono>
+#include <iostream>
+#include <vector>
 
 TEST(gncnumeric_constructors, test_default_constructor)
 {
@@ -561,3 +564,103 @@ TEST(gnc_numeric_functions, test_conversion_to_decimal)
     EXPECT_EQ(100, r.num());
     EXPECT_EQ(1, r.denom());
 }
+
+TEST(gnc_numeric_functions, test_same_denom_add_sub)
+{
+    auto a = gnc_numeric_create(12345, 100), b = gnc_numeric_create(-2345, 100);
+    auto r = gnc_numeric_add_fixed(a, b);
+    EXPECT_EQ(10000, r.num);
+    EXPECT_EQ(100, r.denom);
+    r = gnc_numeric_sub(a, b, 100, GNC_HOW_RND_ROUND_HALF_UP);
+    EXPECT_EQ(14690, r.num);
+    EXPECT_EQ(100, r.denom);
+    r = gnc_numeric_add(a, b, GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+    EXPECT_EQ(10000, r.num);
+    EXPECT_EQ(100, r.denom);
+    // Reducing and converting still go the long way.
+    r = gnc_numeric_add(a, b, GNC_DENOM_AUTO, GNC_HOW_DENOM_REDUCE);
+    EXPECT_EQ(100, r.num);
+    EXPECT_EQ(1, r.denom);
+    r = gnc_numeric_add(a, b, 10, GNC_HOW_RND_ROUND_HALF_UP);
+    EXPECT_EQ(1000, r.num);
+    EXPECT_EQ(10, r.denom);
+    r = gnc_numeric_sub(a, a, GNC_DENOM_AUTO,
+                        GNC_HOW_DENOM_EXACT | GNC_HOW_RND_ROUND_HALF_UP);
+    EXPECT_EQ(0, r.num);
+    EXPECT_EQ(1, r.denom);
+    // So does a sum overflowing 64 bits.
+    auto big = gnc_numeric_create(INT64_MAX - 1, 100);
+    r = gnc_numeric_add_fixed(big, gnc_numeric_create(1, 100));
+    EXPECT_EQ(INT64_MAX, r.num);
+    r = gnc_numeric_add_fixed(big, big);
+    EXPECT_EQ(INT64_C(4611686018427387903), r.num);
+    EXPECT_EQ(25, r.denom);
+    r = gnc_numeric_add_fixed(gnc_numeric_error(GNC_ERROR_ARG),
+                              gnc_numeric_error(GNC_ERROR_ARG));
+    EXPECT_EQ(GNC_ERROR_ARG, gnc_numeric_check(r));
+
+    EXPECT_EQ(1, gnc_numeric_compare(a, b));
+    EXPECT_EQ(-1, gnc_numeric_compare(b, a));
+    EXPECT_EQ(0, gnc_numeric_compare(a, a));
+}
+
+TEST(gnc_numeric_functions, test_sum)
+{
+    std::vector<gnc_numeric> values{gnc_numeric_create(150, 100),
+        gnc_numeric_create(-25, 100), gnc_numeric_create(5, 1000),
+        gnc_numeric_create(75, 100), gnc_numeric_create(200, 100)};
+    auto r = gnc_numeric_sum(values.data(), 0, GNC_DENOM_AUTO,
+                             GNC_HOW_DENOM_FIXED);
+    EXPECT_TRUE(gnc_numeric_zero_p(r));
+    r = gnc_numeric_sum(values.data(), values.size(), 100,
+                        GNC_HOW_RND_ROUND_HALF_UP);
+    EXPECT_EQ(401, r.num);
+    EXPECT_EQ(100, r.denom);
+
+    // The result is the same as adding the values one at a time, even
+    // when the running sum overflows.
+    values.insert(values.begin() + 2, {gnc_numeric_create(INT64_MAX - 100, 100),
+            gnc_numeric_create(-INT64_MAX + 100, 100)});
+    for (auto how : {GNC_HOW_DENOM_FIXED, GNC_HOW_DENOM_LCD, GNC_HOW_DENOM_REDUCE})
+    {
+        auto expected = gnc_numeric_zero();
+        for (auto value : values)
+            expected = gnc_numeric_add(expected, value, GNC_DENOM_AUTO, how);
+        r = gnc_numeric_sum(values.data(), values.size(), GNC_DENOM_AUTO, how);
+        EXPECT_TRUE(gnc_numeric_eq(expected, r));
+    }
+}
+
+TEST(gnc_numeric_functions, test_sum_performance)
+{
+    constexpr size_t n_values = 1000000;
+    std::vector<gnc_numeric> values;
+    values.reserve(n_values);
+    for (size_t i = 0; i < n_values; ++i)
+        values.push_back(gnc_numeric_create(i % 2 ? 1234567 : -765432, 100));
+
+    using clock = std::chrono::steady_clock;
+    auto start = clock::now();
+    GncNumeric general;
+    for (auto value : values)
+        general = general + GncNumeric(value);
+    std::chrono::duration<double> general_time = clock::now() - start;
+
+    start = clock::now();
+    auto added = gnc_numeric_zero();
+    for (auto value : values)
+        added = gnc_numeric_add_fixed(added, value);
+    std::chrono::duration<double> add_time = clock::now() - start;
+
+    start = clock::now();
+    auto sum = gnc_numeric_sum(values.data(), values.size(), GNC_DENOM_AUTO,
+                               GNC_HOW_DENOM_FIXED);
+    std::chrono::duration<double> sum_time = clock::now() - start;
+
+    EXPECT_TRUE(gnc_numeric_equal(static_cast<gnc_numeric>(general), added));
+    EXPECT_TRUE(gnc_numeric_eq(added, sum));
+    std::cout << "Adding " << n_values << " values took " <<
+        general_time.count() << "s with GncNumeric, " << add_time.count() <<
+        "s with gnc_numeric_add and " << sum_time.count() <<
+        "s with gnc_numeric_sum.\n";
+}
@@ -22,7 +22,10 @@
  *******************************************************************/
 
 #include <gtest/gtest.h>
+#include <chrono>
+#include <iostream>
 #include <random>
+#include <vector>
 #include "../gnc-rational.hpp"
 #include "../gnc-numeric.hpp" //for RoundType
 
@@ -177,3 +180,45 @@ TEST(gncrational_functions, test_round_to_numeric)
 
     }
 }
+
+TEST(gncrational_functions, test_reduce_round_performance)
+{
+    std::default_random_engine dre;
+    std::uniform_int_distribution<int64_t> di{INT64_C(0x1000000000000),
+            INT64_C(0x7ffffffffffffff)};
+    static const int reps{100000};
+    std::vector<GncRational> products;
+    products.reserve(reps);
+    for (auto i = 0; i < reps; ++i)
+        products.push_back(GncRational(di(dre), di(dre)) *
+                           GncRational(di(dre), 100));
+
+    using clock = std::chrono::steady_clock;
+    auto start = clock::now();
+    int reduced{};
+    for (const auto& product : products)
+        if (product.reduce().valid())
+            ++reduced;
+    std::chrono::duration<double> reduce_time = clock::now() - start;
+
+    start = clock::now();
+    int rounded{};
+    for (const auto& product : products)
+    {
+        try
+        {
+            if (product.round_to_numeric().valid())
+                ++rounded;
+        }
+        catch (const std::overflow_error&)
+        {
+        }
+    }
+    std::chrono::duration<double> round_time = clock::now() - start;
+
+    EXPECT_EQ(reps, reduced);
+    EXPECT_LT(0, rounded);
+    std::cout << "GncRational::reduce took " << reduce_time.count() <<
+        "s and GncRational::round_to_numeric took " << round_time.count() <<
+        "s for " << reps << " products.\n";
+}
@@ -30,6 +30,10 @@ extern "C"
 #include <qofinstance-p.h>
 #include <kvp-frame.hpp>
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
 #include <string>
 
 class ImapTest : public testing::Test
@@ -383,6 +387,140 @@ TEST_F (ImapBayesTest, import_map_with_delimiters)
     EXPECT_EQ (account, t_expense_account1);
 }
 
+/* The matcher's index must notice entries that change behind its back. */
+TEST_F (ImapBayesTest, IndexFollowsChanges)
+{
+    gnc_account_imap_add_account_bayes (t_imap, t_list1, t_expense_account1);
+    EXPECT_EQ (t_expense_account1, gnc_account_imap_find_account_bayes (t_imap, t_list1));
+    gnc_account_delete_all_bayes_maps (t_bank_account);
+    EXPECT_EQ (nullptr, gnc_account_imap_find_account_bayes (t_imap, t_list1));
+
+    auto root = qof_instance_get_slots (QOF_INSTANCE (t_bank_account));
+    auto acct2_guid = guid_to_string (xaccAccountGetGUID (t_expense_account2));
+    root->set_path ({std::string{IMAP_FRAME_BAYES} + "/" + foo + "/" + acct2_guid},
+                    new KvpValue {INT64_C (3)});
+    EXPECT_EQ (t_expense_account2, gnc_account_imap_find_account_bayes (t_imap, t_list1));
+
+    /* foo is now 1:3 between the accounts, which isn't decisive. */
+    gnc_account_imap_add_account_bayes (t_imap, t_list1, t_expense_account1);
+    auto foo_only = g_list_prepend (nullptr, const_cast<char*>(foo));
+    EXPECT_EQ (nullptr, gnc_account_imap_find_account_bayes (t_imap, foo_only));
+    g_list_free (foo_only);
+    g_free (acct2_guid);
+}
+
+/* What gnc_account_imap_find_account_bayes did before it had an index:
+ * walk the account's slots for each token. */
+static std::string
+reference_find_bayes (Account *acc, GList *tokens)
+{
+    std::vector<std::pair<std::string, std::pair<double, double>>> probs;
+    for (auto node = tokens; node; node = node->next)
+    {
+        std::map<std::string, int64_t> counts;
+        int64_t total = 0;
+        auto prefix = std::string{IMAP_FRAME_BAYES} + "/" + static_cast<char*>(node->data) + "/";
+        qof_instance_foreach_slot_prefix (QOF_INSTANCE (acc), prefix,
+            [&total] (char const *suffix, KvpValue *value, std::map<std::string, int64_t> &counts)
+            {
+                if (strlen (suffix) != GUID_ENCODING_LENGTH) return;
+                counts[suffix] = value->get<int64_t>();
+                total += value->get<int64_t>();
+            }, counts);
+        for (auto const & count : counts)
+        {
+            auto p = (double)count.second / (double)total;
+            auto item = std::find_if (probs.begin (), probs.end (),
+                                      [&count] (decltype (probs)::value_type const & a)
+                                      { return a.first == count.first; });
+            if (item == probs.end ())
+                probs.push_back ({count.first, {p, 1 - p}});
+            else
+            {
+                item->second.first *= p;
+                item->second.second *= 1 - p;
+            }
+        }
+    }
+    std::string best;
+    int32_t best_prob = 0;
+    for (auto const & prob : probs)
+    {
+        int32_t p = prob.second.first / (prob.second.first + prob.second.second) * 100000;
+        if (p > best_prob)
+        {
+            best = prob.first;
+            best_prob = p;
+        }
+    }
+    return best_prob >= .90 * 100000 ? best : std::string {};
+}
+
+/* Not a pass/fail benchmark: it reports matching throughput against the
+ * slot walk and checks that both agree. */
+TEST_F (ImapBayesTest, FindAccountBayesThroughput)
+{
+    constexpr int n_tokens = 3000, n_lookups = 200;
+    auto root = qof_instance_get_slots (QOF_INSTANCE (t_bank_account));
+    Account *accounts[] {t_expense_account1, t_expense_account2, t_sav_account};
+    std::vector<std::string> guids;
+    for (auto acc : accounts)
+    {
+        auto guid = guid_to_string (xaccAccountGetGUID (acc));
+        guids.emplace_back (guid);
+        g_free (guid);
+    }
+    std::vector<std::string> words;
+    for (int i = 0; i < n_tokens; ++i)
+    {
+        words.push_back ("token" + std::to_string (i));
+        /* Each token mostly points at one account, sometimes at two. */
+        root->set_path ({std::string{IMAP_FRAME_BAYES} + "/" + words.back () + "/" + guids[i % 3]},
+                        new KvpValue {INT64_C (1) + i % 7});
+        if (i % 5 == 0)
+            root->set_path ({std::string{IMAP_FRAME_BAYES} + "/" + words.back () + "/" + guids[(i + 1) % 3]},
+                            new KvpValue {INT64_C (1)});
+    }
+    std::vector<GList*> lookups;
+    for (int i = 0; i < n_lookups; ++i)
+    {
+        GList *tokens = nullptr;
+        for (int j = 0; j < 4; ++j)
+            tokens = g_list_prepend (tokens, const_cast<char*>(words[(i * 37 + j * 3) % n_tokens].c_str ()));
+        lookups.push_back (tokens);
+    }
+
+    using clock = std::chrono::steady_clock;
+    auto start = clock::now ();
+    std::vector<Account*> found;
+    for (auto tokens : lookups)
+        found.push_back (gnc_account_imap_find_account_bayes (t_imap, tokens));
+    auto indexed = clock::now () - start;
+
+    start = clock::now ();
+    std::vector<std::string> expected;
+    for (auto tokens : lookups)
+        expected.push_back (reference_find_bayes (t_bank_account, tokens));
+    auto walked = clock::now () - start;
+
+    for (int i = 0; i < n_lookups; ++i)
+    {
+        std::string guid;
+        if (found[i])
+        {
+            auto str = guid_to_string (xaccAccountGetGUID (found[i]));
+            guid = str;
+            g_free (str);
+        }
+        EXPECT_EQ (expected[i], guid);
+        g_list_free (lookups[i]);
+    }
+    using ms = std::chrono::duration<double, std::milli>;
+    std::cout << n_lookups << " bayes lookups over " << n_tokens << " tokens: index "
+              << ms (indexed).count () << " ms (including build), slot walk "
+              << ms (walked).count () << " ms" << std::endl;
+}
+
 TEST_F (ImapBayesTest, get_bayes_info)
 {
     GList * tokens {nullptr};
@@ -0,0 +1,120 @@
+/***************************************************************************
+ *            test-book-close.cpp
+ *
+ *  Measures the memory a generated book takes and what closing it gives
+ *  back.
+ ****************************************************************************/
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ */
+/* Before test-stuff.h, whose failure macro breaks the C++ headers. */
+#include <chrono>
+#include "kvp-frame.hpp"
+#include "kvp-value.hpp"
+
+extern "C"
+{
+#include <config.h>
+#include <glib.h>
+#include <stdio.h>
+#ifdef __linux__
+#include <unistd.h>
+#endif
+#include "qof.h"
+#include "cashobjects.h"
+#include "test-stuff.h"
+#include "test-engine-stuff.h"
+}
+
+static const gint transaction_num = 2000;
+
+/* The resident set size in KiB, or -1 where we don't know how to get it. */
+static long
+resident_kib (void)
+{
+    long pages = -1;
+#ifdef __linux__
+    auto statm = fopen ("/proc/self/statm", "r");
+    if (statm)
+    {
+        long size;
+        if (fscanf (statm, "%ld %ld", &size, &pages) != 2)
+            pages = -1;
+        fclose (statm);
+    }
+    if (pages >= 0)
+        return pages * (sysconf (_SC_PAGESIZE) / 1024);
+#endif
+    return pages;
+}
+
+static void
+report (const char *when)
+{
+    auto& frames = KvpFrameImpl::slab_stats ();
+    auto& values = KvpValueImpl::slab_stats ();
+    auto rss = resident_kib ();
+
+    printf ("%-12s %8zu frames %8zu values live, %9zu bytes in KVP slabs, ",
+            when, frames.live, values.live, frames.bytes + values.bytes);
+    if (rss < 0)
+        printf ("RSS unknown\n");
+    else
+        printf ("RSS %ld KiB\n", rss);
+}
+
+static void
+run_test (void)
+{
+    using clock = std::chrono::steady_clock;
+    auto& frames = KvpFrameImpl::slab_stats ();
+
+    report ("before load");
+    auto start = clock::now ();
+    auto book = get_random_book ();
+    add_random_transactions_to_book (book, transaction_num);
+    std::chrono::duration<double> load_time = clock::now () - start;
+    report ("loaded");
+    auto frames_loaded = frames.live;
+
+    start = clock::now ();
+    qof_book_destroy (book);
+    std::chrono::duration<double> close_time = clock::now () - start;
+    report ("closed");
+
+    printf ("%d transactions generated in %.3f s, book closed in %.3f s\n",
+            transaction_num, load_time.count (), close_time.count ());
+    /* Every instance owns a frame, so the book must have added some and
+     * closing it must give them back. */
+    do_test (frames_loaded > 0, "the book holds KVP frames");
+    do_test (frames.live < frames_loaded, "closing the book frees KVP frames");
+}
+
+int
+main (int argc, char **argv)
+{
+    qof_init ();
+    if (!cashobjects_register ())
+        exit (1);
+
+    /* Set up a reproducible test-case */
+    srand (0);
+    run_test ();
+    print_test_results ();
+
+    qof_close ();
+    return get_rv ();
+}
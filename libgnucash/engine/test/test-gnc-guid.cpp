@@ -24,11 +24,17 @@
 
 #include "../guid.hpp"
 
+#include <boost/uuid/uuid_generators.hpp>
+#include <boost/uuid/uuid_io.hpp>
+#include <chrono>
+#include <cstring>
 #include <random>
+#include <set>
 #include <sstream>
 #include <iomanip>
 #include <string>
 #include <iostream>
+#include <vector>
 #include <gtest/gtest.h>
 #include <boost/version.hpp>
 
@@ -97,3 +103,128 @@ TEST (GncGUID, round_trip)
     EXPECT_EQ (guid1, guid2);
 }
 
+
+TEST (GncGUID, from_string_forms)
+{
+    auto guid = gnc::GUID::from_string ("0123456789abcdef0123456789ABCDEF");
+    EXPECT_EQ (guid.to_string (), "0123456789abcdef0123456789abcdef");
+    auto dashed = gnc::GUID::from_string ("01234567-89ab-cdef-0123-456789abcdef");
+    EXPECT_EQ (guid, dashed);
+
+    GncGUID gncguid = guid;
+    EXPECT_TRUE (string_to_guid ("0123456789abcdef0123456789abcdef", &gncguid));
+    EXPECT_EQ (guid, gncguid);
+    EXPECT_FALSE (string_to_guid ("0123456789abcdef0123456789abcdeg", &gncguid));
+    EXPECT_FALSE (string_to_guid ("0123456789abcdef", &gncguid));
+    EXPECT_FALSE (string_to_guid ("0123456789abcdef0123456789abcdef0", &gncguid));
+    EXPECT_EQ (guid, gncguid);
+}
+
+TEST (GncGUID, to_string_buff)
+{
+    auto guid = gnc::GUID::create_random ();
+    GncGUID gncguid = guid;
+    char buff[GUID_ENCODING_LENGTH + 1];
+    auto end = guid_to_string_buff (&gncguid, buff);
+    EXPECT_EQ (buff + GUID_ENCODING_LENGTH, end);
+    EXPECT_EQ (guid.to_string (), buff);
+    std::ostringstream expected;
+    for (auto byte : guid)
+        expected << std::hex << std::setw (2) << std::setfill ('0') <<
+            static_cast<unsigned> (byte);
+    EXPECT_EQ (expected.str (), buff);
+}
+
+TEST (GncGUID, replace_batch)
+{
+    std::vector<GncGUID> guids (1000);
+    guid_replace_batch (guids.data (), guids.size ());
+    std::set<std::string> strings;
+    for (auto& guid : guids)
+    {
+        // Version 4, variant 1 as for boost's random_generator.
+        EXPECT_EQ (0x40, guid.reserved[6] & 0xf0);
+        EXPECT_EQ (0x80, guid.reserved[8] & 0xc0);
+        strings.insert (gnc::GUID {guid}.to_string ());
+    }
+    EXPECT_EQ (guids.size (), strings.size ());
+}
+
+TEST (GncGUID, hash)
+{
+    /* Guids that differ only in their first or last byte must still
+     * spread over the buckets of a small table from either end of the hash. */
+    constexpr unsigned n_buckets = 64;
+    std::set<guint64> low_buckets, high_buckets;
+    GncGUID guid {};
+    for (auto i = 0; i < 256; ++i)
+    {
+        guid.reserved[i % 2 ? 0 : GUID_DATA_SIZE - 1] = i;
+        auto hash = guid_hash_to_guint64 (&guid);
+        low_buckets.insert (hash % n_buckets);
+        high_buckets.insert (hash >> 58);
+    }
+    EXPECT_GT (low_buckets.size (), n_buckets * 3 / 4);
+    EXPECT_GT (high_buckets.size (), n_buckets * 3 / 4);
+}
+
+TEST (GncGUID, performance)
+{
+    constexpr size_t n_guids = 200000;
+    using clock = std::chrono::steady_clock;
+    boost::uuids::random_generator gen;
+    std::vector<GncGUID> guids (n_guids);
+
+    auto start = clock::now ();
+    for (auto& guid : guids)
+        guid = gnc::GUID {gen ()};
+    std::chrono::duration<double> boost_time = clock::now () - start;
+
+    start = clock::now ();
+    for (auto& guid : guids)
+        guid_replace (&guid);
+    std::chrono::duration<double> replace_time = clock::now () - start;
+
+    start = clock::now ();
+    guid_replace_batch (guids.data (), guids.size ());
+    std::chrono::duration<double> batch_time = clock::now () - start;
+
+    std::vector<std::string> boost_strings;
+    boost_strings.reserve (n_guids);
+    start = clock::now ();
+    for (auto& guid : guids)
+    {
+        boost::uuids::uuid uuid;
+        memcpy (uuid.data, guid.reserved, sizeof (uuid.data));
+        boost_strings.push_back (boost::uuids::to_string (uuid));
+    }
+    std::chrono::duration<double> boost_str_time = clock::now () - start;
+
+    std::vector<char> buff (n_guids * (GUID_ENCODING_LENGTH + 1));
+    start = clock::now ();
+    for (size_t i = 0; i < n_guids; ++i)
+        guid_to_string_buff (&guids[i], &buff[i * (GUID_ENCODING_LENGTH + 1)]);
+    std::chrono::duration<double> str_time = clock::now () - start;
+
+    std::vector<GncGUID> parsed (n_guids);
+    start = clock::now ();
+    for (size_t i = 0; i < n_guids; ++i)
+        string_to_guid (&buff[i * (GUID_ENCODING_LENGTH + 1)], &parsed[i]);
+    std::chrono::duration<double> parse_time = clock::now () - start;
+
+    boost::uuids::string_generator strgen;
+    start = clock::now ();
+    for (auto& str : boost_strings)
+        strgen (str);
+    std::chrono::duration<double> boost_parse_time = clock::now () - start;
+
+    EXPECT_EQ (0, memcmp (guids.data (), parsed.data (),
+                          n_guids * sizeof (GncGUID)));
+    std::cout << n_guids << " guids: generating took " << boost_time.count () <<
+        "s with boost, " << replace_time.count () << "s with guid_replace and " <<
+        batch_time.count () << "s with guid_replace_batch; formatting took " <<
+        boost_str_time.count () << "s with boost and " << str_time.count () <<
+        "s with guid_to_string_buff; parsing took " <<
+        boost_parse_time.count () << "s with boost and " <<
+        parse_time.count () << "s with string_to_guid.\n";
+}
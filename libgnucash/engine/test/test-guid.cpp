@@ -36,6 +36,7 @@ extern "C"
 #include "test-engine-stuff.h"
 #include "qof.h"
 }
+#include <vector>
 #define NENT 50123
 
 static void test_null_guid(void)
@@ -52,6 +53,19 @@ static void test_null_guid(void)
     guid_free(gp);
 }
 
+static void
+collect_entity (QofInstance *ent, gpointer data)
+{
+    static_cast<std::vector<QofInstance*>*>(data)->push_back (ent);
+}
+
+static void
+remove_entity (QofInstance *ent, gpointer data)
+{
+    collect_entity (ent, data);
+    qof_collection_remove_entity (ent);
+}
+
 static void
 run_test (void)
 {
@@ -62,6 +76,7 @@ run_test (void)
     QofCollection *col;
     QofIdType type;
     GncGUID guid;
+    std::vector<QofInstance*> added, visited;
 
     sess = get_random_session ();
     book = qof_session_get_book (sess);
@@ -82,7 +97,27 @@ run_test (void)
         qof_collection_insert_entity (col, ent);
         do_test ((NULL != qof_collection_lookup_entity (col, &guid)),
                  "guid not found");
+        added.push_back (ent);
+    }
+    do_test (qof_collection_count (col) == NENT, "wrong count");
+    qof_collection_foreach (col, collect_entity, &visited);
+    do_test (visited == added, "foreach not in insertion order");
+
+    /* Remove every other entity and check that the rest are still found. */
+    for (i = 0; i < NENT; i += 2)
+        qof_collection_remove_entity (added[i]);
+    for (i = 0; i < NENT; i++)
+    {
+        ent = qof_collection_lookup_entity (col, qof_instance_get_guid (added[i]));
+        do_test (ent == (i % 2 ? added[i] : NULL), "wrong entity after removal");
     }
+    do_test (qof_collection_count (col) == NENT / 2, "wrong count after removal");
+
+    /* Entities can remove themselves while the collection is traversed. */
+    visited.clear ();
+    qof_collection_foreach (col, remove_entity, &visited);
+    do_test (visited.size () == NENT / 2, "wrong number visited while removing");
+    do_test (qof_collection_count (col) == 0, "collection not emptied");
 
     /* Make valgrind happy -- destroy the session. */
     qof_session_destroy(sess);
@@ -226,3 +226,49 @@ TEST (KvpFrameTestForEachPrefix, for_each_prefix_2)
             EXPECT_EQ(value->get_type(), KvpValue::Type::INT64);
         }, count);
 }
+
+TEST (KvpFrameTestSlab, allocate_and_release)
+{
+    auto& frames = KvpFrameImpl::slab_stats ();
+    auto& values = KvpValueImpl::slab_stats ();
+    auto frames_live = frames.live;
+    auto values_live = values.live;
+    auto values_allocated = values.allocated;
+
+    auto f1 = new KvpFrame;
+    f1->set({"a"}, new KvpValue {INT64_C(1)});
+    f1->set_path({"b", "c"}, new KvpValue {2.0});
+    EXPECT_EQ (frames.live, frames_live + 2);
+    EXPECT_EQ (values.live, values_live + 2);
+    EXPECT_EQ (values.allocated, values_allocated + 2);
+    EXPECT_GT (frames.bytes, 0u);
+    /* Nothing is released while frames are alive. */
+    EXPECT_FALSE (KvpFrameImpl::release_slab ());
+    delete f1;
+    EXPECT_EQ (frames.live, frames_live);
+    EXPECT_EQ (values.live, values_live);
+    if (frames_live == 0)
+    {
+        EXPECT_TRUE (KvpFrameImpl::release_slab ());
+        EXPECT_EQ (frames.bytes, 0u);
+        EXPECT_EQ (frames.blocks, 0u);
+    }
+}
+
+TEST (KvpFrameTestSlab, reuse)
+{
+    QofSlab<KvpValue, 4> slab;
+    void* chunks[5];
+    for (auto& chunk : chunks)
+        chunk = slab.allocate (sizeof (KvpValue));
+    EXPECT_EQ (slab.stats ().blocks, 2u);
+    EXPECT_EQ (slab.stats ().live, 5u);
+    slab.deallocate (chunks[2], sizeof (KvpValue));
+    EXPECT_EQ (slab.allocate (sizeof (KvpValue)), chunks[2]);
+    EXPECT_FALSE (slab.release ());
+    for (auto chunk : chunks)
+        slab.deallocate (chunk, sizeof (KvpValue));
+    EXPECT_EQ (slab.stats ().allocated, 6u);
+    EXPECT_TRUE (slab.release ());
+    EXPECT_EQ (slab.stats ().bytes, 0u);
+}
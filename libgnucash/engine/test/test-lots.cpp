@@ -36,11 +36,166 @@ extern "C"
 #include "test-stuff.h"
 #include "test-engine-stuff.h"
 #include "Transaction.h"
+#include "gnc-lot.h"
+#include "cap-gains.h"
 }
 
 static gint transaction_num = 32;
 static gint	max_iterate = 1;
 
+/* The lot answers gnc_lot_get_balance_before from running totals; check
+ * them against a walk comparing every split's transaction. */
+static void
+check_balance_before (GNCLot *lot)
+{
+    auto order_source = [](Split *split)
+                        {
+                            auto source = xaccSplitGetGainsSourceSplit (split);
+                            return source ? source : split;
+                        };
+    auto splits = gnc_lot_get_split_list (lot);
+
+    for (auto tnode = splits; tnode; tnode = tnode->next)
+    {
+        auto target = order_source (static_cast<Split*>(tnode->data));
+        auto tb = xaccSplitGetParent (target);
+        gnc_numeric amount = gnc_numeric_zero (), value = gnc_numeric_zero ();
+        gnc_numeric lot_amount, lot_value;
+
+        for (auto node = splits; node; node = node->next)
+        {
+            auto split = static_cast<Split*>(node->data);
+            auto source = order_source (split);
+            auto ta = xaccSplitGetParent (source);
+            if ((ta == tb && source != target) || xaccTransOrder (ta, tb) < 0)
+            {
+                amount = gnc_numeric_add_fixed (amount, xaccSplitGetAmount (split));
+                value = gnc_numeric_add_fixed (value, xaccSplitGetValue (split));
+            }
+        }
+        gnc_lot_get_balance_before (lot, static_cast<Split*>(tnode->data),
+                                    &lot_amount, &lot_value);
+        if (!gnc_numeric_equal (amount, lot_amount) ||
+            !gnc_numeric_equal (value, lot_value))
+            failure ("lot balance before a split differs from a walk of its splits");
+    }
+}
+
+/* The lot caches its balance and keeps its splits sorted; check both
+ * against a plain walk of the split list. */
+static gpointer
+check_lot_cache (GNCLot *lot, gpointer data)
+{
+    gnc_numeric sum = gnc_numeric_zero ();
+    auto posted = [](Split *split)
+                  { return xaccTransRetDatePosted (xaccSplitGetParent (split)); };
+    Split *earliest = gnc_lot_get_earliest_split (lot);
+    Split *latest = gnc_lot_get_latest_split (lot);
+
+    for (auto node = gnc_lot_get_split_list (lot); node; node = node->next)
+    {
+        auto split = static_cast<Split*>(node->data);
+        sum = gnc_numeric_add_fixed (sum, xaccSplitGetAmount (split));
+        if (posted (split) < posted (earliest))
+            failure ("lot earliest split is not the earliest");
+        if (posted (split) > posted (latest))
+            failure ("lot latest split is not the latest");
+    }
+    if (!gnc_numeric_equal (sum, gnc_lot_get_balance (lot)))
+        failure ("cached lot balance differs from the sum of its splits");
+    check_balance_before (lot);
+    return NULL;
+}
+
+static time64
+opening_date (GNCLot *lot)
+{
+    if (!lot) return 0;
+    return xaccTransRetDatePosted (xaccSplitGetParent (gnc_lot_get_earliest_split (lot)));
+}
+
+/* The open-lot index must find a lot opened on the same date as a scan
+ * of all the account's lots does. */
+static void
+check_open_lots (Account *acc, gboolean positive)
+{
+    GNCLot *earliest = nullptr, *latest = nullptr;
+    auto sign = positive ? gnc_numeric_create (-1, 1) : gnc_numeric_create (1, 1);
+    auto lots = xaccAccountGetLotList (acc);
+
+    for (auto node = lots; node; node = node->next)
+    {
+        auto lot = static_cast<GNCLot*>(node->data);
+        auto split = gnc_lot_get_earliest_split (lot);
+        if (gnc_lot_is_closed (lot) || !split ||
+            gnc_numeric_zero_p (xaccSplitGetAmount (split)))
+            continue;
+        auto open_pos = gnc_numeric_positive_p (xaccSplitGetAmount (split));
+        if (open_pos != positive ||
+            open_pos != gnc_numeric_positive_p (gnc_lot_get_balance (lot)))
+            continue;
+        if (!earliest || opening_date (lot) < opening_date (earliest))
+            earliest = lot;
+        if (!latest || opening_date (lot) > opening_date (latest))
+            latest = lot;
+    }
+    g_list_free (lots);
+
+    auto found = xaccAccountFindEarliestOpenLot (acc, sign, nullptr);
+    if ((found == nullptr) != (earliest == nullptr) ||
+        opening_date (found) != opening_date (earliest))
+        failure ("wrong earliest open lot");
+    found = xaccAccountFindLatestOpenLot (acc, sign, nullptr);
+    if ((found == nullptr) != (latest == nullptr) ||
+        opening_date (found) != opening_date (latest))
+        failure ("wrong latest open lot");
+}
+
+static void
+check_lot_caches (Account *acc, gpointer data)
+{
+    xaccAccountForEachLot (acc, check_lot_cache, NULL);
+    check_open_lots (acc, TRUE);
+    check_open_lots (acc, FALSE);
+}
+
+/* Collect the transaction of each lot's latest split ... */
+static gpointer
+collect_latest_trans (GNCLot *lot, gpointer data)
+{
+    auto trans = xaccSplitGetParent (gnc_lot_get_latest_split (lot));
+    auto list = static_cast<GList**>(data);
+    if (trans && !g_list_find (*list, trans))
+        *list = g_list_prepend (*list, trans);
+    return NULL;
+}
+
+static void
+collect_lots_latest_trans (Account *acc, gpointer data)
+{
+    xaccAccountForEachLot (acc, collect_latest_trans, data);
+}
+
+/* ... and move it a year back, ahead of the lot's other splits, so that the
+ * lots have to notice the date changes. */
+static void
+move_lots_latest_trans (Account *root)
+{
+    GList *transactions = nullptr;
+
+    gnc_account_foreach_descendant (root, collect_lots_latest_trans, &transactions);
+    for (auto node = transactions; node; node = node->next)
+    {
+        auto trans = static_cast<Transaction*>(node->data);
+        if (xaccTransGetReadOnly (trans))
+            continue;
+        xaccTransBeginEdit (trans);
+        xaccTransSetDatePostedSecs (trans, xaccTransRetDatePosted (trans) - 366 * 86400);
+        xaccTransCommitEdit (trans);
+    }
+    g_list_free (transactions);
+}
+
 static void
 run_test (void)
 {
@@ -59,6 +214,9 @@ run_test (void)
 
     root = gnc_book_get_root_account (book);
     xaccAccountTreeScrubLots (root);
+    gnc_account_foreach_descendant (root, check_lot_caches, NULL);
+    move_lots_latest_trans (root);
+    gnc_account_foreach_descendant (root, check_lot_caches, NULL);
 
     /* --------------------------------------------------------- */
     /* In the second test, we create an account with unrealized gains,
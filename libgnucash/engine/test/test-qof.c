@@ -31,6 +31,7 @@ extern void test_suite_qofinstance();
 extern void test_suite_qofobject();
 extern void test_suite_gnc_date();
 extern void test_suite_qof_string_cache();
+extern void test_suite_qofevent();
 
 int
 main (int   argc,
@@ -48,6 +49,7 @@ main (int   argc,
     test_suite_qofobject();
     test_suite_gnc_date();
     test_suite_qof_string_cache();
+    test_suite_qofevent();
 
     return g_test_run( );
 }
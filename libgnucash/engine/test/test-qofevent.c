@@ -0,0 +1,199 @@
+/********************************************************************
+ * test-qofevent.c: GLib g_test test suite for qofevent.cpp.        *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+
+#include <config.h>
+#include <glib.h>
+#include <unittest-support.h>
+#include "qof.h"
+
+static const gchar *suitename = "/qof/qofevent";
+void test_suite_qofevent ( void );
+
+typedef struct
+{
+    QofInstance *inst1;
+    QofInstance *inst2;
+    guint legacy_calls;
+    QofEventId legacy_events[8];
+    guint batch_calls;
+    guint batch_events;
+    gint legacy_id;
+    gint batch_id;
+} Fixture;
+
+static void
+legacy_handler (QofInstance *ent, QofEventId event_type,
+                gpointer handler_data, gpointer event_data)
+{
+    Fixture *fixture = handler_data;
+    if (fixture->legacy_calls < G_N_ELEMENTS (fixture->legacy_events))
+        fixture->legacy_events[fixture->legacy_calls] = event_type;
+    fixture->legacy_calls++;
+}
+
+static void
+batch_handler (const QofEventRecord *events, guint n_events,
+               gpointer handler_data)
+{
+    Fixture *fixture = handler_data;
+    fixture->batch_calls++;
+    fixture->batch_events += n_events;
+}
+
+static void
+setup( Fixture *fixture, gconstpointer pData )
+{
+    fixture->inst1 = g_object_new (QOF_TYPE_INSTANCE, NULL);
+    fixture->inst2 = g_object_new (QOF_TYPE_INSTANCE, NULL);
+    fixture->legacy_calls = fixture->batch_calls = fixture->batch_events = 0;
+    fixture->legacy_id = qof_event_register_handler (legacy_handler, fixture);
+    fixture->batch_id = qof_event_register_batch_handler (batch_handler,
+                                                          fixture);
+    qof_event_reset_stats ();
+}
+
+static void
+teardown( Fixture *fixture, gconstpointer pData )
+{
+    qof_event_unregister_handler (fixture->legacy_id);
+    qof_event_unregister_handler (fixture->batch_id);
+    g_object_unref (fixture->inst1);
+    g_object_unref (fixture->inst2);
+}
+
+static void
+test_qof_event_unbatched (Fixture *fixture, gconstpointer pData)
+{
+    QofEventStats stats;
+
+    qof_event_gen (fixture->inst1, QOF_EVENT_MODIFY, NULL);
+    qof_event_gen (fixture->inst1, QOF_EVENT_MODIFY, NULL);
+    g_assert_cmpuint (fixture->legacy_calls, ==, 2);
+    g_assert_cmpuint (fixture->batch_calls, ==, 2);
+    g_assert_cmpuint (fixture->batch_events, ==, 2);
+
+    qof_event_get_stats (&stats);
+    g_assert_cmpuint (stats.generated, ==, 2);
+    g_assert_cmpuint (stats.queued, ==, 0);
+    g_assert_cmpuint (stats.delivered, ==, 4);
+}
+
+static void
+test_qof_event_batch_coalesce (Fixture *fixture, gconstpointer pData)
+{
+    QofEventStats stats;
+    int i;
+
+    qof_event_begin_batch ();
+    g_assert (qof_event_is_batching ());
+    for (i = 0; i < 10; ++i)
+    {
+        qof_event_gen (fixture->inst1, QOF_EVENT_MODIFY, NULL);
+        qof_event_gen (fixture->inst2, QOF_EVENT_MODIFY, NULL);
+    }
+    qof_event_gen (fixture->inst2, QOF_EVENT_ADD, NULL);
+    /* Nested batches are delivered by the outermost end. */
+    qof_event_begin_batch ();
+    qof_event_gen (fixture->inst1, QOF_EVENT_MODIFY, NULL);
+    qof_event_end_batch ();
+    g_assert_cmpuint (fixture->legacy_calls, ==, 0);
+    g_assert_cmpuint (fixture->batch_calls, ==, 0);
+    qof_event_end_batch ();
+    g_assert (!qof_event_is_batching ());
+
+    g_assert_cmpuint (fixture->legacy_calls, ==, 3);
+    g_assert_cmpuint (fixture->batch_calls, ==, 1);
+    g_assert_cmpuint (fixture->batch_events, ==, 3);
+
+    qof_event_get_stats (&stats);
+    g_assert_cmpuint (stats.generated, ==, 22);
+    g_assert_cmpuint (stats.queued, ==, 3);
+    g_assert_cmpuint (stats.coalesced, ==, 19);
+    g_assert_cmpuint (stats.batches, ==, 1);
+    g_assert_cmpuint (stats.delivered, ==, 4);
+}
+
+static void
+test_qof_event_batch_payload_and_destroy (Fixture *fixture,
+                                          gconstpointer pData)
+{
+    QofEventStats stats;
+
+    qof_event_begin_batch ();
+    qof_event_gen (fixture->inst1, QOF_EVENT_MODIFY, NULL);
+    qof_event_gen (fixture->inst2, QOF_EVENT_MODIFY, NULL);
+    /* Events with a payload aren't deferred, and the entity's queued
+     * events are delivered ahead of them. */
+    qof_event_gen (fixture->inst1, QOF_EVENT_ADD, fixture);
+    g_assert_cmpuint (fixture->legacy_calls, ==, 2);
+    g_assert_cmpint (fixture->legacy_events[0], ==, QOF_EVENT_MODIFY);
+    g_assert_cmpint (fixture->legacy_events[1], ==, QOF_EVENT_ADD);
+    /* A destroy is delivered now and cancels the entity's queued events. */
+    qof_event_gen (fixture->inst1, QOF_EVENT_MODIFY, NULL);
+    qof_event_gen (fixture->inst1, QOF_EVENT_DESTROY, NULL);
+    g_assert_cmpuint (fixture->legacy_calls, ==, 3);
+    g_assert_cmpint (fixture->legacy_events[2], ==, QOF_EVENT_DESTROY);
+    qof_event_end_batch ();
+
+    g_assert_cmpuint (fixture->legacy_calls, ==, 4);
+    g_assert_cmpint (fixture->legacy_events[3], ==, QOF_EVENT_MODIFY);
+    g_assert_cmpuint (fixture->batch_calls, ==, 4);
+    g_assert_cmpuint (fixture->batch_events, ==, 4);
+
+    qof_event_get_stats (&stats);
+    g_assert_cmpuint (stats.queued, ==, 3);
+    g_assert_cmpuint (stats.dropped, ==, 1);
+}
+
+static void
+test_qof_event_batch_suspended_destroy (Fixture *fixture,
+                                        gconstpointer pData)
+{
+    QofEventStats stats;
+
+    qof_event_begin_batch ();
+    qof_event_gen (fixture->inst1, QOF_EVENT_MODIFY, NULL);
+    qof_event_gen (fixture->inst2, QOF_EVENT_MODIFY, NULL);
+    /* An unannounced destroy still forgets the entity's queued events. */
+    qof_event_suspend ();
+    qof_event_gen (fixture->inst1, QOF_EVENT_DESTROY, NULL);
+    qof_event_resume ();
+    g_assert_cmpuint (fixture->legacy_calls, ==, 0);
+    qof_event_end_batch ();
+
+    g_assert_cmpuint (fixture->legacy_calls, ==, 1);
+    g_assert_cmpuint (fixture->batch_events, ==, 1);
+    qof_event_get_stats (&stats);
+    g_assert_cmpuint (stats.dropped, ==, 1);
+}
+
+void
+test_suite_qofevent ( void )
+{
+    GNC_TEST_ADD( suitename, "unbatched", Fixture, NULL, setup,
+                  test_qof_event_unbatched, teardown );
+    GNC_TEST_ADD( suitename, "batch coalesce", Fixture, NULL, setup,
+                  test_qof_event_batch_coalesce, teardown );
+    GNC_TEST_ADD( suitename, "batch payload and destroy", Fixture, NULL, setup,
+                  test_qof_event_batch_payload_and_destroy, teardown );
+    GNC_TEST_ADD( suitename, "batch suspended destroy", Fixture, NULL, setup,
+                  test_qof_event_batch_suspended_destroy, teardown );
+}
@@ -0,0 +1,236 @@
+/***************************************************************************
+ *            test-scrub.cpp
+ *
+ ****************************************************************************/
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ */
+/**
+ * @file test-scrub.cpp
+ * @brief Check that the tree-wide scrubbers, which check the transactions
+ * on several threads, repair a book the same way as scrubbing it one
+ * account at a time.
+ */
+extern "C"
+{
+#include <config.h>
+#include <glib.h>
+#include "qof.h"
+#include "Account.h"
+#include "Scrub.h"
+#include "cashobjects.h"
+#include "test-stuff.h"
+#include "Transaction.h"
+#include "TransactionP.h"
+#include "SplitP.h"
+}
+#include <string>
+#include <vector>
+
+/* Well above the number of transactions the check runs in parallel for. */
+static const int transaction_num = 3000;
+
+static void
+no_progress (const char *message, double percent)
+{
+}
+
+static Account *
+make_account (QofBook *book, Account *parent, const char *name,
+              gnc_commodity *comm, GNCAccountType type)
+{
+    auto acc = xaccMallocAccount (book);
+    xaccAccountBeginEdit (acc);
+    xaccAccountSetName (acc, name);
+    xaccAccountSetCommodity (acc, comm);
+    xaccAccountSetType (acc, type);
+    gnc_account_append_child (parent, acc);
+    xaccAccountCommitEdit (acc);
+    return acc;
+}
+
+static Split *
+add_split (Transaction *trans, Account *acc, gnc_numeric amount,
+           gnc_numeric value)
+{
+    auto split = xaccMallocSplit (xaccTransGetBook (trans));
+    xaccSplitSetParent (split, trans);
+    if (acc)
+        xaccSplitSetAccount (split, acc);
+    xaccSplitSetAmount (split, amount);
+    xaccSplitSetValue (split, value);
+    return split;
+}
+
+/* Builds the same book every time: mostly clean transactions, with
+ * every tenth one an orphan, an imbalance, a split off its SCU or an
+ * amount that differs from the value in the transaction's currency. */
+static std::vector<Transaction*>
+build_book (QofBook *book)
+{
+    std::vector<Transaction*> txns;
+    auto table = gnc_commodity_table_get_table (book);
+    auto usd = gnc_commodity_table_lookup (table, GNC_COMMODITY_NS_CURRENCY,
+                                           "USD");
+    auto root = gnc_book_get_root_account (book);
+    auto bank = make_account (book, root, "Bank", usd, ACCT_TYPE_BANK);
+    auto expense = make_account (book, root, "Expenses", usd,
+                                 ACCT_TYPE_EXPENSE);
+    auto income = make_account (book, root, "Income", usd, ACCT_TYPE_INCOME);
+
+    xaccDisableDataScrubbing ();
+    for (int i = 0; i < transaction_num; i++)
+    {
+        auto trans = xaccMallocTransaction (book);
+        auto other = i % 2 ? expense : income;
+        auto amt = gnc_numeric_create (100 + i, 100);
+        auto neg = gnc_numeric_neg (amt);
+
+        xaccTransBeginEdit (trans);
+        xaccTransSetCurrency (trans, usd);
+        xaccTransSetDatePostedSecsNormalized (trans, 1500000000 + i * 3600);
+        xaccTransSetDescription (trans, std::to_string (i).c_str ());
+        add_split (trans, bank, amt, amt);
+        switch (i % 10)
+        {
+        case 1:                 /* orphan */
+            add_split (trans, nullptr, neg, neg);
+            break;
+        case 3:                 /* imbalance */
+            add_split (trans, other, gnc_numeric_create (-90, 100),
+                       gnc_numeric_create (-90, 100));
+            break;
+        case 5:                 /* off the SCU */
+        {
+            auto split = add_split (trans, other, neg, neg);
+            split->amount = gnc_numeric_create (-(1000 + 10 * i + 3), 1000);
+            split->value = split->amount;
+            break;
+        }
+        case 7:                 /* amount differs from value */
+        {
+            auto split = add_split (trans, other, neg, neg);
+            split->amount = gnc_numeric_create (-(100 + i + 5), 100);
+            break;
+        }
+        default:
+            add_split (trans, other, neg, neg);
+            break;
+        }
+        xaccTransCommitEdit (trans);
+        txns.push_back (trans);
+    }
+    xaccEnableDataScrubbing ();
+    return txns;
+}
+
+static std::string
+describe_trans (Transaction *trans)
+{
+    std::string desc;
+    for (auto node = xaccTransGetSplitList (trans); node; node = node->next)
+    {
+        auto split = static_cast<Split*>(node->data);
+        auto acc = xaccSplitGetAccount (split);
+        auto name = acc ? gnc_account_get_full_name (acc) : g_strdup ("(none)");
+        auto amount = gnc_numeric_to_string (xaccSplitGetAmount (split));
+        auto value = gnc_numeric_to_string (xaccSplitGetValue (split));
+        desc = desc + name + " " + amount + " " + value + "; ";
+        g_free (name);
+        g_free (amount);
+        g_free (value);
+    }
+    return desc;
+}
+
+static std::string
+describe_accounts (Account *root)
+{
+    std::string desc;
+    auto accts = gnc_account_get_descendants_sorted (root);
+    for (auto node = accts; node; node = node->next)
+    {
+        auto acc = static_cast<Account*>(node->data);
+        auto name = gnc_account_get_full_name (acc);
+        desc = desc + name + "; ";
+        g_free (name);
+    }
+    g_list_free (accts);
+    return desc;
+}
+
+static void
+run_test (void)
+{
+    auto serial_book = qof_book_new ();
+    auto tree_book = qof_book_new ();
+    auto serial = build_book (serial_book);
+    auto tree = build_book (tree_book);
+    auto serial_root = gnc_book_get_root_account (serial_book);
+    auto tree_root = gnc_book_get_root_account (tree_book);
+    int mismatches = 0;
+
+    do_test (describe_trans (serial[1]) == describe_trans (tree[1]),
+             "books built alike");
+    do_test (!xaccTransIsBalanced (tree[3]), "imbalance injected");
+
+    /* One account at a time, every transaction of every split. */
+    auto accts = gnc_account_get_descendants (serial_root);
+    for (auto node = accts; node; node = node->next)
+        xaccAccountScrubOrphans (static_cast<Account*>(node->data),
+                                 no_progress);
+    for (auto node = accts; node; node = node->next)
+        xaccAccountScrubImbalance (static_cast<Account*>(node->data),
+                                   no_progress);
+    g_list_free (accts);
+
+    /* The whole tree at once, checked in parallel. */
+    xaccAccountTreeScrubOrphans (tree_root, no_progress);
+    xaccAccountTreeScrubImbalance (tree_root, no_progress);
+
+    for (int i = 0; i < transaction_num; i++)
+        if (describe_trans (serial[i]) != describe_trans (tree[i]))
+        {
+            if (!mismatches++)
+                fprintf (stderr, "transaction %d:\n serial %s\n tree   %s\n",
+                         i, describe_trans (serial[i]).c_str (),
+                         describe_trans (tree[i]).c_str ());
+        }
+    do_test (mismatches == 0, "tree scrub repairs like the serial scrub");
+    do_test (describe_accounts (serial_root) == describe_accounts (tree_root),
+             "tree scrub creates the same accounts");
+    do_test (xaccTransIsBalanced (tree[3]), "imbalance repaired");
+    do_test (xaccSplitGetAccount (xaccTransGetSplit (tree[1], 1)) != nullptr,
+             "orphan repaired");
+
+    qof_book_destroy (tree_book);
+    qof_book_destroy (serial_book);
+}
+
+int
+main (int argc, char **argv)
+{
+    qof_init();
+    if (!cashobjects_register())
+        exit(1);
+
+    g_log_set_always_fatal((GLogLevelFlags)(G_LOG_LEVEL_CRITICAL | G_LOG_LEVEL_WARNING));
+    run_test ();
+    print_test_results();
+
+    qof_close();
+    return get_rv();
+}
@@ -31,6 +31,7 @@ extern "C"
 #include "../Account.h"
 #include "../AccountP.h"
 #include "../Split.h"
+#include "../SplitP.h"
 #include "../Transaction.h"
 #include "../gnc-lot.h"
 
@@ -1185,8 +1186,161 @@ test_gnc_account_insert_remove_split (Fixture *fixture, gconstpointer pData)
 void
 xaccAccountSortSplits (Account *acc, gboolean force)// C: 4 in 2
 Make static?
-Passthrough, no test.
 */
+/* Few distinct values in each field, so that many splits share their sort
+ * key and xaccSplitOrder has to settle the order on memo, action or guid.
+ */
+static void
+fill_sort_account (Account *acct, guint count)
+{
+    static const char *nums[] = { "", "1", "2", "10", "x" };
+    static const char *actions[] = { "1", "2", "3", "" };
+    static const char *texts[] = { "", "a", "b" };
+    const time64 base = 1420070400; /* 2015-01-01 */
+    auto book = gnc_account_get_book (acct);
+
+    /* Keep gnc_account_insert_split from sorting on every insert. */
+    xaccAccountBeginEdit (acct);
+    for (guint i = 0; i < count; i++)
+    {
+        auto txn = xaccMallocTransaction (book);
+        auto split = xaccMallocSplit (book);
+        auto amount = gnc_numeric_create (g_test_rand_int_range (-2, 3), 1);
+
+        xaccTransBeginEdit (txn);
+        xaccTransSetDatePostedSecs (txn, base + g_test_rand_int_range (0, 8) * 86400);
+        xaccTransSetDateEnteredSecs (txn, base + g_test_rand_int_range (0, 3));
+        xaccTransSetNum (txn, nums[g_test_rand_int_range (0, G_N_ELEMENTS (nums))]);
+        xaccTransSetDescription (txn, texts[g_test_rand_int_range (0, G_N_ELEMENTS (texts))]);
+        xaccSplitSetParent (split, txn);
+        xaccSplitSetMemo (split, texts[g_test_rand_int_range (0, G_N_ELEMENTS (texts))]);
+        xaccSplitSetAction (split, actions[g_test_rand_int_range (0, G_N_ELEMENTS (actions))]);
+        g_object_set (split,
+                      "account", acct,
+                      "amount", &amount,
+                      "value", &amount,
+                      NULL);
+        gnc_account_insert_split (acct, split);
+        /* xaccTransCommitEdit () does a bunch of scrubbing that we don't need */
+        qof_commit_edit (QOF_INSTANCE (txn));
+    }
+}
+
+static void
+shuffle_splits (AccountPrivate *priv)
+{
+    auto splits = g_ptr_array_new ();
+    for (auto node = priv->splits; node; node = node->next)
+        g_ptr_array_add (splits, node->data);
+    for (guint i = splits->len; i > 1; i--)
+    {
+        auto j = g_test_rand_int_range (0, i);
+        auto tmp = splits->pdata[i - 1];
+        splits->pdata[i - 1] = splits->pdata[j];
+        splits->pdata[j] = tmp;
+    }
+    guint i = 0;
+    for (auto node = priv->splits; node; node = node->next)
+        node->data = splits->pdata[i++];
+    g_ptr_array_free (splits, TRUE);
+    priv->sort_dirty = TRUE;
+}
+
+static void
+set_split_action_num (Account *acct, const char *value)
+{
+    auto book = gnc_account_get_book (acct);
+    qof_book_begin_edit (book);
+    qof_instance_set (QOF_INSTANCE (book), "split-action-num-field", value, NULL);
+    qof_book_commit_edit (book);
+}
+
+/* Sort the account's splits with xaccAccountSortSplits and a copy of them
+ * with g_list_sort and xaccSplitOrder, then check the orders agree. */
+static void
+check_sort_order (Account *acct, AccountPrivate *priv)
+{
+    auto expected = g_list_sort (g_list_copy (priv->splits),
+                                 (GCompareFunc)xaccSplitOrder);
+    g_assert (priv->sort_dirty);
+    xaccAccountSortSplits (acct, TRUE);
+    g_assert (!priv->sort_dirty);
+    g_assert_cmpuint (g_list_length (priv->splits), ==,
+                      g_list_length (expected));
+    auto index = 0;
+    for (auto a = priv->splits, b = expected; a && b;
+         a = a->next, b = b->next, ++index)
+    {
+        if (a->data != b->data)
+            g_test_message ("Orders differ at split %d", index);
+        g_assert (a->data == b->data);
+    }
+    g_list_free (expected);
+}
+
+static void
+test_xaccAccountSortSplits (Fixture *fixture, gconstpointer pData)
+{
+    auto acct = fixture->acct;
+    auto priv = fixture->func->get_private (acct);
+
+    fill_sort_account (acct, 3000);
+    check_sort_order (acct, priv);
+
+    /* Sort on the split actions: every split has one, so the sort keys
+     * still decide most comparisons. */
+    set_split_action_num (acct, "t");
+    shuffle_splits (priv);
+    check_sort_order (acct, priv);
+
+    /* A split without an action makes xaccSplitOrder fall back to the
+     * transaction num for it, which its sort key can't express, so the
+     * whole list takes the g_list_sort path. */
+    auto split = static_cast<Split*>(g_list_nth_data (priv->splits, 1500));
+    CACHE_REMOVE (split->action);
+    split->action = NULL;
+    shuffle_splits (priv);
+    check_sort_order (acct, priv);
+    split->action = static_cast<char*>(CACHE_INSERT (""));
+
+    set_split_action_num (acct, "f");
+    shuffle_splits (priv);
+    check_sort_order (acct, priv);
+    xaccAccountCommitEdit (acct);
+}
+
+/* Times xaccAccountSortSplits, which calls the static sort_splits, against
+ * g_list_sort with xaccSplitOrder on the same shuffled splits. Run with
+ * -m perf for a book-sized account. */
+static void
+test_xaccAccountSortSplits_bench (Fixture *fixture, gconstpointer pData)
+{
+    auto acct = fixture->acct;
+    auto priv = fixture->func->get_private (acct);
+    guint count = g_test_perf () ? 200000 : 20000;
+
+    fill_sort_account (acct, count);
+    shuffle_splits (priv);
+    auto copy = g_list_copy (priv->splits);
+
+    g_test_timer_start ();
+    copy = g_list_sort (copy, (GCompareFunc)xaccSplitOrder);
+    auto list_time = g_test_timer_elapsed ();
+
+    g_test_timer_start ();
+    xaccAccountSortSplits (acct, TRUE);
+    auto key_time = g_test_timer_elapsed ();
+
+    g_test_message ("%u splits: g_list_sort %.3f s, xaccAccountSortSplits %.3f s",
+                    count, list_time, key_time);
+    g_test_minimized_result (key_time, "xaccAccountSortSplits of %u splits",
+                             count);
+    g_assert (g_list_length (copy) == count);
+    for (auto a = priv->splits, b = copy; a && b; a = a->next, b = b->next)
+        g_assert (a->data == b->data);
+    g_list_free (copy);
+    xaccAccountCommitEdit (acct);
+}
 /* xaccAccountBringUpToDate
 static void
 xaccAccountBringUpToDate (Account *acc)// 3
@@ -1934,6 +2088,47 @@ test_xaccAccountGetBalanceAsOfDate (Fixture *fixture, gconstpointer pData)
     dval = gnc_numeric_to_double (val);
     g_assert_cmpfloat (dval, == , dbal);
 }
+/* xaccAccountsGetBalancesAtDates
+void
+xaccAccountsGetBalancesAtDates (Account **accounts, guint n_accounts,*/
+static void
+test_xaccAccountsGetBalancesAtDates (Fixture *fixture, gconstpointer pData)
+{
+    Account *root = gnc_account_get_root (fixture->acct);
+    Account *accounts[] = { gnc_account_lookup_by_name (root, "baz"),
+                            gnc_account_lookup_by_name (root, "meh"),
+                            gnc_account_lookup_by_name (root, "foo") };
+    const guint n_accounts = G_N_ELEMENTS (accounts), n_dates = 5;
+    time64 now = gnc_time (NULL), day = 24 * 3600;
+    /* Between the transactions, which are 9, 7 and 2 days ago and 3 and
+     * 5 days ahead. */
+    time64 dates[] = { now - 8 * day, now - 3 * day, now + 7,
+                       now + 4 * day, now + 6 * day };
+    gnc_numeric balances[n_accounts * n_dates];
+    gnc_numeric changes[n_accounts * n_dates];
+
+    xaccAccountsGetBalancesAtDates (accounts, n_accounts, dates, n_dates,
+                                    FALSE, FALSE, balances);
+    xaccAccountsGetBalancesAtDates (accounts, n_accounts, dates, n_dates,
+                                    FALSE, TRUE, changes);
+    for (guint i = 0; i < n_accounts; i++)
+    {
+        gnc_numeric prev = gnc_numeric_zero ();
+        g_assert (accounts[i]);
+        for (guint j = 0; j < n_dates; j++)
+        {
+            gnc_numeric bal = xaccAccountGetBalanceAsOfDate (accounts[i],
+                                                             dates[j]);
+            g_assert (gnc_numeric_equal (balances[i * n_dates + j], bal));
+            g_assert (gnc_numeric_equal (changes[i * n_dates + j],
+                                         gnc_numeric_sub_fixed (bal, prev)));
+            prev = bal;
+        }
+    }
+    g_assert (gnc_numeric_equal (balances[1],
+                                 gnc_numeric_create (-162345, 100)));
+    g_assert (gnc_numeric_zero_p (balances[2 * n_dates + 4]));
+}
 /* xaccAccountGetPresentBalance
 gnc_numeric
 xaccAccountGetPresentBalance (const Account *acc)// C: 4 in 2 */
@@ -2562,6 +2757,8 @@ test_suite_account (void)
     GNC_TEST_ADD (suitename, "gnc account insert & remove split", Fixture, NULL, setup, test_gnc_account_insert_remove_split,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccount Insert and Remove Lot", Fixture, &good_data, setup, test_xaccAccountInsertRemoveLot,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountRecomputeBalance", Fixture, &some_data, setup, test_xaccAccountRecomputeBalance,  teardown );
+    GNC_TEST_ADD (suitename, "xaccAccountSortSplits", Fixture, NULL, setup, test_xaccAccountSortSplits,  teardown );
+    GNC_TEST_ADD (suitename, "xaccAccountSortSplits benchmark", Fixture, NULL, setup, test_xaccAccountSortSplits_bench,  teardown );
     GNC_TEST_ADD_FUNC (suitename, "xaccAccountOrder", test_xaccAccountOrder );
     GNC_TEST_ADD (suitename, "qofAccountSetParent", Fixture, &some_data, setup, test_qofAccountSetParent,  teardown );
     GNC_TEST_ADD (suitename, "gnc account append/remove child", Fixture, NULL, setup, test_gnc_account_append_remove_child,  teardown );
@@ -2580,6 +2777,7 @@ test_suite_account (void)
     GNC_TEST_ADD (suitename, "gnc account get full name", Fixture, &good_data, setup, test_gnc_account_get_full_name,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountGetProjectedMinimumBalance", Fixture, &some_data, setup, test_xaccAccountGetProjectedMinimumBalance,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountGetBalanceAsOfDate", Fixture, &some_data, setup, test_xaccAccountGetBalanceAsOfDate,  teardown );
+    GNC_TEST_ADD (suitename, "xaccAccountsGetBalancesAtDates", Fixture, &some_data, setup, test_xaccAccountsGetBalancesAtDates,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountGetPresentBalance", Fixture, &some_data, setup, test_xaccAccountGetPresentBalance,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountFindOpenLots", Fixture, &complex_data, setup, test_xaccAccountFindOpenLots,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountForEachLot", Fixture, &complex_data, setup, test_xaccAccountForEachLot,  teardown );
@@ -208,6 +208,25 @@ test_invoice_posted_trans ( Fixture *fixture, gconstpointer pData )
     }
 }
 
+static void
+test_invoice_owner_open_lots ( Fixture *fixture, gconstpointer pData )
+{
+    GNCLot *lot = gncInvoiceGetPostedLot (fixture->invoice);
+    GList *lots;
+
+    g_assert (lot);
+    lots = gncOwnerGetOpenLots (&fixture->owner, NULL);
+    g_assert_cmpint (g_list_length (lots), ==, 1);
+    g_assert (lots->data == lot);
+    g_list_free (lots);
+
+    lots = gncOwnerGetOpenLots (&fixture->owner, fixture->account2);
+    g_assert_cmpint (g_list_length (lots), ==, 1);
+    g_list_free (lots);
+
+    g_assert (gncOwnerGetOpenLots (&fixture->owner, fixture->account) == NULL);
+}
+
 void
 test_suite_gncInvoice ( void )
 {
@@ -221,4 +240,5 @@ test_suite_gncInvoice ( void )
     GNC_TEST_ADD( suitename, "post trans - customer creditnote", Fixture, &pData, setup_with_invoice, test_invoice_posted_trans, teardown_with_invoice );
     pData.is_cn = FALSE;   // Customer invoice
     GNC_TEST_ADD( suitename, "post trans - customer invoice", Fixture, &pData, setup_with_invoice, test_invoice_posted_trans, teardown_with_invoice );
+    GNC_TEST_ADD( suitename, "owner open lots", Fixture, &pData, setup_with_invoice, test_invoice_owner_open_lots, teardown_with_invoice );
 }
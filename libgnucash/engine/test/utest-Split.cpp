@@ -1221,6 +1221,61 @@ test_xaccSplitOrder (Fixture *fixture, gconstpointer pData)
     test_destroy (o_split);
     test_destroy (o_txn);
 }
+/* xaccSplitGetSortKey
+gboolean
+xaccSplitGetSortKey (const Split *s, gboolean action_for_num,
+                     SplitSortKey *key)// C: 1 in 1
+*/
+static void
+test_xaccSplitGetSortKey (Fixture *fixture, gconstpointer pData)
+{
+    Split *split = fixture->split;
+    QofBook *book = xaccSplitGetBook (split);
+    Split *o_split = xaccMallocSplit (book);
+    Transaction *o_txn = xaccMallocTransaction (book);
+    Transaction *txn = split->parent;
+    SplitSortKey key, o_key;
+
+    /* A split without a parent sorts after one with. */
+    g_assert (xaccSplitGetSortKey (split, FALSE, &key));
+    g_assert (xaccSplitGetSortKey (o_split, FALSE, &o_key));
+    g_assert_cmpint (xaccSplitSortKeyCompare (&key, &o_key), ==, -1);
+    g_assert_cmpint (xaccSplitOrder (split, o_split), ==, -1);
+
+    o_split->parent = o_txn;
+    txn->date_posted = o_txn->date_posted = gnc_time (NULL);
+    txn->date_entered = o_txn->date_entered;
+    txn->num = "124";
+    o_txn->num = "123";
+    split->action = "5";
+    o_split->action = "6";
+    g_assert (xaccSplitGetSortKey (split, FALSE, &key));
+    g_assert (xaccSplitGetSortKey (o_split, FALSE, &o_key));
+    g_assert_cmpint (xaccSplitSortKeyCompare (&key, &o_key), ==, 1);
+    g_assert_cmpint (xaccSplitOrder (split, o_split), ==, 1);
+    g_assert (xaccSplitGetSortKey (split, TRUE, &key));
+    g_assert (xaccSplitGetSortKey (o_split, TRUE, &o_key));
+    g_assert_cmpint (xaccSplitSortKeyCompare (&key, &o_key), ==, -1);
+
+    o_txn->date_posted -= 1;
+    g_assert (xaccSplitGetSortKey (o_split, FALSE, &o_key));
+    g_assert (xaccSplitGetSortKey (split, FALSE, &key));
+    g_assert_cmpint (xaccSplitSortKeyCompare (&key, &o_key), ==, 1);
+
+    /* Equal keys leave the decision to xaccSplitOrder. */
+    o_txn->date_posted = txn->date_posted;
+    o_txn->num = txn->num;
+    g_assert (xaccSplitGetSortKey (o_split, FALSE, &o_key));
+    g_assert_cmpint (xaccSplitSortKeyCompare (&key, &o_key), ==, 0);
+
+    /* Without an action the order depends on the other split's. */
+    o_split->action = NULL;
+    g_assert (!xaccSplitGetSortKey (o_split, TRUE, &o_key));
+
+    o_split->parent = NULL;
+    test_destroy (o_split);
+    test_destroy (o_txn);
+}
 /* xaccSplitOrderDateOnly
 gint
 xaccSplitOrderDateOnly (const Split *sa, const Split *sb)// C: 2 in 1
@@ -1922,6 +1977,7 @@ test_suite_split (void)
     GNC_TEST_ADD_FUNC (suitename, "xaccSplitConvertAmount", test_xaccSplitConvertAmount);
     GNC_TEST_ADD_FUNC (suitename, "xaccSplitDestroy", test_xaccSplitDestroy);
     GNC_TEST_ADD (suitename, "xaccSplitOrder", Fixture, NULL, setup, test_xaccSplitOrder, teardown);
+    GNC_TEST_ADD (suitename, "xaccSplitGetSortKey", Fixture, NULL, setup, test_xaccSplitGetSortKey, teardown);
     GNC_TEST_ADD (suitename, "xaccSplitOrderDateOnly", Fixture, NULL, setup, test_xaccSplitOrderDateOnly, teardown);
     GNC_TEST_ADD (suitename, "get corr account split", Fixture, NULL, setup, test_get_corr_account_split, teardown);
     GNC_TEST_ADD (suitename, "xaccSplitGetCorrAccountFullName", Fixture, NULL, setup, test_xaccSplitGetCorrAccountFullName, teardown);
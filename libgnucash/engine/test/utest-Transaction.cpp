@@ -26,10 +26,12 @@ extern "C"
 #include <config.h>
 #include <string.h>
 #include <glib.h>
+#include <glib/gstdio.h>
 #include <unittest-support.h>
 /* Add specific headers for this class */
 #include "../Transaction.h"
 #include "../TransactionP.h"
+#include "../TransLog.h"
 #include "../Split.h"
 #include "../Account.h"
 #include "../gnc-lot.h"
@@ -46,6 +48,7 @@ void test_suite_transaction ( void );
 
 #include <qof-backend.hpp>
 #include <kvp-frame.hpp>
+#include <vector>
 
 /* Copied from Transaction.c. Changing these values will break
  * existing databases, which is a good reason to fail a test.
@@ -1360,6 +1363,301 @@ test_xaccTransBeginEdit ()
     xaccTransDestroy (txn);
     qof_book_destroy (book);
 }
+/* Binary transaction journal, see TransLog.c */
+static guint32
+journal_u32 (const guint8 *data)
+{
+    guint32 val;
+    memcpy (&val, data, sizeof (val));
+    return GUINT32_FROM_LE (val);
+}
+
+static guint32
+journal_checksum (const guint8 *data, guint32 len)
+{
+    guint32 hash = 2166136261u;
+    for (guint32 i = 0; i < len; ++i)
+        hash = (hash ^ data[i]) * 16777619u;
+    return hash;
+}
+
+/* Checks the record at *pos and moves pos past it. */
+static void
+check_journal_record (const guint8 **pos, const guint8 *end, char flag,
+                      Transaction *txn, const char *description)
+{
+    const guint8 *rec = *pos;
+    g_assert_cmpint (end - rec, >=, 8);
+    auto len = journal_u32 (rec);
+    g_assert_cmpint (end - rec, >=, 8 + len);
+    auto payload = rec + 4;
+    g_assert_cmpuint (journal_u32 (payload + len),
+                      ==, journal_checksum (payload, len));
+    g_assert_cmpint (payload[0], ==, flag);
+    /* flag, then three dates, then the transaction's guid */
+    auto guid = payload + 1 + 3 * 8;
+    g_assert (memcmp (guid, xaccTransGetGUID (txn)->reserved,
+                      GUID_DATA_SIZE) == 0);
+    auto num = guid + GUID_DATA_SIZE;
+    auto num_len = journal_u32 (num);
+    auto descr = num + 4 + num_len;
+    g_assert_cmpuint (journal_u32 (descr), ==, strlen (description));
+    g_assert (memcmp (descr + 4, description, strlen (description)) == 0);
+    *pos = payload + len + 4;
+}
+
+static void
+test_xaccTransWriteLog_binary (Fixture *fixture, gconstpointer pData)
+{
+    auto txn = fixture->txn;
+    auto dir = g_dir_make_tmp ("translog-XXXXXX", NULL);
+    auto base = g_build_filename (dir, "test", NULL);
+    gchar *contents = NULL;
+    gsize length = 0;
+
+    g_assert (dir != NULL);
+    xaccLogSetBaseName (base);
+    xaccLogSetBinary (TRUE);
+    xaccLogEnable ();
+
+    xaccTransBeginEdit (txn);
+    xaccTransSetDescription (txn, "Journaled");
+    xaccTransCommitEdit (txn);
+    xaccLogFlush ();
+
+    auto gdir = g_dir_open (dir, 0, NULL);
+    auto name = g_dir_read_name (gdir);
+    g_assert (name != NULL);
+    auto filename = g_build_filename (dir, name, NULL);
+    g_assert (g_dir_read_name (gdir) == NULL);
+    g_dir_close (gdir);
+    g_assert (g_file_get_contents (filename, &contents, &length, NULL));
+
+    auto magic_len = strlen (TRANS_LOG_BINARY_MAGIC);
+    g_assert_cmpuint (length, >, magic_len);
+    g_assert (memcmp (contents, TRANS_LOG_BINARY_MAGIC, magic_len) == 0);
+    auto pos = reinterpret_cast<const guint8*>(contents) + magic_len;
+    auto end = reinterpret_cast<const guint8*>(contents) + length;
+    check_journal_record (&pos, end, 'B', txn, "Waldo Pepper");
+    check_journal_record (&pos, end, 'C', txn, "Journaled");
+    g_assert (pos == end);
+
+    xaccCloseLog ();
+    xaccLogDisable ();
+    xaccLogSetBinary (FALSE);
+    xaccLogSetBaseName ("translog");
+    g_remove (filename);
+    g_rmdir (dir);
+    g_free (contents);
+    g_free (filename);
+    g_free (base);
+    g_free (dir);
+}
+/* xaccLogReadJournal */
+struct JournalRead
+{
+    Transaction *txn;
+    std::vector<char> flags;
+};
+
+static const char*
+journal_str (const char *str)
+{
+    return str ? str : "";
+}
+
+/* Compares a record read back with the fixture's transaction, which was
+ * only changed in its description. */
+static void
+check_journal_trans (const TransLogRecord *record, gpointer data)
+{
+    auto read = static_cast<JournalRead*>(data);
+    auto txn = read->txn;
+
+    read->flags.push_back (record->flag);
+    g_assert (guid_equal (&record->trans_guid, xaccTransGetGUID (txn)));
+    g_assert_cmpint (record->date_entered, ==, xaccTransRetDateEntered (txn));
+    g_assert_cmpint (record->date_posted, ==, xaccTransRetDatePosted (txn));
+    g_assert_cmpstr (record->num, ==, journal_str (xaccTransGetNum (txn)));
+    g_assert_cmpstr (record->description, ==,
+                     record->flag == 'B' ? "Waldo Pepper" : xaccTransGetDescription (txn));
+    g_assert_cmpstr (record->notes, ==, journal_str (xaccTransGetNotes (txn)));
+    g_assert_cmpuint (record->n_splits, ==, xaccTransCountSplits (txn));
+    for (guint i = 0; i < record->n_splits; i++)
+    {
+        auto logged = &record->splits[i];
+        auto split = xaccTransGetSplit (txn, i);
+        auto acc = xaccSplitGetAccount (split);
+        g_assert (guid_equal (&logged->split_guid, xaccSplitGetGUID (split)));
+        g_assert (guid_equal (&logged->acc_guid, xaccAccountGetGUID (acc)));
+        g_assert_cmpstr (logged->acc_name, ==, journal_str (xaccAccountGetName (acc)));
+        g_assert_cmpstr (logged->memo, ==, journal_str (xaccSplitGetMemo (split)));
+        g_assert_cmpstr (logged->action, ==, journal_str (xaccSplitGetAction (split)));
+        g_assert_cmpint (logged->reconciled, ==, xaccSplitGetReconcile (split));
+        g_assert (gnc_numeric_equal (logged->amount, xaccSplitGetAmount (split)));
+        g_assert (gnc_numeric_equal (logged->value, xaccSplitGetValue (split)));
+        g_assert_cmpint (logged->date_reconciled, ==, xaccSplitGetDateReconciled (split));
+    }
+}
+
+/* Reads back the journal contents after writing them to filename. */
+static TransLogJournalStatus
+read_test_journal (const gchar *filename, const gchar *contents, gsize length,
+                   JournalRead *read)
+{
+    g_assert (g_file_set_contents (filename, contents, length, NULL));
+    auto file = g_fopen (filename, "rb");
+    g_assert (file != NULL);
+    g_assert (fseek (file, strlen (TRANS_LOG_BINARY_MAGIC), SEEK_SET) == 0);
+    read->flags.clear ();
+    auto status = xaccLogReadJournal (file, check_journal_trans, read);
+    fclose (file);
+    return status;
+}
+
+static void
+test_xaccLogReadJournal (Fixture *fixture, gconstpointer pData)
+{
+    auto txn = fixture->txn;
+    auto dir = g_dir_make_tmp ("translog-XXXXXX", NULL);
+    auto base = g_build_filename (dir, "test", NULL);
+    auto copy = g_build_filename (dir, "copy.bin", NULL);
+    JournalRead read {txn, {}};
+    const std::vector<char> both {'B', 'C'}, first {'B'};
+    gchar *contents = NULL;
+    gsize length = 0;
+
+    g_assert (dir != NULL);
+    xaccLogSetBaseName (base);
+    xaccLogSetBinary (TRUE);
+    xaccLogEnable ();
+
+    xaccTransBeginEdit (txn);
+    xaccTransSetDescription (txn, "Journaled");
+    xaccTransCommitEdit (txn);
+    xaccCloseLog ();
+
+    auto gdir = g_dir_open (dir, 0, NULL);
+    auto name = g_dir_read_name (gdir);
+    g_assert (name != NULL);
+    auto filename = g_build_filename (dir, name, NULL);
+    g_dir_close (gdir);
+    g_assert (g_file_get_contents (filename, &contents, &length, NULL));
+
+    /* Both records read back as logged. */
+    g_assert_cmpint (read_test_journal (copy, contents, length, &read),
+                     ==, TRANS_LOG_JOURNAL_OK);
+    g_assert (read.flags == both);
+
+    /* A crash cut the last record short ... */
+    g_assert_cmpint (read_test_journal (copy, contents, length - 3, &read),
+                     ==, TRANS_LOG_JOURNAL_TRUNCATED);
+    g_assert (read.flags == first);
+
+    /* ... or even its length. */
+    auto magic_len = strlen (TRANS_LOG_BINARY_MAGIC);
+    auto first_len = journal_u32 (reinterpret_cast<const guint8*>(contents) + magic_len);
+    auto second = magic_len + 4 + first_len + 4;
+    g_assert_cmpuint (second, <, length);
+    g_assert_cmpint (read_test_journal (copy, contents, second + 2, &read),
+                     ==, TRANS_LOG_JOURNAL_TRUNCATED);
+    g_assert (read.flags == first);
+
+    /* A damaged byte in the last record fails its checksum. */
+    contents[length - 5] ^= 0x40;
+    g_assert_cmpint (read_test_journal (copy, contents, length, &read),
+                     ==, TRANS_LOG_JOURNAL_CORRUPT);
+    g_assert (read.flags == first);
+
+    xaccLogDisable ();
+    xaccLogSetBinary (FALSE);
+    xaccLogSetBaseName ("translog");
+    g_remove (filename);
+    g_remove (copy);
+    g_rmdir (dir);
+    g_free (contents);
+    g_free (filename);
+    g_free (copy);
+    g_free (base);
+    g_free (dir);
+}
+/* xaccTransCommitBulk
+TransList *
+xaccTransCommitBulk (TransList *transactions, TransBulkMode mode)
+*/
+static Transaction*
+make_bulk_txn (Fixture *fixture, Account *acc, gint64 debit, gint64 credit,
+               time64 posted)
+{
+    auto book = gnc_account_get_book (acc);
+    auto txn = xaccMallocTransaction (book);
+    auto split1 = xaccMallocSplit (book);
+    auto split2 = xaccMallocSplit (book);
+
+    xaccTransBeginEdit (txn);
+    xaccTransSetCurrency (txn, fixture->curr);
+    xaccTransSetDatePostedSecs (txn, posted);
+    xaccSplitSetParent (split1, txn);
+    xaccSplitSetParent (split2, txn);
+    xaccSplitSetAccount (split1, acc);
+    xaccSplitSetAccount (split2, fixture->acc2);
+    xaccSplitSetAmount (split1, gnc_numeric_create (debit, 240));
+    xaccSplitSetValue (split1, gnc_numeric_create (debit, 240));
+    xaccSplitSetAmount (split2, gnc_numeric_create (-credit, 240));
+    xaccSplitSetValue (split2, gnc_numeric_create (-credit, 240));
+    return txn;
+}
+
+static void
+test_xaccTransCommitBulk (Fixture *fixture, gconstpointer pData)
+{
+    auto book = qof_instance_get_book (QOF_INSTANCE (fixture->txn));
+    auto acc = xaccMallocAccount (book);
+    auto posted = gnc_dmy2time64 (1, 5, 2012);
+    xaccAccountSetCommodity (acc, fixture->curr);
+    auto acc2_count = g_list_length (xaccAccountGetSplitList (fixture->acc2));
+    auto acc2_balance = xaccAccountGetBalance (fixture->acc2);
+
+    /* Posted in reverse order, to check the accounts are sorted. */
+    auto txn1 = make_bulk_txn (fixture, acc, 240, 240, posted + 2 * 86400);
+    auto txn2 = make_bulk_txn (fixture, acc, 480, 480, posted + 86400);
+    auto txn3 = make_bulk_txn (fixture, acc, 720, 360, posted);
+    auto txns = g_list_append (NULL, txn1);
+    txns = g_list_append (txns, txn2);
+    txns = g_list_append (txns, txn3);
+
+    auto left = xaccTransCommitBulk (txns, TRANS_BULK_SKIP_UNBALANCED);
+    g_assert_cmpint (g_list_length (left), ==, 1);
+    g_assert (left->data == txn3);
+    g_assert (xaccTransIsOpen (txn3));
+    g_assert (!xaccTransIsOpen (txn1));
+    g_assert (!xaccTransIsOpen (txn2));
+    g_assert_cmpint (qof_instance_get_editlevel (acc), ==, 0);
+    g_list_free (left);
+
+    auto splits = xaccAccountGetSplitList (acc);
+    g_assert_cmpint (g_list_length (splits), ==, 2);
+    g_assert (xaccSplitGetParent (static_cast<Split*>(splits->data)) == txn2);
+    g_assert (xaccSplitGetParent (static_cast<Split*>(splits->next->data)) == txn1);
+    g_assert (gnc_numeric_equal (xaccAccountGetBalance (acc),
+                                 gnc_numeric_create (720, 240)));
+    g_assert_cmpint (g_list_length (xaccAccountGetSplitList (fixture->acc2)),
+                     ==, acc2_count + 2);
+    g_assert (gnc_numeric_equal (xaccAccountGetBalance (fixture->acc2),
+                                 gnc_numeric_sub_fixed (acc2_balance,
+                                                        gnc_numeric_create (720, 240))));
+
+    /* Scrubbing balances the one left open. */
+    g_list_free (txns);
+    txns = g_list_append (NULL, txn3);
+    left = xaccTransCommitBulk (txns, TRANS_BULK_SCRUB);
+    g_assert (left == NULL);
+    g_assert (!xaccTransIsOpen (txn3));
+    g_assert (xaccTransIsBalanced (txn3));
+    g_assert_cmpint (g_list_length (xaccAccountGetSplitList (acc)), ==, 3);
+    g_assert (xaccSplitGetParent (static_cast<Split*>(xaccAccountGetSplitList (acc)->data)) == txn3);
+    g_list_free (txns);
+}
 /* xaccTransDestroy
 void
 xaccTransDestroy (Transaction *trans)// C: 26 in 15 SCM: 4 in 4 Local: 3:0:0
@@ -1987,10 +2285,87 @@ test_xaccTransScrubGainsDate_gains_dirty (GainsFixture *fixture,
  */
 /* xaccTransFindSplitByAccount C: 7 in 5  Local: 0:0:0
  * destroy_tx_on_book_close Local: 0:1:0
- * gnc_transaction_book_end Local: 0:1:0
  * trans_is_balanced_p Local: 0:1:0
  * Trivial pass-through.
  */
+/* gnc_transaction_book_end
+static void
+gnc_transaction_book_end(QofBook* book)// Local: 0:1:0
+*/
+static void
+count_destroy_events (QofInstance *ent, QofEventId event_type,
+                      gpointer handler_data, gpointer event_data)
+{
+    if (event_type == QOF_EVENT_DESTROY &&
+        (GNC_IS_TRANSACTION (ent) || GNC_IS_SPLIT (ent)))
+        ++*static_cast<guint*>(handler_data);
+}
+
+static void
+count_freed (gpointer data, GObject *where_the_object_was)
+{
+    ++*static_cast<guint*>(data);
+}
+
+static void
+test_gnc_transaction_book_end (void)
+{
+    auto book = qof_book_new ();
+    auto root = gnc_account_create_root (book);
+    auto curr = gnc_commodity_new (book, "Gnu Rand", "CURRENCY", "GNR", "", 240);
+    auto acc1 = xaccMallocAccount (book);
+    auto acc2 = xaccMallocAccount (book);
+    auto posted = gnc_dmy2time64 (1, 5, 2012);
+    Transaction *open_txn = nullptr;
+    guint destroyed = 0, freed_txns = 0, freed_splits = 0;
+
+    xaccAccountSetCommodity (acc1, curr);
+    xaccAccountSetCommodity (acc2, curr);
+    gnc_account_append_child (root, acc1);
+    gnc_account_append_child (root, acc2);
+    for (int i = 0; i < 10; ++i)
+    {
+        auto txn = xaccMallocTransaction (book);
+        auto split1 = xaccMallocSplit (book);
+        auto split2 = xaccMallocSplit (book);
+        xaccTransBeginEdit (txn);
+        xaccTransSetCurrency (txn, curr);
+        xaccTransSetDatePostedSecs (txn, posted + i * 86400);
+        xaccSplitSetParent (split1, txn);
+        xaccSplitSetParent (split2, txn);
+        xaccSplitSetAccount (split1, acc1);
+        xaccSplitSetAccount (split2, acc2);
+        xaccSplitSetAmount (split1, gnc_numeric_create (240, 240));
+        xaccSplitSetValue (split1, gnc_numeric_create (240, 240));
+        xaccSplitSetAmount (split2, gnc_numeric_create (-240, 240));
+        xaccSplitSetValue (split2, gnc_numeric_create (-240, 240));
+        g_object_weak_ref (G_OBJECT (txn), count_freed, &freed_txns);
+        g_object_weak_ref (G_OBJECT (split1), count_freed, &freed_splits);
+        g_object_weak_ref (G_OBJECT (split2), count_freed, &freed_splits);
+        /* Leave the last one open to check that it's left alone. */
+        if (i < 9)
+            xaccTransCommitEdit (txn);
+        else
+            open_txn = txn;
+    }
+    g_assert_cmpint (g_list_length (xaccAccountGetSplitList (acc1)), ==, 9);
+    g_assert (open_txn != nullptr);
+    g_assert_cmpuint (qof_collection_count (qof_book_get_collection (book, GNC_ID_TRANS)), ==, 10);
+    g_assert_cmpuint (qof_collection_count (qof_book_get_collection (book, GNC_ID_SPLIT)), ==, 20);
+
+    auto id = qof_event_register_handler (count_destroy_events, &destroyed);
+    qof_book_destroy (book);
+    qof_event_unregister_handler (id);
+    /* The committed transactions and their splits were freed without
+     * any events. xaccTransDestroy on the open transaction only marks it
+     * as being destroyed: the destroy happens when its edit is
+     * committed, which never comes, so it isn't freed either. */
+    g_assert_cmpuint (destroyed, ==, 0);
+    g_assert_cmpuint (freed_txns, ==, 9);
+    g_assert_cmpuint (freed_splits, ==, 18);
+    g_assert_true (qof_instance_get_destroying (open_txn));
+    g_assert_cmpint (qof_instance_get_editlevel (open_txn), ==, 1);
+}
 
 
 void
@@ -2027,6 +2402,8 @@ test_suite_transaction (void)
 
     GNC_TEST_ADD (suitename, "xaccTransSetCurrency", Fixture, NULL, setup, test_xaccTransSetCurrency, teardown);
     GNC_TEST_ADD_FUNC (suitename, "xaccTransBeginEdit", test_xaccTransBeginEdit);
+    GNC_TEST_ADD (suitename, "xaccTransWriteLog binary", Fixture, NULL, setup, test_xaccTransWriteLog_binary, teardown);
+    GNC_TEST_ADD (suitename, "xaccLogReadJournal", Fixture, NULL, setup, test_xaccLogReadJournal, teardown);
     GNC_TEST_ADD (suitename, "xaccTransDestroy", Fixture, NULL, setup, test_xaccTransDestroy, teardown);
     GNC_TEST_ADD (suitename, "destroy gains", GainsFixture, NULL, setup_with_gains, test_destroy_gains, teardown_with_gains);
     GNC_TEST_ADD (suitename, "do destroy", GainsFixture, NULL, setup_with_gains, test_do_destroy, teardown_with_gains);
@@ -2034,6 +2411,7 @@ test_suite_transaction (void)
     GNC_TEST_ADD (suitename, "trans on error", Fixture, NULL, setup, test_trans_on_error, teardown);
     GNC_TEST_ADD (suitename, "trans cleanup commit", Fixture, NULL, setup, test_trans_cleanup_commit, teardown);
     GNC_TEST_ADD_FUNC (suitename, "xaccTransCommitEdit", test_xaccTransCommitEdit);
+    GNC_TEST_ADD (suitename, "xaccTransCommitBulk", Fixture, NULL, setup, test_xaccTransCommitBulk, teardown);
     GNC_TEST_ADD (suitename, "xaccTransRollbackEdit", Fixture, NULL, setup, test_xaccTransRollbackEdit, teardown);
     GNC_TEST_ADD (suitename, "xaccTransRollbackEdit - Backend Errors", Fixture, NULL, setup, test_xaccTransRollbackEdit_BackendErrors, teardown);
     GNC_TEST_ADD (suitename, "xaccTransOrder_num_action", Fixture, NULL, setup, test_xaccTransOrder_num_action, teardown);
@@ -2043,5 +2421,6 @@ test_suite_transaction (void)
     GNC_TEST_ADD (suitename, "xaccTransScrubGainsDate_no_dirty", GainsFixture, NULL, setup_with_gains, test_xaccTransScrubGainsDate_no_dirty, teardown_with_gains);
     GNC_TEST_ADD (suitename, "xaccTransScrubGainsDate_base_dirty", GainsFixture, NULL, setup_with_gains, test_xaccTransScrubGainsDate_base_dirty, teardown_with_gains);
     GNC_TEST_ADD (suitename, "xaccTransScrubGainsDate_gains_dirty", GainsFixture, NULL, setup_with_gains, test_xaccTransScrubGainsDate_gains_dirty, teardown_with_gains);
+    GNC_TEST_ADD_FUNC (suitename, "gnc_transaction_book_end", test_gnc_transaction_book_end);
 
 }
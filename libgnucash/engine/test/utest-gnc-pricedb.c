@@ -737,6 +737,122 @@ gnc_pricedb_add_price(GNCPriceDB *db, GNCPrice *p)// C: 7 in 7 SCM: 1  Local: 0:
 test_gnc_pricedb_add_price (Fixture *fixture, gconstpointer pData)
 {
 }*/
+/* gnc_pricedb_add_prices
+guint
+gnc_pricedb_add_prices (GNCPriceDB *db, PriceList *prices, PriceAddMode mode,
+*/
+static void
+test_gnc_pricedb_add_prices (PriceDBFixture *fixture, gconstpointer pData)
+{
+    GNCPriceDB *db = fixture->pricedb;
+    QofBook *book = qof_instance_get_book(QOF_INSTANCE(db));
+    Commodities *c = fixture->com;
+    PriceAddCounts counts;
+    PriceList *prices = NULL;
+    GNCPrice *price;
+    time64 t = gnc_dmy2time64(2, 1, 2020);
+
+    /* A user price doesn't replace a Finance::Quote one. */
+    prices = g_list_append(prices,
+                           construct_price(book, c->usd, c->aud,
+                                           gnc_dmy2time64(11, 4, 2009),
+                                           PRICE_SOURCE_USER_PRICE,
+                                           gnc_numeric_create(131000, 10000)));
+    /* A Finance::Quote price replaces a user one. */
+    prices = g_list_append(prices,
+                           construct_price(book, c->usd, c->aud,
+                                           gnc_dmy2time64(12, 4, 2009),
+                                           PRICE_SOURCE_FQ,
+                                           gnc_numeric_create(132000, 10000)));
+    /* Of two new prices on the same day the last one wins. */
+    prices = g_list_append(prices,
+                           construct_price(book, c->usd, c->aud, t,
+                                           PRICE_SOURCE_FQ,
+                                           gnc_numeric_create(150000, 10000)));
+    prices = g_list_append(prices,
+                           construct_price(book, c->usd, c->aud, t,
+                                           PRICE_SOURCE_FQ,
+                                           gnc_numeric_create(151000, 10000)));
+    /* A price replaces one in the reverse direction. */
+    prices = g_list_append(prices,
+                           construct_price(book, c->usd, c->gbp,
+                                           gnc_dmy2time64(11, 4, 2009),
+                                           PRICE_SOURCE_FQ,
+                                           gnc_numeric_create(60000, 100000)));
+
+    g_assert_cmpuint(gnc_pricedb_add_prices(db, prices, PRICE_ADD_BY_SOURCE,
+                                            &counts), ==, 3);
+    g_assert_cmpuint(counts.added, ==, 3);
+    g_assert_cmpuint(counts.replaced, ==, 2);
+    g_assert_cmpuint(counts.skipped, ==, 2);
+    g_assert_cmpint(gnc_pricedb_get_num_prices(db), ==, 43);
+    g_assert(qof_instance_get_dirty_flag(db));
+
+    price = gnc_pricedb_lookup_day_t64(db, c->usd, c->aud, t);
+    g_assert(gnc_numeric_equal(gnc_price_get_value(price),
+                               gnc_numeric_create(151000, 10000)));
+    gnc_price_unref(price);
+    price = gnc_pricedb_lookup_day_t64(db, c->usd, c->aud,
+                                       gnc_dmy2time64(11, 4, 2009));
+    g_assert_cmpint(gnc_price_get_source(price), ==, PRICE_SOURCE_FQ);
+    gnc_price_unref(price);
+    price = gnc_pricedb_lookup_day_t64(db, c->gbp, c->usd,
+                                       gnc_dmy2time64(11, 4, 2009));
+    g_assert(gnc_price_get_commodity(price) == c->usd);
+    gnc_price_unref(price);
+    g_list_free_full(prices, (GDestroyNotify)gnc_price_unref);
+
+    /* The explicit modes ignore the price source. */
+    prices = g_list_append(NULL,
+                           construct_price(book, c->usd, c->aud,
+                                           gnc_dmy2time64(11, 4, 2009),
+                                           PRICE_SOURCE_USER_PRICE,
+                                           gnc_numeric_create(133000, 10000)));
+    g_assert_cmpuint(gnc_pricedb_add_prices(db, prices, PRICE_ADD_KEEP_EXISTING,
+                                            &counts), ==, 0);
+    g_assert_cmpuint(counts.skipped, ==, 1);
+    g_assert_cmpuint(gnc_pricedb_add_prices(db, prices, PRICE_ADD_REPLACE,
+                                            &counts), ==, 1);
+    g_assert_cmpuint(counts.replaced, ==, 1);
+    g_assert_cmpint(gnc_pricedb_get_num_prices(db), ==, 43);
+    g_list_free_full(prices, (GDestroyNotify)gnc_price_unref);
+}
+
+static void
+test_gnc_pricedb_add_prices_throughput (PriceDBFixture *fixture,
+                                        gconstpointer pData)
+{
+    GNCPriceDB *db = fixture->pricedb;
+    QofBook *book = qof_instance_get_book(QOF_INSTANCE(db));
+    Commodities *c = fixture->com;
+    gnc_commodity *currencies[] = { c->usd, c->eur, c->gbp, c->dkk };
+    const guint n_days = 5000, n_currencies = G_N_ELEMENTS(currencies);
+    time64 start = gnc_dmy2time64(1, 1, 1950);
+    PriceList *prices = NULL;
+    PriceAddCounts counts;
+    gint64 begin, elapsed;
+
+    for (guint day = 0; day < n_days; day++)
+        for (guint i = 0; i < n_currencies; i++)
+            prices = g_list_prepend(prices,
+                                    construct_price(book, c->amzn, currencies[i],
+                                                    start + day * 86400,
+                                                    PRICE_SOURCE_USER_PRICE,
+                                                    gnc_numeric_create(day + i, 100)));
+
+    begin = g_get_monotonic_time();
+    gnc_pricedb_add_prices(db, prices, PRICE_ADD_BY_SOURCE, &counts);
+    elapsed = g_get_monotonic_time() - begin;
+    g_test_message("Added %u prices in %" G_GINT64_FORMAT " us, %.0f rows/s",
+                   counts.added, elapsed,
+                   elapsed ? counts.added * 1e6 / elapsed : 0.0);
+
+    g_assert_cmpuint(counts.added, ==, n_days * n_currencies);
+    g_assert_cmpuint(counts.replaced, ==, 0);
+    g_assert_cmpint(gnc_pricedb_get_num_prices(db), ==,
+                    42 + n_days * n_currencies);
+    g_list_free_full(prices, (GDestroyNotify)gnc_price_unref);
+}
 /* remove_price
 static gboolean
 remove_price(GNCPriceDB *db, GNCPrice *p, gboolean cleanup)// Local: 4:0:0
@@ -1552,6 +1668,8 @@ test_suite_gnc_pricedb (void)
 // GNC_TEST_ADD (suitename, "insert or replace price", Fixture, NULL, setup, test_insert_or_replace_price, teardown);
 // GNC_TEST_ADD (suitename, "add price", Fixture, NULL, setup, test_add_price, teardown);
 // GNC_TEST_ADD (suitename, "gnc pricedb add price", Fixture, NULL, setup, test_gnc_pricedb_add_price, teardown);
+    GNC_TEST_ADD (suitename, "gnc pricedb add prices", PriceDBFixture, NULL, setup, test_gnc_pricedb_add_prices, teardown);
+    GNC_TEST_ADD (suitename, "gnc pricedb add prices throughput", PriceDBFixture, NULL, setup, test_gnc_pricedb_add_prices_throughput, teardown);
 // GNC_TEST_ADD (suitename, "remove price", Fixture, NULL, setup, test_remove_price, teardown);
 // GNC_TEST_ADD (suitename, "gnc pricedb remove price", Fixture, NULL, setup, test_gnc_pricedb_remove_price, teardown);
 // GNC_TEST_ADD (suitename, "check one price date", Fixture, NULL, setup, test_check_one_price_date, teardown);